@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#include "ns3/PushPullDefines.h"
+#include "ns3/PushPullPacket.h"
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+using namespace pushpull;
+
+/*
+ * This program compares the CPU time needed to encode and decode control messages (REQUEST and HAVE)
+ * via the Header-based message classes with the time needed via the PushPullMessageBatch class.
+ * It does not run a simulation.
+ */
+
+namespace {
+
+double GetElapsedMilliSeconds (std::clock_t start)
+{
+  return 1000.0 * (std::clock () - start) / CLOCKS_PER_SEC;
+}
+
+// Encode each message into its own packet via three AddHeader calls, as done by the Peer class before
+uint64_t EncodeWithHeaders (uint32_t messages)
+{
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < messages; ++i)
+    {
+      Ptr<Packet> packet = Create<Packet> ();
+
+      PushPullLengthHeader lenHead (PP_PROTOCOL_MESSAGES_REQUEST_LENGTH);
+      PushPullTypeHeader typeHead (PushPullTypeHeader::REQUEST);
+      PushPullRequestMessage reqMsg (i, 0, 16384);
+
+      packet->AddHeader (reqMsg);
+      packet->AddHeader (typeHead);
+      packet->AddHeader (lenHead);
+
+      bytes += packet->GetSize ();
+    }
+
+  return bytes;
+}
+
+// Encode each message into its own packet via the batch encoder
+uint64_t EncodeSingleWithBatch (uint32_t messages)
+{
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < messages; ++i)
+    {
+      PushPullMessageBatch batch;
+      batch.AddRequest (i, 0, 16384);
+
+      bytes += batch.ToPacket ()->GetSize ();
+    }
+
+  return bytes;
+}
+
+// Encode all messages into one packet via the batch encoder
+uint64_t EncodeBatch (uint32_t messages)
+{
+  PushPullMessageBatch batch (messages);
+  for (uint32_t i = 0; i < messages; ++i)
+    {
+      batch.AddRequest (i, 0, 16384);
+    }
+
+  return batch.ToPacket ()->GetSize ();
+}
+
+// Decode messages from a packet by removing one header after the other
+uint64_t DecodeWithHeaders (Ptr<Packet> packet)
+{
+  uint64_t sum = 0;
+  PushPullLengthHeader lenHead;
+  PushPullTypeHeader typeHead;
+  PushPullRequestMessage reqMsg;
+  while (packet->GetSize () >= PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + PP_PROTOCOL_MESSAGES_REQUEST_LENGTH)
+    {
+      packet->RemoveHeader (lenHead);
+      packet->RemoveHeader (typeHead);
+      packet->RemoveHeader (reqMsg);
+
+      sum += reqMsg.GetPieceIndex ();
+    }
+
+  return sum;
+}
+
+// Decode messages from a contiguous buffer via the batch decoder
+uint64_t DecodeBatch (const std::vector<uint8_t> &data)
+{
+  std::vector<PushPullMessageBatch::Message> messages;
+  messages.reserve (data.size () / (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + PP_PROTOCOL_MESSAGES_REQUEST_LENGTH));
+  PushPullMessageBatch::Decode (&data[0], data.size (), messages);
+
+  uint64_t sum = 0;
+  for (std::vector<PushPullMessageBatch::Message>::const_iterator it = messages.begin (); it != messages.end (); ++it)
+    {
+      sum += (*it).m_pieceIndex;
+    }
+
+  return sum;
+}
+
+} // namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t messages = 100000;
+  uint32_t rounds = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("messages", "Number of REQUEST messages encoded and decoded per round", messages);
+  cmd.AddValue ("rounds", "Number of rounds per benchmark", rounds);
+  cmd.Parse (argc, argv);
+
+  uint64_t checksum = 0;
+
+  // Benchmark 1: Encoding
+  std::clock_t start = std::clock ();
+  for (uint32_t round = 0; round < rounds; ++round)
+    {
+      checksum += EncodeWithHeaders (messages);
+    }
+  double headerEncodeTime = GetElapsedMilliSeconds (start);
+
+  start = std::clock ();
+  for (uint32_t round = 0; round < rounds; ++round)
+    {
+      checksum += EncodeSingleWithBatch (messages);
+    }
+  double singleEncodeTime = GetElapsedMilliSeconds (start);
+
+  start = std::clock ();
+  for (uint32_t round = 0; round < rounds; ++round)
+    {
+      checksum += EncodeBatch (messages);
+    }
+  double batchEncodeTime = GetElapsedMilliSeconds (start);
+
+  // Benchmark 2: Decoding of the same byte stream
+  PushPullMessageBatch batch (messages);
+  for (uint32_t i = 0; i < messages; ++i)
+    {
+      batch.AddRequest (i, 0, 16384);
+    }
+  std::vector<uint8_t> data (batch.GetData (), batch.GetData () + batch.GetSize ());
+
+  start = std::clock ();
+  for (uint32_t round = 0; round < rounds; ++round)
+    {
+      checksum += DecodeWithHeaders (batch.ToPacket ());
+    }
+  double headerDecodeTime = GetElapsedMilliSeconds (start);
+
+  start = std::clock ();
+  for (uint32_t round = 0; round < rounds; ++round)
+    {
+      checksum += DecodeBatch (data);
+    }
+  double batchDecodeTime = GetElapsedMilliSeconds (start);
+
+  std::cout << "Encoding and decoding " << messages << " REQUEST messages, " << rounds << " rounds (checksum " << checksum << ")" << std::endl;
+  std::cout << "  Encode, one packet per message via headers: " << headerEncodeTime << "ms" << std::endl;
+  std::cout << "  Encode, one packet per message via batch:   " << singleEncodeTime << "ms" << std::endl;
+  std::cout << "  Encode, one packet for all messages:        " << batchEncodeTime << "ms" << std::endl;
+  std::cout << "  Decode via headers:                         " << headerDecodeTime << "ms" << std::endl;
+  std::cout << "  Decode via batch decoder:                   " << batchDecodeTime << "ms" << std::endl;
+
+  return 0;
+}
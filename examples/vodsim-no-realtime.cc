@@ -56,11 +56,15 @@ int main (int argc, char *argv[])
   std::string replacements = "";
   uint32_t simulationDuration = 25000;
   bool enableLogging = false;
+  bool verboseStory = true;
+  bool lazyStory = false;
   CommandLine cmd;
   cmd.AddValue ("story", "Name of the story input file, without \".story\" ending. Expected to reside within the ns3 directory tree", storyFileName);
   cmd.AddValue ("replacements", "Variable replacements that shall take place while parsing the story input file, in format \"variable_1:value_1/variable2:value_2\".", replacements);
   cmd.AddValue ("duration", "Length of the simulation in seconds", simulationDuration);
   cmd.AddValue ("logging", "Full-scale logging (0 = off, 1 = on)", enableLogging);
+  cmd.AddValue ("verbose-story", "Print each event while reading the story (0 = off, 1 = on)", verboseStory);
+  cmd.AddValue ("lazy-story", "Schedule the events of time ranges and poisson processes one after the other instead of all at once (0 = off, 1 = on)", lazyStory);
   cmd.Parse (argc, argv);
 
   std::cout << "Setting up BitTorrent Video-on-Demand simulation..." << std::endl;
@@ -84,6 +88,8 @@ int main (int argc, char *argv[])
   story->SetBTNodeApplicationContainer (&nodeApplicationContainer);
   story->SetBTTrackerApplicationContainer (&trackerApplicationContainer);
   story->ParseReplacements (replacements);
+  story->SetVerbose (verboseStory);
+  story->SetLazyScheduling (lazyStory);
   story->ReadAndScheduleStory (storyFileName + ".story", simulationDuration);
 
   std::cout << "Configuring network topology..." << std::endl;
@@ -21,6 +21,7 @@
 #include "Story.h"
 
 #include "brite-topology-helper.h"
+#include "StoryEventGenerator.h"
 
 #include "ns3/BitTorrentClient.h"
 #include "ns3/BitTorrentVideoClient.h"
@@ -32,6 +33,7 @@
 #include "ns3/double.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/inet-socket-address.h"
+#include "ns3/make-event.h"
 #include "ns3/mpi-interface.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
@@ -48,6 +50,7 @@
 #include <cmath>
 #include <ctime>
 #include <fstream>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <set>
@@ -57,26 +60,47 @@
 namespace ns3 {
 namespace bittorrent {
 
+// Time ranges and poisson processes are handed to a StoryEventGenerator in lazy scheduling mode (see Story::SetLazyScheduling)
 #ifdef NS3_MPI
 #define SCHEDULE_CHAPTER_NOARGS(function, type) \
   { \
     UniformVariable uv; \
+    Ptr<StoryEventGenerator> generator = CreateEventGenerator (time, time2, poisson, poissonInterarrivalTime); \
     for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it) \
       { \
         if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ()) \
           { \
+            if (generator) \
+              { \
+                generator->Add (Ptr<EventImpl> (MakeEvent (function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0)))), false)); \
+                continue; \
+              } \
             Simulator::Schedule (MilliSeconds (time.GetMilliSeconds () + uv.GetInteger (0, time2.GetMilliSeconds () - time.GetMilliSeconds ())), function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0)))); \
           } \
       } \
+    if (generator) \
+      { \
+        generator->Start (); \
+      } \
   }
 #else
 #define SCHEDULE_CHAPTER_NOARGS(function, type) \
   { \
     UniformVariable uv; \
+    Ptr<StoryEventGenerator> generator = CreateEventGenerator (time, time2, poisson, poissonInterarrivalTime); \
     for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it) \
       { \
+        if (generator) \
+          { \
+            generator->Add (Ptr<EventImpl> (MakeEvent (function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0)))), false)); \
+            continue; \
+          } \
         Simulator::Schedule (MilliSeconds (time.GetMilliSeconds () + uv.GetInteger (0, time2.GetMilliSeconds () - time.GetMilliSeconds ())), function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0)))); \
       } \
+    if (generator) \
+      { \
+        generator->Start (); \
+      } \
   }
 #endif
 
@@ -84,22 +108,42 @@ namespace bittorrent {
 #define SCHEDULE_CHAPTER(function, type, ...) \
   { \
     UniformVariable uv; \
+    Ptr<StoryEventGenerator> generator = CreateEventGenerator (time, time2, poisson, poissonInterarrivalTime); \
     for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it) \
       { \
         if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ()) \
           { \
+            if (generator) \
+              { \
+                generator->Add (Ptr<EventImpl> (MakeEvent (function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0))), __VA_ARGS__), false)); \
+                continue; \
+              } \
             Simulator::Schedule (MilliSeconds (time.GetMilliSeconds () + uv.GetInteger (0, time2.GetMilliSeconds () - time.GetMilliSeconds ())), function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0))), __VA_ARGS__); \
           } \
       } \
+    if (generator) \
+      { \
+        generator->Start (); \
+      } \
   }
 #else
 #define SCHEDULE_CHAPTER(function, type, ...) \
   { \
     UniformVariable uv; \
+    Ptr<StoryEventGenerator> generator = CreateEventGenerator (time, time2, poisson, poissonInterarrivalTime); \
     for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it) \
       { \
+        if (generator) \
+          { \
+            generator->Add (Ptr<EventImpl> (MakeEvent (function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0))), __VA_ARGS__), false)); \
+            continue; \
+          } \
         Simulator::Schedule (MilliSeconds (time.GetMilliSeconds () + uv.GetInteger (0, time2.GetMilliSeconds () - time.GetMilliSeconds ())), function, dynamic_cast<type*> (PeekPointer ((*it)->GetApplication (0))), __VA_ARGS__); \
       } \
+    if (generator) \
+      { \
+        generator->Start (); \
+      } \
   }
 #endif
 
@@ -124,7 +168,7 @@ namespace bittorrent {
   }
 #endif
 
-Story::Story ()
+Story::Story () : m_output (std::cout.rdbuf ())
 {
   m_trackerAdded = false;
   m_randomSeedSet = false;
@@ -132,6 +176,7 @@ Story::Story ()
   m_otherNodeCount = 0;
   m_loggingToFile = false;
   m_checkData = false;
+  m_lazyScheduling = false;
 }
 
 Story::~Story ()
@@ -223,6 +268,13 @@ bool Story::GetRandomSeedSet () const
 }
 
 void Story::ParseVideoTime (std::istringstream& lineBuffer, int32_t& result, bool& isRelative, uint32_t currentLine = 0)
+{
+  int64_t wideResult;
+  ParseVideoTime (lineBuffer, wideResult, isRelative, currentLine);
+  result = static_cast<int32_t> (wideResult);
+}
+
+void Story::ParseVideoTime (std::istringstream& lineBuffer, int64_t& result, bool& isRelative, uint32_t currentLine = 0)
 {
   std::string buffer;
   lineBuffer >> buffer;
@@ -275,1319 +327,1430 @@ void Story::ParseVideoTime (std::istringstream& lineBuffer, int32_t& result, boo
       ms = 0;
     }
 
-  result = prefix * (ms + 1000 * s + 60000 * m + 3600000 * h);
+  result = prefix * (static_cast<int64_t> (ms) + 1000 * static_cast<int64_t> (s) + 60000 * static_cast<int64_t> (m) + 3600000 * static_cast<int64_t> (h));
 }
 
-void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDuration)
+void Story::ReplaceVariables (std::string& line) const
 {
-  std::ifstream storyFile;
-  std::istringstream lineBuffer;
-  std::string line;
+  // Single pass over the line: each "$name$" whose name is a known variable is replaced by its value
+  if (m_variables.empty () || line.find ('$') == std::string::npos)
+    {
+      return;
+    }
 
-  storyFile.open (filePath.c_str ());
-  if (!storyFile.is_open ())
+  std::string result;
+  result.reserve (line.size ());
+
+  size_t position = 0;
+  while (position < line.size ())
     {
-      NS_ABORT_MSG ("Error: Story file not found.");
+      size_t start = line.find ('$', position);
+      if (start == std::string::npos)
+        {
+          result.append (line, position, std::string::npos);
+          break;
+        }
+      result.append (line, position, start - position);
+
+      size_t end = line.find ('$', start + 1);
+      if (end != std::string::npos)
+        {
+          std::map<std::string, std::string>::const_iterator it = m_variables.find (line.substr (start + 1, end - start - 1));
+          if (it != m_variables.end ())
+            {
+              result.append ((*it).second);
+              position = end + 1;
+              continue;
+            }
+        }
+
+      result.push_back ('$');
+      position = start + 1;
     }
 
-  std::cout << "This is the VODSim Story reader. Processing file " << filePath << "." << std::endl;
+  line.swap (result);
+}
 
-  std::string buffer, buffer2, buffer3;
+bool Story::ParseStoryLine (std::string& line, uint32_t currentLine, Time& oldTime, StoryEvent& event)
+{
+  // Step 0: Replace variables and skip empty lines and comments -->
+  ReplaceVariables (line);
 
-  Time oldTime = FemtoSeconds (0);
-  uint32_t currentLine = 0;
+  if (line == "" || (line[0] == '/' && line[1] == '/'))
+    {
+      return false;
+    }
 
-  m_randomSeedSet = false;
-  m_trackerAdded = (m_btTracker->GetN () > 0);
+  std::istringstream lineBuffer (line);
+  std::string buffer;
 
-  while (!storyFile.eof ())
+  // <-- Step 0: Replace variables and skip empty lines and comments
+
+  // Step 1: Process the time of the event -->
+
+  Time time, time2;
+  bool poisson = false;
+  Time poissonInterarrivalTime;
+
+  if (lineBuffer.str ()[0] == 'p')
     {
-      // Step 0: Read in next line and replace variables -->
-      ++currentLine;
-      getline (storyFile, line);      
+      poisson = true;
+    }
 
-      for (std::map<std::string, std::string>::const_iterator it = m_variables.begin (); it != m_variables.end (); ++it)
+  if (poisson || lineBuffer.str ().substr (0, 4) == "from")
+    {
+      lineBuffer >> buffer;
+      if (poisson && buffer != "poisson")
         {
-          std::string variable = "$" + (*it).first + "$";
-          size_t position;
-          do
-            {
-              position = line.find (variable);
-              if (position != std::string::npos)
-                {
-                  line.erase (position, variable.length ());
-                  line.insert (position, m_variables[(*it).first]);
-                }
-            }
-          while (position != std::string::npos);
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: A poisson process declaration must begin with the \"poisson from\" keyword.");
         }
-
-      lineBuffer.clear ();
-      lineBuffer.str (line);
-      if (lineBuffer.str () == "" || (lineBuffer.str ()[0] == '/' && lineBuffer.str ()[1] == '/'))
+      if (poisson)
+        {
+          lineBuffer >> buffer;
+        }
+      if (buffer != "from")
         {
-          continue;
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: A time range declaration must begin with the \"from\" keyword.");
         }
 
-      // <-- Step 0: Read in next line and replace variables
+      int64_t eventTime;
+      bool dummy;
 
-      // Step 1: Process the time of the event -->
+      ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
+      time = MilliSeconds (eventTime);
 
-      Time time, time2;
-      bool poisson = false;
-      Time poissonInterarrivalTime;
-
-      if (lineBuffer.str ()[0] == 'p')
+      if (time < oldTime)
         {
-          poisson = true;
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: You are scheduling an event that takes place before already scheduled events. That's not allowed.");
         }
 
-      if (poisson || lineBuffer.str ().substr (0, 4) == "from")
-        {
-          lineBuffer >> buffer;
-          if (poisson && buffer != "poisson")
-            {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: A poisson process declaration must begin with the \"poisson from\" keyword.");
-            }
-          if (poisson)
-            {
-              lineBuffer >> buffer;
-            }
-          if (buffer != "from")
-            {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: A time range declaration must begin with the \"from\" keyword.");
-            }
+      lineBuffer >> buffer;
 
-          int32_t eventTime;
-          bool dummy;
+      if (buffer != "till" && buffer != "until")
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a time range, you must provide the end of the range following the statements \"till\" or \"until\".");
+        }
 
-          ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
-          time = MilliSeconds (eventTime);
+      ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
+      time2 = MilliSeconds (eventTime);
 
-          if (time < oldTime)
-            {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: You are scheduling an event that takes place before already scheduled events. That's not allowed.");
-            }
+      if (time2 < time)
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a time range, the upper bound of the range must actually be an UPPER bound.");
+        }
 
+      if (poisson)
+        {
           lineBuffer >> buffer;
 
-          if (buffer != "till" && buffer != "until")
+          if (buffer != "interarrival")
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a time range, you must provide the end of the range following the statements \"till\" or \"until\".");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a poisson process, you must provide the mean interarrival time following the statement \"interarrival\".");
             }
 
           ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
-          time2 = MilliSeconds (eventTime);
+          poissonInterarrivalTime = MilliSeconds (eventTime);
 
-          if (time2 < time)
+          if (poissonInterarrivalTime > (time2 - time) || poissonInterarrivalTime.IsNegative ())
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a time range, the upper bound of the range must actually be an UPPER bound.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a poisson process, the interarrival time must be positive and not be larger than the difference between the start and end time of the process.");
             }
+        }
+    }
+  else
+    {
+      int64_t eventTime;
+      bool dummy;
+      ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
 
-          if (poisson)
-            {
-              lineBuffer >> buffer;
+      time = MilliSeconds (eventTime);
+      time2 = time;
 
-              if (buffer != "interarrival")
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a poisson process, you must provide the mean interarrival time following the statement \"interarrival\".");
-                }
+      if (time < oldTime)
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: You are scheduling an event that takes place before already scheduled events. That's not allowed.");
+        }
+    }
 
-              ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
-              poissonInterarrivalTime = MilliSeconds (eventTime);
+  oldTime = time;
 
-              if (poissonInterarrivalTime > (time2 - time) || poissonInterarrivalTime.IsNegative ())
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When defining a poisson process, the interarrival time must be positive and not be larger than the difference between the start and end time of the process.");
-                }
-            }
-        }
-      else
-        {
-          int32_t eventTime;
-          bool dummy;
-          ParseVideoTime (lineBuffer, eventTime, dummy, currentLine);
+  // <-- Step 1: Process the time of the event
 
-          time = MilliSeconds (eventTime);
-          time2 = time;
+  // Step 2: Store the event; the rest of the line is the command, which is interpreted when the event is scheduled
+  event.m_line = currentLine;
+  event.m_timing = poisson ? EVENT_POISSON : (time == time2 ? EVENT_AT : EVENT_RANGE);
+  event.m_time = time.GetMilliSeconds ();
+  event.m_time2 = time2.GetMilliSeconds ();
+  event.m_interarrival = poissonInterarrivalTime.GetMilliSeconds ();
+  event.m_command.clear ();
+  std::getline (lineBuffer, event.m_command);
 
-          if (time < oldTime)
-            {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: You are scheduling an event that takes place before already scheduled events. That's not allowed.");
-            }
-        }
+  return true;
+}
 
-      oldTime = time;
+void Story::ScheduleStoryEvent (const StoryEvent& event, uint32_t simulationDuration)
+{
+  std::istringstream lineBuffer (event.m_command);
+  std::string buffer, buffer2, buffer3;
 
-      if (time.GetMilliSeconds () == time2.GetMilliSeconds ())
-        {
-          std::cout << "At " << time.GetMilliSeconds () << " msec:" << std::endl;
-        }
-      else if (!poisson)
-        {
-          std::cout << "Between " << time.GetMilliSeconds () << " and " << time2.GetMilliSeconds () << " msec at a random point in time: " << std::endl;
-        }
-      else if (poisson)
-        {
-          std::cout << "Between " << time.GetMilliSeconds () << " and " << time2.GetMilliSeconds () << " msec following a poisson process with an interarrival time of " << poissonInterarrivalTime.GetMilliSeconds () << " msec: " << std::endl;
-        }
+  // Step 1: Process the time of the event -->
+
+  const uint32_t currentLine = event.m_line;
+  const bool poisson = (event.m_timing == EVENT_POISSON);
+  const Time time = MilliSeconds (event.m_time);
+  const Time time2 = MilliSeconds (event.m_time2);
+  const Time poissonInterarrivalTime = MilliSeconds (event.m_interarrival);
+
+  if (time.GetMilliSeconds () == time2.GetMilliSeconds ())
+    {
+      m_output << "At " << time.GetMilliSeconds () << " msec:" << std::endl;
+    }
+  else if (!poisson)
+    {
+      m_output << "Between " << time.GetMilliSeconds () << " and " << time2.GetMilliSeconds () << " msec at a random point in time: " << std::endl;
+    }
+  else if (poisson)
+    {
+      m_output << "Between " << time.GetMilliSeconds () << " and " << time2.GetMilliSeconds () << " msec following a poisson process with an interarrival time of " << poissonInterarrivalTime.GetMilliSeconds () << " msec: " << std::endl;
+    }
 
-      // <-- Step 1: Process the time of the event
+  // <-- Step 1: Process the time of the event
 
-      // Step 2: Process the target of the event -->
+  // Step 2: Process the target of the event -->
 
-      std::string target;
-      uint32_t clientNrStart = 0;
-      uint32_t clientNrEnd = 0;
-      bool tracker = false;
-      bool client = false;
-      bool topology = false;
-      bool simulation = false;
-      bool random = false;
-      NodeContainer affectedNodes;
+  std::string target;
+  uint32_t clientNrStart = 0;
+  uint32_t clientNrEnd = 0;
+  bool tracker = false;
+  bool client = false;
+  bool topology = false;
+  bool simulation = false;
+  bool random = false;
+  NodeContainer affectedNodes;
 
-      lineBuffer >> target;
+  lineBuffer >> target;
 
-      if (target == "simulation")
+  if (target == "simulation")
+    {
+      simulation = true;
+    }
+  if (target == "topology")
+    {
+      topology = true;
+    }
+  else if (target == "tracker")
+    {
+      tracker = true;
+    }
+  else if (target == "client")
+    {
+      client = true;
+      lineBuffer >> clientNrStart;
+      clientNrEnd = clientNrStart;
+      if (clientNrEnd > m_btNodes->GetN ())
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: A node with such an index is not available.");
+        }
+      m_output << "	For client "<< clientNrStart << " (" << m_btNodes->Get (clientNrStart - 1)->GetId () << "):" << std::endl;
+    }
+  else if (target == "clients")
+    {
+      client = true;
+      lineBuffer >> buffer;
+      if (buffer == "max")
         {
-          simulation = true;
+          clientNrStart = m_btNodes->GetN ();
         }
-      if (target == "topology")
+      else
         {
-          topology = true;
+          clientNrStart = lexical_cast<uint32_t> (buffer);
         }
-      else if (target == "tracker")
+      lineBuffer >> buffer;
+      lineBuffer >> buffer;
+      if (buffer == "max")
         {
-          tracker = true;
+          clientNrEnd = m_btNodes->GetN ();
         }
-      else if (target == "client")
+      else
         {
-          client = true;
-          lineBuffer >> clientNrStart;
-          clientNrEnd = clientNrStart;
+          clientNrEnd = lexical_cast<uint32_t> (buffer);
           if (clientNrEnd > m_btNodes->GetN ())
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: A node with such an index is not available.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: More nodes requested than available.");
             }
-          std::cout << "	For client "<< clientNrStart << " (" << m_btNodes->Get (clientNrStart - 1)->GetId () << "):" << std::endl;
         }
-      else if (target == "clients")
+      m_output << "	For clients "<< clientNrStart << " (" << m_btNodes->Get (clientNrStart - 1)->GetId () << ") - " << clientNrEnd << " (" << m_btNodes->Get (clientNrEnd - 1)->GetId () << "):" << std::endl;
+
+    }
+  else if (target == "all")
+    {
+      lineBuffer >> target;
+      if (target == "clients")
         {
           client = true;
-          lineBuffer >> buffer;
-          if (buffer == "max")
-            {
-              clientNrStart = m_btNodes->GetN ();
-            }
-          else
+          clientNrStart = 1;
+          clientNrEnd = m_btNodes->GetN ();
+        }
+      else
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"clients\" statement behind \"all\".");
+        }
+      m_output << "	For all clients:"<< std::endl;
+
+    }
+  else if (target == "random")
+    {
+      random = true;
+      lineBuffer >> buffer;
+      if (buffer != "clients")
+        {
+          client = true;
+          clientNrStart = 1;
+          clientNrEnd = lexical_cast<uint32_t> (buffer);
+          if (clientNrEnd > m_btNodes->GetN ())
             {
-              clientNrStart = lexical_cast<uint32_t> (buffer);
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: More random nodes requested than available.");
             }
           lineBuffer >> buffer;
-          lineBuffer >> buffer;
-          if (buffer == "max")
-            {
-              clientNrEnd = m_btNodes->GetN ();
-            }
-          else
+          if (buffer != "clients")
             {
-              clientNrEnd = lexical_cast<uint32_t> (buffer);
-              if (clientNrEnd > m_btNodes->GetN ())
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: More nodes requested than available.");
-                }
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Wrong format for number of random clients.");
             }
-          std::cout << "	For clients "<< clientNrStart << " (" << m_btNodes->Get (clientNrStart - 1)->GetId () << ") - " << clientNrEnd << " (" << m_btNodes->Get (clientNrEnd - 1)->GetId () << "):" << std::endl;
 
+          m_output << "	For "<< clientNrEnd << " random clients:" << std::endl;
+        }
+    }
+  else if (target == "group")
+    {
+      client = true;
+      lineBuffer >> buffer;
+      if (m_groups.find (buffer) != m_groups.end ())
+        {
+          affectedNodes = (*m_groups.find (buffer)).second;
+        }
+      else
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Cannot find group.");
         }
-      else if (target == "all")
+
+      m_output << "	For group "<< buffer << " (" << affectedNodes.GetN () << " nodes):" << std::endl;
+    }
+
+  if (client)
+    {
+      if (random)
         {
-          lineBuffer >> target;
-          if (target == "clients")
+          std::set<uint32_t> indices = Utilities::GetRandomSampleF2 (m_btNodes->GetN (), clientNrEnd);
+
+          for (std::set<uint32_t>::const_iterator indexIt = indices.begin (); indexIt != indices.end (); ++indexIt)
             {
-              client = true;
-              clientNrStart = 1;
-              clientNrEnd = m_btNodes->GetN ();
+              affectedNodes.Add (m_btNodes->Get ((*indexIt) - 1));
             }
-          else
+        }
+      else
+        {
+          for (uint32_t i = clientNrStart - 1; i < clientNrEnd; ++i)
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"clients\" statement behind \"all\".");
+              affectedNodes.Add (m_btNodes->Get (i));
             }
-          std::cout << "	For all clients:"<< std::endl;
-
         }
-      else if (target == "random")
+    }
+  else if (tracker)
+    {
+      affectedNodes.Add (m_btTracker->Get (0));
+    }
+  // <-- Step 2
+
+  // Step 3: Get and schedule the action to perform
+
+  lineBuffer >> buffer;
+
+  if (client)
+    {
+      if (buffer == "join")
         {
-          random = true;
           lineBuffer >> buffer;
-          if (buffer != "clients")
+          if (buffer == "group")
             {
-              client = true;
-              clientNrStart = 1;
-              clientNrEnd = lexical_cast<uint32_t> (buffer);
-              if (clientNrEnd > m_btNodes->GetN ())
+              lineBuffer >> buffer;
+
+              if (m_groups.find (buffer) == m_groups.end ())
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: More random nodes requested than available.");
+                  m_groups[buffer] = affectedNodes;
                 }
-              lineBuffer >> buffer;
-              if (buffer != "clients")
+              else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Wrong format for number of random clients.");
+                  m_groups[buffer].Add (affectedNodes);
                 }
 
-              std::cout << "	For "<< clientNrEnd << " random clients:" << std::endl;
+              m_output << "		Nodes joined group "<< buffer << " which now has " << m_groups[buffer].GetN () << " nodes" << std::endl;
+            }
+          else
+            {
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to join right now...");
             }
         }
-      else if (target == "group")
+
+      else if (buffer == "leave")
         {
-          client = true;
           lineBuffer >> buffer;
-          if (m_groups.find (buffer) != m_groups.end ())
+
+          if (buffer == "group")
+            {
+              lineBuffer >> buffer;
+
+              if (m_groups.find (buffer) == m_groups.end ())
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Group to leave does not exist!");
+                }
+              else
+                {
+                  NodeContainer newNodes;
+                  NodeContainer toDeleteFrom = (*m_groups.find (buffer)).second;
+                  for (NodeContainer::Iterator it = toDeleteFrom.Begin (); it != toDeleteFrom.End (); ++it)
+                    {
+                      bool inNodeContainer = false;
+                      for (NodeContainer::Iterator it2 = affectedNodes.Begin (); it2 != affectedNodes.End (); ++it2)
+                        {
+                          if ((*it2) == (*it))
+                            {
+                              inNodeContainer = true;
+                            }
+                        }
+                      if (!inNodeContainer)
+                        {
+                          newNodes.Add (*it);
+                        }
+                    }
+                  m_groups[buffer] = newNodes;
+
+                  m_output << "		Scheduled leaving of group "<< buffer << " which now has " << m_groups[buffer].GetN () << " nodes" << std::endl;
+                }
+            }
+          else if (buffer == "cloud")
             {
-              affectedNodes = (*m_groups.find (buffer)).second;
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::DisconnectFromCloud, BitTorrentVideoClient)
+              m_output << "		Scheduled leaving of cloud"<< std::endl;
             }
           else
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Cannot find group.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to leave right now...");
             }
-
-          std::cout << "	For group "<< buffer << " (" << affectedNodes.GetN () << " nodes):" << std::endl;
         }
-
-      if (client)
+      else if (buffer == "clean")
         {
-          if (random)
+          lineBuffer >> buffer;
+
+          if (buffer == "group")
             {
-              std::set<uint32_t> indices = Utilities::GetRandomSampleF2 (m_btNodes->GetN (), clientNrEnd);
+              lineBuffer >> buffer;
 
-              for (std::set<uint32_t>::const_iterator indexIt = indices.begin (); indexIt != indices.end (); ++indexIt)
+              if (m_groups.find (buffer) == m_groups.end ())
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Group to clean does not exist!");
+                }
+              else
                 {
-                  affectedNodes.Add (m_btNodes->Get ((*indexIt) - 1));
+                  NodeContainer emptyGroup;
+                  m_groups[buffer] = emptyGroup;
+                  m_output << "		Cleared group "<< buffer << std::endl;
                 }
             }
           else
             {
-              for (uint32_t i = clientNrStart - 1; i < clientNrEnd; ++i)
-                {
-                  affectedNodes.Add (m_btNodes->Get (i));
-                }
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to clean right now...");
             }
         }
-      else if (tracker)
+      else if (buffer == "init")
         {
-          affectedNodes.Add (m_btTracker->Get (0));
+          if (client)
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::StartApplication, BitTorrentVideoClient)
+            }
+          else
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentTracker::StartApplication, BitTorrentTracker)
+            }
+          m_output << "		Scheduled init."<< std::endl;
         }
-      // <-- Step 2
-
-      // Step 3: Get and schedule the action to perform
-
-      lineBuffer >> buffer;
-
-      if (client)
+      else if (buffer == "set")
         {
-          if (buffer == "join")
+          lineBuffer >> buffer;
+
+          if (buffer == "peers")
             {
+              uint32_t numwant;
               lineBuffer >> buffer;
-              if (buffer == "group")
+              if (buffer == "all")
                 {
-                  lineBuffer >> buffer;
-
-                  if (m_groups.find (buffer) == m_groups.end ())
-                    {
-                      m_groups[buffer] = affectedNodes;
-                    }
-                  else
-                    {
-                      m_groups[buffer].Add (affectedNodes);
-                    }
-
-                  std::cout << "		Nodes joined group "<< buffer << " which now has " << m_groups[buffer].GetN () << " nodes" << std::endl;
+                  numwant = m_btNodes->GetN ();
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to join right now...");
+                  numwant = lexical_cast<uint32_t> (buffer);
                 }
-            }
 
-          else if (buffer == "leave")
+              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetDesiredPeers, BitTorrentVideoClient, numwant)
+
+              m_output << "		Set desired peers to "<< numwant << std::endl;
+            }
+          else if (buffer == "max")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "group")
+              if (buffer == "peers")
                 {
+                  uint32_t numwant;
+
                   lineBuffer >> buffer;
 
-                  if (m_groups.find (buffer) == m_groups.end ())
+                  if (buffer == "all")
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Group to leave does not exist!");
+                      numwant = m_btNodes->GetN ();
                     }
                   else
                     {
-                      NodeContainer newNodes;
-                      NodeContainer toDeleteFrom = (*m_groups.find (buffer)).second;
-                      for (NodeContainer::Iterator it = toDeleteFrom.Begin (); it != toDeleteFrom.End (); ++it)
-                        {
-                          bool inNodeContainer = false;
-                          for (NodeContainer::Iterator it2 = affectedNodes.Begin (); it2 != affectedNodes.End (); ++it2)
-                            {
-                              if ((*it2) == (*it))
-                                {
-                                  inNodeContainer = true;
-                                }
-                            }
-                          if (!inNodeContainer)
-                            {
-                              newNodes.Add (*it);
-                            }
-                        }
-                      m_groups[buffer] = newNodes;
-
-                      std::cout << "		Scheduled leaving of group "<< buffer << " which now has " << m_groups[buffer].GetN () << " nodes" << std::endl;
+                      numwant = lexical_cast<uint32_t> (buffer);
                     }
-                }
-              else if (buffer == "cloud")
-                {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::DisconnectFromCloud, BitTorrentVideoClient)
-                  std::cout << "		Scheduled leaving of cloud"<< std::endl;
-                }
-              else
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to leave right now...");
+
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxPeers, BitTorrentVideoClient, numwant)
+
+                  m_output << "		Set maximum allowed peers to "<< buffer << std::endl;
                 }
             }
-          else if (buffer == "clean")
+          else if (buffer == "unchoked")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "group")
+              if (buffer == "peers")
                 {
+                  uint16_t concurrentUnchokes;
+
                   lineBuffer >> buffer;
 
-                  if (m_groups.find (buffer) == m_groups.end ())
+                  if (buffer == "all")
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Group to clean does not exist!");
+                      concurrentUnchokes = 0;
                     }
                   else
                     {
-                      NodeContainer emptyGroup;
-                      m_groups[buffer] = emptyGroup;
-                      std::cout << "		Cleared group "<< buffer << std::endl;
+                      concurrentUnchokes = lexical_cast<uint16_t> (buffer);
                     }
-                }
-              else
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to clean right now...");
+
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxUnchokedPeers, BitTorrentVideoClient, concurrentUnchokes)
+
+                  m_output << "		Set maximum unchoked peers to "<< buffer << std::endl;
                 }
             }
-          else if (buffer == "init")
+          else if (buffer == "autoconnect")
             {
-              if (client)
+              lineBuffer >> buffer;
+
+              bool autoConnect = (buffer == "1");
+
+              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoConnect, BitTorrentVideoClient, autoConnect)
+              m_output << "		Scheduled autoconnect ("<< (buffer == "1") << ")." << std::endl;
+            }
+          else if (buffer == "autoplay")
+            {
+              lineBuffer >> buffer;
+
+              bool autoPlay = false, autoPlayFromRight = false;
+
+              if (buffer == "from")
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::StartApplication, BitTorrentVideoClient)
+                  lineBuffer >> buffer;
+                  if (buffer == "right")
+                    {
+                      lineBuffer >> buffer;
+                      autoPlayFromRight = (buffer == "1");
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlayFromRight, BitTorrentVideoClient, autoPlayFromRight)
+                      if (autoPlayFromRight)
+                        {
+                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlay, BitTorrentVideoClient, autoPlayFromRight)
+                          m_output << "		Scheduled playback from the rightmost continously reachable position from the beginning when the client starts ("<< (buffer == "1") << ")." << std::endl;
+                        }
+                    }
+                  else
+                    {
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"right\" statement after \"set autoplay from\".");
+                    }
+                }
+              else if (buffer == "1" || buffer == "0")
+                {
+                  autoPlay = (buffer == "1");
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlay, BitTorrentVideoClient, autoPlay)
+                  m_output << "		Scheduled automatic start of playback when the client starts ("<< (buffer == "1") << ")." << std::endl;
                 }
               else
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentTracker::StartApplication, BitTorrentTracker)
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that \"autoplay\" option.");
                 }
-              std::cout << "		Scheduled init."<< std::endl;
             }
-          else if (buffer == "set")
+          else if (buffer == "leave")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "peers")
+              if (buffer == "after")
                 {
-                  uint32_t numwant;
                   lineBuffer >> buffer;
-                  if (buffer == "all")
+
+                  if (buffer == "completed")
                     {
-                      numwant = m_btNodes->GetN ();
+                      int32_t seedingTime;
+                      bool voidDummy;
+                      ParseVideoTime (lineBuffer, seedingTime, voidDummy, currentLine);
+
+                      CALL_FUNCTION (SetSeedingDuration, BitTorrentVideoClient, MilliSeconds (seedingTime))
                     }
                   else
                     {
-                      numwant = lexical_cast<uint32_t> (buffer);
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know after what I should leave.");
                     }
 
-                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetDesiredPeers, BitTorrentVideoClient, numwant)
-
-                  std::cout << "		Set desired peers to "<< numwant << std::endl;
                 }
-              else if (buffer == "max")
+              else
                 {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "peers")
-                    {
-                      uint32_t numwant;
-
-                      lineBuffer >> buffer;
-
-                      if (buffer == "all")
-                        {
-                          numwant = m_btNodes->GetN ();
-                        }
-                      else
-                        {
-                          numwant = lexical_cast<uint32_t> (buffer);
-                        }
-
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxPeers, BitTorrentVideoClient, numwant)
-
-                      std::cout << "		Set maximum allowed peers to "<< buffer << std::endl;
-                    }
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only leave \"after\" something happens.");
                 }
-              else if (buffer == "unchoked")
+            }
+          else if (buffer == "strategy" || buffer == "protocol")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "options")
                 {
-                  lineBuffer >> buffer;
+                  std::map<std::string, std::string> arguments;
 
-                  if (buffer == "peers")
+                  while (!lineBuffer.eof ())
                     {
-                      uint16_t concurrentUnchokes;
-
                       lineBuffer >> buffer;
+                      size_t equalSignPos = buffer.find ('=');
+                      arguments[buffer.substr (0, equalSignPos)] = buffer.substr (equalSignPos + 1, buffer.size () - equalSignPos - 1);
+                    }
 
-                      if (buffer == "all")
-                        {
-                          concurrentUnchokes = 0;
-                        }
-                      else
-                        {
-                          concurrentUnchokes = lexical_cast<uint16_t> (buffer);
-                        }
-
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxUnchokedPeers, BitTorrentVideoClient, concurrentUnchokes)
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetStrategyOptions, BitTorrentVideoClient, arguments)
 
-                      std::cout << "		Set maximum unchoked peers to "<< buffer << std::endl;
-                    }
+                  m_output << "		Set strategy options to set of "<< arguments.size () << " options." << std::endl;
                 }
-              else if (buffer == "autoconnect")
+              else
                 {
                   lineBuffer >> buffer;
 
-                  bool autoConnect = (buffer == "1");
+                  CALL_FUNCTION (SetProtocol, BitTorrentVideoClient, buffer)
 
-                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoConnect, BitTorrentVideoClient, autoConnect)
-                  std::cout << "		Scheduled autoconnect ("<< (buffer == "1") << ")." << std::endl;
+                  m_output << "		Set protocol to "<< buffer << std::endl;
                 }
-              else if (buffer == "autoplay")
+            }
+          else if (buffer == "initial")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "bitfield")
                 {
                   lineBuffer >> buffer;
 
-                  bool autoPlay = false, autoPlayFromRight = false;
-
-                  if (buffer == "from")
+                  if (buffer == "empty")
                     {
-                      lineBuffer >> buffer;
-                      if (buffer == "right")
-                        {
-                          lineBuffer >> buffer;
-                          autoPlayFromRight = (buffer == "1");
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlayFromRight, BitTorrentVideoClient, autoPlayFromRight)
-                          if (autoPlayFromRight)
-                            {
-                              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlay, BitTorrentVideoClient, autoPlayFromRight)
-                              std::cout << "		Scheduled playback from the rightmost continously reachable position from the beginning when the client starts ("<< (buffer == "1") << ")." << std::endl;
-                            }
-                        }
-                      else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"right\" statement after \"set autoplay from\".");
-                        }
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "empty")
+                      m_output << "		Set initial bitfield to empty."<< std::endl;
                     }
-                  else if (buffer == "1" || buffer == "0")
+                  else if (buffer == "full")
                     {
-                      autoPlay = (buffer == "1");
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetAutoPlay, BitTorrentVideoClient, autoPlay)
-                      std::cout << "		Scheduled automatic start of playback when the client starts ("<< (buffer == "1") << ")." << std::endl;
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "full")
+                      m_output << "		Set initial bitfield to full."<< std::endl;
                     }
-                  else
+			//KIRIL - for partially complete file at start
+                  else if (buffer == "part")
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that \"autoplay\" option.");
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "part")
+                      m_output << "		Set initial bitfield to full."<< std::endl;
                     }
-                }
-              else if (buffer == "leave")
-                {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "after")
+                  else if (buffer == "gaussian")
                     {
                       lineBuffer >> buffer;
 
-                      if (buffer == "completed")
-                        {
-                          int32_t seedingTime;
-                          bool voidDummy;
-                          ParseVideoTime (lineBuffer, seedingTime, voidDummy, currentLine);
-
-                          CALL_FUNCTION (SetSeedingDuration, BitTorrentVideoClient, MilliSeconds (seedingTime))
-                        }
-                      else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know after what I should leave.");
-                        }
-
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only leave \"after\" something happens.");
-                    }
-                }
-              else if (buffer == "strategy" || buffer == "protocol")
-                {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "options")
-                    {
-                      std::map<std::string, std::string> arguments;
-
-                      while (!lineBuffer.eof ())
+                      if (buffer != "mean")
                         {
-                          lineBuffer >> buffer;
-                          size_t equalSignPos = buffer.find ('=');
-                          arguments[buffer.substr (0, equalSignPos)] = buffer.substr (equalSignPos + 1, buffer.size () - equalSignPos - 1);
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: You must first define the mean (\"mean\") of the gaussian distribution.");
                         }
 
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetStrategyOptions, BitTorrentVideoClient, arguments)
-
-                      std::cout << "		Set strategy options to set of "<< arguments.size () << " options." << std::endl;
-                    }
-                  else
-                    {
                       lineBuffer >> buffer;
 
-                      CALL_FUNCTION (SetProtocol, BitTorrentVideoClient, buffer)
-
-                      std::cout << "		Set protocol to "<< buffer << std::endl;
-                    }
-                }
-              else if (buffer == "initial")
-                {
-                  lineBuffer >> buffer;
+                      double mean = lexical_cast<double> (buffer);
 
-                  if (buffer == "bitfield")
-                    {
                       lineBuffer >> buffer;
 
-                      if (buffer == "empty")
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "empty")
-                          std::cout << "		Set initial bitfield to empty."<< std::endl;
-                        }
-                      else if (buffer == "full")
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "full")
-                          std::cout << "		Set initial bitfield to full."<< std::endl;
-                        }
-			//KIRIL - for partially complete file at start
-                      else if (buffer == "part")
+                      if (buffer != "stddev")
                         {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "part")
-                          std::cout << "		Set initial bitfield to full."<< std::endl;
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: After the mean (\"mean\") you must define the standard deviation (\"stddev\") of the gaussian distribution. (NOT the variance!)");
                         }
-                      else if (buffer == "gaussian")
-                        {
-                          lineBuffer >> buffer;
-
-                          if (buffer != "mean")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: You must first define the mean (\"mean\") of the gaussian distribution.");
-                            }
-
-                          lineBuffer >> buffer;
 
-                          double mean = lexical_cast<double> (buffer);
+                      lineBuffer >> buffer;
 
-                          lineBuffer >> buffer;
+                      double stdDev = lexical_cast<double> (buffer);
 
-                          if (buffer != "stddev")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: After the mean (\"mean\") you must define the standard deviation (\"stddev\") of the gaussian distribution. (NOT the variance!)");
-                            }
+                      bool randomTail = false;
 
+                      if (!lineBuffer.eof ())
+                        {
                           lineBuffer >> buffer;
 
-                          double stdDev = lexical_cast<double> (buffer);
-
-                          bool randomTail = false;
-
-                          if (!lineBuffer.eof ())
+                          if (buffer == "random")
                             {
                               lineBuffer >> buffer;
 
-                              if (buffer == "random")
+                              if (buffer == "tail")
                                 {
-                                  lineBuffer >> buffer;
-
-                                  if (buffer == "tail")
-                                    {
-                                      randomTail = true;
-                                    }
-                                  else
-                                    {
-                                      NS_ABORT_MSG ("[line " << currentLine << "] Error: The gaussian distribution only allows a \"random tail\".");
-                                    }
+                                  randomTail = true;
                                 }
                               else
                                 {
                                   NS_ABORT_MSG ("[line " << currentLine << "] Error: The gaussian distribution only allows a \"random tail\".");
                                 }
                             }
+                          else
+                            {
+                              NS_ABORT_MSG ("[line " << currentLine << "] Error: The gaussian distribution only allows a \"random tail\".");
+                            }
+                        }
 
-                          NormalVariable gaussians (mean, stdDev * stdDev);
+                      NormalVariable gaussians (mean, stdDev * stdDev);
 
-                          for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it)
+                      for (NodeContainer::Iterator it = affectedNodes.Begin (); it != affectedNodes.End (); ++it)
+                        {
+                          double randomValue = -1;
+                          while (randomValue < 0 || randomValue > 1)
                             {
-                              double randomValue = -1;
-                              while (randomValue < 0 || randomValue > 1)
-                                {
-                                  randomValue = gaussians.GetValue ();
-                                }
+                              randomValue = gaussians.GetValue ();
+                            }
 
-                              if (!randomTail)
-                                {
-                                  Simulator::Schedule (time, &BitTorrentVideoClient::SetInitialBitfield, dynamic_cast<BitTorrentVideoClient*> (PeekPointer ((*it)->GetApplication (0))), "p" + lexical_cast<std::string> (randomValue));
-                                  std::cout << "		Node "<< (*it)->GetId () << " has " << randomValue * 100 << "% bitfield filling from the beginning." << std::endl;
-                                }
-                              else
-                                {
-                                  Simulator::Schedule (time, &BitTorrentVideoClient::SetInitialBitfield, dynamic_cast<BitTorrentVideoClient*> (PeekPointer ((*it)->GetApplication (0))), "q" + lexical_cast<std::string> (randomValue));
-                                  std::cout << "		Node "<< (*it)->GetId () << " has " << randomValue * 100 << "% bitfield filling from the beginning, with a random tail for the following pieces." << std::endl;
-                                }
+                          if (!randomTail)
+                            {
+                              Simulator::Schedule (time, &BitTorrentVideoClient::SetInitialBitfield, dynamic_cast<BitTorrentVideoClient*> (PeekPointer ((*it)->GetApplication (0))), "p" + lexical_cast<std::string> (randomValue));
+                              m_output << "		Node "<< (*it)->GetId () << " has " << randomValue * 100 << "% bitfield filling from the beginning." << std::endl;
+                            }
+                          else
+                            {
+                              Simulator::Schedule (time, &BitTorrentVideoClient::SetInitialBitfield, dynamic_cast<BitTorrentVideoClient*> (PeekPointer ((*it)->GetApplication (0))), "q" + lexical_cast<std::string> (randomValue));
+                              m_output << "		Node "<< (*it)->GetId () << " has " << randomValue * 100 << "% bitfield filling from the beginning, with a random tail for the following pieces." << std::endl;
                             }
                         }
-                      else if (buffer == "from")
+                    }
+                  else if (buffer == "from")
+                    {
+                      lineBuffer >> buffer;
+
+                      if (buffer != "left")
                         {
-                          lineBuffer >> buffer;
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"left\" after \"from\".");
+                        }
 
-                          if (buffer != "left")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"left\" after \"from\".");
-                            }
+                      lineBuffer >> buffer;
 
-                          lineBuffer >> buffer;
+                      double percentage = lexical_cast<double> (buffer);
 
-                          double percentage = lexical_cast<double> (buffer);
+                      if (percentage < 0 || percentage > 1)
+                        {
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: The filling percentage must be given as a value in the range [0.0, 1.0].");
+                        }
 
-                          if (percentage < 0 || percentage > 1)
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: The filling percentage must be given as a value in the range [0.0, 1.0].");
-                            }
+                      bool randomTail = false;
 
-                          bool randomTail = false;
+                      if (!lineBuffer.eof ())
+                        {
+                          lineBuffer >> buffer;
 
-                          if (!lineBuffer.eof ())
+                          if (buffer == "random")
                             {
                               lineBuffer >> buffer;
 
-                              if (buffer == "random")
+                              if (buffer == "tail")
                                 {
-                                  lineBuffer >> buffer;
-
-                                  if (buffer == "tail")
-                                    {
-                                      randomTail = true;
-                                    }
-                                  else
-                                    {
-                                      NS_ABORT_MSG ("[line " << currentLine << "] Error: A filling from the left only allows a \"random tail\".");
-                                    }
+                                  randomTail = true;
                                 }
                               else
                                 {
                                   NS_ABORT_MSG ("[line " << currentLine << "] Error: A filling from the left only allows a \"random tail\".");
                                 }
                             }
-
-                          if (!randomTail)
-                            {
-                              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "p" + lexical_cast<std::string> (percentage))
-                              std::cout << "		Set initial bitfield to "<< percentage * 100 << "% filling from the beginning." << std::endl;
-                            }
                           else
                             {
-                              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "q" + lexical_cast<std::string> (percentage))
-                              std::cout << "		Set initial bitfield to "<< percentage * 100 << "% filling from the beginning, with a random tail for the following pieces." << std::endl;
+                              NS_ABORT_MSG ("[line " << currentLine << "] Error: A filling from the left only allows a \"random tail\".");
                             }
                         }
-                      else if (buffer == "debug")
+
+                      if (!randomTail)
                         {
-                          lineBuffer >> buffer;
-                          uint32_t bitfieldIndex = lexical_cast<uint32_t> (buffer);
-                          lineBuffer >> buffer;
-                          uint32_t value = lexical_cast<uint32_t> (buffer);
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::ManipulateInitialBitfield, BitTorrentVideoClient, bitfieldIndex, value)
-                          std::cout << "		Set bitfield index "<< bitfieldIndex << " to value " << value << " for debugging purposes." << std::endl;
+                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "p" + lexical_cast<std::string> (percentage))
+                          m_output << "		Set initial bitfield to "<< percentage * 100 << "% filling from the beginning." << std::endl;
                         }
                       else
                         {
-                          UniformVariable uv;
-                          
-                          buffer = lexical_cast<std::string> (uv.GetValue (0, 1) );
-                          
-                          if(!lineBuffer.eof ())
-                            lineBuffer >> buffer;
-                            
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "random " + buffer)
-                          
-                          std::cout << "		Set initial bitfield to random, percentage: " << buffer << "." << std::endl;
+                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "q" + lexical_cast<std::string> (percentage))
+                          m_output << "		Set initial bitfield to "<< percentage * 100 << "% filling from the beginning, with a random tail for the following pieces." << std::endl;
                         }
                     }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what initial thing to set for peers.");
-                    }
-                }
-              else if (buffer == "block")
-                {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "size")
+                  else if (buffer == "debug")
                     {
                       lineBuffer >> buffer;
-
-                      bool send = false;
-                      if (buffer == "send")
-                        {
-                          send = true;
-                        }
-                      else if (buffer != "request")
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for block sizes.");
-                        }
-
-                      uint32_t blockSize;
+                      uint32_t bitfieldIndex = lexical_cast<uint32_t> (buffer);
                       lineBuffer >> buffer;
-                      blockSize = lexical_cast<uint32_t> (buffer);
-
-                      if (send)
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetSendBlockSize, BitTorrentVideoClient, blockSize)
-                          std::cout << "		Set transmission block size to "<< blockSize << " bytes." << std::endl;
-                        }
-                      else
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetRequestBlockSize, BitTorrentVideoClient, blockSize)
-                          std::cout << "		Set request block size to "<< blockSize << " bytes." << std::endl;
-                        }
+                      uint32_t value = lexical_cast<uint32_t> (buffer);
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::ManipulateInitialBitfield, BitTorrentVideoClient, bitfieldIndex, value)
+                      m_output << "		Set bitfield index "<< bitfieldIndex << " to value " << value << " for debugging purposes." << std::endl;
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for block requests.");
+                      UniformVariable uv;
+                      
+                      buffer = lexical_cast<std::string> (uv.GetValue (0, 1) );
+                      
+                      if(!lineBuffer.eof ())
+                        lineBuffer >> buffer;
+                        
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetInitialBitfield, BitTorrentVideoClient, "random " + buffer)
+                      
+                      m_output << "		Set initial bitfield to random, percentage: " << buffer << "." << std::endl;
                     }
                 }
-              else if (buffer == "piece")
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what initial thing to set for peers.");
+                }
+            }
+          else if (buffer == "block")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "size")
                 {
                   lineBuffer >> buffer;
 
-                  if (buffer == "timeout")
+                  bool send = false;
+                  if (buffer == "send")
                     {
-                      int32_t blockTimeout;
-                      bool voidDummy;
-                      ParseVideoTime (lineBuffer, blockTimeout, voidDummy, currentLine);
-
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPieceTimeout, BitTorrentVideoClient, MilliSeconds (blockTimeout))
-                      std::cout << "		Set piece timeout to "<< blockTimeout << " milliseconds." << std::endl;
+                      send = true;
                     }
-                  else if (buffer == "max")
+                  else if (buffer != "request")
                     {
-                      lineBuffer >> buffer;
-
-                      if (buffer == "requests")
-                        {
-                          lineBuffer >> buffer;
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for block sizes.");
+                    }
 
-                          uint32_t maxPieceRequests;
-                          maxPieceRequests = lexical_cast<uint32_t> (buffer);
+                  uint32_t blockSize;
+                  lineBuffer >> buffer;
+                  blockSize = lexical_cast<uint32_t> (buffer);
 
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxRequestsPerPiece, BitTorrentVideoClient, maxPieceRequests)
-                          std::cout << "		Set number of maximum concurrent requests per piece to "<< maxPieceRequests << "." << std::endl;
-                        }
-                      else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what max thing to set for piece requests.");
-                        }
+                  if (send)
+                    {
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetSendBlockSize, BitTorrentVideoClient, blockSize)
+                      m_output << "		Set transmission block size to "<< blockSize << " bytes." << std::endl;
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for piece requests.");
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetRequestBlockSize, BitTorrentVideoClient, blockSize)
+                      m_output << "		Set request block size to "<< blockSize << " bytes." << std::endl;
                     }
                 }
-              else if (buffer == "concurrent")
+              else
                 {
-                  lineBuffer >> buffer;
-
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for block requests.");
+                }
+            }
+          else if (buffer == "piece")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "timeout")
+                {
+                  int32_t blockTimeout;
+                  bool voidDummy;
+                  ParseVideoTime (lineBuffer, blockTimeout, voidDummy, currentLine);
+
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPieceTimeout, BitTorrentVideoClient, MilliSeconds (blockTimeout))
+                  m_output << "		Set piece timeout to "<< blockTimeout << " milliseconds." << std::endl;
+                }
+              else if (buffer == "max")
+                {
+                  lineBuffer >> buffer;
+
                   if (buffer == "requests")
                     {
                       lineBuffer >> buffer;
 
-                      uint32_t maxPeerRequests;
-                      maxPeerRequests = lexical_cast<uint32_t> (buffer);
+                      uint32_t maxPieceRequests;
+                      maxPieceRequests = lexical_cast<uint32_t> (buffer);
 
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxRequestsPerPeer, BitTorrentVideoClient, maxPeerRequests)
-                      std::cout << "		Set number of maximum concurrent requests per peer (in pieces) to "<< maxPeerRequests << "." << std::endl;
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxRequestsPerPiece, BitTorrentVideoClient, maxPieceRequests)
+                      m_output << "		Set number of maximum concurrent requests per piece to "<< maxPieceRequests << "." << std::endl;
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for concurrent things.");
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what max thing to set for piece requests.");
                     }
                 }
-              else if (buffer == "video")
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for piece requests.");
+                }
+            }
+          else if (buffer == "concurrent")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "requests")
+                {
+                  lineBuffer >> buffer;
+
+                  uint32_t maxPeerRequests;
+                  maxPeerRequests = lexical_cast<uint32_t> (buffer);
+
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetMaxRequestsPerPeer, BitTorrentVideoClient, maxPeerRequests)
+                  m_output << "		Set number of maximum concurrent requests per peer (in pieces) to "<< maxPeerRequests << "." << std::endl;
+                }
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for concurrent things.");
+                }
+            }
+          else if (buffer == "video")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "prebuffering")
+                {
+                  int32_t preBufferingTime;
+                  bool voidDummy;
+                  ParseVideoTime (lineBuffer, preBufferingTime, voidDummy, currentLine);
+
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPreBufferingTime, BitTorrentVideoClient, MilliSeconds (preBufferingTime))
+
+                  m_output << "		Set pre-buffering time to "<< preBufferingTime << " milliseconds." << std::endl;
+                }
+              else if (buffer == "faststart")
                 {
                   lineBuffer >> buffer;
 
-                  if (buffer == "prebuffering")
+                  if (buffer == "active")
                     {
-                      int32_t preBufferingTime;
-                      bool voidDummy;
-                      ParseVideoTime (lineBuffer, preBufferingTime, voidDummy, currentLine);
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetFastStart, BitTorrentVideoClient, true)
 
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPreBufferingTime, BitTorrentVideoClient, MilliSeconds (preBufferingTime))
+                      m_output << "		Set pre-buffering to stripe the needed pieces across all peers (fast start)."<< std::endl;
+                    }
+                  else if (buffer == "inactive")
+                    {
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetFastStart, BitTorrentVideoClient, false)
 
-                      std::cout << "		Set pre-buffering time to "<< preBufferingTime << " milliseconds." << std::endl;
+                      m_output << "		Set pre-buffering to request the needed pieces like any other pieces."<< std::endl;
                     }
-                  else if (buffer == "skip")
+                  else
                     {
-                      lineBuffer >> buffer;
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Fast start can only be set active or inactive.");
+                    }
+                }
+              else if (buffer == "watermarks")
+                {
+                  int32_t lowWatermark;
+                  int32_t highWatermark;
+                  bool voidDummy;
+                  ParseVideoTime (lineBuffer, lowWatermark, voidDummy, currentLine);
+                  ParseVideoTime (lineBuffer, highWatermark, voidDummy, currentLine);
 
-                      if (buffer == "active")
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPiecesMissable, BitTorrentVideoClient, true)
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetBufferWatermarks, BitTorrentVideoClient, MilliSeconds (lowWatermark), MilliSeconds (highWatermark))
 
-                          std::cout << "		Set pieces missable during playback, subject to the further settings (\"tolerance\" and \"afterwards\")."<< std::endl;
+                  m_output << "		Set buffer watermarks to "<< lowWatermark << " (low) and " << highWatermark << " (high) milliseconds." << std::endl;
+                }
+              else if (buffer == "skip")
+                {
+                  lineBuffer >> buffer;
 
-                        }
-                      else if (buffer == "inactive")
-                        {
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPiecesMissable, BitTorrentVideoClient, false)
+                  if (buffer == "active")
+                    {
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPiecesMissable, BitTorrentVideoClient, true)
 
-                          std::cout << "		Set pieces missable during playback, subject to the further settings (\"tolerance\" and \"afterwards\")."<< std::endl;
-                        }
-                      else if (buffer == "tolerance")
-                        {
-                          int32_t skipTolerance;
-                          bool voidDummy;
-                          ParseVideoTime (lineBuffer, skipTolerance, voidDummy, currentLine);
+                      m_output << "		Set pieces missable during playback, subject to the further settings (\"tolerance\" and \"afterwards\")."<< std::endl;
 
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetSkipTolerance, BitTorrentVideoClient, MilliSeconds (skipTolerance))
+                    }
+                  else if (buffer == "inactive")
+                    {
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPiecesMissable, BitTorrentVideoClient, false)
 
-                          std::cout << "		Set maximum tolerance for missing pieces to skip before onset of a buffering period to "<< skipTolerance << " milliseconds." << std::endl;
-                        }
-                      else if (buffer == "afterwards")
-                        {
-                          int32_t skipTolerance;
-                          bool voidDummy;
-                          ParseVideoTime (lineBuffer, skipTolerance, voidDummy, currentLine);
+                      m_output << "		Set pieces missable during playback, subject to the further settings (\"tolerance\" and \"afterwards\")."<< std::endl;
+                    }
+                  else if (buffer == "tolerance")
+                    {
+                      int32_t skipTolerance;
+                      bool voidDummy;
+                      ParseVideoTime (lineBuffer, skipTolerance, voidDummy, currentLine);
 
-                          SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetRequiredContinousPlaybackAfterSkip, BitTorrentVideoClient, MilliSeconds (skipTolerance))
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetSkipTolerance, BitTorrentVideoClient, MilliSeconds (skipTolerance))
 
-                          std::cout << "		Set minimum length of required uninterrupted possible playback after a buffering period because of missing pieces to "<< skipTolerance << " milliseconds." << std::endl;
-                        }
+                      m_output << "		Set maximum tolerance for missing pieces to skip before onset of a buffering period to "<< skipTolerance << " milliseconds." << std::endl;
                     }
-                  else
+                  else if (buffer == "afterwards")
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the video plaback.");
+                      int32_t skipTolerance;
+                      bool voidDummy;
+                      ParseVideoTime (lineBuffer, skipTolerance, voidDummy, currentLine);
+
+                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetRequiredContinousPlaybackAfterSkip, BitTorrentVideoClient, MilliSeconds (skipTolerance))
+
+                      m_output << "		Set minimum length of required uninterrupted possible playback after a buffering period because of missing pieces to "<< skipTolerance << " milliseconds." << std::endl;
                     }
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the client.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the video plaback.");
                 }
             }
-          else if (buffer == "connect")
+          else
             {
-              uint32_t connectCount;
-              lineBuffer >> buffer;
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the client.");
+            }
+        }
+      else if (buffer == "connect")
+        {
+          uint32_t connectCount;
+          lineBuffer >> buffer;
 
-              if (buffer == "max")
-                {
-                  connectCount = 0;                       // Will force PeerConnectorStrategyBase to connect to max. numwant peers
-                }
-              else
-                {
-                  connectCount = lexical_cast<uint32_t> (buffer);
-                }
+          if (buffer == "max")
+            {
+              connectCount = 0;                       // Will force PeerConnectorStrategyBase to connect to max. numwant peers
+            }
+          else
+            {
+              connectCount = lexical_cast<uint32_t> (buffer);
+            }
 
-              SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackConnectToPeers, BitTorrentVideoClient, connectCount)
+          SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackConnectToPeers, BitTorrentVideoClient, connectCount)
 
-              if (buffer == "max")
-                {
-                  std::cout << "		Scheduled connections to the maximum possible clients."<< std::endl;
-                }
-              else
-                {
-                  std::cout << "		Scheduled connections to "<< connectCount << "clients." << std::endl;
-                }
+          if (buffer == "max")
+            {
+              m_output << "		Scheduled connections to the maximum possible clients."<< std::endl;
             }
-          else if (buffer == "directconnect")
+          else
             {
-              std::string address_str;
-              std::string port;
+              m_output << "		Scheduled connections to "<< connectCount << "clients." << std::endl;
+            }
+        }
+      else if (buffer == "directconnect")
+        {
+          std::string address_str;
+          std::string port;
 
-              lineBuffer >> buffer;
-              lineBuffer >> buffer2;
+          lineBuffer >> buffer;
+          lineBuffer >> buffer2;
 
-              if (buffer != "to" || buffer2 != "ip")
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"directconnect to\" ip <IPAddress> port <Port>.");
-                }
+          if (buffer != "to" || buffer2 != "ip")
+            {
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"directconnect to\" ip <IPAddress> port <Port>.");
+            }
 
-              lineBuffer >> address_str;
+          lineBuffer >> address_str;
 
-              lineBuffer >> buffer;
+          lineBuffer >> buffer;
 
-              if (buffer != "port")
-                {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"directconnect to\" ip <IPAddress>.");
-                }
+          if (buffer != "port")
+            {
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"directconnect to\" ip <IPAddress>.");
+            }
 
-              lineBuffer >> port;
+          lineBuffer >> port;
 
-              Ipv4Address address (address_str.c_str ());
+          Ipv4Address address (address_str.c_str ());
 
-              SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackConnectToPeer, BitTorrentVideoClient, address, lexical_cast<uint16_t> (port));
+          SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackConnectToPeer, BitTorrentVideoClient, address, lexical_cast<uint16_t> (port));
+
+          m_output << "		Scheduled connection to peer with address "<< address_str << ", port " << port << "." << std::endl;
+        }
+      else if (buffer == "disconnect")
+        {
+          int32_t disconnectCount;
+          lineBuffer >> buffer;
 
-              std::cout << "		Scheduled connection to peer with address "<< address_str << ", port " << port << "." << std::endl;
+          if (buffer == "all")
+            {
+              disconnectCount = -1;                       // TODO: Make a function that disconnects from 0 <= x <= (Connection count) peers
             }
-          else if (buffer == "disconnect")
+          else
             {
-              int32_t disconnectCount;
-              lineBuffer >> buffer;
+              disconnectCount = lexical_cast<uint32_t> (buffer);
+            }
 
-              if (buffer == "all")
+          SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackDisconnectPeers, BitTorrentVideoClient, disconnectCount)
+
+          m_output << "		Scheduled disconnection of"<< disconnectCount << "clients" << std::endl;
+
+        }
+      else if (buffer == "rejoin")
+        {
+          lineBuffer >> buffer;
+
+          if (buffer == "cloud")
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::JoinCloud, BitTorrentVideoClient)
+              m_output << "		Scheduled rejoining of cloud"<< std::endl;
+            }
+          else
+            {
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to join right now...");
+            }
+        }
+      else if (buffer == "video")
+        {
+          lineBuffer >> buffer;
+
+          if (buffer == "play")
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Play, BitTorrentVideoClient)
+              m_output << "		Scheduled video play."<< std::endl;
+            }
+          else if (buffer == "pause")
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Pause, BitTorrentVideoClient)
+              m_output << "		Scheduled pausing of video if no buffering takes place at this moment."<< std::endl;
+            }
+          else if (buffer == "unpause")
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Pause, BitTorrentVideoClient)
+              m_output << "		Scheduled unpausing of video if no buffering takes place at this moment."<< std::endl;
+            }
+          else if (buffer == "stop")
+            {
+              SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Stop, BitTorrentVideoClient)
+              m_output << "		Scheduled video stop."<< std::endl;
+            }
+          else if (buffer == "ff")
+            {
+              int32_t newTime;
+              bool isRelative;
+              ParseVideoTime (lineBuffer, newTime, isRelative, currentLine);
+
+              if (isRelative)
                 {
-                  disconnectCount = -1;                       // TODO: Make a function that disconnects from 0 <= x <= (Connection count) peers
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPositionRelative, BitTorrentVideoClient, MilliSeconds (newTime))
                 }
               else
                 {
-                  disconnectCount = lexical_cast<uint32_t> (buffer);
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPosition, BitTorrentVideoClient, MilliSeconds (newTime))
                 }
 
-              SCHEDULE_CHAPTER (&BitTorrentVideoClient::TriggerCallbackDisconnectPeers, BitTorrentVideoClient, disconnectCount)
-
-              std::cout << "		Scheduled disconnection of"<< disconnectCount << "clients" << std::endl;
-
+              m_output << "		Scheduled video fast forward "<< (isRelative ? "for " : "to ") << newTime << "milliseconds" << std::endl;
             }
-          else if (buffer == "rejoin")
+          else if (buffer == "skip")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "cloud")
+              if (buffer == "left")
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::JoinCloud, BitTorrentVideoClient)
-                  std::cout << "		Scheduled rejoining of cloud"<< std::endl;
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPositionToTheRight, BitTorrentVideoClient, true)
+
+                  m_output << "		Scheduled video fast forward to rightmost continously reachable position from the beginning."<< std::endl;
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to join right now...");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to skip.");
                 }
             }
-          else if (buffer == "video")
+          else if (buffer == "buffer")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "play")
+              uint8_t bufferingType = 0;
+              if (buffer == "for")
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Play, BitTorrentVideoClient)
-                  std::cout << "		Scheduled video play."<< std::endl;
+                  bufferingType = 0;
                 }
-              else if (buffer == "pause")
+              else if (buffer == "next")
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Pause, BitTorrentVideoClient)
-                  std::cout << "		Scheduled pausing of video if no buffering takes place at this moment."<< std::endl;
+                  bufferingType = 1;
                 }
-              else if (buffer == "unpause")
+              else if (buffer == "until")
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Pause, BitTorrentVideoClient)
-                  std::cout << "		Scheduled unpausing of video if no buffering takes place at this moment."<< std::endl;
+                  bufferingType = 2;
                 }
-              else if (buffer == "stop")
+              else
                 {
-                  SCHEDULE_CHAPTER_NOARGS (&BitTorrentVideoClient::Stop, BitTorrentVideoClient)
-                  std::cout << "		Scheduled video stop."<< std::endl;
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how else to manipulate client's buffer behavior.");
                 }
-              else if (buffer == "ff")
-                {
-                  int32_t newTime;
-                  bool isRelative;
-                  ParseVideoTime (lineBuffer, newTime, isRelative, currentLine);
 
-                  if (isRelative)
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPositionRelative, BitTorrentVideoClient, MilliSeconds (newTime))
-                    }
-                  else
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPosition, BitTorrentVideoClient, MilliSeconds (newTime))
-                    }
+              int32_t bufferTime;
+              bool voidDummy;
+              ParseVideoTime (lineBuffer, bufferTime, voidDummy, currentLine);
 
-                  std::cout << "		Scheduled video fast forward "<< (isRelative ? "for " : "to ") << newTime << "milliseconds" << std::endl;
-                }
-              else if (buffer == "skip")
+              if (bufferingType == 0)                      // for
                 {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "left")
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetPlaybackPositionToTheRight, BitTorrentVideoClient, true)
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
 
-                      std::cout << "		Scheduled video fast forward to rightmost continously reachable position from the beginning."<< std::endl;
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to skip.");
-                    }
+                  m_output << "            Scheduled video buffering for the next " << buffer << " ms in \"real time\". " << std::endl;
                 }
-              else if (buffer == "buffer")
+              else if (bufferingType == 1)                      // next
                 {
-                  lineBuffer >> buffer;
-
-                  uint8_t bufferingType = 0;
-                  if (buffer == "for")
-                    {
-                      bufferingType = 0;
-                    }
-                  else if (buffer == "next")
-                    {
-                      bufferingType = 1;
-                    }
-                  else if (buffer == "until")
-                    {
-                      bufferingType = 2;
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how else to manipulate client's buffer behavior.");
-                    }
-
-                  int32_t bufferTime;
-                  bool voidDummy;
-                  ParseVideoTime (lineBuffer, bufferTime, voidDummy, currentLine);
-
-                  if (bufferingType == 0)                      // for
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
-
-                      std::cout << "            Scheduled video buffering for the next " << buffer << " ms in \"real time\". " << std::endl;
-                    }
-                  else if (bufferingType == 1)                      // next
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
-
-                      std::cout << "            Scheduled video buffering until the next " << buffer << " ms in the video are available. " << std::endl;
-                    }
-                  else                       // until
-                    {
-                      SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
 
-                      std::cout << "            Scheduled video buffering until the part at " << buffer << " ms in the video is available. " << std::endl;
-                    }
+                  m_output << "            Scheduled video buffering until the next " << buffer << " ms in the video are available. " << std::endl;
                 }
-              else if (buffer == "metrics")
+              else                       // until
                 {
-                  lineBuffer >> buffer;
-
-                  if (buffer != "interval")
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only set \"metrics interval\".");
-                    }
-
-                  int32_t metricInterval;
-                  bool dummy;
-                  ParseVideoTime (lineBuffer, metricInterval, dummy, currentLine);
-
-                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetGatherMetricsEventPeriodicity, BitTorrentVideoClient, MilliSeconds (metricInterval))
+                  SCHEDULE_CHAPTER (&BitTorrentVideoClient::BufferFor, BitTorrentVideoClient, MilliSeconds (bufferTime))
 
-                  std::cout << "                Scheduled metrics to be taken every " << time << " ms." << std::endl;
+                  m_output << "            Scheduled video buffering until the part at " << buffer << " ms in the video is available. " << std::endl;
                 }
-              else
+            }
+          else if (buffer == "metrics")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer != "interval")
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the video plaback.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only set \"metrics interval\".");
                 }
+
+              int32_t metricInterval;
+              bool dummy;
+              ParseVideoTime (lineBuffer, metricInterval, dummy, currentLine);
+
+              SCHEDULE_CHAPTER (&BitTorrentVideoClient::SetGatherMetricsEventPeriodicity, BitTorrentVideoClient, MilliSeconds (metricInterval))
+
+              m_output << "                Scheduled metrics to be taken every " << time << " ms." << std::endl;
             }
           else
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the client.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the video plaback.");
             }
         }
-      else if (tracker)
+      else
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the client.");
+        }
+    }
+  else if (tracker)
+    {
+      if (buffer == "set")
         {
-          if (buffer == "set")
+          lineBuffer >> buffer;
+          if (buffer == "update")
             {
               lineBuffer >> buffer;
-              if (buffer == "update")
+              if (buffer == "interval")
                 {
-                  lineBuffer >> buffer;
-                  if (buffer == "interval")
-                    {
-                      int32_t updateInterval;
-                      bool voidDummy;
-                      ParseVideoTime (lineBuffer, updateInterval, voidDummy, currentLine);
+                  int32_t updateInterval;
+                  bool voidDummy;
+                  ParseVideoTime (lineBuffer, updateInterval, voidDummy, currentLine);
 
-                      SCHEDULE_CHAPTER (&BitTorrentTracker::SetUpdateInterval, BitTorrentTracker, MilliSeconds (updateInterval))
-                      std::cout << "		Set tracker update interval to "<< updateInterval << " ms." << std::endl;
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"interval\" after \"update\".");
-                    }
+                  SCHEDULE_CHAPTER (&BitTorrentTracker::SetUpdateInterval, BitTorrentTracker, MilliSeconds (updateInterval))
+                  m_output << "		Set tracker update interval to "<< updateInterval << " ms." << std::endl;
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the tracker.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Missing \"interval\" after \"update\".");
                 }
             }
           else
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what else to do with the tracker.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know how to set that for the tracker.");
             }
         }
-      else if (topology)
+      else
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what else to do with the tracker.");
+        }
+    }
+  else if (topology)
+    {
+      if (buffer == "set")
         {
-          if (buffer == "set")
+          lineBuffer >> buffer;
+
+          if (buffer == "file")
             {
               lineBuffer >> buffer;
 
-              if (buffer == "file")
-                {
-                  lineBuffer >> buffer;
+              m_topologyHelper->SetFileName (buffer);
+              m_routerNodes->Add (m_topologyHelper->Read ());
 
-                  m_topologyHelper->SetFileName (buffer);
-                  m_routerNodes->Add (m_topologyHelper->Read ());
+              m_output << "		Read and established topology in file "<< buffer << "." << std::endl;
+            }
+          else if (buffer == "bandwidth")
+            {
+              lineBuffer >> buffer;
 
-                  std::cout << "		Read and established topology in file "<< buffer << "." << std::endl;
-                }
-              else if (buffer == "bandwidth")
+              if (buffer == "samples")
                 {
                   lineBuffer >> buffer;
 
-                  if (buffer == "samples")
+                  if (buffer == "file")
                     {
                       lineBuffer >> buffer;
 
-                      if (buffer == "file")
+                      if (buffer == "none")
                         {
-                          lineBuffer >> buffer;
-
-                          if (buffer == "none")
-                            {
-                              m_bandwidthSamplesFile = "";
-                              m_topologyHelper->SetBandwidthSamplesFile (m_bandwidthSamplesFile);
+                          m_bandwidthSamplesFile = "";
+                          m_topologyHelper->SetBandwidthSamplesFile (m_bandwidthSamplesFile);
 
-                              std::cout << "		Will not use a bandwidth samples file. Using simple DSL distribution as fallback."<< std::endl;
-                            }
-                          else
-                            {
-                              m_bandwidthSamplesFile = buffer;
-                              m_topologyHelper->SetBandwidthSamplesFile (m_bandwidthSamplesFile);
+                          m_output << "		Will not use a bandwidth samples file. Using simple DSL distribution as fallback."<< std::endl;
+                        }
+                      else
+                        {
+                          m_bandwidthSamplesFile = buffer;
+                          m_topologyHelper->SetBandwidthSamplesFile (m_bandwidthSamplesFile);
 
-                              std::cout << "		Set bandwidth samples file to "<< m_bandwidthSamplesFile << "." << std::endl;
-                            }
+                          m_output << "		Set bandwidth samples file to "<< m_bandwidthSamplesFile << "." << std::endl;
                         }
                     }
                 }
-              else if (buffer == "delays")
-                {
-                  uint32_t min = 0;
-                  uint32_t max = 0;
-
-                  lineBuffer >> buffer;
-                  if (buffer != "min")
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Minimum delay (\"min\") must be provided first.");
-                    }
-                  lineBuffer >> buffer;
-                  min = lexical_cast<uint32_t> (buffer);
-                  lineBuffer >> buffer;
-                  if (buffer != "max")
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Maximum delay (\"max\") must be provided after minimum delay.");
-                    }
-                  lineBuffer >> buffer;
-                  max = lexical_cast<uint32_t> (buffer);
-
-                  m_topologyHelper->SetClientLinkDelays (min, max);
+            }
+          else if (buffer == "delays")
+            {
+              uint32_t min = 0;
+              uint32_t max = 0;
 
-                  std::cout << "		Set client link delays to a random value between "<< min << "ms and " << max << "ms." << std::endl;
+              lineBuffer >> buffer;
+              if (buffer != "min")
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Minimum delay (\"min\") must be provided first.");
                 }
-              else if (buffer == "node")
+              lineBuffer >> buffer;
+              min = lexical_cast<uint32_t> (buffer);
+              lineBuffer >> buffer;
+              if (buffer != "max")
                 {
-                  lineBuffer >> buffer;
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Maximum delay (\"max\") must be provided after minimum delay.");
+                }
+              lineBuffer >> buffer;
+              max = lexical_cast<uint32_t> (buffer);
 
-                  if (buffer == "count")
-                    {
-                      lineBuffer >> buffer;
+              m_topologyHelper->SetClientLinkDelays (min, max);
 
-                      uint32_t newNodes = lexical_cast<uint32_t> (buffer);
+              m_output << "		Set client link delays to a random value between "<< min << "ms and " << max << "ms." << std::endl;
+            }
+          else if (buffer == "node")
+            {
+              lineBuffer >> buffer;
 
-                      NodeContainer newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodes, "point-to-point");
+              if (buffer == "count")
+                {
+                  lineBuffer >> buffer;
 
-                      for (NodeContainer::Iterator it = newNodeContainer.Begin (); it != newNodeContainer.End (); ++it)
-                        {
-                          Ptr<Node> node = *it;
-                          Ptr<BitTorrentVideoClient> btclient = Create<BitTorrentVideoClient> ();
-                          btclient->SetStartTime (Seconds (simulationDuration));                             // So the applications don't start when not ordered to
-                          btclient->SetStopTime (Seconds (simulationDuration - 1));
-                          btclient->SetCheckDownloadedData (m_checkData);
+                  uint32_t newNodes = lexical_cast<uint32_t> (buffer);
+
+                  NodeContainer newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodes, "point-to-point");
+
+                  for (NodeContainer::Iterator it = newNodeContainer.Begin (); it != newNodeContainer.End (); ++it)
+                    {
+                      Ptr<Node> node = *it;
+                      Ptr<BitTorrentVideoClient> btclient = Create<BitTorrentVideoClient> ();
+                      btclient->SetStartTime (Seconds (simulationDuration));                             // So the applications don't start when not ordered to
+                      btclient->SetStopTime (Seconds (simulationDuration - 1));
+                      btclient->SetCheckDownloadedData (m_checkData);
 
 #ifdef NS3_MPI
-                          if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ())
+                      if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ())
 #endif
-                            {
-                              node->AddApplication (btclient);
-                              m_clientAppContainer->Add (btclient);
-                            }
+                        {
+                          node->AddApplication (btclient);
+                          m_clientAppContainer->Add (btclient);
                         }
+                    }
 
-                      m_btNodes->Add (newNodeContainer);
-                      m_btNodeCount += newNodes;
+                  m_btNodes->Add (newNodeContainer);
+                  m_btNodeCount += newNodes;
 
-                      std::cout << "		Added "<< newNodes << " client nodes to the topology." << std::endl;
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the nodes in the topology.");
-                    }
+                  m_output << "		Added "<< newNodes << " client nodes to the topology." << std::endl;
+                }
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the nodes in the topology.");
                 }
-              else if (buffer == "other")
+            }
+          else if (buffer == "other")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "node")
                 {
                   lineBuffer >> buffer;
 
-                  if (buffer == "node")
+                  if (buffer == "count")
                     {
                       lineBuffer >> buffer;
 
-                      if (buffer == "count")
-                        {
-                          lineBuffer >> buffer;
-
-                          uint32_t newNodes = lexical_cast<uint32_t> (buffer);
+                      uint32_t newNodes = lexical_cast<uint32_t> (buffer);
 
-                          NodeContainer newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodes, "point-to-point");
+                      NodeContainer newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodes, "point-to-point");
 
-                          m_otherNodes->Add (newNodeContainer);
-                          m_otherNodeCount += newNodes;
+                      m_otherNodes->Add (newNodeContainer);
+                      m_otherNodeCount += newNodes;
 
-                          std::cout << "		Added "<< newNodes << " other nodes to the topology." << std::endl;
-                        }
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"set other node count\" for the topology.");
+                      m_output << "		Added "<< newNodes << " other nodes to the topology." << std::endl;
                     }
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the topology.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only \"set other node count\" for the topology.");
                 }
             }
-          else if (buffer == "add")
+          else
             {
-              std::string uplinkSpeed = "", downlinkSpeed, delay;
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the topology.");
+            }
+        }
+      else if (buffer == "add")
+        {
+          std::string uplinkSpeed = "", downlinkSpeed, delay;
+          lineBuffer >> buffer;
+
+          if (buffer == "tapnode")
+            {
+              // Step 1: Get a random router
+              std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_topologyHelper->GetLastRouters ();
+              UniformVariable uv;
+              uint32_t its = uv.GetInteger (0, m_topologyHelper->GetLastRouterCount () - 1);
+              for (uint32_t i = 0; i < its; ++i)
+                {
+                  ++routerIt;
+                }
+
               lineBuffer >> buffer;
 
-              if (buffer == "tapnode")
+              // Step 2: Check if a TapDevice name has been specified
+              if (buffer != "tapname")
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding a tapnode, please specify the name of the TapDevice as a first parameter.");
+                }
+
+              lineBuffer >> buffer;
+              std::string tapDevice = buffer;
+
+              // Step 3: Check if uplink and downlink are specified
+              lineBuffer >> buffer;
+              if (buffer == "uplink")
+                {
+                  lineBuffer >> uplinkSpeed;
+
+                  lineBuffer >> buffer;
+                  if (buffer != "downlink")
+                    {
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a second parameter.");
+                    }
+
+                  lineBuffer >> downlinkSpeed;
+                }
+              else
+                {
+                  // Alternative: Use default values
+                  uplinkSpeed = "100Mbps";
+                  downlinkSpeed = "100Mbps";
+                }
+
+              m_tapNodes->Add (m_topologyHelper->AddTapNodeToLastTopology (tapDevice, (*routerIt).second, uplinkSpeed, downlinkSpeed, "0ms", false, false));
+
+              m_output << "		Added TapNode attached to TapDevice "<< tapDevice << std::endl;
+            }
+          else if (buffer == "tracker")
+            {
+              if (!m_trackerAdded)
                 {
-                  // Step 1: Get a random router
                   std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_topologyHelper->GetLastRouters ();
                   UniformVariable uv;
                   uint32_t its = uv.GetInteger (0, m_topologyHelper->GetLastRouterCount () - 1);
@@ -1596,78 +1759,194 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
                       ++routerIt;
                     }
 
+                  Ptr<BitTorrentTracker> btTrackerApp = Create<BitTorrentTracker> ();
+                  btTrackerApp->SetAnnouncePath ("/announce");
+                  btTrackerApp->SetScrapePath ("/scrape");
+                  btTrackerApp->SetUpdateInterval (Seconds (60));
+                  btTrackerApp->SetStartTime (Seconds (0));
+
+                  m_btTracker->Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, "point-to-point", "100Mbps", "100Mbps", "0ms", false, false, 0, true, ""));
+                  m_btTracker->Get (0)->AddApplication (btTrackerApp);
+                  m_trackerAppContainer->Add (btTrackerApp);
+
+                  m_output << "		Added the tracker application to a new node attached to a random router."<< std::endl;
+
+                  m_trackerAdded = true;
+                }
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Tracker already existent in the topology. Only one tracker is allowed.");
+                }
+            }
+          else if (buffer == "clients")
+            {
+              uint32_t newNodeCount;
+              std::string deviceType, uplinkSpeed = "", downlinkSpeed, delay, routerId = "";
+              NodeContainer newNodeContainer;
+
+              lineBuffer >> buffer;
+
+              if (buffer != "count")
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the number of the clients to add (\"count\") as a first parameter.");
+                }
+
+              lineBuffer >> buffer;
+
+              newNodeCount = lexical_cast<uint32_t> (buffer);
+
+              lineBuffer >> buffer;
+
+              if (buffer != "type")
+              {
+            	  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the connection type of the clients to add (\"type\") as a second parameter.");
+              }
+
+              lineBuffer >> deviceType;
+
+              lineBuffer >> buffer;
+
+              if (buffer == "uplink")
+                {
+                  lineBuffer >> uplinkSpeed;
+
                   lineBuffer >> buffer;
 
-                  // Step 2: Check if a TapDevice name has been specified
-                  if (buffer != "tapname")
+                  if (buffer != "downlink")
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding a tapnode, please specify the name of the TapDevice as a first parameter.");
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a third parameter.");
                     }
 
+                  lineBuffer >> downlinkSpeed;
+                }
+              else if (buffer == "using")
+                {
                   lineBuffer >> buffer;
-                  std::string tapDevice = buffer;
 
-                  // Step 3: Check if uplink and downlink are specified
+                  if (buffer != "samples")
+                    {
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
+                    }
+
                   lineBuffer >> buffer;
-                  if (buffer == "uplink")
+
+                  if (buffer != "file")
                     {
-                      lineBuffer >> uplinkSpeed;
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
+                    }
 
-                      lineBuffer >> buffer;
-                      if (buffer != "downlink")
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a second parameter.");
-                        }
+                  uplinkSpeed = "samples";
+                }
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
+                }
 
-                      lineBuffer >> downlinkSpeed;
+              lineBuffer >> buffer;
+
+              if (buffer == "delay")
+                {
+                  lineBuffer >> delay;
+                }
+              else if (uplinkSpeed != "samples")
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients not using the \"samples file\", please specify the channel delay of the connection of the clients (\"delay\") as a third parameter.");
+                }
+
+              if (!lineBuffer.eof ())
+                {
+                  lineBuffer >> buffer >> buffer2;
+
+                  if (buffer != "to" || buffer2 != "router")
+                    {
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you may specify to which router to add your nodes using the \"to router\" argument.");
                     }
                   else
                     {
-                      // Alternative: Use default values
-                      uplinkSpeed = "100Mbps";
-                      downlinkSpeed = "100Mbps";
+                      lineBuffer >> routerId;
                     }
+                }
 
-                  m_tapNodes->Add (m_topologyHelper->AddTapNodeToLastTopology (tapDevice, (*routerIt).second, uplinkSpeed, downlinkSpeed, "0ms", false, false));
-
-                  std::cout << "		Added TapNode attached to TapDevice "<< tapDevice << std::endl;
+              if (uplinkSpeed == "samples")
+                {
+                  newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodeCount, deviceType);
                 }
-              else if (buffer == "tracker")
+              else
                 {
-                  if (!m_trackerAdded)
+                  UniformVariable uv;
+                  for (uint32_t i = 0; i < newNodeCount; ++i)
                     {
                       std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_topologyHelper->GetLastRouters ();
-                      UniformVariable uv;
                       uint32_t its = uv.GetInteger (0, m_topologyHelper->GetLastRouterCount () - 1);
-                      for (uint32_t i = 0; i < its; ++i)
+
+                      if(routerId == "")
                         {
-                          ++routerIt;
+                          for (uint32_t j = 0; j < its; ++j)
+                            {
+                              ++routerIt;
+                            }
                         }
+                      else
+                        {
+                          its = m_topologyHelper->GetLastRouterCount ();
+                          bool found = false;
 
-                      Ptr<BitTorrentTracker> btTrackerApp = Create<BitTorrentTracker> ();
-                      btTrackerApp->SetAnnouncePath ("/announce");
-                      btTrackerApp->SetScrapePath ("/scrape");
-                      btTrackerApp->SetUpdateInterval (Seconds (60));
-                      btTrackerApp->SetStartTime (Seconds (0));
+                          for (uint32_t j = 0; j < its; ++j)
+                            {
+                              if((*routerIt).first == routerId)
+                                {
+                                  found = true;
+                                  break;
+                                }
 
-                      m_btTracker->Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, "point-to-point", "100Mbps", "100Mbps", "0ms", false, false, 0, true, ""));
-                      m_btTracker->Get (0)->AddApplication (btTrackerApp);
-                      m_trackerAppContainer->Add (btTrackerApp);
+                              ++routerIt;
+                            }
 
-                      std::cout << "		Added the tracker application to a new node attached to a random router."<< std::endl;
+                          if (!found)
+                            {
+                              NS_ABORT_MSG ("[line " << currentLine << "] Error: Could not find the router to attach the new clients to. Make sure that IDs are sequential, starting at 0.");
+                            }
+                        }
 
-                      m_trackerAdded = true;
+                      newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, ""));
                     }
-                  else
+                }
+
+              for (NodeContainer::Iterator it = newNodeContainer.Begin (); it != newNodeContainer.End (); ++it)
+                {
+                  Ptr<Node> node = *it;
+                  Ptr<BitTorrentVideoClient> btclient = Create<BitTorrentVideoClient> ();
+                  btclient->SetStartTime (Seconds (simulationDuration - 1)); // So the applications don't start when not ordered to
+                  btclient->SetStopTime (Seconds (simulationDuration));
+                  btclient->SetCheckDownloadedData (m_checkData);
+
+#ifdef NS3_MPI
+                  if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ())
+#endif
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Tracker already existent in the topology. Only one tracker is allowed.");
+                      node->AddApplication (btclient);
+	                      m_clientAppContainer->Add (btclient);
                     }
                 }
-              else if (buffer == "clients")
+
+              m_btNodes->Add (newNodeContainer);
+              m_btNodeCount += newNodeCount;
+
+              m_output << "		Added "<< newNodeCount << " client nodes to the topology." << std::endl;
+            }
+          else if (buffer == "other" || buffer == "background" || buffer == "sink")
+            {
+              bool background = (buffer == "background");
+              bool backgroundSink = (buffer == "sink");
+              
+              lineBuffer >> buffer;
+
+              if (buffer == "nodes")
                 {
                   uint32_t newNodeCount;
-                  std::string deviceType, uplinkSpeed = "", downlinkSpeed, delay, routerId = "";
+                  std::string deviceType, uplinkSpeed = "", downlinkSpeed, delay, routerId, ip, destination;
                   NodeContainer newNodeContainer;
+                  NodeContainer newNodeContainer2;
 
                   lineBuffer >> buffer;
 
@@ -1684,7 +1963,7 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
 
                   if (buffer != "type")
                   {
-                	  NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the connection type of the clients to add (\"type\") as a second parameter.");
+                    NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the connection type of the clients to add (\"type\") as a second parameter.");
                   }
 
                   lineBuffer >> deviceType;
@@ -1699,7 +1978,7 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
 
                       if (buffer != "downlink")
                         {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a third parameter.");
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a second parameter.");
                         }
 
                       lineBuffer >> downlinkSpeed;
@@ -1737,7 +2016,25 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
                     {
                       NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients not using the \"samples file\", please specify the channel delay of the connection of the clients (\"delay\") as a third parameter.");
                     }
-
+                    
+                  if (!lineBuffer. eof())
+                  {
+                    lineBuffer >> buffer;
+                    
+                    if (buffer == "ip" && (!background || backgroundSink))
+                    {
+                        lineBuffer >> ip;
+                    }
+                    else if (buffer == "destination" && background)
+                    {
+                        lineBuffer >> destination;
+                    }
+                    else
+                    {
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: You may either specify an \"ip\" address for a default empty node or a \"destination\" for a background traffic node.");
+                    }
+                  }
+                  
                   if (!lineBuffer.eof ())
                     {
                       lineBuffer >> buffer >> buffer2;
@@ -1750,8 +2047,9 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
                         {
                           lineBuffer >> routerId;
                         }
-                    }
-
+                    }                        
+                                          
+                                        
                   if (uplinkSpeed == "samples")
                     {
                       newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodeCount, deviceType);
@@ -1759,11 +2057,13 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
                   else
                     {
                       UniformVariable uv;
+                      Ipv4Address ipAddress (ip.c_str ());
+                      
                       for (uint32_t i = 0; i < newNodeCount; ++i)
                         {
                           std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_topologyHelper->GetLastRouters ();
                           uint32_t its = uv.GetInteger (0, m_topologyHelper->GetLastRouterCount () - 1);
-
+                          
                           if(routerId == "")
                             {
                               for (uint32_t j = 0; j < its; ++j)
@@ -1789,483 +2089,300 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
 
                               if (!found)
                                 {
-                                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Could not find the router to attach the new clients to. Make sure that IDs are sequential, starting at 0.");
+                                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Could not find the router to attach the new nodes to. Make sure that IDs are sequential, starting at 0.");
                                 }
                             }
-
-                          newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, ""));
-                        }
-                    }
-
-                  for (NodeContainer::Iterator it = newNodeContainer.Begin (); it != newNodeContainer.End (); ++it)
-                    {
-                      Ptr<Node> node = *it;
-                      Ptr<BitTorrentVideoClient> btclient = Create<BitTorrentVideoClient> ();
-                      btclient->SetStartTime (Seconds (simulationDuration - 1)); // So the applications don't start when not ordered to
-                      btclient->SetStopTime (Seconds (simulationDuration));
-                      btclient->SetCheckDownloadedData (m_checkData);
-
-#ifdef NS3_MPI
-                      if (PeekPointer (*it)->GetSystemId () == MpiInterface::GetSystemId ())
-#endif
-                        {
-                          node->AddApplication (btclient);
-	                      m_clientAppContainer->Add (btclient);
-                        }
-                    }
-
-                  m_btNodes->Add (newNodeContainer);
-                  m_btNodeCount += newNodeCount;
-
-                  std::cout << "		Added "<< newNodeCount << " client nodes to the topology." << std::endl;
-                }
-              else if (buffer == "other" || buffer == "background" || buffer == "sink")
-                {
-                  bool background = (buffer == "background");
-                  bool backgroundSink = (buffer == "sink");
-                  
-                  lineBuffer >> buffer;
-
-                  if (buffer == "nodes")
-                    {
-                      uint32_t newNodeCount;
-                      std::string deviceType, uplinkSpeed = "", downlinkSpeed, delay, routerId, ip, destination;
-                      NodeContainer newNodeContainer;
-                      NodeContainer newNodeContainer2;
-
-                      lineBuffer >> buffer;
-
-                      if (buffer != "count")
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the number of the clients to add (\"count\") as a first parameter.");
-                        }
-
-                      lineBuffer >> buffer;
-
-                      newNodeCount = lexical_cast<uint32_t> (buffer);
-
-                      lineBuffer >> buffer;
-
-                      if (buffer != "type")
-                      {
-                        NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the connection type of the clients to add (\"type\") as a second parameter.");
-                      }
-
-                      lineBuffer >> deviceType;
-
-                      lineBuffer >> buffer;
-
-                      if (buffer == "uplink")
-                        {
-                          lineBuffer >> uplinkSpeed;
-
-                          lineBuffer >> buffer;
-
-                          if (buffer != "downlink")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, please specify the downlink speed of the clients (\"downlink\") as a second parameter.");
-                            }
-
-                          lineBuffer >> downlinkSpeed;
-                        }
-                      else if (buffer == "using")
-                        {
-                          lineBuffer >> buffer;
-
-                          if (buffer != "samples")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
-                            }
-
-                          lineBuffer >> buffer;
-
-                          if (buffer != "file")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
-                            }
-
-                          uplinkSpeed = "samples";
-                        }
-                      else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you can either specify up- and downlink bandwidths or use the \"samples file\".");
-                        }
-
-                      lineBuffer >> buffer;
-
-                      if (buffer == "delay")
-                        {
-                          lineBuffer >> delay;
-                        }
-                      else if (uplinkSpeed != "samples")
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients not using the \"samples file\", please specify the channel delay of the connection of the clients (\"delay\") as a third parameter.");
-                        }
-                        
-                      if (!lineBuffer. eof())
-                      {
-                        lineBuffer >> buffer;
-                        
-                        if (buffer == "ip" && (!background || backgroundSink))
-                        {
-                            lineBuffer >> ip;
-                        }
-                        else if (buffer == "destination" && background)
-                        {
-                            lineBuffer >> destination;
-                        }
-                        else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: You may either specify an \"ip\" address for a default empty node or a \"destination\" for a background traffic node.");
-                        }
-                      }
-                      
-                      if (!lineBuffer.eof ())
-                        {
-                          lineBuffer >> buffer >> buffer2;
-
-                          if (buffer != "to" || buffer2 != "router")
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: When adding clients, you may specify to which router to add your nodes using the \"to router\" argument.");
-                            }
-                          else
-                            {
-                              lineBuffer >> routerId;
-                            }
-                        }                        
-                                              
-                                            
-                      if (uplinkSpeed == "samples")
-                        {
-                          newNodeContainer = m_topologyHelper->AddClientNodesToLastTopology (newNodeCount, deviceType);
-                        }
-                      else
-                        {
-                          UniformVariable uv;
-                          Ipv4Address ipAddress (ip.c_str ());
                           
-                          for (uint32_t i = 0; i < newNodeCount; ++i)
-                            {
-                              std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_topologyHelper->GetLastRouters ();
-                              uint32_t its = uv.GetInteger (0, m_topologyHelper->GetLastRouterCount () - 1);
-                              
-                              if(routerId == "")
-                                {
-                                  for (uint32_t j = 0; j < its; ++j)
-                                    {
-                                      ++routerIt;
-                                    }
-                                }
-                              else
-                                {
-                                  its = m_topologyHelper->GetLastRouterCount ();
-                                  bool found = false;
-
-                                  for (uint32_t j = 0; j < its; ++j)
-                                    {
-                                      if((*routerIt).first == routerId)
-                                        {
-                                          found = true;
-                                          break;
-                                        }
-
-                                      ++routerIt;
-                                    }
-
-                                  if (!found)
-                                    {
-                                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Could not find the router to attach the new nodes to. Make sure that IDs are sequential, starting at 0.");
-                                    }
-                                }
-                              
-                              if(ip != "")
-                                {                             
-                                    std::ostringstream ipAddressStream;
-                                    ipAddress.Print (ipAddressStream);
-                                    
-                                    newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, ipAddressStream.str ())); 
-                                    
-                                    ipAddress.Set(ipAddress.Get() + 1);    
-                                  }
-                                else
-                                  {
-                                    newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, "")); 
-                                  }
-                            }
+                          if(ip != "")
+                            {                             
+                                std::ostringstream ipAddressStream;
+                                ipAddress.Print (ipAddressStream);
+                                
+                                newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, ipAddressStream.str ())); 
+                                
+                                ipAddress.Set(ipAddress.Get() + 1);    
+                              }
+                            else
+                              {
+                                newNodeContainer.Add (m_topologyHelper->AddNodeToLastTopology ((*routerIt).second, deviceType, uplinkSpeed, downlinkSpeed, delay, false, false, 0, false, "")); 
+                              }
                         }
-                   
-                      if (background)
-                      {
-                         if (destination == "")
-                         {
-                           NS_ABORT_MSG ("[line " << currentLine << "} Error: When defining a \"background\" node, you must specify a \"destination\" ip for the traffic.");
-                         }
-                         
-                         OnOffHelper ooh ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address (destination.c_str ()), 33333));
-                         
-                         ooh.SetConstantRate (DataRate (uplinkSpeed));
-                        
-                         ooh.SetAttribute ("StartTime", TimeValue(Seconds(0)));                        
-                         ooh.SetAttribute ("StopTime", TimeValue(Seconds (simulationDuration - 1)));
+                    }
+               
+                  if (background)
+                  {
+                     if (destination == "")
+                     {
+                       NS_ABORT_MSG ("[line " << currentLine << "} Error: When defining a \"background\" node, you must specify a \"destination\" ip for the traffic.");
+                     }
+                     
+                     OnOffHelper ooh ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address (destination.c_str ()), 33333));
+                     
+                     ooh.SetConstantRate (DataRate (uplinkSpeed));
+                    
+                     ooh.SetAttribute ("StartTime", TimeValue(Seconds(0)));                        
+                     ooh.SetAttribute ("StopTime", TimeValue(Seconds (simulationDuration - 1)));
 
 #ifdef NS3_MPI                         
-                         if (MpiInterface::GetSystemId () == 0)
+                     if (MpiInterface::GetSystemId () == 0)
 #endif
-                         {
-                             ooh.Install (newNodeContainer);
-                         }
-                      }
-                      else if (backgroundSink)
-                      {
-                        PacketSinkHelper psh ("ns3::TcpSocketFactory", Ipv4Address ("0.0.0.0")); //Ipv4Address (ip.c_str()));
-                        psh.SetAttribute ("Local", AddressValue (InetSocketAddress ("0.0.0.0", 33333)));
-                        
-                        psh.SetAttribute ("StartTime", TimeValue(Seconds(0)));
-                        psh.SetAttribute ("StopTime", TimeValue(Seconds (simulationDuration - 1)));
+                     {
+                         ooh.Install (newNodeContainer);
+                     }
+                  }
+                  else if (backgroundSink)
+                  {
+                    PacketSinkHelper psh ("ns3::TcpSocketFactory", Ipv4Address ("0.0.0.0")); //Ipv4Address (ip.c_str()));
+                    psh.SetAttribute ("Local", AddressValue (InetSocketAddress ("0.0.0.0", 33333)));
+                    
+                    psh.SetAttribute ("StartTime", TimeValue(Seconds(0)));
+                    psh.SetAttribute ("StopTime", TimeValue(Seconds (simulationDuration - 1)));
 
 #ifdef NS3_MPI
-                        if (MpiInterface::GetSystemId () == 0)
+                    if (MpiInterface::GetSystemId () == 0)
 #endif
-                        {
-                          psh.Install (newNodeContainer);
-                        }
-                      }
-                      
-                      m_otherNodes->Add (newNodeContainer);
-                      m_otherNodeCount += newNodeCount;
-
-                      std::cout << "		Added " << newNodeCount << " " << (background ? "background" : (backgroundSink ? "sink" : "other")) << " nodes to the topology." << std::endl;
-                    }
-                  else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only add \"{background, sink, other} nodes\" to the topology.");
+                      psh.Install (newNodeContainer);
                     }
+                  }
+                  
+                  m_otherNodes->Add (newNodeContainer);
+                  m_otherNodeCount += newNodeCount;
+
+                  m_output << "		Added " << newNodeCount << " " << (background ? "background" : (backgroundSink ? "sink" : "other")) << " nodes to the topology." << std::endl;
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what else to add to the topology.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only add \"{background, sink, other} nodes\" to the topology.");
                 }
             }
           else
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the topology.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what else to add to the topology.");
             }
         }
-      else if (simulation)
+      else
+        {
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the topology.");
+        }
+    }
+  else if (simulation)
+    {
+      if (buffer == "set")
         {
-          if (buffer == "set")
-            {
-              lineBuffer >> buffer;
+          lineBuffer >> buffer;
 
-              if (buffer == "id")
+          if (buffer == "id")
+            {
+              if (m_simulationId == "")
                 {
-                  if (m_simulationId == "")
-                    {
-                      lineBuffer >> buffer;
-
-                      if (buffer == "random")
-                        {
-                          UniformVariable uv;
-                          m_simulationId = lexical_cast<std::string> (uv.GetInteger (0, std::numeric_limits<uint32_t>::max () - 1));
-                        }
-                      else if (buffer == "time")
-                        {
-                          time_t currentTime;
-                          struct tm* currentTimeInfo;
-                          char simulationIdBuffer[20];
+                  lineBuffer >> buffer;
 
-                          std::time (&currentTime);
-                          currentTimeInfo = localtime (&currentTime);
-                          strftime (simulationIdBuffer, 20, "%Y-%m-%d-%H-%M-%S", currentTimeInfo);
+                  if (buffer == "random")
+                    {
+                      UniformVariable uv;
+                      m_simulationId = lexical_cast<std::string> (uv.GetInteger (0, std::numeric_limits<uint32_t>::max () - 1));
+                    }
+                  else if (buffer == "time")
+                    {
+                      time_t currentTime;
+                      struct tm* currentTimeInfo;
+                      char simulationIdBuffer[20];
 
-                          m_simulationId.assign (simulationIdBuffer, 19);
-                        }
-                      else
-                        {
-                          m_simulationId = buffer;
-                        }
+                      std::time (&currentTime);
+                      currentTimeInfo = localtime (&currentTime);
+                      strftime (simulationIdBuffer, 20, "%Y-%m-%d-%H-%M-%S", currentTimeInfo);
 
-                      std::cout << "                The ID of this simulation is " << m_simulationId << "." << std::endl;
+                      m_simulationId.assign (simulationIdBuffer, 19);
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Simulation ID already set in a previous line.");
+                      m_simulationId = buffer;
                     }
+
+                  m_output << "                The ID of this simulation is " << m_simulationId << "." << std::endl;
                 }
-              else if (buffer == "logging")
+              else
                 {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "file")
-                    {
-                      m_loggingToFile = true;
-                    }
-
-                  std::cout << "		Enabled logging to file."<< std::endl;
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Simulation ID already set in a previous line.");
                 }
-              else if (buffer == "folder")
+            }
+          else if (buffer == "logging")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "file")
                 {
-                  lineBuffer >> buffer;
+                  m_loggingToFile = true;
+                }
 
-                  m_torrentFolder = buffer;
+              m_output << "		Enabled logging to file."<< std::endl;
+            }
+          else if (buffer == "folder")
+            {
+              lineBuffer >> buffer;
 
-                  std::cout << "		Set torrent data folder to "<< buffer << "." << std::endl;
-                }
-              else if (buffer == "file")
+              m_torrentFolder = buffer;
+
+              m_output << "		Set torrent data folder to "<< buffer << "." << std::endl;
+            }
+          else if (buffer == "file")
+            {
+              if (m_torrentFolder == "")
                 {
-                  if (m_torrentFolder == "")
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: You must set the torrent data folder first.");
-                    }
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: You must set the torrent data folder first.");
+                }
 
-                  lineBuffer >> buffer;
+              lineBuffer >> buffer;
 
-                  m_torrentFile = buffer;
+              m_torrentFile = buffer;
 
-                  bool useFakeData = false;
-                  if (!lineBuffer.eof ())
+              bool useFakeData = false;
+              if (!lineBuffer.eof ())
+                {
+                  lineBuffer >> buffer;
+
+                  if (buffer == "fake")
                     {
                       lineBuffer >> buffer;
 
-                      if (buffer == "fake")
+                      if (buffer == "data")
                         {
-                          lineBuffer >> buffer;
-
-                          if (buffer == "data")
-                            {
-                              StorageManager::GetInstance ()->SetUseFakeData (true);
-                              useFakeData = true;
-                              m_useFakeData = true;
-                            }
-                          else
-                            {
-                              NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only fake \"data\" for the torrent.");
-                            }
+                          StorageManager::GetInstance ()->SetUseFakeData (true);
+                          useFakeData = true;
+                          m_useFakeData = true;
                         }
                       else
                         {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: The path to the torrent file must not include whitespace characters.");
+                          NS_ABORT_MSG ("[line " << currentLine << "] Error: Can only fake \"data\" for the torrent.");
                         }
                     }
-
-                  if (!useFakeData)
-                    {
-                      std::cout << "		Set shared torrent file to "<< m_torrentFile << "." << std::endl;
-                    }
                   else
                     {
-                      std::cout << "		Set shared torrent file to "<< m_torrentFile << " but using fake data for speedup." << std::endl;
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: The path to the torrent file must not include whitespace characters.");
                     }
                 }
-              else if (buffer == "random")
-                {
-                  lineBuffer >> buffer;
-
-                  if (buffer == "seed")
-                    {
-                      lineBuffer >> buffer;
 
-                      uint32_t randomSeed = 0;                           // assignment to mute compiler
-
-                      if (buffer == "time")
-                        {
-                          randomSeed = std::time (0);
-                        }
-                      else
-                        {
-                          randomSeed = lexical_cast<uint32_t> (buffer);
-                        }
+              if (!useFakeData)
+                {
+                  m_output << "		Set shared torrent file to "<< m_torrentFile << "." << std::endl;
+                }
+              else
+                {
+                  m_output << "		Set shared torrent file to "<< m_torrentFile << " but using fake data for speedup." << std::endl;
+                }
+            }
+          else if (buffer == "random")
+            {
+              lineBuffer >> buffer;
 
-                      srand (randomSeed);
-                      SeedManager::SetSeed (randomSeed);
+              if (buffer == "seed")
+                {
+                  lineBuffer >> buffer;
 
-                      std::cout << "		Set random seed to "<< randomSeed << "." << std::endl;
+                  uint32_t randomSeed = 0;                           // assignment to mute compiler
 
-                      m_randomSeedSet = true;
+                  if (buffer == "time")
+                    {
+                      randomSeed = std::time (0);
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the random seed.");
+                      randomSeed = lexical_cast<uint32_t> (buffer);
                     }
+
+                  srand (randomSeed);
+                  SeedManager::SetSeed (randomSeed);
+
+                  m_output << "		Set random seed to "<< randomSeed << "." << std::endl;
+
+                  m_randomSeedSet = true;
                 }
-              else if (buffer == "variable")
+              else
+                {
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the random seed.");
+                }
+            }
+          else if (buffer == "variable")
+            {
+              lineBuffer >> buffer;
+              lineBuffer >> buffer2;
+              buffer3 = buffer2;
+              while (!lineBuffer.eof ())
                 {
-                  lineBuffer >> buffer;
                   lineBuffer >> buffer2;
-                  buffer3 = buffer2;
-                  while (!lineBuffer.eof ())
-                    {
-                      lineBuffer >> buffer2;
-                      buffer3.append (" " + buffer2);
-                    }
+                  buffer3.append (" " + buffer2);
+                }
 
-                  m_variables[buffer] = buffer3;
+              m_variables[buffer] = buffer3;
 
-                  std::cout << "		Set variable "<< buffer << " to value \"" << buffer3 << "\"." << std::endl;
-                }
-              else if (buffer == "pcap")
+              m_output << "		Set variable "<< buffer << " to value \"" << buffer3 << "\"." << std::endl;
+            }
+          else if (buffer == "pcap")
+            {
+              lineBuffer >> buffer;
+
+              if (buffer == "enabled")
                 {
                   lineBuffer >> buffer;
 
-                  if (buffer == "enabled")
+                  if (buffer == "prefix")
                     {
                       lineBuffer >> buffer;
 
-                      if (buffer == "prefix")
-                        {
-                          lineBuffer >> buffer;
-
-                          buffer = buffer + "." + lexical_cast<std::string> (rand () % static_cast<uint32_t> (std::pow ((double)2, (double)31)));
+                      buffer = buffer + "." + lexical_cast<std::string> (rand () % static_cast<uint32_t> (std::pow ((double)2, (double)31)));
 
-                          m_topologyHelper->EnablePcaps (buffer);
+                      m_topologyHelper->EnablePcaps (buffer);
 
-                          std::cout << "		PCAP enabled. Files will be stored under "<< buffer << ".*.pcap." << std::endl;
-                        }
-                      else
-                        {
-                          NS_ABORT_MSG ("[line " << currentLine << "] Error: To enable PCAP tracing, specify the file name prefix (may include paths).");
-                        }
+                      m_output << "		PCAP enabled. Files will be stored under "<< buffer << ".*.pcap." << std::endl;
                     }
                   else
                     {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: PCAP can only be \"enable\"d.");
+                      NS_ABORT_MSG ("[line " << currentLine << "] Error: To enable PCAP tracing, specify the file name prefix (may include paths).");
                     }
                 }
-              else if (buffer == "checkdata")
+              else
                 {
-                  lineBuffer >> buffer;
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: PCAP can only be \"enable\"d.");
+                }
+            }
+          else if (buffer == "checkdata")
+            {
+              lineBuffer >> buffer;
 
-                  if (buffer == "1")
-                    {
-                      m_checkData = true;
-                      std::cout << "		Downloaded data of clients will be checked for correctness."<< std::endl;
-                    }
-                  else if (buffer == "0")
-                    {
-                      m_checkData = false;
-                      std::cout << "		Downloaded data of clients will not be checked for correctness."<< std::endl;
-                    }
-                  else
-                    {
-                      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know whether to check downloaded Data or not.");
-                    }
+              if (buffer == "1")
+                {
+                  m_checkData = true;
+                  m_output << "		Downloaded data of clients will be checked for correctness."<< std::endl;
+                }
+              else if (buffer == "0")
+                {
+                  m_checkData = false;
+                  m_output << "		Downloaded data of clients will not be checked for correctness."<< std::endl;
                 }
               else
                 {
-                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for the simulation.");
+                  NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know whether to check downloaded Data or not.");
                 }
             }
           else
             {
-              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the simulation.");
+              NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to set for the simulation.");
             }
         }
       else
         {
-          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know that entity.");
+          NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know what to do with the simulation.");
         }
-    }     // while(!storyFile.eof())
+    }
+  else
+    {
+      NS_ABORT_MSG ("[line " << currentLine << "] Error: Don't know that entity.");
+    }
+}
 
+void Story::CheckStoryComplete (uint32_t currentLine) const
+{
   if (m_simulationId == "")
     {
       NS_ABORT_MSG ("[line " << currentLine << "] Error: No Simulation ID was set. This, however, is a required setting.");
@@ -2277,5 +2394,60 @@ void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDurat
     }
 }
 
+void Story::ReadAndScheduleStory (std::string filePath, uint32_t simulationDuration)
+{
+  std::ifstream storyFile;
+  std::string line;
+
+  storyFile.open (filePath.c_str ());
+  if (!storyFile.is_open ())
+    {
+      NS_ABORT_MSG ("Error: Story file not found.");
+    }
+
+  m_output << "This is the VODSim Story reader. Processing file " << filePath << "." << std::endl;
+
+  Time oldTime = FemtoSeconds (0);
+  uint32_t currentLine = 0;
+  StoryEvent event;
+
+  m_randomSeedSet = false;
+  m_trackerAdded = (m_btTracker->GetN () > 0);
+
+  while (!storyFile.eof ())
+    {
+      ++currentLine;
+      getline (storyFile, line);
+
+      if (ParseStoryLine (line, currentLine, oldTime, event))
+        {
+          ScheduleStoryEvent (event, simulationDuration);
+        }
+    }
+
+  CheckStoryComplete (currentLine);
+}
+
+void Story::SetVerbose (bool verbose)
+{
+  m_output.rdbuf (verbose ? std::cout.rdbuf () : 0);
+}
+
+void Story::SetLazyScheduling (bool lazyScheduling)
+{
+  m_lazyScheduling = lazyScheduling;
+}
+
+Ptr<StoryEventGenerator> Story::CreateEventGenerator (Time time, Time time2, bool poisson, Time poissonInterarrivalTime) const
+{
+  // Events at a fixed point in time gain nothing from lazy scheduling
+  if (!m_lazyScheduling || time == time2)
+    {
+      return 0;
+    }
+
+  return Create<StoryEventGenerator> (time, time2, poisson, poissonInterarrivalTime);
+}
+
 } // ns bittorrent
 } // ns ns3
@@ -22,6 +22,7 @@
 #define STORY_H_
 
 #include "brite-topology-helper.h"
+#include "StoryEventGenerator.h"
 
 #include "ns3/Torrent.h"
 
@@ -30,9 +31,11 @@
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 
-#include <string>
+#include <iostream>
 #include <map>
 #include <set>
+#include <sstream>
+#include <string>
 
 namespace ns3 {
 namespace bittorrent {
@@ -91,6 +94,27 @@ namespace bittorrent {
  */
 class Story : public Object
 {
+// Types used
+private:
+  enum StoryEventTiming
+  {
+    EVENT_AT = 0,                  // The event takes place at a fixed point in time
+    EVENT_RANGE = 1,               // The event takes place at a random point in time within a range, drawn per affected node
+    EVENT_POISSON = 2              // The event follows a poisson process within a range
+  };
+
+  /// @cond HIDDEN
+  typedef struct
+  {
+    uint32_t                 m_line;                       // The line of the story file the event was read from
+    uint8_t                  m_timing;                     // One of StoryEventTiming
+    int64_t                  m_time;                       // The time of the event or the start of its range, in milliseconds
+    int64_t                  m_time2;                      // The end of the range, in milliseconds (equals m_time for EVENT_AT)
+    int64_t                  m_interarrival;               // The mean interarrival time of the poisson process, in milliseconds
+    std::string              m_command;                    // The remainder of the line following the time declaration, with variables replaced
+  } StoryEvent;
+  /// @endcond HIDDEN
+
 // Fields
 private:
   // Main settings for the story file
@@ -127,6 +151,9 @@ private:
   bool                       m_trackerAdded;               // Whether the tracker was already added (not possible again)
   bool                       m_randomSeedSet;              // Whether the random seed was already set (not possible again)
 
+  bool                       m_lazyScheduling;             // Whether time ranges and poisson processes are scheduled lazily by StoryEventGenerator instances
+  std::ostream               m_output;                     // Receives the description of the scheduled events; discards it if verbose output is disabled
+
 // Constructors etc. (singleton pattern)
 private:
   Story ();
@@ -228,6 +255,24 @@ public:
    */
   void ReadAndScheduleStory (std::string filePath, uint32_t simulationDuration);
 
+  /**
+   * \brief Control whether a description of each scheduled event is printed to stdout while reading stories. Default is true.
+   */
+  void SetVerbose (bool verbose);
+
+  /**
+   * \brief Control whether the per-node events of time ranges and poisson processes are scheduled lazily. Default is false.
+   *
+   * By default, the events of all affected nodes are inserted into the global scheduling queue while the story is read. In lazy mode, each
+   * time range or poisson process only schedules its next event (see the StoryEventGenerator class), which keeps the scheduling queue small in
+   * scenarios with many nodes joining or leaving over long periods. Time ranges yield the same distribution of event times in both modes;
+   * poisson processes, however, only trigger the affected nodes at exponentially distributed interarrival times in lazy mode, while they are
+   * treated like time ranges otherwise.
+   *
+   * Note: Must be set before the story is read.
+   */
+  void SetLazyScheduling (bool lazyScheduling);
+
 // Getters for read simulation parameters
 public:
   /**
@@ -326,6 +371,26 @@ private:
    *  Used to generate messages in case of errorneous inputs.
    */
   static void ParseVideoTime (std::istringstream& lineBuffer, int32_t& result, bool& isRelative, uint32_t currentLine);
+
+  // Like ParseVideoTime, but without the limit of about 24.8 days; used for the times of events
+  static void ParseVideoTime (std::istringstream& lineBuffer, int64_t& result, bool& isRelative, uint32_t currentLine);
+
+// Internal methods
+private:
+  // Replace all occurrences of "$name$" for the set variables within a line in a single pass
+  void ReplaceVariables (std::string& line) const;
+
+  // Replace variables in a line and parse its time declaration. Returns false for empty lines and comments.
+  bool ParseStoryLine (std::string& line, uint32_t currentLine, Time& oldTime, StoryEvent& event);
+
+  // Interpret the command of an event and schedule the resulting calls
+  void ScheduleStoryEvent (const StoryEvent& event, uint32_t simulationDuration);
+
+  // Create a generator for the per-node events of a time range or poisson process, or return 0 if they are to be scheduled eagerly
+  Ptr<StoryEventGenerator> CreateEventGenerator (Time time, Time time2, bool poisson, Time poissonInterarrivalTime) const;
+
+  // Abort if required settings were missing from the story
+  void CheckStoryComplete (uint32_t currentLine) const;
 };
 
 } // ns bittorrent
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke (principal author), Alexander Hocks
+ */
+
+#include "StoryEventGenerator.h"
+
+#include "ns3/random-variable.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace bittorrent {
+
+StoryEventGenerator::StoryEventGenerator (Time start, Time end, bool poisson, Time interarrival)
+{
+  m_nextEvent = 0;
+  m_poisson = poisson;
+  m_end = end.GetMilliSeconds ();
+  m_interarrival = interarrival.GetMilliSeconds ();
+  m_current = start.GetMilliSeconds ();
+}
+
+StoryEventGenerator::~StoryEventGenerator ()
+{
+  m_events.clear ();
+}
+
+void StoryEventGenerator::Add (Ptr<EventImpl> event)
+{
+  m_events.push_back (event);
+}
+
+void StoryEventGenerator::Start ()
+{
+  // Step 1: Determine the order in which the nodes are triggered (Fisher-Yates shuffle)
+  UniformVariable uv;
+  for (uint32_t i = m_events.size (); i > 1; --i)
+    {
+      std::swap (m_events[i - 1], m_events[uv.GetInteger (0, i - 1)]);
+    }
+
+  // Step 2: A poisson process starts with the first arrival at the beginning of the range
+  if (m_poisson && !m_events.empty ())
+    {
+      Simulator::Schedule (MilliSeconds (static_cast<int64_t> (m_current)) - Simulator::Now (), &StoryEventGenerator::Fire, Ptr<StoryEventGenerator> (this));
+      return;
+    }
+
+  ScheduleNext ();
+}
+
+void StoryEventGenerator::Fire ()
+{
+  Ptr<EventImpl> event = m_events[m_nextEvent];
+  m_events[m_nextEvent] = Ptr<EventImpl> ();     // Release the event as soon as it was triggered
+  ++m_nextEvent;
+
+  event->Invoke ();
+
+  ScheduleNext ();
+}
+
+void StoryEventGenerator::ScheduleNext ()
+{
+  if (m_nextEvent >= m_events.size ())
+    {
+      m_events.clear ();
+      return;
+    }
+
+  // Step 1: Draw the time of the next event
+  UniformVariable uv;
+  if (m_poisson)
+    {
+      m_current += ExponentialVariable (m_interarrival).GetValue ();
+      if (m_current > m_end)
+        {
+          m_events.clear ();             // The remaining nodes would be triggered after the end of the process
+          return;
+        }
+    }
+  else
+    {
+      // The minimum of the k remaining uniform times within [current, end] is current + (end - current) * (1 - U^(1/k))
+      uint32_t remaining = m_events.size () - m_nextEvent;
+      m_current += (m_end - m_current) * (1 - std::pow (uv.GetValue (), 1.0 / remaining));
+    }
+
+  // Step 2: Schedule it; times are rounded to milliseconds, like those of eagerly scheduled events
+  Time next = MilliSeconds (static_cast<int64_t> (m_current));
+  Simulator::Schedule (std::max (next - Simulator::Now (), Seconds (0)), &StoryEventGenerator::Fire, Ptr<StoryEventGenerator> (this));
+}
+
+} // ns bittorrent
+} // ns ns3
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke (principal author), Alexander Hocks
+ */
+
+#ifndef STORYEVENTGENERATOR_H_
+#define STORYEVENTGENERATOR_H_
+
+#include "ns3/event-impl.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <vector>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Lazily schedules the per-node events of a Story time range or poisson process.
+ *
+ * Instead of inserting one event per affected node into the global scheduling queue up front, the generator keeps the events of all nodes
+ * itself and only schedules the next one; each time an event fires, the time of the following one is drawn. Thus, each time range or poisson
+ * process of a story occupies a single slot in the scheduling queue at any time.
+ *
+ * For time ranges, the times are drawn as consecutive order statistics of uniformly distributed times within the range, assigned to the nodes
+ * in random order, which yields the same distribution as drawing a uniform time per node. For poisson processes, the nodes are triggered in
+ * random order with exponentially distributed interarrival times, starting at the beginning of the range; nodes whose turn would come after
+ * the end of the range are not triggered.
+ */
+class StoryEventGenerator : public SimpleRefCount<StoryEventGenerator>
+{
+// Fields
+private:
+  std::vector<Ptr<EventImpl> >  m_events;              // The events of the affected nodes, in the order they are triggered
+  uint32_t                      m_nextEvent;           // The index of the next event to trigger
+
+  bool                          m_poisson;             // Whether the events follow a poisson process (true) or are distributed uniformly (false)
+  int64_t                       m_end;                 // The end of the range, in milliseconds
+  double                        m_interarrival;        // The mean interarrival time of the poisson process, in milliseconds
+  double                        m_current;             // The (unrounded) time of the last drawn event, in milliseconds
+
+// Constructors etc.
+public:
+  /**
+   * @param start the beginning of the range.
+   * @param end the end of the range.
+   * @param poisson whether the events follow a poisson process within the range, instead of being distributed uniformly.
+   * @param interarrival the mean interarrival time of the poisson process.
+   */
+  StoryEventGenerator (Time start, Time end, bool poisson, Time interarrival);
+  virtual ~StoryEventGenerator ();
+
+// Interaction methods
+public:
+  /**
+   * \brief Add the event of an affected node. Events must be added before the generator is started.
+   */
+  void Add (Ptr<EventImpl> event);
+
+  /**
+   * \brief Shuffle the added events and schedule the first one.
+   */
+  void Start ();
+
+// Internal methods
+private:
+  // Trigger the next event and schedule the following one
+  void Fire ();
+
+  // Draw the time of the next event and schedule it, if any
+  void ScheduleNext ();
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#endif /* STORYEVENTGENERATOR_H_ */
@@ -21,6 +21,7 @@
 #include "brite-topology-helper.h"
 
 #include "ns3/BitTorrentUtilities.h"
+#include "ns3/NetworkLocality.h"
 #include "ns3/brite-tap-helper.h"
 // #include "ns3/sync-tunnel-bridge-helper.h"
 
@@ -173,6 +174,7 @@ NodeContainer BriteTopologyHelper::AddNodeToLastTopology (Ptr<Node> parent, std:
     {
       m_clients[lexical_cast < std::string > (newNode->GetId ())] = newNode;
       m_clientsToRouters[lexical_cast < std::string > (newNode->GetId ())] = parent;
+      m_clientLinkDelays[lexical_cast < std::string > (newNode->GetId ())] = delay;
     }
 
   m_autonomousSystems[lexical_cast < std::string > (newNode->GetId ())] = AS;
@@ -202,6 +204,7 @@ NodeContainer BriteTopologyHelper::AddTapNodeToLastTopology (std::string tapDevi
 
   m_clients[lexical_cast < std::string > (newNode->GetId ())] = newNode;
   m_clientsToRouters[lexical_cast < std::string > (newNode->GetId ())] = parent;
+  m_clientLinkDelays[lexical_cast < std::string > (newNode->GetId ())] = delay;
 
   Link link (newNode, lexical_cast<std::string> (newNode->GetId ()), parent, lexical_cast<std::string> (parent->GetId ()));
   link.SetAttribute ("Device-Type", "csmaTap");
@@ -333,6 +336,8 @@ bool BriteTopologyHelper::EstablishNetworkOnLastTopology ()
   ASSIGN_ADDRESSES(csmaInterfaces, "10.100.0.0", "255.255.0.0");
   ASSIGN_ADDRESSES(csmaTapInterfaces, "192.168.0.0", "255.255.255.0");
 
+  RegisterClientLocations ();
+
   if (m_hasTapNode)
     {
 	BriteTapHelper::InstallTapDevices (&m_tapNodes, &m_tapDeviceNames);
@@ -577,6 +582,37 @@ void BriteTopologyHelper::DistributeClientNodesToMPISystems()
 #endif
 }
 
+void BriteTopologyHelper::RegisterClientLocations ()
+{
+  NetworkLocality *locality = NetworkLocality::GetInstance ();
+
+  for (std::map<std::string, Ptr<Node> >::const_iterator it = m_clients.begin (); it != m_clients.end (); ++it)
+    {
+      Ptr<Ipv4> ipv4 = ((*it).second)->GetObject<Ipv4> ();
+      std::map<std::string, Ptr<Node> >::const_iterator routerIt = m_clientsToRouters.find ((*it).first);
+      std::map<std::string, std::string>::const_iterator delayIt = m_clientLinkDelays.find ((*it).first);
+      if (ipv4 == 0 || routerIt == m_clientsToRouters.end () || delayIt == m_clientLinkDelays.end ())
+        {
+          continue;
+        }
+
+      // Clients belong to the AS of their access router (see DistributeClientNodesToMPISystems)
+      int32_t autonomousSystem = m_autonomousSystems[lexical_cast<std::string> (((*routerIt).second)->GetId ())];
+
+      // The link delay is interpreted the same way as when configuring the channel of the access link
+      Time accessLinkDelay ((*delayIt).second);
+
+      // Interface 0 is the loopback interface
+      for (uint32_t interface = 1; interface < ipv4->GetNInterfaces (); ++interface)
+        {
+          for (uint32_t address = 0; address < ipv4->GetNAddresses (interface); ++address)
+            {
+              locality->SetLocation (ipv4->GetAddress (interface, address).GetLocal ().Get (), autonomousSystem, ((*routerIt).second)->GetId (), accessLinkDelay);
+            }
+        }
+    }
+}
+
 bool BriteTopologyHelper::WriteLastTopologyToGraphVizFile (std::string fileName) const
 {
    // Open the output stream
@@ -55,6 +55,7 @@ private:
 protected:
   std::map<std::string, Ptr<Node> > m_clients;
   std::map<std::string, Ptr<Node> > m_clientsToRouters;
+  std::map<std::string, std::string> m_clientLinkDelays;
   std::string m_bandwidthSamplesFile;
   uint32_t m_minDelay;
   uint32_t m_maxDelay;
@@ -260,6 +261,14 @@ public:
    */
   void DistributeClientNodesToMPISystems();
 
+  /**
+   * Register the location (IP addresses, AS, access router and access link delay) of each client node with the NetworkLocality instance,
+   * so that strategies may rank potential peers by their topological distance.
+   *
+   * This method is automatically called by EstablishNetworkOnLastTopology after IP addresses have been assigned.
+   */
+  void RegisterClientLocations ();
+
   bool WriteLastTopologyToGraphVizFile (std::string fileName) const;
 };
 
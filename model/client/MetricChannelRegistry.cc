@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#include "MetricChannelRegistry.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+namespace pushpull {
+
+MetricChannelRegistry::MetricChannelRegistry ()
+{
+}
+
+MetricChannelRegistry::~MetricChannelRegistry ()
+{
+  m_channels.clear ();
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::RegisterCounter (const std::string &name)
+{
+  ChannelId id = FindChannel (name, COUNTER);
+  if (id == GetChannelCount ())
+    {
+      id = AddChannel (name, COUNTER);
+      m_channels[id].m_hasValue = true;
+    }
+
+  return id;
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::RegisterGauge (const std::string &name)
+{
+  ChannelId id = FindChannel (name, GAUGE);
+  if (id == GetChannelCount ())
+    {
+      id = AddChannel (name, GAUGE);
+    }
+
+  return id;
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::RegisterHistogram (const std::string &name, const std::vector<double> &bucketBounds)
+{
+  ChannelId id = FindChannel (name, HISTOGRAM);
+  if (id != GetChannelCount ())
+    {
+      return id;
+    }
+
+  id = AddChannel (name, HISTOGRAM);
+  Channel &channel = m_channels[id];
+  channel.m_hasValue = true;
+
+  // Step 1: Set up the buckets; the additional last bucket takes all values above the highest bound
+  channel.m_bucketBounds = bucketBounds;
+  std::sort (channel.m_bucketBounds.begin (), channel.m_bucketBounds.end ());
+  channel.m_bucketCounts.resize (channel.m_bucketBounds.size () + 1, 0);
+
+  // Step 2: Build the output names once, so announcing the histogram does not need to assemble strings
+  channel.m_outputNames.reserve (channel.m_bucketCounts.size () + 2);
+  channel.m_outputNames.push_back (name + ".count");
+  channel.m_outputNames.push_back (name + ".sum");
+  for (std::vector<double>::const_iterator it = channel.m_bucketBounds.begin (); it != channel.m_bucketBounds.end (); ++it)
+    {
+      std::stringstream ss;
+      ss << name << ".le-" << *it;
+      channel.m_outputNames.push_back (ss.str ());
+    }
+  channel.m_outputNames.push_back (name + ".le-inf");
+
+  return id;
+}
+
+void MetricChannelRegistry::Observe (ChannelId id, double value)
+{
+  Channel &channel = m_channels[id];
+
+  // The bounds are sorted, so the first bound not below the value denotes the bucket
+  uint32_t bucket = std::lower_bound (channel.m_bucketBounds.begin (), channel.m_bucketBounds.end (), value) - channel.m_bucketBounds.begin ();
+  ++channel.m_bucketCounts[bucket];
+  ++channel.m_count;
+  channel.m_value += value;
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::GetChannelCount () const
+{
+  return m_channels.size ();
+}
+
+const std::string& MetricChannelRegistry::GetName (ChannelId id) const
+{
+  return m_channels[id].m_name;
+}
+
+MetricChannelRegistry::ChannelType MetricChannelRegistry::GetType (ChannelId id) const
+{
+  return m_channels[id].m_type;
+}
+
+bool MetricChannelRegistry::HasValue (ChannelId id) const
+{
+  return m_channels[id].m_hasValue;
+}
+
+double MetricChannelRegistry::GetValue (ChannelId id) const
+{
+  return m_channels[id].m_value;
+}
+
+uint64_t MetricChannelRegistry::GetCount (ChannelId id) const
+{
+  return m_channels[id].m_count;
+}
+
+uint32_t MetricChannelRegistry::GetBucketCount (ChannelId id) const
+{
+  return m_channels[id].m_bucketCounts.size ();
+}
+
+uint64_t MetricChannelRegistry::GetBucketValue (ChannelId id, uint32_t bucket) const
+{
+  return m_channels[id].m_bucketCounts[bucket];
+}
+
+const std::vector<std::string>& MetricChannelRegistry::GetOutputNames (ChannelId id) const
+{
+  return m_channels[id].m_outputNames;
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::FindChannel (const std::string &name, ChannelType type) const
+{
+  ChannelId id = 0;
+  for (; id < GetChannelCount (); ++id)
+    {
+      if (m_channels[id].m_type == type && m_channels[id].m_name == name)
+        {
+          break;
+        }
+    }
+
+  return id;
+}
+
+MetricChannelRegistry::ChannelId MetricChannelRegistry::AddChannel (const std::string &name, ChannelType type)
+{
+  NS_ASSERT_MSG (m_channels.size () < 0xffff, "Too many metric channels registered.");
+
+  Channel channel;
+  channel.m_name = name;
+  channel.m_type = type;
+  channel.m_hasValue = false;
+  channel.m_value = 0;
+  channel.m_count = 0;
+  m_channels.push_back (channel);
+
+  return m_channels.size () - 1;
+}
+
+} // ns pushpull
+} // ns ns3
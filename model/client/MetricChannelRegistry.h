@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#ifndef METRICCHANNELREGISTRY_H_
+#define METRICCHANNELREGISTRY_H_
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace pushpull {
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Holds the typed, numeric metric channels of one PushPullClient instance.
+ *
+ * Strategies register the metrics they provide once (usually in their DoInitialize method) and obtain a numeric channel id
+ * in return. They subsequently update the values of their channels via that id, which does not involve any string handling
+ * or memory allocation. In regular intervals, the client announces the current values of all channels (see the
+ * PushPullClient::AnnounceMetricChannels method).
+ *
+ * Three types of channels are supported:\n
+ * <i>Counters</i> accumulate values (e.g., bytes or events) over the lifetime of the client.\n
+ * <i>Gauges</i> hold the last value set (e.g., a ratio calculated periodically). A gauge has no value until it is first set.\n
+ * <i>Histograms</i> count observations in buckets with fixed upper bounds and additionally keep the number and sum of all observations.
+ */
+class MetricChannelRegistry
+{
+// Types used
+public:
+  enum ChannelType
+  {
+    COUNTER = 0,
+    GAUGE = 1,
+    HISTOGRAM = 2
+  };
+
+  typedef uint16_t ChannelId;
+
+private:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    std::string              m_name;           // The name of the channel, used for output
+    ChannelType              m_type;           // The type of the channel
+    bool                     m_hasValue;       // Whether the channel currently holds a value (always true for counters and histograms)
+    double                   m_value;          // Counters: accumulated value; gauges: last value; histograms: sum of all observations
+    uint64_t                 m_count;          // Histograms: number of observations
+    std::vector<double>      m_bucketBounds;   // Histograms: inclusive upper bounds of the buckets, in ascending order
+    std::vector<uint64_t>    m_bucketCounts;   // Histograms: number of observations per bucket; the last entry counts values above all bounds
+    std::vector<std::string> m_outputNames;    // Histograms: pre-built output names "<name>.count", "<name>.sum", "<name>.le-<bound>"..., "<name>.le-inf"
+  } Channel;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  std::vector<Channel> m_channels;           // The registered channels, indexed by their id
+
+// Constructors etc.
+public:
+  MetricChannelRegistry ();
+  virtual ~MetricChannelRegistry ();
+
+// Channel registration
+public:
+  /**
+   * \brief Register a counter channel.
+   *
+   * If a channel with the same name and type was already registered, its id is returned instead.
+   *
+   * @param name the name of the channel.
+   *
+   * @returns the id of the channel.
+   */
+  ChannelId RegisterCounter (const std::string &name);
+
+  /**
+   * \brief Register a gauge channel.
+   *
+   * If a channel with the same name and type was already registered, its id is returned instead.
+   *
+   * @param name the name of the channel.
+   *
+   * @returns the id of the channel.
+   */
+  ChannelId RegisterGauge (const std::string &name);
+
+  /**
+   * \brief Register a histogram channel.
+   *
+   * If a channel with the same name and type was already registered, its id is returned instead and the given bounds are ignored.
+   *
+   * @param name the name of the channel.
+   * @param bucketBounds the inclusive upper bounds of the buckets, in ascending order. An additional bucket for values above the last bound is added automatically.
+   *
+   * @returns the id of the channel.
+   */
+  ChannelId RegisterHistogram (const std::string &name, const std::vector<double> &bucketBounds);
+
+// Value updates
+public:
+  /**
+   * \brief Add a value to a counter.
+   */
+  void Increment (ChannelId id, double amount)
+  {
+    m_channels[id].m_value += amount;
+  }
+
+  /**
+   * \brief Set the value of a gauge.
+   */
+  void Set (ChannelId id, double value)
+  {
+    m_channels[id].m_value = value;
+    m_channels[id].m_hasValue = true;
+  }
+
+  /**
+   * \brief Remove the value of a gauge, e.g., if it is currently undefined. Channels without value are not announced.
+   */
+  void Clear (ChannelId id)
+  {
+    m_channels[id].m_hasValue = false;
+  }
+
+  /**
+   * \brief Add an observation to a histogram.
+   */
+  void Observe (ChannelId id, double value);
+
+// Channel access
+public:
+  /**
+   * @returns the number of registered channels. Valid channel ids range from 0 to GetChannelCount () - 1.
+   */
+  ChannelId GetChannelCount () const;
+
+  const std::string& GetName (ChannelId id) const;
+
+  ChannelType GetType (ChannelId id) const;
+
+  /**
+   * @returns true, if the channel currently holds a value.
+   */
+  bool HasValue (ChannelId id) const;
+
+  /**
+   * @returns the accumulated value of a counter, the last value of a gauge or the sum of all observations of a histogram.
+   */
+  double GetValue (ChannelId id) const;
+
+  /**
+   * @returns the number of observations of a histogram.
+   */
+  uint64_t GetCount (ChannelId id) const;
+
+  /**
+   * @returns the number of buckets of a histogram, including the bucket for values above the last bound.
+   */
+  uint32_t GetBucketCount (ChannelId id) const;
+
+  /**
+   * @returns the number of observations in the given bucket of a histogram.
+   */
+  uint64_t GetBucketValue (ChannelId id, uint32_t bucket) const;
+
+  /**
+   * \brief Get the pre-built output names of a histogram.
+   *
+   * @returns the names "<name>.count", "<name>.sum" followed by one name per bucket.
+   */
+  const std::vector<std::string>& GetOutputNames (ChannelId id) const;
+
+// Internal methods
+private:
+  // Find a channel by name and type; returns GetChannelCount () if there is none
+  ChannelId FindChannel (const std::string &name, ChannelType type) const;
+
+  // Append a new channel without any values
+  ChannelId AddChannel (const std::string &name, ChannelType type);
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* METRICCHANNELREGISTRY_H_ */
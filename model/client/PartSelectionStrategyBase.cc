@@ -25,9 +25,14 @@
 #include "PushPullClient.h"
 #include "ns3/PushPullUtilities.h"
 #include "PushPullPeer.h"
+#include "PushPullVideoClient.h"
+#include "ns3/WallclockProfiler.h"
 
 #include "ns3/log.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <list>
 #include <map>
 #include <set>
@@ -44,11 +49,21 @@ PartSelectionStrategyBase::PartSelectionStrategyBase (Ptr<PushPullClient> myClie
   CheckDownloadCompleted ();
 
   // Step 2: Set up the basic working intervals of the strategy
+  m_myVideoClient = DynamicCast<PushPullVideoClient> (myClient);
   m_periodicInterval = Seconds (1);
 
   // Step 3: Set up the timeouts for connection failure/... heuristics
   m_requestPatience = Seconds (45);
   m_downloadPatience = Seconds (120);
+  m_endgame = false;
+  m_fastStart = false;
+  m_fastStartBegin = 0;
+  m_fastStartEnd = 0;
+  m_throttled = false;
+  m_throttleBegin = 0;
+  m_throttleEnd = 0;
+  m_seekBegin = 0;
+  m_seekEnd = 0;
 
   /*
    * Step 4: Initialize the data structures representing still needed pieces / blocks
@@ -76,9 +91,19 @@ void PartSelectionStrategyBase::DoInitialize ()
   // Step 1: Register with the client class instance
   m_myClient->RegisterCallbackBitfieldReceivedEvent (MakeCallback (&PartSelectionStrategyBase::ProcessBitfieldReceivedEvent, this));
   m_myClient->RegisterCallbackPeerHaveEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerHaveEvent,this));
+  m_myClient->RegisterCallbackPeerPieceUnavailableEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerPieceUnavailableEvent,this));
   m_myClient->RegisterCallbackBlockCompleteEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerBlockCompleteEvent,this));
   m_myClient->RegisterCallbackConnectionCloseEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerConnectionCloseEvent,this));
+  m_myClient->RegisterCallbackChokeChangingEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerChokeChangingEvent,this));
+  m_myClient->RegisterCallbackRejectRequestEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerRejectRequestEvent,this));
+  m_myClient->RegisterCallbackAllowedFastEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerAllowedFastEvent,this));
+  m_myClient->RegisterCallbackSuggestPieceEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerSuggestPieceEvent,this));
   m_myClient->RegisterCallbackStrategyOptionsChangedEvent (MakeCallback (&PartSelectionStrategyBase::ProcessStrategyOptionsChangedEvent, this));
+  if (m_myVideoClient)
+    {
+      m_myVideoClient->RegisterCallbackPlaybackSeekEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPlaybackSeekEvent, this));
+      m_myVideoClient->RegisterCallbackPlaybackStateChangedEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPlaybackStateChangedEvent, this));
+    }
 
   /*
    * Note: DO NOT START THE SCHEDULER RIGHT NOW! This will be done automatically when connection to a peer has been fully established!
@@ -228,6 +253,7 @@ void PartSelectionStrategyBase::RequestBlock (BlockRequested* block)
   (*block).m_requestedFrom->RequestPiece ((*block).m_pieceIndex, (*block).m_blockOffset, (*block).m_blockLength);
 
   // Step 2: Insert the request information for this block into the data structures
+  (*block).m_requestTime = Simulator::Now ();
   SaveRequest (block);
 
   // Step 3: If the block has not yet been requested from any peer, issue a PieceRequestedEvent
@@ -350,7 +376,7 @@ void PartSelectionStrategyBase::RemoveAllRequests (BlockRequested block, bool ca
           (**pbIt).m_timeoutEvent.Cancel ();
 
           // Step 3c: Delete the reference to the object in the list of open requests for the peer it was assigned to
-          RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.find (block.m_requestedFrom);
+          RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.find ((**pbIt).m_requestedFrom);
           if (rbmIt != m_requestedBlocks.end ())
             {
               std::list<BlockRequested*>::iterator pbIt2 = (*rbmIt).second.begin ();
@@ -409,6 +435,15 @@ void PartSelectionStrategyBase::ProcessPeerHaveEvent (Ptr<Peer> peer, uint32_t p
     }
 }
 
+void PartSelectionStrategyBase::ProcessPeerPieceUnavailableEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  // The peer may not offer any needed piece anymore; the scheduler then signals that we are not interested
+  if (m_neededPieces.find (pieceIndex) != m_neededPieces.end ())
+    {
+      Scheduler ();
+    }
+}
+
 void PartSelectionStrategyBase::ProcessPeerBlockCompleteEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
 {
   NS_LOG_INFO ("Peer " << peer->GetRemoteIp () << " sent me block " << pieceIndex << "@" << blockOffset << "->" << blockOffset + blockLength << ".");
@@ -432,6 +467,12 @@ void PartSelectionStrategyBase::ProcessPeerBlockCompleteEvent (Ptr<Peer> peer, u
       return;
     }
 
+  // Step 1b: The latency of the request drives the request window of the peer
+  if (m_myClient->GetAdaptivePipelining ())
+    {
+      UpdateRequestWindow (peer, Simulator::Now () - (**it).m_requestTime);
+    }
+
   // Step 2: Remove all instances to the block in all our data structures and cancel all pending requests
   RemoveAllRequests (block, true);
 
@@ -485,7 +526,8 @@ void PartSelectionStrategyBase::ProcessPeerBlockCompleteEvent (Ptr<Peer> peer, u
 void PartSelectionStrategyBase::ProcessPeerConnectionCloseEvent (Ptr<Peer> peer)
 {
   // A closed connection more or less is the same as a choked connection. Plus: We delete the references to this peer totally
-  ProcessPeerChokeChangingEvent (peer);
+  RemoveAllRequestsOfPeer (peer);
+  m_rejectedPieces.erase (peer);
   RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.find (peer);
   if (rbmIt != m_requestedBlocks.end ())
     {
@@ -496,6 +538,134 @@ void PartSelectionStrategyBase::ProcessPeerConnectionCloseEvent (Ptr<Peer> peer)
     {
       m_requestedPieces.erase (rpmIt);
     }
+  m_pipelines.erase (peer);
+}
+
+void PartSelectionStrategyBase::ProcessPeerChokeChangingEvent (Ptr<Peer> peer)
+{
+  if (peer->IsChoking ())
+    {
+      // Without the Fast Extension, the peer discards our requests silently; with it, they are served or rejected explicitly
+      if (!peer->GetFastExtension ())
+        {
+          RemoveAllRequestsOfPeer (peer);
+        }
+    }
+  else
+    {
+      m_rejectedPieces.erase (peer);
+    }
+
+  Scheduler ();
+}
+
+void PartSelectionStrategyBase::ProcessPeerRejectRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  NS_LOG_INFO ("Request " << pieceIndex << "@" << blockOffset << "->" << blockOffset + blockLength << " was rejected by peer " << peer->GetRemoteIp () << ".");
+
+  // Step 1: Find the rejected request; rejections of requests we cancelled or that already timed out are ignored
+  RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.find (peer);
+  if (rbmIt == m_requestedBlocks.end ())
+    {
+      return;
+    }
+  BlockRequested block (peer, pieceIndex, blockOffset, blockLength);
+  std::list<BlockRequested*>::iterator it = (*rbmIt).second.begin ();
+  while (it != (*rbmIt).second.end () && !((**it) == block))
+    {
+      ++it;
+    }
+  if (it == (*rbmIt).second.end ())
+    {
+      return;
+    }
+
+  // Step 2: Remove the request without cancelling it and remember that the peer does not serve the piece for now
+  (**it).m_timeoutEvent.Cancel ();
+  RemoveRequest (block, false);
+  m_rejectedPieces[peer].insert (pieceIndex);
+
+  // Step 3: If no other block of this piece is wanted anymore, issue a PieceCancelledEvent
+  NeededPiecesMap::iterator npmIt = m_neededPieces.find (pieceIndex);
+  if (npmIt != m_neededPieces.end () && (*npmIt).second.m_pendingBlocks.empty ())
+    {
+      m_myClient->PieceCancelledEvent (peer, pieceIndex);
+    }
+
+  // Step 4: Re-assign the block right away
+  Scheduler ();
+}
+
+void PartSelectionStrategyBase::ProcessPeerAllowedFastEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  if (peer->IsChoking () && peer->HasPiece (pieceIndex) && m_neededPieces.find (pieceIndex) != m_neededPieces.end ())
+    {
+      Scheduler ();
+    }
+}
+
+void PartSelectionStrategyBase::ProcessPeerSuggestPieceEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  if (peer->HasPiece (pieceIndex) && m_neededPieces.find (pieceIndex) != m_neededPieces.end ())
+    {
+      Scheduler ();
+    }
+}
+
+void PartSelectionStrategyBase::ProcessPlaybackSeekEvent (uint32_t oldPiece, uint32_t newPiece)
+{
+  // Step 1: Determine the pieces whose requests are still relevant
+  uint32_t relevantPieces = std::max (static_cast<uint32_t> (PP_SEEK_RELEVANT_PIECES), m_myVideoClient->DurationToPieces (newPiece, m_myVideoClient->GetPreBufferingTime ()) + 1);
+  uint32_t relevantEnd = newPiece + relevantPieces;
+
+  NS_LOG_INFO ("Playback jumped from piece " << oldPiece << " to piece " << newPiece << "; cancelling requests outside of pieces " << newPiece << "->" << relevantEnd << ".");
+
+  // Step 2: In one pass over the pending requests of all peers, cancel the requests for pieces outside of the relevant range
+  std::set<std::pair<Ptr<Peer>, uint32_t> > cancelledPieces;
+  for (RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.begin (); rbmIt != m_requestedBlocks.end (); ++rbmIt)
+    {
+      // RemoveRequest also removes the block from the peer's list, so we work on a copy
+      std::list<BlockRequested*> blocks = (*rbmIt).second;
+      for (std::list<BlockRequested*>::iterator it = blocks.begin (); it != blocks.end (); ++it)
+        {
+          if ((**it).m_pieceIndex >= newPiece && (**it).m_pieceIndex < relevantEnd)
+            {
+              continue;
+            }
+
+          BlockRequested block = **it;
+          block.m_timeoutEvent.Cancel ();
+          RemoveRequest (block, true);
+          cancelledPieces.insert (std::make_pair (block.m_requestedFrom, block.m_pieceIndex));
+        }
+    }
+
+  // Step 3: Issue a PieceCancelledEvent for each piece no block of which is wanted anymore
+  for (std::set<std::pair<Ptr<Peer>, uint32_t> >::const_iterator it = cancelledPieces.begin (); it != cancelledPieces.end (); ++it)
+    {
+      NeededPiecesMap::iterator npmIt = m_neededPieces.find ((*it).second);
+      if (npmIt != m_neededPieces.end () && (*npmIt).second.m_pendingBlocks.empty ())
+        {
+          m_myClient->PieceCancelledEvent ((*it).first, (*it).second);
+        }
+    }
+
+  // Step 4: Refill the request windows around the new playback position right away; the kept range precedes other choices (see GetSeekBlockForPeer)
+  m_seekBegin = newPiece;
+  m_seekEnd = relevantEnd;
+  Scheduler ();
+}
+
+void PartSelectionStrategyBase::ProcessPlaybackStateChangedEvent ()
+{
+  /*
+   * The buffering flag of the video client is only set after the state change was announced,
+   * so we check for the start of a buffering phase once the current event has been processed
+   */
+  if (m_myVideoClient->GetFastStart () && !m_myClient->GetDownloadCompleted ())
+    {
+      Simulator::ScheduleNow (&PartSelectionStrategyBase::Scheduler, this);
+    }
 }
 
 void PartSelectionStrategyBase::ProcessRequestTimeout (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
@@ -506,6 +676,13 @@ void PartSelectionStrategyBase::ProcessRequestTimeout (Ptr<Peer> peer, uint32_t
   // Step 2: Remvove the request from the data structures
   RemoveRequest (BlockRequested (peer, pieceIndex, blockOffset, blockLength), true);
 
+  // Step 2a: A timed-out request indicates an overloaded peer, so its request window is halved
+  PipelineStateMap::iterator psmIt = m_pipelines.find (peer);
+  if (psmIt != m_pipelines.end ())
+    {
+      (*psmIt).second.m_window = std::max (static_cast<uint16_t> (PP_PIPELINE_MIN_REQUESTS), static_cast<uint16_t> ((*psmIt).second.m_window / 2));
+    }
+
   // Step 3: If no other block of this piece is wanted anymore, issue a PieceCancelledEvent
   if (m_neededPieces[pieceIndex].m_pendingBlocks.size () == 0)
     {
@@ -554,7 +731,11 @@ bool PartSelectionStrategyBase::RequestAllowedForBlock (Ptr<Peer> peer, uint32_t
    * 3) The number of already-pending blocks for this peer must not be exceeded
    * 4) The number of already-pending requests for this piece for the given peer must not be exceeded
    * 5) The number of already-pending requests for this particular block must not be exceeded (!= criterion 2!)
+   * In endgame mode, criterion 2 is skipped and criterion 5 allows at least PP_ENDGAME_MAX_REQUESTS_PER_BLOCK requests.
+   * In fast start mode, criterion 2 is skipped and criterion 4 allows at most PP_FAST_START_REQUESTS_PER_PEER_PER_PIECE requests for the pieces of the pre-buffering range.
+   * While throttled, only the pieces within the high buffer watermark from the playback position are wanted (criterion 1b).
    */
+  bool fastStartPiece = m_fastStart && pieceIndex >= m_fastStartBegin && pieceIndex < m_fastStartEnd;
 
   // Criterion 1: The piece must be wanted
   NeededPiecesMap::iterator npmIt = m_neededPieces.find (pieceIndex);
@@ -562,18 +743,30 @@ bool PartSelectionStrategyBase::RequestAllowedForBlock (Ptr<Peer> peer, uint32_t
     {
       return false;
     }
+  // Criterion 1a: The peer must not have rejected a request for this piece since it last unchoked us
+  RequestedPiecesMap::const_iterator rpmIt = m_rejectedPieces.find (peer);
+  if (rpmIt != m_rejectedPieces.end () && (*rpmIt).second.count (pieceIndex) > 0)
+    {
+      return false;
+    }
+  // Criterion 1b: While throttled, the piece must lie within the buffer target
+  else if (m_throttled && (pieceIndex < m_throttleBegin || pieceIndex >= m_throttleEnd))
+    {
+      return false;
+    }
   // Criterion 2: Not more than the allowed number of block requests per piece
-  else if ((*npmIt).second.m_pendingBlocks.size () >= m_myClient->GetMaxRequestsPerPiece ())
+  else if (!m_endgame && !fastStartPiece && (*npmIt).second.m_pendingBlocks.size () >= m_myClient->GetMaxRequestsPerPiece ())
     {
       return false;
     }
   // Criterion 3: Not more than the allowed number of requests for this peer
-  else if (m_requestedBlocks[peer].size () >= m_myClient->GetMaxRequestsPerPeer ())
+  else if (m_requestedBlocks[peer].size () >= GetRequestWindow (peer))
     {
       return false;
     }
   // Criterion 4: Not more than the allowed number of requests for this piece for the given peer
-  else if ((*npmIt).second.m_requestedFrom.count (peer) >= m_myClient->GetMaxRequestsPerPeerPerPiece ())
+  else if ((*npmIt).second.m_requestedFrom.count (peer) >= (fastStartPiece ? std::min (m_myClient->GetMaxRequestsPerPeerPerPiece (), static_cast<uint16_t> (PP_FAST_START_REQUESTS_PER_PEER_PER_PIECE))
+                                                                           : m_myClient->GetMaxRequestsPerPeerPerPiece ()))
     {
       return false;
     }
@@ -582,6 +775,10 @@ bool PartSelectionStrategyBase::RequestAllowedForBlock (Ptr<Peer> peer, uint32_t
     {
       BlockRequested toFind (pieceIndex, blockOffset, blockLength);
       uint16_t leftRequests = m_myClient->GetMaxRequestsPerBlock ();
+      if (m_endgame)
+        {
+          leftRequests = std::max (leftRequests, static_cast<uint16_t> (PP_ENDGAME_MAX_REQUESTS_PER_BLOCK));
+        }
 
       std::list<BlockRequested*>::iterator it = (*npmIt).second.m_pendingBlocks.begin ();
       while (leftRequests > 0 && it != (*npmIt).second.m_pendingBlocks.end ())
@@ -608,15 +805,22 @@ void PartSelectionStrategyBase::GetHighestPriorityBlockForPeer (Ptr<Peer> peer,
   blockPtr.m_requestedFrom = peer;
   blockPtr.m_blockLength = 0;
 
-  // Step 2: Calculate the timeout of a piece by taking into account how many requests are already running for this peer
-  blockPtr.m_timeoutTime =
-    Simulator::Now () +
-    MilliSeconds ((1 + m_requestedBlocks[peer].size ()) * m_myClient->GetPieceTimeout ().GetMilliSeconds () / m_blocksPerPiece);
+  // Step 2: Calculate the timeout of the request
+  blockPtr.m_timeoutTime = Simulator::Now () + GetRequestTimeout (peer);
 
-  // Step 3: Return needed blocks for piece in-order
+  // Step 3: Return needed blocks for piece in-order; for video clients, starting at the playback position and wrapping around to the pieces before it
   NeededPiecesMap::iterator npmIt = m_neededPieces.begin ();
-  while (npmIt != m_neededPieces.end ())
+  if (m_myVideoClient)
+    {
+      npmIt = m_neededPieces.lower_bound (m_myVideoClient->GetCurrentPiece ());
+    }
+  for (uint32_t visited = 0; visited < m_neededPieces.size (); ++visited, ++npmIt)
     {
+      if (npmIt == m_neededPieces.end ())
+        {
+          npmIt = m_neededPieces.begin ();
+        }
+
       std::list<std::pair<uint32_t, uint32_t> >::iterator blockIt = (*npmIt).second.m_possibleBlocks.begin ();
       while (blockIt != (*npmIt).second.m_possibleBlocks.end ())
         {
@@ -625,22 +829,49 @@ void PartSelectionStrategyBase::GetHighestPriorityBlockForPeer (Ptr<Peer> peer,
               blockPtr.m_pieceIndex = (*npmIt).second.m_pieceIndex;
               blockPtr.m_blockOffset = (*blockIt).first;
               blockPtr.m_blockLength = (*blockIt).second - (*blockIt).first;
-              npmIt = m_neededPieces.end ();
-              --npmIt;
-              break;
+              return;
             }
           else
             {
               ++blockIt;
             }
         }
+    }
+}
 
-      ++npmIt;
+void PartSelectionStrategyBase::GetAllowedFastBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr)
+{
+  blockPtr.m_requestedFrom = peer;
+  blockPtr.m_blockLength = 0;
+
+  // Return the first requestable block among the needed pieces the peer has and allows us to request fast
+  const std::set<uint32_t> &allowedFast = peer->GetAllowedFastPieces ();
+  for (std::set<uint32_t>::const_iterator it = allowedFast.begin (); it != allowedFast.end (); ++it)
+    {
+      NeededPiecesMap::iterator npmIt = m_neededPieces.find (*it);
+      if (npmIt == m_neededPieces.end () || !peer->HasPiece (*it))
+        {
+          continue;
+        }
+
+      std::list<std::pair<uint32_t, uint32_t> >::iterator blockIt = (*npmIt).second.m_possibleBlocks.begin ();
+      for (; blockIt != (*npmIt).second.m_possibleBlocks.end (); ++blockIt)
+        {
+          if (RequestAllowedForBlock (peer, *it, (*blockIt).first, (*blockIt).second - (*blockIt).first))
+            {
+              blockPtr.m_pieceIndex = *it;
+              blockPtr.m_blockOffset = (*blockIt).first;
+              blockPtr.m_blockLength = (*blockIt).second - (*blockIt).first;
+              return;
+            }
+        }
     }
 }
 
 void PartSelectionStrategyBase::Scheduler ()
 {
+  PP_PROFILE_SCOPE (PART_SELECTION_SCHEDULER);
+
   // Step 1: Get the list of available peers
   const std::vector<Ptr<Peer> > &peerlist = m_myClient->GetActivePeers ();
 
@@ -652,6 +883,50 @@ void PartSelectionStrategyBase::Scheduler ()
 
   // Step 3: Randomly iterate through the list of peers and assign requests to them if applicable
   std::list<uint32_t> requestOrder = GetPeerOrderForScheduler ();
+
+  // While a video client buffers, the pieces needed to resume playback are striped across the peers
+  m_fastStart = IsFastStart ();
+  if (m_fastStart)
+    {
+      m_fastStartBegin = m_myVideoClient->GetCurrentPiece ();
+      m_fastStartEnd = m_fastStartBegin + m_myVideoClient->DurationToPieces (m_fastStartBegin, m_myVideoClient->GetPreBufferingTime ()) + 1;
+    }
+
+  // While a video client's buffer is healthy, nothing beyond the buffer target is requested
+  bool wasThrottled = m_throttled;
+  m_throttled = IsThrottled ();
+  if (m_throttled)
+    {
+      m_throttleBegin = m_myVideoClient->GetCurrentPiece ();
+      m_throttleEnd = m_throttleBegin + m_myVideoClient->DurationToPieces (m_throttleBegin, m_myVideoClient->GetBufferHighWatermark ()) + 1;
+    }
+  if (m_throttled != wasThrottled)
+    {
+      NS_LOG_INFO ("Client " << m_myClient->GetNode ()->GetId () << (m_throttled ? " throttles" : " resumes") << " downloading at piece " << m_myVideoClient->GetCurrentPiece () << ".");
+    }
+
+  // In endgame mode, the fastest peers are asked first instead (ties keep their random order)
+  bool wasEndgame = m_endgame;
+  m_endgame = IsEndgame ();
+  if (m_endgame)
+    {
+      if (!wasEndgame)
+        {
+          NS_LOG_INFO ("Client " << m_myClient->GetNode ()->GetId () << " entered endgame mode.");
+        }
+
+      std::multimap<double, uint32_t, std::greater<double> > peersByRate;
+      for (std::list<uint32_t>::const_iterator it = requestOrder.begin (); it != requestOrder.end (); ++it)
+        {
+          peersByRate.insert (std::make_pair (peerlist[(*it) - 1]->GetBpsDownload (), *it));
+        }
+      requestOrder.clear ();
+      for (std::multimap<double, uint32_t, std::greater<double> >::const_iterator it = peersByRate.begin (); it != peersByRate.end (); ++it)
+        {
+          requestOrder.push_back ((*it).second);
+        }
+    }
+
   for (std::list<uint32_t>::const_iterator it = requestOrder.begin (); it != requestOrder.end (); ++it)
     {
       Ptr<Peer> currentPeer = peerlist[(*it) - 1];
@@ -662,8 +937,9 @@ void PartSelectionStrategyBase::Scheduler ()
         }
       std::list<BlockRequested*>& requestedBlocks = (*rbmIt).second;
 
-      // Step 3a: We send out as many requests per peer as our client's setting allows us to
-      while (requestedBlocks.size () < m_myClient->GetMaxRequestsPerPeer ())
+      // Step 3a: We send out as many requests per peer as our client's setting (or the peer's adaptive request window) allows us to
+      uint16_t requestWindow = GetRequestWindow (currentPeer);
+      while (requestedBlocks.size () < requestWindow)
         {
           BlockRequested* block = new BlockRequested ();
           GetHighestPriorityBlockForPeer (currentPeer, *block);
@@ -671,18 +947,19 @@ void PartSelectionStrategyBase::Scheduler ()
           // Step 3a1: If the blockLength is > 0, we found a valid request for this peer
           if ((*block).m_blockLength > 0)
             {
-              // Step 3a1a: If the peer is choking us, the only thing we can do is announce our interest in the peer
+              // Step 3a1a: If the peer is choking us, we announce our interest in the peer and may only request what it allowed us to request fast
               if (currentPeer->IsChoking ())
                 {
                   currentPeer->SetAmInterested (true);
-                  
-                  // OLD
-                  // break;
-                  
-                  // MEMORY
-                  delete block;
-                  break;
-                  // /MEMORY
+
+                  GetAllowedFastBlockForPeer (currentPeer, *block);
+                  if ((*block).m_blockLength == 0)
+                    {
+                      // MEMORY
+                      delete block;
+                      break;
+                      // /MEMORY
+                    }
                 }
 
               // Step 3a1b: Set up timeouts for this block
@@ -708,6 +985,195 @@ void PartSelectionStrategyBase::Scheduler ()
     }
 }
 
+uint16_t PartSelectionStrategyBase::GetRequestWindow (Ptr<Peer> peer)
+{
+  if (!m_myClient->GetAdaptivePipelining ())
+    {
+      return RaiseRequestWindow (m_myClient->GetMaxRequestsPerPeer ());
+    }
+
+  // Newly-seen peers start with the client's static setting
+  PipelineStateMap::iterator psmIt = m_pipelines.find (peer);
+  if (psmIt == m_pipelines.end ())
+    {
+      PipelineState state;
+      state.m_window = std::max (static_cast<uint16_t> (PP_PIPELINE_MIN_REQUESTS), std::min (static_cast<uint16_t> (PP_PIPELINE_MAX_REQUESTS), m_myClient->GetMaxRequestsPerPeer ()));
+      state.m_minRoundTripTime = Seconds (0);
+      state.m_minRoundTripTimeStamp = Simulator::Now ();
+      psmIt = m_pipelines.insert (std::make_pair (peer, state)).first;
+    }
+
+  return RaiseRequestWindow ((*psmIt).second.m_window);
+}
+
+Time PartSelectionStrategyBase::GetRequestTimeout (Ptr<Peer> peer)
+{
+  // Step 1: Take into account how many requests are already running for this peer
+  Time timeout = MilliSeconds ((1 + m_requestedBlocks[peer].size ()) * m_myClient->GetPieceTimeout ().GetMilliSeconds () / m_blocksPerPiece);
+
+  // Step 2: With adaptive pipelining, the timeout is derived from the expected completion time of the request instead
+  PipelineStateMap::iterator psmIt = m_pipelines.find (peer);
+  double bpsDownload = peer->GetBpsDownload ();
+  if (m_myClient->GetAdaptivePipelining () && psmIt != m_pipelines.end () && (*psmIt).second.m_minRoundTripTime.IsStrictlyPositive () && bpsDownload > 0)
+    {
+      Time expectedCompletion = (*psmIt).second.m_minRoundTripTime + Seconds ((1 + m_requestedBlocks[peer].size ()) * 8.0 * m_myClient->GetRequestBlockSize () / bpsDownload);
+      timeout = std::max (MilliSeconds (m_myClient->GetPieceTimeout ().GetMilliSeconds () / m_blocksPerPiece), expectedCompletion * PP_PIPELINE_TIMEOUT_FACTOR);
+    }
+
+  return timeout;
+}
+
+uint16_t PartSelectionStrategyBase::RaiseRequestWindow (uint16_t window) const
+{
+  // Only the raised window of fast start mode is capped; the user's own setting is kept as it is
+  if (!m_fastStart)
+    {
+      return window;
+    }
+
+  uint32_t raised = std::min (static_cast<uint32_t> (PP_PIPELINE_MAX_REQUESTS), static_cast<uint32_t> (PP_FAST_START_PIPELINE_FACTOR) * window);
+  return static_cast<uint16_t> (std::max (static_cast<uint32_t> (window), raised));
+}
+
+void PartSelectionStrategyBase::UpdateRequestWindow (Ptr<Peer> peer, Time latency)
+{
+  GetRequestWindow (peer);
+  PipelineState &state = m_pipelines[peer];
+
+  // Step 1: Update the round-trip time estimate; a sample older than the filter period is replaced so that route changes are picked up
+  if (!state.m_minRoundTripTime.IsStrictlyPositive () || latency <= state.m_minRoundTripTime
+      || Simulator::Now () - state.m_minRoundTripTimeStamp > MilliSeconds (PP_PIPELINE_RTT_FILTER_WINDOW))
+    {
+      state.m_minRoundTripTime = latency;
+      state.m_minRoundTripTimeStamp = Simulator::Now ();
+    }
+
+  // Step 2: Size the window from the bandwidth-delay product, or grow it while the download rate is unknown
+  double bpsDownload = peer->GetBpsDownload ();
+  uint32_t window;
+  if (bpsDownload > 0)
+    {
+      double bdpBytes = bpsDownload / 8 * state.m_minRoundTripTime.GetSeconds ();
+      window = static_cast<uint32_t> (std::ceil (PP_PIPELINE_BDP_GAIN * bdpBytes / m_myClient->GetRequestBlockSize ())) + 1;
+    }
+  else
+    {
+      window = state.m_window + 1;
+    }
+
+  state.m_window = std::max (static_cast<uint32_t> (PP_PIPELINE_MIN_REQUESTS), std::min (static_cast<uint32_t> (PP_PIPELINE_MAX_REQUESTS), window));
+}
+
+bool PartSelectionStrategyBase::IsEndgame ()
+{
+  uint32_t endgameBlocks = m_myClient->GetEndgameBlocks ();
+  if (endgameBlocks == 0)
+    {
+      return false;
+    }
+
+  // Count the blocks still missing; we stop as soon as the threshold is exceeded
+  uint32_t remainingBlocks = 0;
+  for (NeededPiecesMap::const_iterator npmIt = m_neededPieces.begin (); npmIt != m_neededPieces.end (); ++npmIt)
+    {
+      remainingBlocks += (*npmIt).second.m_possibleBlocks.size ();
+      if (remainingBlocks > endgameBlocks)
+        {
+          return false;
+        }
+    }
+
+  return remainingBlocks > 0;
+}
+
+bool PartSelectionStrategyBase::IsFastStart ()
+{
+  return m_myVideoClient && m_myVideoClient->GetFastStart () && m_myVideoClient->IsBuffering ();
+}
+
+bool PartSelectionStrategyBase::IsThrottled ()
+{
+  if (!m_myVideoClient || m_myVideoClient->GetBufferHighWatermark () == Seconds (0) || !m_myVideoClient->IsPlaying ()
+      || m_myVideoClient->IsBuffering ())
+    {
+      return false;
+    }
+
+  // Hysteresis: Once throttled, keep on throttling until the buffer drains to the low watermark
+  uint32_t currentPiece = m_myVideoClient->GetCurrentPiece ();
+  Time buffered = m_myVideoClient->PiecesToDuration (currentPiece, m_myVideoClient->GetContinousPiecesFromPiece (currentPiece));
+  if (m_throttled)
+    {
+      return buffered > m_myVideoClient->GetBufferLowWatermark ();
+    }
+  else
+    {
+      return buffered >= m_myVideoClient->GetBufferHighWatermark ();
+    }
+}
+
+void PartSelectionStrategyBase::GetFastStartBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr)
+{
+  blockPtr.m_requestedFrom = peer;
+  blockPtr.m_blockLength = 0;
+
+  if (!m_fastStart)
+    {
+      return;
+    }
+
+  GetFirstAllowedBlockInRange (peer, m_fastStartBegin, m_fastStartEnd, blockPtr);
+}
+
+void PartSelectionStrategyBase::GetSeekBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr)
+{
+  blockPtr.m_requestedFrom = peer;
+  blockPtr.m_blockLength = 0;
+
+  if (m_seekBegin == m_seekEnd)
+    {
+      return;
+    }
+
+  // Drop the range once all of its pieces have been downloaded
+  NeededPiecesMap::const_iterator npmIt = m_neededPieces.lower_bound (m_seekBegin);
+  if (npmIt == m_neededPieces.end () || (*npmIt).first >= m_seekEnd)
+    {
+      m_seekEnd = m_seekBegin;
+      return;
+    }
+
+  GetFirstAllowedBlockInRange (peer, (*npmIt).first, m_seekEnd, blockPtr);
+}
+
+void PartSelectionStrategyBase::GetFirstAllowedBlockInRange (Ptr<Peer> peer, uint32_t begin, uint32_t end, BlockRequested& blockPtr)
+{
+  blockPtr.m_requestedFrom = peer;
+  blockPtr.m_blockLength = 0;
+
+  NeededPiecesMap::iterator npmIt = m_neededPieces.lower_bound (begin);
+  for (; npmIt != m_neededPieces.end () && (*npmIt).first < end; ++npmIt)
+    {
+      // Only pieces the peer has announced can be requested from it
+      if (!peer->HasPiece ((*npmIt).first))
+        {
+          continue;
+        }
+
+      std::list<std::pair<uint32_t, uint32_t> >::iterator blockIt = (*npmIt).second.m_possibleBlocks.begin ();
+      for (; blockIt != (*npmIt).second.m_possibleBlocks.end (); ++blockIt)
+        {
+          if (RequestAllowedForBlock (peer, (*npmIt).first, (*blockIt).first, (*blockIt).second - (*blockIt).first))
+            {
+              blockPtr.m_pieceIndex = (*npmIt).first;
+              blockPtr.m_blockOffset = (*blockIt).first;
+              blockPtr.m_blockLength = (*blockIt).second - (*blockIt).first;
+              return;
+            }
+        }
+    }
+}
+
 inline std::list<uint32_t> PartSelectionStrategyBase::GetPeerOrderForScheduler ()
 {
   return Utilities::GetPermutationP (m_myClient->GetActivePeers ().size (), m_myClient->GetActivePeers ().size ());
@@ -740,6 +1206,30 @@ void PartSelectionStrategyBase::ProcessPeriodicSchedule ()
     }
 }
 
+void PartSelectionStrategyBase::RemoveAllRequestsOfPeer (Ptr<Peer> peer)
+{
+  RequestedBlocksMap::iterator rbmIt = m_requestedBlocks.find (peer);
+  if (rbmIt == m_requestedBlocks.end ())
+    {
+      return;
+    }
+
+  // RemoveRequest also removes the block from the peer's list, so we work on a copy
+  std::list<BlockRequested*> blocks = (*rbmIt).second;
+  for (std::list<BlockRequested*>::iterator it = blocks.begin (); it != blocks.end (); ++it)
+    {
+      BlockRequested block = **it;
+      block.m_timeoutEvent.Cancel ();
+      RemoveRequest (block, false);
+
+      NeededPiecesMap::iterator npmIt = m_neededPieces.find (block.m_pieceIndex);
+      if (npmIt != m_neededPieces.end () && (*npmIt).second.m_pendingBlocks.empty ())
+        {
+          m_myClient->PieceCancelledEvent (peer, block.m_pieceIndex);
+        }
+    }
+}
+
 void PartSelectionStrategyBase::DebugPrint ()
 {
   std::cout << "Needed pieces -->" << std::endl;
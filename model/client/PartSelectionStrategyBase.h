@@ -36,6 +36,7 @@ namespace ns3 {
 namespace pushpull {
 
 class PushPullClient;
+class PushPullVideoClient;
 class Peer;
 
 /**
@@ -75,6 +76,7 @@ protected:
 
     Time m_timeoutTime;
     EventId m_timeoutEvent;
+    Time m_requestTime;
 
     Ptr<Peer> m_requestedFrom;
 
@@ -189,17 +191,41 @@ protected:
   typedef std::map<Ptr<Peer>, std::list<BlockRequested*> >      RequestedBlocksMap;      // Stores information about blocks currently pending, sorted by peer
   typedef std::map<Ptr<Peer>, std::set<uint32_t> >              RequestedPiecesMap;      // Stores information about pieces currently pending, sorted by peer
 
+  /// @cond HIDDEN
+  typedef struct
+  {
+    uint16_t m_window;                   // The current number of concurrent requests allowed for the peer
+    Time     m_minRoundTripTime;         // The minimum request latency observed within the current filter period; zero if not yet measured
+    Time     m_minRoundTripTimeStamp;    // When m_minRoundTripTime was observed
+  } PipelineState;
+  /// @endcond HIDDEN
+
+  typedef std::map<Ptr<Peer>, PipelineState>                   PipelineStateMap;        // Stores the adaptive request window, by peer
+
 // Fields
 protected:
+  Ptr<PushPullVideoClient>   m_myVideoClient;              // The associated client as a video client, if it is one; used to follow the playback position
+
   // Main data structures
   NeededPiecesMap            m_neededPieces;               // Holds information for all blocks (by piece) which have not yet been downloaded
   RequestedBlocksMap         m_requestedBlocks;            // The blocks which are currently being downloaded, by peer
   RequestedPiecesMap         m_requestedPieces;            // The pieces which are currently being downloaded, by peer
+  PipelineStateMap           m_pipelines;                  // The request windows for adaptive pipelining, by peer
+  RequestedPiecesMap         m_rejectedPieces;             // The pieces whose requests were rejected (Fast Extension), by peer; not requested from that peer again until it unchokes us
 
   // Settings
   Time                       m_periodicInterval;           // The time span between trying to assign piece REQUESTs to peers, if no other event (like HAVE messages) occur in-between
   EventId                    m_nextPeriodicEvent;          // The next scheduled assignment event
   uint32_t                   m_blocksPerPiece;             // The number of blocks that each piece is divided into; for easier calculation of timeouts (see constructor)
+  bool                       m_endgame;                    // Whether the scheduler currently runs in endgame mode (see PushPullClient::SetEndgameBlocks); updated with each scheduler run
+  bool                       m_fastStart;                  // Whether the scheduler currently runs in fast start mode (see IsFastStart); updated with each scheduler run
+  uint32_t                   m_fastStartBegin;             // The first piece of the range striped across the peers in fast start mode
+  uint32_t                   m_fastStartEnd;               // The piece after the last piece of the range striped across the peers in fast start mode
+  bool                       m_throttled;                  // Whether requests beyond the buffer target are held back (see IsThrottled); updated with each scheduler run
+  uint32_t                   m_throttleBegin;              // The first piece that may be requested while throttled
+  uint32_t                   m_throttleEnd;                // The piece after the last piece that may be requested while throttled
+  uint32_t                   m_seekBegin;                  // The first piece of the range kept by the last seek (see ProcessPlaybackSeekEvent)
+  uint32_t                   m_seekEnd;                    // The piece after the last piece of the range kept by the last seek; equal to m_seekBegin if there is none
 
   // Heuristics (not used as of now)
   /// @cond HIDDEN
@@ -326,6 +352,50 @@ protected:
    */
   void RemoveAllRequests (BlockRequested block, bool cancel);
 
+  /**
+   * \brief Get the number of requests that may concurrently be pending at a peer.
+   *
+   * Without adaptive pipelining (see PushPullClient::SetAdaptivePipelining), this is the client's maximum number of requests per peer.
+   * With adaptive pipelining, it is the peer's current request window. In fast start mode (see IsFastStart), the result is raised by PP_FAST_START_PIPELINE_FACTOR.
+   */
+  uint16_t GetRequestWindow (Ptr<Peer> peer);
+
+  /**
+   * \brief Internal method. Calculate the timeout of a new request to a peer, to be used by implementations of GetHighestPriorityBlockForPeer.
+   *
+   * By default, the piece timeout is split among the blocks of a piece and multiplied by the number of requests already running for the peer.
+   * With adaptive pipelining, the timeout is instead derived from the peer's minimum round-trip time and the time needed to transfer the
+   * running requests at the peer's download rate, multiplied by PP_PIPELINE_TIMEOUT_FACTOR.
+   *
+   * @returns the time after which the new request times out.
+   */
+  Time GetRequestTimeout (Ptr<Peer> peer);
+
+  /**
+   * \brief Internal method. Raise a request window by PP_FAST_START_PIPELINE_FACTOR in fast start mode.
+   *
+   * The raised value is capped at PP_PIPELINE_MAX_REQUESTS, but never below the given window. Outside of fast start mode, the window is returned unchanged.
+   *
+   * @returns the request window to use.
+   */
+  uint16_t RaiseRequestWindow (uint16_t window) const;
+
+  /**
+   * \brief Internal method. Update the request window of a peer from the latency of a completed request and the download rate from that peer.
+   *
+   * The round-trip time is estimated as the minimum latency within the last PP_PIPELINE_RTT_FILTER_WINDOW milliseconds, since the latency of pipelined
+   * requests also includes their queueing time. The window then covers PP_PIPELINE_BDP_GAIN times the bandwidth-delay product. If the download rate is not yet known,
+   * the window grows by one request per completed request.
+   */
+  void UpdateRequestWindow (Ptr<Peer> peer, Time latency);
+
+  /**
+   * \brief Internal method. Remove all requests pending at a peer from the internal data structures, without cancelling them.
+   *
+   * The removed blocks are marked as needed again, so that they can be requested from other peers.
+   */
+  void RemoveAllRequestsOfPeer (Ptr<Peer> peer);
+
 // Event listeners
 public:
   // PushPull event listeners (PeerWireProtocol, other events)
@@ -342,6 +412,12 @@ public:
    */
   virtual void ProcessPeerHaveEvent (Ptr<Peer> peer, uint32_t pieceIndex);
 
+  /**
+   * \brief This method re-runs the scheduler when a needed piece left the availability window of a peer, so that the client
+   * signals that it is not interested anymore if the peer has nothing left to offer.
+   */
+  virtual void ProcessPeerPieceUnavailableEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
   /**
    * \brief Process a completed piece.
    *
@@ -369,6 +445,52 @@ public:
    */
   virtual void ProcessPeerConnectionCloseEvent (Ptr<Peer> peer);
 
+  /**
+   * \brief Process a change of the choke state of a peer.
+   *
+   * Without the Fast Extension, a choke implicitly discards all requests pending at the peer, so they are removed and re-assigned to other peers.
+   * With the Fast Extension, they are kept until the peer serves or explicitly rejects them. An unchoke allows rejected pieces to be requested
+   * from the peer again.
+   */
+  virtual void ProcessPeerChokeChangingEvent (Ptr<Peer> peer);
+
+  /**
+   * \brief Process a rejected request (Fast Extension).
+   *
+   * The rejected block is marked as needed again and immediately re-assigned by calling the scheduler, instead of waiting for the request to time out.
+   * The piece is not requested from the rejecting peer again until it unchokes the client.
+   */
+  virtual void ProcessPeerRejectRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Start scheduling if a choking peer allows the client to request a needed piece it has (Fast Extension).
+   */
+  virtual void ProcessPeerAllowedFastEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
+  /**
+   * \brief Start scheduling if a peer suggests a needed piece (Fast Extension), like for a HAVE message.
+   */
+  virtual void ProcessPeerSuggestPieceEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
+  /**
+   * \brief React to a jump of the playback position of a video client.
+   *
+   * In one pass over all pending requests, the requests for pieces before the new playback position and for pieces far ahead of it
+   * (more than PP_SEEK_RELEVANT_PIECES pieces or the pre-buffering time of the client, whichever is longer) are cancelled, so that they
+   * do not occupy the request windows and the upload slots of the peers. Afterwards, the scheduler immediately refills the request
+   * windows, starting at the new playback position (see GetHighestPriorityBlockForPeer). Strategies that do not select pieces by the
+   * playback position let the kept range precede their own choices until it is completely requested (see GetSeekBlockForPeer).
+   *
+   * @param oldPiece the piece at the playback position before the jump.
+   * @param newPiece the piece at the playback position after the jump.
+   */
+  virtual void ProcessPlaybackSeekEvent (uint32_t oldPiece, uint32_t newPiece);
+
+  /**
+   * \brief Start scheduling right away when a video client starts buffering with fast start enabled.
+   */
+  virtual void ProcessPlaybackStateChangedEvent ();
+
   // Client-internal listeners
 
   /**
@@ -427,7 +549,8 @@ protected:
    *
    * This method implements the part selection heuristics of a specific strategy. For a given peer, the method returns the block of highest
    * priority (and, hence, the natural choice for a request). In the standard implementation, this method returns all needed blocks in a
-   * sequential manner, i.e., the first fitting non-downloaded block is returned. You can override this method to provide any desired behavior.
+   * sequential manner, i.e., the first fitting non-downloaded block is returned. For video clients, the sequence starts at the playback position
+   * and wraps around to the pieces before it. You can override this method to provide any desired behavior.
    *
    * In case of a failure (e.g., if no suitable block is found for the given peer), the method is expected to set the
    * m_blockLength member of the BlockRequested object to 0 (zero).
@@ -437,6 +560,18 @@ protected:
    */
   virtual void GetHighestPriorityBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr);
 
+  /**
+   * \brief Get the next block to download from a peer that chokes the client, i.e., a block of a piece the peer allowed the client
+   * to request fast (Fast Extension).
+   *
+   * Like GetHighestPriorityBlockForPeer, the method sets the m_blockLength member of the BlockRequested object to 0 (zero) if no suitable
+   * block is found. Other members, such as the timeout, are left untouched.
+   *
+   * @param peer pointer to the Peer class instance representing the choking peer.
+   * @param blockPtr the BlockRequested instance in which the block shall be stored.
+   */
+  virtual void GetAllowedFastBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr);
+
 // Helper methods
 protected:
 
@@ -446,12 +581,89 @@ protected:
    * This method randomly iterates through the list of available peers and for each peer that has unchoked the client
    * requests the blocks of highest priority (according to the GetHighestPriorityBlockForPeer member method), up to the
    * maximum number of requests per peer set via the PushPullClient::SetMaxRequestsPerPeer method. If a peer was assigned
-   * a block but was not unchoked, the methods sends out an INTERESTED message to the peer to ask for an unchoking of the client.
+   * a block but was not unchoked, the methods sends out an INTERESTED message to the peer to ask for an unchoking of the client,
+   * and only requests blocks the peer allowed the client to request fast (according to the GetAllowedFastBlockForPeer member method).
+   *
+   * In endgame mode (see the IsEndgame member method), the peers are traversed by descending download rate instead, so that the
+   * duplicate requests for the remaining blocks go to the fastest peers first.
    *
    * You may override this method to change the order of peers in the process.
    */
   virtual void Scheduler ();
 
+  /**
+   * \brief Check whether the download has entered its endgame.
+   *
+   * The standard implementation counts the blocks not yet downloaded and compares them to the setting of the PushPullClient::SetEndgameBlocks method.
+   * In endgame mode, the RequestAllowedForBlock member method lifts the per-piece limit and allows up to PP_ENDGAME_MAX_REQUESTS_PER_BLOCK
+   * concurrent requests per block; surplus requests are cancelled as soon as the block arrives (see ProcessPeerBlockCompleteEvent).
+   *
+   * You may override this method to end the download differently, e.g., to enter endgame mode for the last blocks of a playback window.
+   *
+   * @returns true, if the remaining blocks should be requested from multiple peers concurrently.
+   */
+  virtual bool IsEndgame ();
+
+  /**
+   * \brief Check whether the client needs the pieces to start or resume playback as fast as possible.
+   *
+   * The standard implementation returns true for video clients with fast start enabled (see PushPullVideoClient::SetFastStart) while they are
+   * buffering. Then, the blocks of the pieces within the pre-buffering time from the playback position are striped across the peers: the
+   * RequestAllowedForBlock member method lifts the per-piece limit for these pieces and asks each peer for at most
+   * PP_FAST_START_REQUESTS_PER_PEER_PER_PIECE of their blocks at a time, and the request window of each peer is raised by
+   * PP_FAST_START_PIPELINE_FACTOR (see GetRequestWindow), so that all peers work on the pre-buffering range in parallel.
+   *
+   * @returns true, if the pre-buffering range should be striped across the peers.
+   */
+  virtual bool IsFastStart ();
+
+  /**
+   * \brief Get the first block of the pre-buffering range that may be requested from a peer in fast start mode.
+   *
+   * Part selection strategies that do not select pieces sequentially from the playback position may use this method to let the pre-buffering
+   * range precede their own choices in fast start mode. Like GetHighestPriorityBlockForPeer, the method sets the m_blockLength member of the
+   * BlockRequested object to 0 (zero) if no suitable block is found (or if not in fast start mode); the timeout is left untouched.
+   * Only the pieces the peer has announced are considered.
+   *
+   * @param peer pointer to the Peer class instance representing the peer for which a block shall be found.
+   * @param blockPtr the BlockRequested instance in which the block shall be stored.
+   */
+  void GetFastStartBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr);
+
+  /**
+   * \brief Get the first block of the range kept by the last seek (see ProcessPlaybackSeekEvent) that may be requested from a peer.
+   *
+   * Like GetFastStartBlockForPeer, this method is meant for part selection strategies that do not select pieces sequentially from the
+   * playback position: the blocks around the new playback position precede their own choices, so that the requests cancelled by the seek
+   * are not issued again right away. Only the pieces the peer has announced are considered (see GetFirstAllowedBlockInRange), so a peer lacking
+   * the range is left to the strategy's own choices. Once no needed piece is left within the range, the range is dropped.
+   *
+   * @param peer pointer to the Peer class instance representing the peer for which a block shall be found.
+   * @param blockPtr the BlockRequested instance in which the block shall be stored.
+   */
+  void GetSeekBlockForPeer (Ptr<Peer> peer, BlockRequested& blockPtr);
+
+  /**
+   * \brief Get the first block of the needed pieces within the range [begin, end) that the peer has and that may be requested from it (see RequestAllowedForBlock).
+   * Sets the m_blockLength member of the BlockRequested object to 0 (zero) if no such block is found.
+   */
+  void GetFirstAllowedBlockInRange (Ptr<Peer> peer, uint32_t begin, uint32_t end, BlockRequested& blockPtr);
+
+  /**
+   * \brief Check whether the buffer of a video client is healthy enough to hold back requests beyond the buffer target.
+   *
+   * The standard implementation applies the watermarks of the video client (see PushPullVideoClient::SetBufferWatermarks) with hysteresis:
+   * Once the video is continously available for the high watermark from the playback position, the client is throttled, i.e., the
+   * RequestAllowedForBlock member method only allows pieces within the high watermark from the playback position. The client stays
+   * throttled until the continously available playback time falls to the low watermark. Clients that are not playing are never throttled.
+   *
+   * Since a throttled client has no blocks to request, the scheduler also signals that it is not interested anymore, which lets its peers
+   * unchoke other clients.
+   *
+   * @returns true, if requests beyond the buffer target should be held back.
+   */
+  virtual bool IsThrottled ();
+
   /**
    * \brief Generate a permutation of the peers to use in the block request scheduling process.
    *
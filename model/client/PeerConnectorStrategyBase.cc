@@ -45,6 +45,7 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
 namespace ns3 {
 namespace pushpull {
@@ -245,58 +246,72 @@ uint16_t PeerConnectorStrategyBase::ConnectToPeers (uint16_t count)
       return 0;
     }
 
-  // Step 3: Get an iterator through the data structure for our potential clients to connect to
-  std::set<std::pair<uint32_t, uint16_t> >::const_iterator iter = potentialPeers.begin ();
-  // This is a mini heuristic for random selection of peers to connect to.
-  // One might want to implement a better one
-  UniformVariable uv;
-  for (uint32_t start = uv.GetInteger (0, potentialPeers.size () - 1); start > 0; --start)
-    {
-      ++iter;
-    }
+  // Step 3: Select the clients to connect to
+  std::vector<std::pair<uint32_t, uint16_t> > selection;
+  SelectPeersToConnect (connectToNPeers, selection);
 
   uint16_t peersConnected = 0;       // i.e., in this call of ConnectToPeers()
-  bool goOn =
-    (iter != potentialPeers.end ())
-    && (connectToNPeers > 0)
-    && (GetPeerCount () < m_myClient->GetDesiredPeers ());
 
   // Step 4: Connect to peers
-  while (goOn)
+  for (std::vector<std::pair<uint32_t, uint16_t> >::const_iterator iter = selection.begin (); iter != selection.end () && GetPeerCount () < m_myClient->GetDesiredPeers (); ++iter)
     {
-      // Step 4a: Only connect if we are not already connected or have a pending connection
-      if (m_connectedTo.find ((*iter).first) == m_connectedTo.end () && m_pendingConnections.find ((*iter).first) == m_pendingConnections.end ())
-        {
-          // Step 4a1: Re-convert the IP address in integer format to a Ipv4Address object
-          // TODO: We should change this back to using Ipv4Address objets only
-          Ipv4Address connectToAddress;
-          connectToAddress.Set ((*iter).first);
+      // Step 4a: Re-convert the IP address in integer format to a Ipv4Address object
+      // TODO: We should change this back to using Ipv4Address objets only
+      Ipv4Address connectToAddress;
+      connectToAddress.Set ((*iter).first);
 
-          // Step 4a2: Create a Peer object for the new connection and schedule the connection to that peer by calling the appropriate method of the Peer class
-          Ptr<Peer> newPeer = CreateObject<Peer> (m_myClient);
-          Simulator::ScheduleNow (&Peer::ConnectToPeer, newPeer, connectToAddress, (*iter).second);
-          Simulator::Schedule (MilliSeconds (BT_PEER_CONNECTOR_CONNECTION_ACCEPTANCE_DELAY), &PeerConnectorStrategyBase::CheckAndDisconnectIfRejected, this, newPeer);
+      // Step 4b: Create a Peer object for the new connection and schedule the connection to that peer by calling the appropriate method of the Peer class
+      Ptr<Peer> newPeer = CreateObject<Peer> (m_myClient);
+      Simulator::ScheduleNow (&Peer::ConnectToPeer, newPeer, connectToAddress, (*iter).second);
+      Simulator::Schedule (MilliSeconds (BT_PEER_CONNECTOR_CONNECTION_ACCEPTANCE_DELAY), &PeerConnectorStrategyBase::CheckAndDisconnectIfRejected, this, newPeer);
 
-          // Step 4a3: Insert this connection into the list of pending connections
-          m_pendingConnections.insert ((*iter).first);
+      // Step 4c: Insert this connection into the list of pending connections
+      m_pendingConnections.insert ((*iter).first);
+      ++peersConnected;
 
-          // Step 4a4: Adjust our "counters"
-          ++peersConnected;
-          --connectToNPeers;
+      NS_LOG_INFO ("PeerConnectorStrategyBase: " << m_myClient->GetIp () << ": Connecting to " << connectToAddress << ":" << (*iter).second << ".");
+    }
+
+  return peersConnected;
+}
+
+void PeerConnectorStrategyBase::SelectPeersToConnect (uint16_t count, std::vector<std::pair<uint32_t, uint16_t> > &selection)
+{
+  if (m_potentialClientsList.empty ())
+    {
+      return;
+    }
 
-          NS_LOG_INFO ("PeerConnectorStrategyBase: " << m_myClient->GetIp () << ": Connecting to " << connectToAddress << ":" << (*iter).second << ".");
+  // This is a mini heuristic for random selection of peers to connect to: Walk through the list from a random position on
+  UniformVariable uv;
+  uint32_t start = uv.GetInteger (0, m_potentialClientsList.size () - 1);
+  for (uint32_t i = 0; i < m_potentialClientsList.size () && selection.size () < count; ++i)
+    {
+      const std::pair<uint32_t, uint16_t> &client = m_potentialClientsList[(start + i) % m_potentialClientsList.size ()];
+      if (!IsConnectedOrPending (client.first))
+        {
+          selection.push_back (client);
         }
+    }
+}
 
-      // Step 4b: Adjust our iterator and recalculate our "guard" goOn
-      ++iter;
-      goOn =
-        (iter != potentialPeers.end ())
-        && (connectToNPeers > 0)
-        && (GetPeerCount () < m_myClient->GetDesiredPeers ());
+bool PeerConnectorStrategyBase::IsConnectedOrPending (uint32_t address) const
+{
+  return m_connectedTo.find (address) != m_connectedTo.end () || m_pendingConnections.find (address) != m_pendingConnections.end ();
+}
 
+void PeerConnectorStrategyBase::AddPotentialClient (const std::pair<uint32_t, uint16_t> &client)
+{
+  if (m_potentialClients.insert (client).second)
+    {
+      m_potentialClientsList.push_back (client);
     }
+}
 
-  return peersConnected;
+void PeerConnectorStrategyBase::ClearPotentialClients ()
+{
+  m_potentialClients.clear ();
+  m_potentialClientsList.clear ();
 }
 
 void PeerConnectorStrategyBase::DisconnectPeers (int32_t count)
@@ -487,7 +502,7 @@ void PeerConnectorStrategyBase::ParseResponse (std::istream &response)
   // A mini heuristic against dead (inactive) peers in the set of potential peers
   if (m_currentClientUpdateCycle == m_clientUpdateCycles - 1)
     {
-      m_potentialClients.clear ();
+      ClearPotentialClients ();
     }
   m_currentClientUpdateCycle = (m_currentClientUpdateCycle + 1) % m_clientUpdateCycles;
 
@@ -534,7 +549,7 @@ void PeerConnectorStrategyBase::ParseResponse (std::istream &response)
           peer.first = ipaddr;
           peer.second = (peerString[peerNum] << 8) | peerString[peerNum + 1];
 
-          m_potentialClients.insert (peer);
+          AddPotentialClient (peer);
         }
     }
   else
@@ -587,7 +602,7 @@ void PeerConnectorStrategyBase::ParseResponse (std::istream &response)
           peer.first = buf.Get ();
           peer.second = static_cast<uint16_t> (peerPort->GetData ());
 
-          m_potentialClients.insert (peer);
+          AddPotentialClient (peer);
         }
 
     }
@@ -38,6 +38,7 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
 namespace ns3 {
 namespace pushpull {
@@ -77,6 +78,7 @@ protected:
   std::set<uint32_t> m_pendingConnections;             // IP addresses of clients we are currently trying to establish a connection with
   std::set<uint32_t> m_knownSeeders;                   // IP addresses that we have gotten to know of that they are seeders
   std::set<std::pair<uint32_t, uint16_t> > m_potentialClients;             // All known clients, regularly cleaned from too old announcements
+  std::vector<std::pair<uint32_t, uint16_t> > m_potentialClientsList;       // The same clients as in m_potentialClients, for constant-time random access
 
   // Management of incoming connection requests
   Ptr<Socket>        m_serverSocket;                   // The socket used to allow other clients to establish a connection with us
@@ -254,6 +256,26 @@ protected:
   virtual void ConnectToPeer (Ipv4Address address, uint16_t port);
   // Initiate connections to a given number of clients arbitrarily-chosen from the available swarm members
   virtual uint16_t ConnectToPeers (uint16_t count);
+
+  /**
+   * \brief Select the clients that ConnectToPeers initiates connections with.
+   *
+   * The default implementation selects a consecutive run of potential clients starting at a random position in the list of potential clients.
+   * Override this method to implement other peer ranking schemes.
+   *
+   * @param count the maximum number of clients to select.
+   * @param selection the data structure to append the selected <IP, port> pairs to. Must only contain clients for which IsConnectedOrPending returns false.
+   */
+  virtual void SelectPeersToConnect (uint16_t count, std::vector<std::pair<uint32_t, uint16_t> > &selection);
+
+  // Check whether there is an established or pending connection with a given client
+  bool IsConnectedOrPending (uint32_t address) const;
+
+  // Add a client to the set of potential clients, if not yet contained
+  void AddPotentialClient (const std::pair<uint32_t, uint16_t> &client);
+
+  // Remove all clients from the set of potential clients
+  void ClearPotentialClients ();
   // Disconnect from a given number of arbitrarily-chosen peers
   virtual void DisconnectPeers (int32_t count);
 
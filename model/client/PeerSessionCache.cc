@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#include "PeerSessionCache.h"
+
+#include "ns3/PushPullDefines.h"
+
+namespace ns3 {
+namespace pushpull {
+
+PeerSessionCache::PeerSessionCache ()
+{
+  m_capacity = PP_PEER_SESSION_CACHE_SIZE;
+}
+
+PeerSessionCache::~PeerSessionCache ()
+{
+  Clear ();
+}
+
+void PeerSessionCache::Store (const Session &session)
+{
+  if (m_capacity == 0)
+    {
+      return;
+    }
+
+  // Step 1: Remove an older session with the same remote peer
+  std::map<uint32_t, std::list<Session>::iterator>::iterator indexIt = m_index.find (session.m_address);
+  if (indexIt != m_index.end ())
+    {
+      m_sessions.erase ((*indexIt).second);
+      m_index.erase (indexIt);
+    }
+
+  // Step 2: Insert the session as the most recent one and make room for it
+  m_sessions.push_front (session);
+  m_index[session.m_address] = m_sessions.begin ();
+  Shrink ();
+}
+
+bool PeerSessionCache::Contains (uint32_t address) const
+{
+  return m_index.find (address) != m_index.end ();
+}
+
+bool PeerSessionCache::Take (uint32_t address, Session &session)
+{
+  std::map<uint32_t, std::list<Session>::iterator>::iterator indexIt = m_index.find (address);
+  if (indexIt == m_index.end ())
+    {
+      return false;
+    }
+
+  session = *(*indexIt).second;
+  m_sessions.erase ((*indexIt).second);
+  m_index.erase (indexIt);
+
+  return true;
+}
+
+void PeerSessionCache::Clear ()
+{
+  m_index.clear ();
+  m_sessions.clear ();
+}
+
+uint16_t PeerSessionCache::GetSize () const
+{
+  return m_sessions.size ();
+}
+
+uint16_t PeerSessionCache::GetCapacity () const
+{
+  return m_capacity;
+}
+
+void PeerSessionCache::SetCapacity (uint16_t capacity)
+{
+  m_capacity = capacity;
+  Shrink ();
+}
+
+void PeerSessionCache::Shrink ()
+{
+  while (m_sessions.size () > m_capacity)
+    {
+      m_index.erase (m_sessions.back ().m_address);
+      m_sessions.pop_back ();
+    }
+}
+
+} // ns pushpull
+} // ns ns3
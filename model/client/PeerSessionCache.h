@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#ifndef PEERSESSIONCACHE_H_
+#define PEERSESSIONCACHE_H_
+
+#include "ns3/nstime.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace pushpull {
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief A bounded least-recently-used cache of the state of closed peer connections, keyed by the address of the remote peer.
+ *
+ * When a connection is closed, the client stores the last-known bitfield of the remote peer, the pieces it announced to the remote peer
+ * and the transfer rates of the connection. If the same two clients connect again and both still hold a session for each other
+ * (which they announce in their handshake messages), they resume the session: instead of their whole bitfields, they only exchange the pieces
+ * completed since the disconnection, and the rate estimations of the new connection start from the cached values.
+ *
+ * Choke states are not cached: every connection starts with both sides choking, and the choking strategies decide anew in their next
+ * round, based on the rate estimations that are resumed from the cache.
+ */
+class PeerSessionCache
+{
+// Types used
+public:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    uint32_t             m_address;              // The IPv4 address of the remote peer
+    std::string          m_peerId;               // The peer id of the remote peer
+    std::vector<uint8_t> m_remoteBitfield;       // The last-known bitfield of the remote peer
+    std::vector<uint8_t> m_announcedBitfield;    // The pieces of the local client announced to the remote peer (bitfield and HAVE messages) until disconnection
+    double               m_bpsDownload;          // The download rate from the remote peer at disconnection, in bps
+    double               m_bpsUpload;            // The upload rate to the remote peer at disconnection, in bps
+    Time                 m_disconnectionTime;    // When the connection was closed
+  } Session;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  std::list<Session>                                  m_sessions;    // The cached sessions, most recently stored first
+  std::map<uint32_t, std::list<Session>::iterator>    m_index;       // The cached sessions, by address of the remote peer
+  uint16_t                                            m_capacity;    // The maximum number of cached sessions
+
+// Constructors etc.
+public:
+  PeerSessionCache ();
+  virtual ~PeerSessionCache ();
+
+// Cache management
+public:
+  /**
+   * \brief Store the session of a closed connection. An older session with the same remote peer is replaced; if the cache is full,
+   * the least-recently stored session is discarded.
+   */
+  void Store (const Session &session);
+
+  /**
+   * @returns true, if a session with the remote peer at the given address is cached.
+   */
+  bool Contains (uint32_t address) const;
+
+  /**
+   * \brief Remove the session with the remote peer at the given address from the cache in order to resume it.
+   *
+   * @param address the IPv4 address of the remote peer.
+   * @param session the session is copied here.
+   *
+   * @returns true, if a session was cached.
+   */
+  bool Take (uint32_t address, Session &session);
+
+  void Clear ();
+
+  uint16_t GetSize () const;
+
+  uint16_t GetCapacity () const;
+
+  /**
+   * \brief Set the maximum number of cached sessions. Discards the least-recently stored sessions if the cache holds more sessions. 0 disables the cache.
+   */
+  void SetCapacity (uint16_t capacity);
+
+// Internal methods
+private:
+  // Discard the least-recently stored sessions until the capacity is respected
+  void Shrink ();
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* PEERSESSIONCACHE_H_ */
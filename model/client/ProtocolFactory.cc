@@ -28,7 +28,11 @@
 
 #include "PushPullVideoMetricsBase.h"
 
+#include "strategies/DeadlineRequestSchedulingStrategy.h"
+#include "strategies/LocalityAwarePeerConnectorStrategy.h"
 #include "strategies/RarestFirstPartSelectionStrategy.h"
+#include "strategies/SuperSeedingRequestSchedulingStrategy.h"
+#include "strategies/UploadAwareVoDChokeUnChokeStrategy.h"
 
 namespace ns3 {
 namespace pushpull {
@@ -54,6 +58,22 @@ void ProtocolFactory::CreateStrategyBundle (std::string protocolName, Ptr<PushPu
     {
       CreateRarestFirstProtocol (client, strategyStore, aPeerConnectorStrategy);
     }
+  else if (protocolName == "rarest-first-locality")
+    {
+      CreateRarestFirstLocalityProtocol (client, strategyStore, aPeerConnectorStrategy);
+    }
+  else if (protocolName == "rarest-first-superseeding")
+    {
+      CreateRarestFirstSuperSeedingProtocol (client, strategyStore, aPeerConnectorStrategy);
+    }
+  else if (protocolName == "upload-aware-vod")
+    {
+      CreateUploadAwareVoDProtocol (client, strategyStore, aPeerConnectorStrategy);
+    }
+  else if (protocolName == "deadline-vod")
+    {
+      CreateDeadlineVoDProtocol (client, strategyStore, aPeerConnectorStrategy);
+    }
   else if (protocolName == "rarest-first-vod")
     {
       CreateRarestFirstVoDProtocol (client, strategyStore, aPeerConnectorStrategy);
@@ -114,6 +134,90 @@ void ProtocolFactory::CreateRarestFirstProtocol (Ptr<PushPullClient> client, std
   aPeerConnectorStrategy = peerConnectorStrategy;
 }
 
+void ProtocolFactory::CreateRarestFirstLocalityProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& aPeerConnectorStrategy)
+{
+  Ptr<LocalityAwarePeerConnectorStrategy> peerConnectorStrategy = Create<LocalityAwarePeerConnectorStrategy, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (peerConnectorStrategy);
+  peerConnectorStrategy->DoInitialize ();
+
+  Ptr<ChokeUnChokeStrategyBase> chokeUnChokeStrategy = Create<ChokeUnChokeStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (chokeUnChokeStrategy);
+  chokeUnChokeStrategy->DoInitialize ();
+
+  Ptr<RarestFirstPartSelectionStrategy> partSelectionStrategy = Create<RarestFirstPartSelectionStrategy, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (partSelectionStrategy);
+  partSelectionStrategy->DoInitialize ();
+
+  Ptr<RequestSchedulingStrategyBase> requestSchedulingStrategy = Create<RequestSchedulingStrategyBase, Ptr<PushPullClient > > (client);
+  strategyStore.push_back (requestSchedulingStrategy);
+  requestSchedulingStrategy->DoInitialize ();
+
+  aPeerConnectorStrategy = peerConnectorStrategy;
+}
+
+void ProtocolFactory::CreateRarestFirstSuperSeedingProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& aPeerConnectorStrategy)
+{
+  Ptr<PeerConnectorStrategyBase> peerConnectorStrategy = Create<PeerConnectorStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (peerConnectorStrategy);
+  peerConnectorStrategy->DoInitialize ();
+
+  Ptr<ChokeUnChokeStrategyBase> chokeUnChokeStrategy = Create<ChokeUnChokeStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (chokeUnChokeStrategy);
+  chokeUnChokeStrategy->DoInitialize ();
+
+  Ptr<RarestFirstPartSelectionStrategy> partSelectionStrategy = Create<RarestFirstPartSelectionStrategy, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (partSelectionStrategy);
+  partSelectionStrategy->DoInitialize ();
+
+  Ptr<SuperSeedingRequestSchedulingStrategy> requestSchedulingStrategy = Create<SuperSeedingRequestSchedulingStrategy, Ptr<PushPullClient > > (client);
+  strategyStore.push_back (requestSchedulingStrategy);
+  requestSchedulingStrategy->DoInitialize ();
+
+  aPeerConnectorStrategy = peerConnectorStrategy;
+}
+
+void ProtocolFactory::CreateUploadAwareVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& aPeerConnectorStrategy)
+{
+  Ptr<PeerConnectorStrategyBase> peerConnectorStrategy = Create<PeerConnectorStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (peerConnectorStrategy);
+  peerConnectorStrategy->DoInitialize ();
+
+  Ptr<UploadAwareVoDChokeUnChokeStrategy> chokeUnChokeStrategy = Create<UploadAwareVoDChokeUnChokeStrategy, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (chokeUnChokeStrategy);
+  chokeUnChokeStrategy->DoInitialize ();
+
+  Ptr<PartSelectionStrategyBase> partSelectionStrategy = Create<PartSelectionStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (partSelectionStrategy);
+  partSelectionStrategy->DoInitialize ();
+
+  Ptr<RequestSchedulingStrategyBase> requestSchedulingStrategy = Create<RequestSchedulingStrategyBase, Ptr<PushPullClient > > (client);
+  strategyStore.push_back (requestSchedulingStrategy);
+  requestSchedulingStrategy->DoInitialize ();
+
+  aPeerConnectorStrategy = peerConnectorStrategy;
+}
+
+void ProtocolFactory::CreateDeadlineVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& aPeerConnectorStrategy)
+{
+  Ptr<PeerConnectorStrategyBase> peerConnectorStrategy = Create<PeerConnectorStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (peerConnectorStrategy);
+  peerConnectorStrategy->DoInitialize ();
+
+  Ptr<UploadAwareVoDChokeUnChokeStrategy> chokeUnChokeStrategy = Create<UploadAwareVoDChokeUnChokeStrategy, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (chokeUnChokeStrategy);
+  chokeUnChokeStrategy->DoInitialize ();
+
+  Ptr<PartSelectionStrategyBase> partSelectionStrategy = Create<PartSelectionStrategyBase, Ptr<PushPullClient> > (client);
+  strategyStore.push_back (partSelectionStrategy);
+  partSelectionStrategy->DoInitialize ();
+
+  Ptr<DeadlineRequestSchedulingStrategy> requestSchedulingStrategy = Create<DeadlineRequestSchedulingStrategy, Ptr<PushPullClient > > (client);
+  strategyStore.push_back (requestSchedulingStrategy);
+  requestSchedulingStrategy->DoInitialize ();
+
+  aPeerConnectorStrategy = peerConnectorStrategy;
+}
+
 void ProtocolFactory::CreateRarestFirstVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& aPeerConnectorStrategy)
 {
   Ptr<PeerConnectorStrategyBase> peerConnectorStrategy = Create<PeerConnectorStrategyBase, Ptr<PushPullClient> > (client);
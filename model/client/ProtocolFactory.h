@@ -61,6 +61,14 @@ public:
    *
    * * "rarest-first" Default PushPull protocol according to the description on <a href="http://wiki.theory.org/PushPullSpecification" target="_blank">theory.org</a> with a rarest-first selection mechanism.
    *
+   * * "rarest-first-locality" As "rarest-first", but preferably connects to topologically close peers (see LocalityAwarePeerConnectorStrategy).
+   *
+   * * "rarest-first-superseeding" As "rarest-first", but clients that start as seeders reveal their pieces selectively until the swarm holds a full copy (see SuperSeedingRequestSchedulingStrategy).
+   *
+   * * "upload-aware-vod" Sequential piece selection with a choking/unchoking strategy that adapts to the upload capacity and prioritizes peers by playback deadline (see UploadAwareVoDChokeUnChokeStrategy).
+   *
+   * * "deadline-vod" As "upload-aware-vod", but serves the requests of all peers by their playback deadlines with deficit round robin fairness (see DeadlineRequestSchedulingStrategy).
+   *
    * Note: Strategy implementations usually require the network of the client and the internal bitfield of the client to be readily initialized.
    * You should not call this method before this state has been reached.
    *
@@ -77,6 +85,15 @@ private:
   static void                     CreateBasicProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
   // Creates the standard PushPull protocol with the rarest-first piece selection heuristic
   static void                     CreateRarestFirstProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
+  // Creates the standard PushPull protocol with the rarest-first piece selection heuristic and a peer connector preferring topologically close peers
+  static void                     CreateRarestFirstLocalityProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
+  // Creates the standard PushPull protocol with the rarest-first piece selection heuristic, with initial seeders superseeding
+  static void                     CreateRarestFirstSuperSeedingProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
+
+  // Creates a VoD protocol with sequential piece selection and a choking/unchoking strategy adapting to the upload capacity and the playback deadlines of the peers
+  static void                     CreateUploadAwareVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
+  // As above, but with an upload scheduler serving the requests of all peers by their playback deadlines
+  static void                     CreateDeadlineVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
 
   // RENE: NOT YET PORTED TO NEW VERSION: Creates the standard PushPull protocol with rarest-first heuristic that leaves out pieces before the playback point
   static void                     CreateRarestFirstVoDProtocol (Ptr<PushPullClient> client, std::list<Ptr<AbstractStrategy> > &strategyStore, Ptr<PeerConnectorStrategyBase>& peerConnectorStrategy);
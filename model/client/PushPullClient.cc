@@ -72,6 +72,8 @@ PushPullClient::PushPullClient ()
   m_maxRequestsPerPiece = 8;
   m_maxRequestsPerBlock = 1;
   m_maxRequestsPerPeerPerPiece = 8;
+  m_adaptivePipelining = false;
+  m_endgameBlocks = 0;
 
   m_requestBlockSize = 16384;
   m_sendBlockSize = 16384;
@@ -79,6 +81,10 @@ PushPullClient::PushPullClient ()
   m_pieceTimeout = Seconds (30);
 
   m_checkDownloadedData = false;
+  m_compressedBitfield = true;
+  m_availabilityWindow = 0;
+  m_availabilityWindowStart = 0;
+  m_superSeeding = false;
 
   m_downloadCompleted = false;
 
@@ -133,7 +139,7 @@ void PushPullClient::StartApplication ()
 
   // Step 3: Set up the bitfield
   // Step 3a: Calculate its size
-  uint32_t bitfieldSize = m_torrent->GetNumberOfPieces () / (PP_PROTOCOL_PULL_WINDOW + PP_PROTOCOL_PUSH_WINDOW);
+  uint32_t bitfieldSize = m_torrent->GetNumberOfPieces () / 8;
   if ((m_torrent->GetNumberOfPieces () % 8) > 0)
     {
       bitfieldSize++;
@@ -352,6 +358,11 @@ void PushPullClient::SetGatherMetricsEventPeriodicity (Time gatherMetricsEventPe
     }
 }
 
+MetricChannelRegistry& PushPullClient::GetMetricChannels ()
+{
+  return m_metricChannels;
+}
+
 const uint8_t* PushPullClient::GetCurrentInfoHash () const
 {
   return reinterpret_cast<const uint8_t*> (m_torrent->GetByteValueInfoHash ());
@@ -463,6 +474,12 @@ void PushPullClient::SetMaxRequestsPerPeer (uint16_t maxRequestsPerPeer)
   m_maxRequestsPerPeer = maxRequestsPerPeer;
 }
 
+void PushPullClient::SetAdaptivePipelining (bool adaptivePipelining)
+{
+  CHANGED_OPTION ("adaptive_pipelining", m_adaptivePipelining, adaptivePipelining);
+  m_adaptivePipelining = adaptivePipelining;
+}
+
 void PushPullClient::SetMaxRequestsPerPiece (uint16_t maxRequestsPerPiece)
 {
   CHANGED_OPTION ("max_requests_per_piece", m_maxRequestsPerPiece, maxRequestsPerPiece);
@@ -481,6 +498,12 @@ void PushPullClient::SetMaxRequestsPerPeerPerPiece (uint16_t maxRequestsPerPeerP
   m_maxRequestsPerPeerPerPiece = maxRequestsPerPeerPerPiece;
 }
 
+void PushPullClient::SetEndgameBlocks (uint16_t endgameBlocks)
+{
+  CHANGED_OPTION ("endgame_blocks", m_endgameBlocks, endgameBlocks);
+  m_endgameBlocks = endgameBlocks;
+}
+
 void PushPullClient::SetRequestBlockSize (uint32_t requestBlockSize)
 {
   if (requestBlockSize > 0)
@@ -514,6 +537,55 @@ void PushPullClient::SetCheckDownloadedData (bool checkDownloadedData)
   m_checkDownloadedData = checkDownloadedData;
 }
 
+void PushPullClient::SetCompressedBitfield (bool compressedBitfield)
+{
+  CHANGED_OPTION ("compressed_bitfield", m_compressedBitfield, compressedBitfield);
+  m_compressedBitfield = compressedBitfield;
+}
+
+void PushPullClient::SetPeerSessionCacheSize (uint16_t peerSessionCacheSize)
+{
+  CHANGED_OPTION ("peer_session_cache_size", m_sessionCache.GetCapacity (), peerSessionCacheSize);
+  m_sessionCache.SetCapacity (peerSessionCacheSize);
+}
+
+PeerSessionCache& PushPullClient::GetPeerSessionCache ()
+{
+  return m_sessionCache;
+}
+
+void PushPullClient::SetAvailabilityWindow (uint32_t availabilityWindow)
+{
+  // Windows are advertised bytewise, so their size is rounded up to full bytes of the bitfield
+  if ((availabilityWindow % 8) > 0)
+    {
+      availabilityWindow += 8 - (availabilityWindow % 8);
+    }
+
+  CHANGED_OPTION ("availability_window", m_availabilityWindow, availabilityWindow);
+  m_availabilityWindow = availabilityWindow;
+}
+
+void PushPullClient::MoveAvailabilityWindow (uint32_t anchorPiece)
+{
+  uint32_t windowStart = anchorPiece - (anchorPiece % 8);
+  if (m_availabilityWindow == 0 || windowStart == m_availabilityWindowStart)
+    {
+      return;
+    }
+
+  m_availabilityWindowStart = windowStart;
+  for (std::vector<Ptr<Peer> >::iterator it = m_peerList.begin (); it != m_peerList.end (); ++it)
+    {
+      (*it)->UpdateAvailabilityWindow ();
+    }
+}
+
+void PushPullClient::SetSuperSeeding (bool superSeeding)
+{
+  m_superSeeding = superSeeding;
+}
+
 void PushPullClient::SetPieceComplete (uint32_t pieceIndex)
 {
   m_bitfield[pieceIndex / 8] |= (1 << (7 - (pieceIndex % 8)));
@@ -738,6 +810,15 @@ void PushPullClient::PeerHaveEvent (Ptr<Peer> peer, uint32_t pieceIndex)
     }
 }
 
+void PushPullClient::PeerPieceUnavailableEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_pieceUnavailableEventListeners.begin ();
+  for (; iter != m_pieceUnavailableEventListeners.end (); ++iter)
+    {
+      (*iter)(peer,pieceIndex);
+    }
+}
+
 void PushPullClient::PeerBitfieldReceivedEvent (Ptr<Peer> peer)
 {
   std::list<Callback<void, Ptr<Peer> > >::iterator iter = m_bitfieldEventListeners.begin ();
@@ -774,6 +855,33 @@ void PushPullClient::PeerPortMessageEvent (Ptr<Peer> peer, uint16_t port)
     }
 }
 
+void PushPullClient::PeerSuggestPieceEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_suggestPieceEventListeners.begin ();
+  for (; iter != m_suggestPieceEventListeners.end (); ++iter)
+    {
+      (*iter)(peer,pieceIndex);
+    }
+}
+
+void PushPullClient::PeerRejectRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> >::iterator iter = m_rejectRequestEventListeners.begin ();
+  for (; iter != m_rejectRequestEventListeners.end (); ++iter)
+    {
+      (*iter)(peer,pieceIndex,blockOffset,blockLength);
+    }
+}
+
+void PushPullClient::PeerAllowedFastEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_allowedFastEventListeners.begin ();
+  for (; iter != m_allowedFastEventListeners.end (); ++iter)
+    {
+      (*iter)(peer,pieceIndex);
+    }
+}
+
 void PushPullClient::PeerExtensionMessageEvent (Ptr<Peer> peer, uint8_t messageId, std::string message)
 {
   std::list<Callback<void, Ptr<Peer>, const std::string& > >::iterator iter = m_extensionMessageListeners[messageId].begin ();
@@ -878,6 +986,14 @@ void PushPullClient::StrategyOptionsChangedEvent ()
 
 void PushPullClient::GatherMetricsEvent ()
 {
+  // Step 1: Let the strategies refresh their typed channels and announce them
+  for (std::list<Callback<void> >::iterator it = m_updateMetricChannelsEventListeners.begin (); it != m_updateMetricChannelsEventListeners.end (); ++it)
+    {
+      (*it)();
+    }
+  AnnounceMetricChannels ();
+
+  // Step 2: Collect and announce the string-based metrics of strategies not (yet) using typed channels
   std::multimap<std::string, std::string> allMetrics;
   std::list<Callback<std::map<std::string, std::string> > >::iterator iter = m_gatherMetricsEventListeners.begin ();
 
@@ -895,6 +1011,35 @@ void PushPullClient::GatherMetricsEvent ()
   Simulator::Schedule (m_gatherMetricsEventPeriodicity, &PushPullClient::GatherMetricsEvent, this);
 }
 
+void PushPullClient::AnnounceMetricChannels ()
+{
+  GlobalMetricsGatherer* gatherer = GlobalMetricsGatherer::GetInstance ();
+  uint32_t node = GetNode ()->GetId ();
+
+  for (MetricChannelRegistry::ChannelId id = 0; id < m_metricChannels.GetChannelCount (); ++id)
+    {
+      if (!m_metricChannels.HasValue (id))
+        {
+          continue;
+        }
+
+      if (m_metricChannels.GetType (id) == MetricChannelRegistry::HISTOGRAM)
+        {
+          const std::vector<std::string>& names = m_metricChannels.GetOutputNames (id);
+          gatherer->WriteRecord (names[0], node, static_cast<double> (m_metricChannels.GetCount (id)));
+          gatherer->WriteRecord (names[1], node, m_metricChannels.GetValue (id));
+          for (uint32_t bucket = 0; bucket < m_metricChannels.GetBucketCount (id); ++bucket)
+            {
+              gatherer->WriteRecord (names[bucket + 2], node, static_cast<double> (m_metricChannels.GetBucketValue (id, bucket)));
+            }
+        }
+      else
+        {
+          gatherer->WriteRecord (m_metricChannels.GetName (id), node, m_metricChannels.GetValue (id));
+        }
+    }
+}
+
 void PushPullClient::AnnounceMetrics (std::multimap<std::string, std::string> metrics)
 {
   if (!metrics.empty ())
@@ -961,6 +1106,24 @@ void PushPullClient::UnregisterCallbackPeerHaveEvent (Callback<void, Ptr<Peer>,
     }
 }
 
+void PushPullClient::RegisterCallbackPeerPieceUnavailableEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  m_pieceUnavailableEventListeners.push_back (eventCallback);
+}
+
+void PushPullClient::UnregisterCallbackPeerPieceUnavailableEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_pieceUnavailableEventListeners.begin ();
+  for (; iter != m_pieceUnavailableEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_pieceUnavailableEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
 void PushPullClient::RegisterCallbackBitfieldReceivedEvent (Callback<void, Ptr<Peer> > eventCallback)
 {
   m_bitfieldEventListeners.push_back (eventCallback);
@@ -1033,6 +1196,60 @@ void PushPullClient::UnregisterCallbackPortMessageEvent (Callback<void, Ptr<Peer
     }
 }
 
+void PushPullClient::RegisterCallbackSuggestPieceEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  m_suggestPieceEventListeners.push_back (eventCallback);
+}
+
+void PushPullClient::UnregisterCallbackSuggestPieceEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_suggestPieceEventListeners.begin ();
+  for (; iter != m_suggestPieceEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_suggestPieceEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
+void PushPullClient::RegisterCallbackRejectRequestEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback)
+{
+  m_rejectRequestEventListeners.push_back (eventCallback);
+}
+
+void PushPullClient::UnregisterCallbackRejectRequestEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> >::iterator iter = m_rejectRequestEventListeners.begin ();
+  for (; iter != m_rejectRequestEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_rejectRequestEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
+void PushPullClient::RegisterCallbackAllowedFastEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  m_allowedFastEventListeners.push_back (eventCallback);
+}
+
+void PushPullClient::UnregisterCallbackAllowedFastEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback)
+{
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >::iterator iter = m_allowedFastEventListeners.begin ();
+  for (; iter != m_allowedFastEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_allowedFastEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
 void PushPullClient::RegisterCallbackExtensionMessageEvent (uint8_t messageId, Callback<void, Ptr<Peer>, const std::string& > eventCallback)
 {
   m_extensionMessageListeners[messageId].push_back (eventCallback);
@@ -1340,6 +1557,24 @@ void PushPullClient::UnregisterCallbackGatherMetricsEvent (Callback<std::map<std
     }
 }
 
+void PushPullClient::RegisterCallbackUpdateMetricChannelsEvent (Callback<void> eventCallback)
+{
+  m_updateMetricChannelsEventListeners.push_back (eventCallback);
+}
+
+void PushPullClient::UnregisterCallbackUpdateMetricChannelsEvent (Callback<void> eventCallback)
+{
+  std::list<Callback<void> >::iterator iter = m_updateMetricChannelsEventListeners.begin ();
+  for (; iter != m_updateMetricChannelsEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_updateMetricChannelsEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
 void PushPullClient::JoinCloud ()
 {
   if (!GetConnectedToCloud ())
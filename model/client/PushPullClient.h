@@ -25,6 +25,7 @@
 #define PUSHPULLCLIENT_H_
 
 #include "AbstractStrategy.h"
+#include "MetricChannelRegistry.h"
 
 #include "ns3/PushPullUtilities.h"
 
@@ -106,6 +107,7 @@ private:
   std::string                          m_bitfieldFillType;           // A string indicating the way the bitfield of this client instance is filled at start (i.e., download status). Using this after initialization in StartApplication() ins meaningless.
   std::map<uint32_t, uint8_t>          m_bitfieldManipulations;      // Can be used to edit the bitfield after pre-filling it. Using this after initialization in StartApplication() ins meaningless.
   Time                                 m_gatherMetricsEventPeriodicity;        // The intervals at which the client should collect status information for output
+  MetricChannelRegistry                m_metricChannels;             // The typed metric channels registered by the strategies of this client
 
   std::string                          m_peerId;                     // The client's self-generated peer id
 
@@ -127,6 +129,8 @@ private:
   uint16_t                             m_maxRequestsPerPiece;        // The maximum number of concurrent requests for a piece (i.e., how many peers should be asked)
   uint16_t                             m_maxRequestsPerBlock;        // Similar to above, but for block level requests
   uint16_t                             m_maxRequestsPerPeerPerPiece; // Similar to above, but for block level requests
+  bool                                 m_adaptivePipelining;         // Whether the number of concurrent requests per peer is sized from the peer's bandwidth-delay product
+  uint16_t                             m_endgameBlocks;              // The number of remaining blocks below which the part selection enters endgame mode. 0 => No endgame mode
 
   uint32_t                             m_requestBlockSize;           // The number of bytes each REQUEST message should ask for
   uint32_t                             m_sendBlockSize;              // The number of bytes each PIECE message should contain. May be lower than the request size.
@@ -135,6 +139,11 @@ private:
   // Time                                 m_postPieceTimeoutPatience;   // A currently unused attribute for a work-in-progress heuristic in the base part selection strategy
 
   bool                                 m_checkDownloadedData;        // Whether to perform SHA-1 checks on downloaded pieces
+  bool                                 m_compressedBitfield;         // Whether to exchange bitfields in compressed form with peers supporting it
+  PeerSessionCache                     m_sessionCache;               // The sessions of recently closed connections, for fast reconnects
+  uint32_t                             m_availabilityWindow;         // The number of pieces advertised to peers supporting availability windows (0: whole bitfield)
+  uint32_t                             m_availabilityWindowStart;    // The first piece of the advertised availability window
+  bool                                 m_superSeeding;               // Whether the client hides its pieces in its bitfield messages so that they can be revealed selectively
 
   // Internal derived variables (stored for faster access to them)
   uint32_t                             m_piecesCompleted;            // Number of pieces downloaded so far
@@ -172,10 +181,14 @@ private:
   std::list<Callback<void, Ptr<Peer> > >         m_chokeEventListeners;        // Also: unchoke
   std::list<Callback<void, Ptr<Peer> > >         m_interedEventListeners;      // Also: uninterested
   std::list<Callback<void, Ptr<Peer>,uint32_t> > m_haveEventListeners;
+  std::list<Callback<void, Ptr<Peer>,uint32_t> > m_pieceUnavailableEventListeners; // A piece advertised by a peer left the peer's availability window
   std::list<Callback<void, Ptr<Peer> > >         m_bitfieldEventListeners;     // The central event triggering strategies. Indicates readiness for communication.
   std::list<Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> >   m_requestEventListeners;
   std::list<Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> >   m_cancelEventListeners;
   std::list<Callback<void, Ptr<Peer>,uint16_t> >                     m_portMessageEventListeners;
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >                     m_suggestPieceEventListeners;   // Fast Extension
+  std::list<Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> >   m_rejectRequestEventListeners;  // Fast Extension
+  std::list<Callback<void, Ptr<Peer>,uint32_t> >                     m_allowedFastEventListeners;    // Fast Extension
   std::map<uint8_t, std::list<Callback<void, Ptr<Peer>, const std::string& > > >         m_extensionMessageListeners;  // Can be used for arbitrary additional messages according to BEP 10.
 
   // Listeners for download-related events (PIECE messages, REQUEST messages)
@@ -195,6 +208,7 @@ private:
 
   // Listeners for the periodic status generation calls by the GlobalMetricsGatherer, if existent
   std::list<Callback<std::map<std::string, std::string> > >          m_gatherMetricsEventListeners;
+  std::list<Callback<void> >                                         m_updateMetricChannelsEventListeners;                                                         // Strategies refresh their gauges in here
 
 private:
   // Callback plugs for the connector strategy (e.g., tracker-based, DHT, ...)
@@ -339,6 +353,16 @@ public:
    */
   void SetGatherMetricsEventPeriodicity (Time gatherMetricsEventPeriodicity);
 
+  /**
+   * \brief Get the registry of typed metric channels of this client.
+   *
+   * Strategies should register the metrics they provide with this registry once (e.g., in their DoInitialize method) and update the values
+   * of their channels using the returned ids. The current values of all channels are announced periodically, see the GatherMetricsEvent method.
+   *
+   * @returns a reference to the metric channel registry.
+   */
+  MetricChannelRegistry& GetMetricChannels ();
+
   /**
    * \brief Get a pointer to the memory location in which the <b>whole</b> shared file is stored by the StorageManager class.
    *
@@ -532,6 +556,25 @@ public:
    */
   void SetMaxRequestsPerPeer (uint16_t maxRequestsPerPeer);
 
+  /**
+   * @returns true, if the number of concurrent requests per peer is adapted to each peer's bandwidth-delay product.
+   */
+  bool GetAdaptivePipelining () const
+  {
+    return m_adaptivePipelining;
+  }
+
+  /**
+   * \brief Enable or disable adaptive request pipelining.
+   *
+   * If enabled, the part selection strategy sizes the window of concurrent requests of each peer from the observed download rate from that peer
+   * and the round-trip time of its requests, so that fast peers are kept busy and slow peers are not assigned blocks they cannot deliver in time.
+   * The setting of the SetMaxRequestsPerPeer method is then only used as the initial window of newly-connected peers.
+   *
+   * @param adaptivePipelining whether to enable adaptive request pipelining. Default is false.
+   */
+  void SetAdaptivePipelining (bool adaptivePipelining);
+
   /**
    * @returns the maximum number of concurrent block requests sent out for a piece.
    */
@@ -596,6 +639,26 @@ public:
    */
   void SetMaxRequestsPerPeerPerPiece (uint16_t maxRequestsPerPeerPerPiece);
 
+  /**
+   * @returns the number of remaining blocks at or below which the part selection strategy enters endgame mode.
+   */
+  uint16_t GetEndgameBlocks () const
+  {
+    return m_endgameBlocks;
+  }
+
+  /**
+   * \brief Set the number of remaining blocks at or below which the part selection strategy enters endgame mode.
+   *
+   * In endgame mode, the remaining blocks are requested from up to PP_ENDGAME_MAX_REQUESTS_PER_BLOCK peers concurrently
+   * (ignoring the settings of the SetMaxRequestsPerPiece and SetMaxRequestsPerBlock methods), with the fastest peers being asked first.
+   * As soon as a block arrives, the duplicate requests for it are cancelled. This prevents the last blocks of a download from waiting
+   * for a single slow peer until their requests time out.
+   *
+   * @param endgameBlocks the number of remaining blocks. Default is 0, which disables endgame mode.
+   */
+  void SetEndgameBlocks (uint16_t endgameBlocks);
+
   /**
    * @returns the size of the blocks requested from a peer, in bytes.
    */
@@ -684,6 +747,117 @@ public:
    */
   void SetCheckDownloadedData (bool checkDownloadedData);
 
+  /**
+   * @returns true, if bitfields are exchanged in compressed form with peers supporting it.
+   */
+  bool GetCompressedBitfield () const
+  {
+    return m_compressedBitfield;
+  }
+
+  /**
+   * \brief Control whether the client sends its bitfield in compressed form.
+   *
+   * If enabled, the client announces support for compressed bitfields in its handshake message. To peers that announce support as well,
+   * the bitfield is then sent as an Extension Protocol message containing a "have all" or "have none" indicator or a run-length encoding
+   * of the bitfield, whichever is smallest (see the PushPullCompressedBitfield class). This reduces the connection setup overhead for files
+   * with many pieces. Compressed bitfields are received regardless of this setting.
+   *
+   * Note: The setting only affects connections established after it was changed.
+   *
+   * @param compressedBitfield whether to send compressed bitfields. Default is true.
+   */
+  void SetCompressedBitfield (bool compressedBitfield);
+
+  /**
+   * @returns the maximum number of closed connections whose session is cached for fast reconnects.
+   */
+  uint16_t GetPeerSessionCacheSize () const
+  {
+    return m_sessionCache.GetCapacity ();
+  }
+
+  /**
+   * \brief Set the maximum number of closed connections whose session is cached for fast reconnects.
+   *
+   * When a connection is closed, the client keeps the last-known bitfield of the remote peer, its own bitfield as known to the remote peer,
+   * and the transfer rates of the connection (see the PeerSessionCache class). If both clients still hold the session when
+   * they reconnect, they only exchange the pieces gained in between instead of their whole bitfields, and the rate estimations of the new
+   * connection start from the cached rates, which the choking strategies base their next round on. The least-recently closed sessions are discarded first.
+   *
+   * @param peerSessionCacheSize the maximum number of cached sessions. 0 disables the cache. Default is PP_PEER_SESSION_CACHE_SIZE.
+   */
+  void SetPeerSessionCacheSize (uint16_t peerSessionCacheSize);
+
+  /**
+   * @returns true, if the client advertises no pieces in its bitfield messages (superseeding mode).
+   */
+  bool GetSuperSeeding () const
+  {
+    return m_superSeeding;
+  }
+
+  /**
+   * \brief Enable or disable superseeding mode.
+   *
+   * In superseeding mode, the client poses as a peer without any pieces towards newly-connected peers, so that a strategy can reveal
+   * its pieces selectively via HAVE messages (see SuperSeedingRequestSchedulingStrategy). The mode is set by that strategy; enabling it
+   * without such a strategy leaves the peers of the client without anything to request.
+   *
+   * Note: The setting only affects connections established after it was changed.
+   *
+   * @param superSeeding whether to enable superseeding mode. Default is false.
+   */
+  void SetSuperSeeding (bool superSeeding);
+
+  /**
+   * @returns a reference to the cache of sessions of recently closed connections.
+   */
+  PeerSessionCache& GetPeerSessionCache ();
+
+  /**
+   * @returns the number of pieces advertised to peers supporting availability windows, or 0 if the whole bitfield is advertised.
+   */
+  uint32_t GetAvailabilityWindow () const
+  {
+    return m_availabilityWindow;
+  }
+
+  /**
+   * \brief Set the number of pieces advertised to peers supporting availability windows.
+   *
+   * Instead of the whole bitfield, the client then only sends the part of its bitfield covering a window of the given number of pieces
+   * to peers which announce support for availability windows in their handshake message, and only sends HAVE messages for pieces within
+   * that window. The window is moved along with the playback position (see MoveAvailabilityWindow); on each move, only the bits of the
+   * pieces entering the window are sent. For large files with long-running sessions, this keeps the per-connection state and the
+   * announcement overhead proportional to the window instead of the file.
+   *
+   * The window size is rounded up to a multiple of 8 pieces, and windows always start at a multiple of 8 pieces, so that the advertised
+   * part of the bitfield can be copied bytewise.
+   *
+   * Note: The setting only affects connections established after it was changed.
+   *
+   * @param availabilityWindow the size of the window, in pieces. 0 disables availability windows. Default is 0.
+   */
+  void SetAvailabilityWindow (uint32_t availabilityWindow);
+
+  /**
+   * @returns the first piece of the advertised availability window.
+   */
+  uint32_t GetAvailabilityWindowStart () const
+  {
+    return m_availabilityWindowStart;
+  }
+
+  /**
+   * \brief Move the advertised availability window such that it begins at the given piece (rounded down to a multiple of 8 pieces).
+   *
+   * All peers advertising a window to their remote peers are informed of the move. Does nothing if availability windows are disabled.
+   *
+   * @param anchorPiece the piece the window should begin with, usually the piece containing the current playback position.
+   */
+  void MoveAvailabilityWindow (uint32_t anchorPiece);
+
   // Internal derived variables
 
   /**
@@ -954,6 +1128,16 @@ public:
    */
   void PeerHaveEvent (Ptr<Peer> peer, uint32_t pieceIndex);
 
+  /**
+   * \brief This event is triggered when a piece previously advertised by a peer left the availability window of that peer.
+   *
+   * The piece is no longer included in the result of the HasPiece method of the Peer class. Strategies keeping track of piece
+   * availability (e.g., for rarest-first selection) should treat this event as the inverse of the PeerHaveEvent.
+   *
+   * @param pieceIndex the index of the piece no longer advertised.
+   */
+  void PeerPieceUnavailableEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
   /**
    * \brief This event is one of the two events that usually start the operation of a strategy.
    *
@@ -976,6 +1160,9 @@ public:
 
   /**
    * \brief This event is the "inverse" of the PeerRequestEvent, informing about the reception of a cancellation request.
+   *
+   * The event is triggered for all received cancellation requests except those for the block currently being uploaded, including requests
+   * that were not (yet) queued for sending at the peer. Requests queued at the peer are removed before the event is triggered.
    */
   void PeerCancelEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
 
@@ -986,6 +1173,32 @@ public:
    */
   void PeerPortMessageEvent (Ptr<Peer> peer, uint16_t port);
 
+  /**
+   * \brief This event informs about the reception of a SUGGEST_PIECE message (Fast Extension), i.e., the peer suggests downloading a piece from it.
+   *
+   * @param pieceIndex the index of the suggested piece.
+   */
+  void PeerSuggestPieceEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
+  /**
+   * \brief This event informs about the reception of a REJECT_REQUEST message (Fast Extension), i.e., the peer will not serve one of our requests.
+   *
+   * Without the Fast Extension, rejected requests are dropped silently by the peer and only detected when they time out.
+   *
+   * @param pieceIndex the index of the piece of the rejected request.
+   * @param blockOffset the offset (in bytes) of the block of the rejected request within the piece.
+   * @param blockLength the length of the block of the rejected request.
+   */
+  void PeerRejectRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief This event informs about the reception of an ALLOWED_FAST message (Fast Extension), i.e., the peer allows us to request a piece
+   * even while it chokes us.
+   *
+   * @param pieceIndex the index of the piece that may be requested.
+   */
+  void PeerAllowedFastEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
   /**
    * \brief This event is triggered upon the reception of a message of the <a href="http://www.pushpull.org/beps/bep_0010.html" target="_blank">PushPull Extension Protocol (BEP 10)</a>.
    *
@@ -1096,12 +1309,24 @@ public:
   /**
    * \brief This event is triggered in regular intervals in order to obtain status information about the client and its strategies.
    *
-   * All associated listeners to the GatherMetricsEvent within strategies are called, and the returned maps containing the names
-   * of the metrics as keys and the values as the respective entries of the map are combined and announced via the AnnounceMetrics
-   * method.
+   * First, all listeners to the UpdateMetricChannelsEvent are called so that strategies can refresh their gauges, and the values of all
+   * channels in the metric channel registry (see the GetMetricChannels method) are announced via the AnnounceMetricChannels method.
+   *
+   * Then, all associated listeners to the (legacy, string-based) GatherMetricsEvent within strategies are called, and the returned maps
+   * containing the names of the metrics as keys and the values as the respective entries of the map are combined and announced via the
+   * AnnounceMetrics method.
    */
   void GatherMetricsEvent ();
 
+  /**
+   * \brief Announce the values of the typed metric channels to some output mechanism.
+   *
+   * The default implementation writes one binary record per counter and gauge (and one record per count, sum and bucket of each histogram)
+   * using the GlobalMetricsGatherer::WriteRecord method. Gauges without a value are skipped. You can override this method in order to use
+   * other output channels or filter output data.
+   */
+  virtual void AnnounceMetricChannels ();
+
   /**
    * \brief Announce client-local metrics to some output mechanism.
    *
@@ -1149,6 +1374,8 @@ public:
   void UnregisterCallbackInterestedChangingEvent (Callback<void, Ptr<Peer> > eventCallback);
   void RegisterCallbackPeerHaveEvent (Callback<void, Ptr<Peer>,uint32_t> eventCallback);
   void UnregisterCallbackPeerHaveEvent (Callback<void, Ptr<Peer>,uint32_t> eventCallback);
+  void RegisterCallbackPeerPieceUnavailableEvent (Callback<void, Ptr<Peer>,uint32_t> eventCallback);
+  void UnregisterCallbackPeerPieceUnavailableEvent (Callback<void, Ptr<Peer>,uint32_t> eventCallback);
   void RegisterCallbackBitfieldReceivedEvent (Callback<void, Ptr<Peer> > eventCallback);
   void UnregisterCallbackBitfieldReceivedEvent (Callback<void, Ptr<Peer> > eventCallback);
   void RegisterCallbackRequestEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback);
@@ -1157,6 +1384,12 @@ public:
   void UnregisterCallbackCancelEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback);
   void RegisterCallbackPortMessageEvent (Callback<void, Ptr<Peer>, uint16_t> eventCallback);
   void UnregisterCallbackPortMessageEvent (Callback<void, Ptr<Peer>, uint16_t> eventCallback);
+  void RegisterCallbackSuggestPieceEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback);
+  void UnregisterCallbackSuggestPieceEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback);
+  void RegisterCallbackRejectRequestEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback);
+  void UnregisterCallbackRejectRequestEvent (Callback<void, Ptr<Peer>,uint32_t,uint32_t,uint32_t> eventCallback);
+  void RegisterCallbackAllowedFastEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback);
+  void UnregisterCallbackAllowedFastEvent (Callback<void, Ptr<Peer>, uint32_t> eventCallback);
   void RegisterCallbackExtensionMessageEvent (uint8_t messageId, Callback<void, Ptr<Peer>, const std::string& > eventCallback);
   void UnregisterCallbackExtensionMessageEvent (uint8_t messageId, Callback<void, Ptr<Peer>, const std::string& > eventCallback);
 
@@ -1189,6 +1422,8 @@ public:
 
   void RegisterCallbackGatherMetricsEvent (Callback<std::map<std::string, std::string> > eventCallback);
   void UnregisterCallbackGatherMetricsEvent (Callback<std::map<std::string, std::string> > eventCallback);
+  void RegisterCallbackUpdateMetricChannelsEvent (Callback<void> eventCallback);
+  void UnregisterCallbackUpdateMetricChannelsEvent (Callback<void> eventCallback);
 
 // Callback triggers
 public:
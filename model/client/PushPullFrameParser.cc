@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#include "PushPullFrameParser.h"
+
+#include "ns3/PushPullDefines.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cstring> // for memcpy
+
+namespace ns3 {
+namespace pushpull {
+
+PushPullFrameParser::PushPullFrameParser ()
+{
+  m_data = 0;
+  m_capacity = 0;
+  m_head = 0;
+  m_size = 0;
+}
+
+PushPullFrameParser::~PushPullFrameParser ()
+{
+  delete[] m_data;
+}
+
+void PushPullFrameParser::Reserve (uint32_t freeSpace)
+{
+  if (m_capacity - m_size >= freeSpace)
+    {
+      return;
+    }
+
+  // Step 1: Determine the new capacity
+  uint32_t newCapacity = std::max (m_capacity, static_cast<uint32_t> (PP_PEER_RECEIVE_BUFFER_INITIAL_SIZE));
+  while (newCapacity - m_size < freeSpace)
+    {
+      newCapacity *= 2;
+    }
+
+  // Step 2: Move the buffered data to the beginning of the new storage, so it does not wrap around anymore
+  uint8_t* newData = new uint8_t[newCapacity];
+  CopyTo (0, newData, m_size);
+
+  delete[] m_data;
+  m_data = newData;
+  m_capacity = newCapacity;
+  m_head = 0;
+}
+
+uint8_t* PushPullFrameParser::GetWriteSpan (uint32_t &length)
+{
+  if (m_capacity == 0)
+    {
+      length = 0;
+      return 0;
+    }
+
+  uint32_t tail = (m_head + m_size) & (m_capacity - 1);
+  length = std::min (m_capacity - m_size, m_capacity - tail);
+
+  return m_data + tail;
+}
+
+void PushPullFrameParser::CommitWrite (uint32_t length)
+{
+  NS_ASSERT (m_size + length <= m_capacity);
+
+  m_size += length;
+}
+
+void PushPullFrameParser::Consume (uint32_t length)
+{
+  NS_ASSERT (length <= m_size);
+
+  m_size -= length;
+  if (m_size == 0)
+    {
+      m_head = 0;             // Keeps the next write span as large as possible
+    }
+  else
+    {
+      m_head = (m_head + length) & (m_capacity - 1);
+    }
+}
+
+void PushPullFrameParser::Clear (bool release)
+{
+  m_head = 0;
+  m_size = 0;
+
+  if (release)
+    {
+      delete[] m_data;
+      m_data = 0;
+      m_capacity = 0;
+    }
+}
+
+uint16_t PushPullFrameParser::PeekNtohU16 (uint32_t offset) const
+{
+  return (static_cast<uint16_t> (PeekU8 (offset)) << 8) | PeekU8 (offset + 1);
+}
+
+uint32_t PushPullFrameParser::PeekNtohU32 (uint32_t offset) const
+{
+  return (static_cast<uint32_t> (PeekU8 (offset)) << 24) | (static_cast<uint32_t> (PeekU8 (offset + 1)) << 16)
+         | (static_cast<uint32_t> (PeekU8 (offset + 2)) << 8) | PeekU8 (offset + 3);
+}
+
+void PushPullFrameParser::CopyTo (uint32_t offset, uint8_t* target, uint32_t length) const
+{
+  NS_ASSERT (offset + length <= m_size);
+
+  if (length == 0)
+    {
+      return;
+    }
+
+  // The data consists of at most two contiguous parts: up to the end of the storage, and from its beginning
+  uint32_t start = (m_head + offset) & (m_capacity - 1);
+  uint32_t firstPart = std::min (length, m_capacity - start);
+  std::memcpy (target, m_data + start, firstPart);
+  std::memcpy (target + firstPart, m_data, length - firstPart);
+}
+
+bool PushPullFrameParser::Equals (uint32_t offset, const uint8_t* data, uint32_t length) const
+{
+  NS_ASSERT (offset + length <= m_size);
+
+  if (length == 0)
+    {
+      return true;
+    }
+
+  uint32_t start = (m_head + offset) & (m_capacity - 1);
+  uint32_t firstPart = std::min (length, m_capacity - start);
+
+  return std::memcmp (data, m_data + start, firstPart) == 0 && std::memcmp (data + firstPart, m_data, length - firstPart) == 0;
+}
+
+bool PushPullFrameParser::HasCompleteMessage (uint32_t &messageLength) const
+{
+  if (m_size < PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH)
+    {
+      return false;
+    }
+
+  messageLength = PeekNtohU32 (0);
+
+  return m_size - PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH >= messageLength;
+}
+
+bool PushPullFrameParser::HasCompleteHandshake (uint32_t &handshakeLength) const
+{
+  if (m_size < 1)
+    {
+      return false;
+    }
+
+  // The handshake starts with the length of the protocol string, followed by the string and the fixed-size part of the message
+  handshakeLength = PP_PROTOCOL_MESSAGES_HANDSHAKE_LENGTH_MIN + PeekU8 (0);
+
+  return m_size >= handshakeLength;
+}
+
+} // ns pushpull
+} // ns ns3
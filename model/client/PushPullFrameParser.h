@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ * Partially copyright (c) 2014-2015 Yonsei University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ * Contributors: Taejin Park
+ */
+
+#ifndef PUSHPULLFRAMEPARSER_H_
+#define PUSHPULLFRAMEPARSER_H_
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace pushpull {
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief A contiguous ring buffer for the incoming byte stream of a peer connection, with helpers to decode PushPull Peer Wire Protocol frames in place.
+ *
+ * Data is received from the socket directly into the free space of the buffer (see the GetWriteSpan and CommitWrite methods).
+ * The fields of a message can then be read at offsets relative to the beginning of the buffered data, without the need to construct
+ * intermediate Packet or Header objects. Reads transparently handle messages that wrap around the end of the buffer.
+ * The buffer grows (to the next power of two) if a message does not fit into it.
+ *
+ * All multi-byte fields are decoded in network byte order.
+ */
+class PushPullFrameParser
+{
+// Fields
+private:
+  uint8_t*   m_data;           // The storage of the ring buffer
+  uint32_t   m_capacity;       // The size of m_data; always a power of two (or 0 if no storage is allocated)
+  uint32_t   m_head;           // The position of the first buffered byte within m_data
+  uint32_t   m_size;           // The number of buffered bytes
+
+// Constructors etc.
+public:
+  PushPullFrameParser ();
+  virtual ~PushPullFrameParser ();
+
+// Buffer management
+public:
+  /**
+   * \brief Make sure that at least the given number of bytes can be appended to the buffer, growing it if necessary.
+   */
+  void Reserve (uint32_t freeSpace);
+
+  /**
+   * \brief Get the contiguous free space at the end of the buffered data.
+   *
+   * @param length is set to the number of bytes that can be written to the returned pointer. May be smaller than the overall free space if the buffer wraps around.
+   *
+   * @returns a pointer to write newly-received data to.
+   */
+  uint8_t* GetWriteSpan (uint32_t &length);
+
+  /**
+   * \brief Append the given number of bytes, previously written to the span returned by GetWriteSpan, to the buffered data.
+   */
+  void CommitWrite (uint32_t length);
+
+  /**
+   * \brief Remove the given number of bytes from the beginning of the buffered data.
+   */
+  void Consume (uint32_t length);
+
+  /**
+   * \brief Remove all buffered data.
+   *
+   * @param release whether to also free the storage of the buffer.
+   */
+  void Clear (bool release);
+
+  /**
+   * @returns the number of buffered bytes.
+   */
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+
+// Field access
+public:
+  uint8_t PeekU8 (uint32_t offset) const
+  {
+    return m_data[(m_head + offset) & (m_capacity - 1)];
+  }
+
+  uint16_t PeekNtohU16 (uint32_t offset) const;
+
+  uint32_t PeekNtohU32 (uint32_t offset) const;
+
+  /**
+   * \brief Copy buffered data to another memory location.
+   *
+   * @param offset the position of the first byte to copy, relative to the beginning of the buffered data.
+   * @param target the memory location to copy the data to.
+   * @param length the number of bytes to copy.
+   */
+  void CopyTo (uint32_t offset, uint8_t* target, uint32_t length) const;
+
+  /**
+   * \brief Compare buffered data with another memory location without copying it.
+   *
+   * @returns true, if the given number of bytes at the offset is equal to the data at the given memory location.
+   */
+  bool Equals (uint32_t offset, const uint8_t* data, uint32_t length) const;
+
+// Framing
+public:
+  /**
+   * \brief Check whether a complete length-prefixed message is buffered.
+   *
+   * @param messageLength is set to the announced length of the message (excluding the length prefix), if at least the prefix is buffered.
+   *
+   * @returns true, if the length prefix and the complete message are buffered.
+   */
+  bool HasCompleteMessage (uint32_t &messageLength) const;
+
+  /**
+   * \brief Check whether a complete handshake message is buffered.
+   *
+   * @param handshakeLength is set to the overall length of the handshake message, if at least its first byte is buffered.
+   *
+   * @returns true, if the complete handshake message is buffered.
+   */
+  bool HasCompleteHandshake (uint32_t &handshakeLength) const;
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* PUSHPULLFRAMEPARSER_H_ */
@@ -22,9 +22,12 @@
 
 #include "PushPullPacket.h"
 
+#include "ns3/PushPullDefines.h"
+
 #include "ns3/log.h"
 #include "ns3/packet.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace ns3 {
@@ -38,6 +41,10 @@ NS_OBJECT_ENSURE_REGISTERED (PushPullHandshakeMessage);
 
 PushPullHandshakeMessage::PushPullHandshakeMessage ()
 {
+  m_compressedBitfieldSupport = false;
+  m_sessionResume = false;
+  m_availabilityWindowSupport = false;
+  m_fastExtensionSupport = false;
 }
 
 PushPullHandshakeMessage::~PushPullHandshakeMessage ()
@@ -57,7 +64,12 @@ void PushPullHandshakeMessage::Serialize (Buffer::Iterator start) const
   // Announce that we support the extension protocol
   uint8_t extensionBit = 0x10;
   start.WriteU8 (extensionBit);
-  start.Write (buffer, 2);
+  // Announce whether we want to resume a cached session
+  start.WriteU8 (m_sessionResume ? PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_MASK : 0);
+  // Announce whether we support compressed bitfields, availability windows and the Fast Extension
+  start.WriteU8 ((m_compressedBitfieldSupport ? PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_MASK : 0)
+                 | (m_availabilityWindowSupport ? PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_MASK : 0)
+                 | (m_fastExtensionSupport ? PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_MASK : 0));
   // Write the rest of the message
   start.Write (m_infoHash,20);
   start.Write (m_peerId,20);
@@ -72,6 +84,10 @@ uint32_t PushPullHandshakeMessage::Deserialize (Buffer::Iterator start)
   start.Read (buffer,pstrLen);      // protocol string
   m_protocol = reinterpret_cast<char*> (buffer);
   start.Read (buffer,8);      // Reserved space; TODO: Read out announcements for "extension protocol" messages (see Serialize())
+  m_compressedBitfieldSupport = buffer[PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_BYTE] & PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_MASK;
+  m_sessionResume = buffer[PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_BYTE] & PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_MASK;
+  m_availabilityWindowSupport = buffer[PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_BYTE] & PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_MASK;
+  m_fastExtensionSupport = buffer[PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_BYTE] & PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_MASK;
   start.Read (m_infoHash,20);
   start.Read (m_peerId,20);
   return pstrLen + 49;
@@ -523,5 +539,429 @@ std::string PushPullExtensionMessage::GetContent () const
   return result;
 }
 
+/************************************************************************************************/
+/**************************************** PushPullMessageBatch **************************************/
+/************************************************************************************************/
+
+PushPullMessageBatch::PushPullMessageBatch (uint32_t expectedMessages)
+{
+  // REQUEST and CANCEL are the largest of the supported messages
+  m_data.reserve (expectedMessages * (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + PP_PROTOCOL_MESSAGES_REQUEST_LENGTH));
+  m_messageCount = 0;
+}
+
+PushPullMessageBatch::~PushPullMessageBatch ()
+{
+}
+
+void PushPullMessageBatch::AddKeepAlive ()
+{
+  AppendHtonU32 (PP_PROTOCOL_MESSAGES_KEEPALIVE_LENGTH);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddChoke (bool choke)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_CHOKE_LENGTH, choke ? PushPullTypeHeader::CHOKE : PushPullTypeHeader::UNCHOKE);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddInterested (bool interested)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_INTERESTED_LENGTH, interested ? PushPullTypeHeader::INTERESTED : PushPullTypeHeader::NOT_INTERESTED);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddHave (uint32_t pieceIndex)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_HAVE_LENGTH, PushPullTypeHeader::HAVE);
+  AppendHtonU32 (pieceIndex);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_REQUEST_LENGTH, PushPullTypeHeader::REQUEST);
+  AppendHtonU32 (pieceIndex);
+  AppendHtonU32 (blockOffset);
+  AppendHtonU32 (blockLength);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddCancel (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_CANCEL_LENGTH, PushPullTypeHeader::CANCEL);
+  AppendHtonU32 (pieceIndex);
+  AppendHtonU32 (blockOffset);
+  AppendHtonU32 (blockLength);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddSuggestPiece (uint32_t pieceIndex)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_SUGGEST_PIECE_LENGTH, PushPullTypeHeader::SUGGEST_PIECE);
+  AppendHtonU32 (pieceIndex);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddHaveAll (bool haveAll)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_HAVE_ALL_LENGTH, haveAll ? PushPullTypeHeader::HAVE_ALL : PushPullTypeHeader::HAVE_NONE);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddRejectRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_REJECT_REQUEST_LENGTH, PushPullTypeHeader::REJECT_REQUEST);
+  AppendHtonU32 (pieceIndex);
+  AppendHtonU32 (blockOffset);
+  AppendHtonU32 (blockLength);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::AddAllowedFast (uint32_t pieceIndex)
+{
+  AppendPrelude (PP_PROTOCOL_MESSAGES_ALLOWED_FAST_LENGTH, PushPullTypeHeader::ALLOWED_FAST);
+  AppendHtonU32 (pieceIndex);
+  ++m_messageCount;
+}
+
+void PushPullMessageBatch::Clear ()
+{
+  m_data.clear ();
+  m_messageCount = 0;
+}
+
+Ptr<Packet> PushPullMessageBatch::ToPacket () const
+{
+  return Create<Packet> (GetData (), GetSize ());
+}
+
+uint32_t PushPullMessageBatch::Decode (const uint8_t* data, uint32_t size, std::vector<Message>& messages)
+{
+  uint32_t position = 0;
+  while (size - position >= PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH)
+    {
+      // Step 1: Read the length prefix and check whether the message is complete
+      const uint8_t* current = data + position;
+      uint32_t messageLength = (static_cast<uint32_t> (current[0]) << 24) | (static_cast<uint32_t> (current[1]) << 16)
+        | (static_cast<uint32_t> (current[2]) << 8) | current[3];
+      if (size - position - PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH < messageLength)
+        {
+          break;
+        }
+
+      // Step 2: Decode the fields of the supported message types
+      Message message;
+      message.m_pieceIndex = 0;
+      message.m_blockOffset = 0;
+      message.m_blockLength = 0;
+
+      const uint8_t* fields = current + PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + 1;
+      uint32_t fieldCount = 0;
+      if (messageLength == PP_PROTOCOL_MESSAGES_KEEPALIVE_LENGTH)
+        {
+          message.m_type = PushPullTypeHeader::KEEP_ALIVE;
+        }
+      else
+        {
+          message.m_type = current[PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH];
+          switch (message.m_type)
+            {
+            case PushPullTypeHeader::CHOKE:
+            case PushPullTypeHeader::UNCHOKE:
+            case PushPullTypeHeader::INTERESTED:
+            case PushPullTypeHeader::NOT_INTERESTED:
+            case PushPullTypeHeader::HAVE_ALL:
+            case PushPullTypeHeader::HAVE_NONE:
+              break;
+            case PushPullTypeHeader::HAVE:
+            case PushPullTypeHeader::SUGGEST_PIECE:
+            case PushPullTypeHeader::ALLOWED_FAST:
+              fieldCount = 1;
+              break;
+            case PushPullTypeHeader::REQUEST:
+            case PushPullTypeHeader::CANCEL:
+            case PushPullTypeHeader::REJECT_REQUEST:
+              fieldCount = 3;
+              break;
+            default:
+              return position;               // Not a fixed-size message; left to the caller
+            }
+
+          if (messageLength != 1 + 4 * fieldCount)
+            {
+              return position;
+            }
+        }
+
+      uint32_t* targets[3] = { &message.m_pieceIndex, &message.m_blockOffset, &message.m_blockLength };
+      for (uint32_t i = 0; i < fieldCount; ++i)
+        {
+          const uint8_t* field = fields + 4 * i;
+          *targets[i] = (static_cast<uint32_t> (field[0]) << 24) | (static_cast<uint32_t> (field[1]) << 16)
+            | (static_cast<uint32_t> (field[2]) << 8) | field[3];
+        }
+
+      messages.push_back (message);
+      position += PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + messageLength;
+    }
+
+  return position;
+}
+
+void PushPullMessageBatch::AppendPrelude (uint32_t messageLength, uint8_t type)
+{
+  AppendHtonU32 (messageLength);
+  m_data.push_back (type);
+}
+
+void PushPullMessageBatch::AppendHtonU32 (uint32_t value)
+{
+  m_data.push_back (static_cast<uint8_t> (value >> 24));
+  m_data.push_back (static_cast<uint8_t> (value >> 16));
+  m_data.push_back (static_cast<uint8_t> (value >> 8));
+  m_data.push_back (static_cast<uint8_t> (value));
+}
+
+/************************************************************************************************/
+/************************************** PushPullCompressedBitfield **************************************/
+/************************************************************************************************/
+
+std::string PushPullCompressedBitfield::Encode (const std::vector<uint8_t> &bitfield, uint32_t numberOfPieces)
+{
+  std::string content (1, static_cast<char> (RUN_LENGTH));
+
+  // Step 1: Create the run-length encoding; whole bytes of equal bits are skipped at once
+  bool runValue = false;       // Runs alternate, starting with missing pieces
+  uint32_t runLength = 0;
+  uint32_t runCount = 0;
+  uint32_t i = 0;
+  while (i < numberOfPieces)
+    {
+      if (i % 8 == 0 && i + 8 <= numberOfPieces && bitfield[i / 8] == (runValue ? 0xff : 0x00))
+        {
+          runLength += 8;
+          i += 8;
+          continue;
+        }
+
+      if (HasPiece (bitfield, i) != runValue)
+        {
+          AppendVarInt (content, runLength);
+          ++runCount;
+          runValue = !runValue;
+          runLength = 0;
+        }
+      ++runLength;
+      ++i;
+    }
+  AppendVarInt (content, runLength);
+  ++runCount;
+
+  // Step 2: A single run of missing pieces or a zero-length run followed by a run of available pieces denote the trivial cases
+  if (runCount == 1)
+    {
+      return std::string (1, static_cast<char> (HAVE_NONE));
+    }
+  if (runCount == 2 && content[1] == 0)
+    {
+      return std::string (1, static_cast<char> (HAVE_ALL));
+    }
+
+  // Step 3: Fall back to the uncompressed bitfield if the run-length encoding does not pay off
+  uint32_t bitfieldSize = (numberOfPieces + 7) / 8;
+  if (content.size () > 1 + bitfieldSize)
+    {
+      content.assign (1, static_cast<char> (RAW));
+      content.append (reinterpret_cast<const char*> (&bitfield[0]), bitfieldSize);
+    }
+
+  return content;
+}
+
+bool PushPullCompressedBitfield::Decode (const std::string &content, uint32_t numberOfPieces, std::vector<uint8_t> *target)
+{
+  uint32_t bitfieldSize = (numberOfPieces + 7) / 8;
+  if (content.empty () || target->size () != bitfieldSize)
+    {
+      return false;
+    }
+
+  switch (static_cast<uint8_t> (content[0]))
+    {
+    case HAVE_NONE:
+      {
+        std::fill (target->begin (), target->end (), 0);
+        return true;
+      }
+    case HAVE_ALL:
+      {
+        std::fill (target->begin (), target->end (), 0);
+        SetPieces (target, 0, numberOfPieces);
+        return true;
+      }
+    case RAW:
+      {
+        if (content.size () != 1 + bitfieldSize)
+          {
+            return false;
+          }
+        content.copy (reinterpret_cast<char*> (&(*target)[0]), bitfieldSize, 1);
+        return true;
+      }
+    case RUN_LENGTH:
+      {
+        std::fill (target->begin (), target->end (), 0);
+
+        bool runValue = false;
+        uint32_t position = 0;
+        uint32_t value = 0;
+        uint32_t shift = 0;
+        for (uint32_t i = 1; i < content.size (); ++i)
+          {
+            // Step 1: Assemble the next run length
+            uint8_t byte = static_cast<uint8_t> (content[i]);
+            if (shift > 28)
+              {
+                return false;
+              }
+            value |= static_cast<uint32_t> (byte & 0x7f) << shift;
+            shift += 7;
+            if (byte & 0x80)
+              {
+                continue;
+              }
+
+            // Step 2: Apply the run
+            if (value > numberOfPieces - position)
+              {
+                return false;
+              }
+            if (runValue)
+              {
+                SetPieces (target, position, value);
+              }
+            position += value;
+            runValue = !runValue;
+            value = 0;
+            shift = 0;
+          }
+
+        return shift == 0 && position == numberOfPieces;
+      }
+    default:
+      {
+        return false;
+      }
+    }
+}
+
+bool PushPullCompressedBitfield::EncodeDelta (const std::vector<uint8_t> &previous, const std::vector<uint8_t> &current, uint32_t numberOfPieces, std::string &content)
+{
+  content.clear ();
+
+  uint32_t bitfieldSize = (numberOfPieces + 7) / 8;
+  if (previous.size () != bitfieldSize || current.size () != bitfieldSize)
+    {
+      return false;
+    }
+
+  uint32_t nextPiece = 0;       // The first piece index the next distance refers to
+  for (uint32_t i = 0; i < bitfieldSize; ++i)
+    {
+      // Step 1: Whole bytes without changes are skipped at once
+      if (previous[i] & ~current[i])
+        {
+          return false;
+        }
+      uint8_t gained = current[i] & ~previous[i];
+      if (gained == 0)
+        {
+          continue;
+        }
+
+      // Step 2: Append the distances of the gained pieces of this byte
+      for (uint32_t bit = 0; bit < 8 && i * 8 + bit < numberOfPieces; ++bit)
+        {
+          if (gained & (0x80 >> bit))
+            {
+              AppendVarInt (content, i * 8 + bit - nextPiece);
+              nextPiece = i * 8 + bit + 1;
+            }
+        }
+    }
+
+  return true;
+}
+
+bool PushPullCompressedBitfield::DecodeDelta (const std::string &content, uint32_t numberOfPieces, std::vector<uint8_t> *target)
+{
+  if (target->size () != (numberOfPieces + 7) / 8)
+    {
+      return false;
+    }
+
+  uint32_t nextPiece = 0;
+  uint32_t value = 0;
+  uint32_t shift = 0;
+  for (uint32_t i = 0; i < content.size (); ++i)
+    {
+      // Step 1: Assemble the next distance
+      uint8_t byte = static_cast<uint8_t> (content[i]);
+      if (shift > 28)
+        {
+          return false;
+        }
+      value |= static_cast<uint32_t> (byte & 0x7f) << shift;
+      shift += 7;
+      if (byte & 0x80)
+        {
+          continue;
+        }
+
+      // Step 2: Add the piece
+      if (value >= numberOfPieces - nextPiece)
+        {
+          return false;
+        }
+      nextPiece += value;
+      (*target)[nextPiece / 8] |= 0x01 << (7 - nextPiece % 8);
+      ++nextPiece;
+      value = 0;
+      shift = 0;
+    }
+
+  return shift == 0;
+}
+
+void PushPullCompressedBitfield::AppendVarInt (std::string &content, uint32_t value)
+{
+  while (value >= 0x80)
+    {
+      content.push_back (static_cast<char> ((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+  content.push_back (static_cast<char> (value));
+}
+
+void PushPullCompressedBitfield::SetPieces (std::vector<uint8_t> *target, uint32_t from, uint32_t count)
+{
+  uint32_t end = from + count;
+  while (from < end)
+    {
+      if (from % 8 == 0 && from + 8 <= end)
+        {
+          (*target)[from / 8] = 0xff;
+          from += 8;
+        }
+      else
+        {
+          (*target)[from / 8] |= 0x01 << (7 - from % 8);
+          ++from;
+        }
+    }
+}
+
 } // ns pushpull
 } // ns ns3
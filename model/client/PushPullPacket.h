@@ -24,6 +24,10 @@
 #define PPPACKET_H_
 
 #include "ns3/header.h"
+#include "ns3/packet.h"
+
+#include <string>
+#include <vector>
 
 namespace ns3 {
 namespace pushpull {
@@ -46,6 +50,10 @@ private:
   std::string m_protocol;    // The string referencing the protocol
   uint8_t m_infoHash[20];    // The info hash of the torrent
   uint8_t m_peerId[20];      // Some ID that the client wishes to be identified with at the remote side
+  bool m_compressedBitfieldSupport; // Whether the sending client announces support for compressed bitfields
+  bool m_sessionResume;      // Whether the sending client holds a cached session with the receiving client (see the PeerSessionCache class)
+  bool m_availabilityWindowSupport; // Whether the sending client understands availability window messages
+  bool m_fastExtensionSupport; // Whether the sending client supports the Fast Extension messages
 
 // Constructors etc.
 public:
@@ -120,6 +128,71 @@ public:
     memcpy (m_peerId,peerId,20);
   }
 
+  /**
+   * @returns true, if the sending client announced support for compressed bitfields (see the PushPullCompressedBitfield class).
+   */
+  bool GetCompressedBitfieldSupport () const
+  {
+    return m_compressedBitfieldSupport;
+  }
+
+  /**
+   * \brief Set whether the handshake announces support for compressed bitfields. The announcement uses a bit of the reserved space of the message.
+   */
+  void SetCompressedBitfieldSupport (bool compressedBitfieldSupport)
+  {
+    m_compressedBitfieldSupport = compressedBitfieldSupport;
+  }
+
+  /**
+   * @returns true, if the sending client announced that it wants to resume a cached session with the receiving client.
+   */
+  bool GetSessionResume () const
+  {
+    return m_sessionResume;
+  }
+
+  /**
+   * \brief Set whether the handshake announces that the sending client wants to resume a cached session with the receiving client.
+   * The announcement uses a bit of the reserved space of the message.
+   */
+  void SetSessionResume (bool sessionResume)
+  {
+    m_sessionResume = sessionResume;
+  }
+
+  /**
+   * @returns true, if the sending client announced that it understands availability window messages (see PushPullClient::SetAvailabilityWindow).
+   */
+  bool GetAvailabilityWindowSupport () const
+  {
+    return m_availabilityWindowSupport;
+  }
+
+  /**
+   * \brief Set whether the handshake announces that the sending client understands availability window messages. The announcement uses a bit of the reserved space of the message.
+   */
+  void SetAvailabilityWindowSupport (bool availabilityWindowSupport)
+  {
+    m_availabilityWindowSupport = availabilityWindowSupport;
+  }
+
+  /**
+   * @returns true, if the sending client announced support for the Fast Extension messages (SUGGEST_PIECE, HAVE_ALL, HAVE_NONE, REJECT_REQUEST and ALLOWED_FAST).
+   */
+  bool GetFastExtensionSupport () const
+  {
+    return m_fastExtensionSupport;
+  }
+
+  /**
+   * \brief Set whether the handshake announces support for the Fast Extension messages. The announcement uses a bit of the reserved space of the message.
+   */
+  void SetFastExtensionSupport (bool fastExtensionSupport)
+  {
+    m_fastExtensionSupport = fastExtensionSupport;
+  }
+
 // (De-)Serialization
 public:
   virtual void Serialize (Buffer::Iterator start) const;
@@ -239,6 +312,11 @@ public:
     PIECE = 7,
     CANCEL = 8,
     PORT = 9,
+    SUGGEST_PIECE = 13,   // Fast Extension according to BEP-6
+    HAVE_ALL = 14,
+    HAVE_NONE = 15,
+    REJECT_REQUEST = 16,
+    ALLOWED_FAST = 17,
     EXTENDED = 20,  // PushPull Extension Protocol according to BEP-10,
 	HANDSHAKE = 128
   };
@@ -874,6 +952,228 @@ private:
   }
 };
 
+/************************************************************************************************/
+/**************************************** PushPullMessageBatch **************************************/
+/************************************************************************************************/
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief A compact encoder and decoder for batches of fixed-size Peer Wire messages.
+ *
+ * In contrast to the Header-based message classes above, which require one AddHeader call (and buffer adjustment) per header,
+ * this class writes the length prefix, type and fields of each message directly into a single contiguous buffer.
+ * Any number of CHOKE, UNCHOKE, INTERESTED, NOT_INTERESTED, HAVE, REQUEST and CANCEL messages, the SUGGEST_PIECE, HAVE_ALL, HAVE_NONE,
+ * REJECT_REQUEST and ALLOWED_FAST messages of the Fast Extension (BEP 6) as well as keep-alives can be appended; the whole batch is then
+ * turned into a single Packet with one allocation.
+ *
+ * The static Decode method is the bulk counterpart, which reads a sequence of such messages from a contiguous buffer.
+ */
+class PushPullMessageBatch
+{
+// Types used
+public:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    int16_t  m_type;           // The PushPullTypeHeader::PushPullMessageType of the message; KEEP_ALIVE for keep-alives
+    uint32_t m_pieceIndex;     // HAVE, REQUEST, CANCEL, SUGGEST_PIECE, REJECT_REQUEST, ALLOWED_FAST: the index of the piece
+    uint32_t m_blockOffset;    // REQUEST, CANCEL, REJECT_REQUEST: the offset of the block within the piece
+    uint32_t m_blockLength;    // REQUEST, CANCEL, REJECT_REQUEST: the length of the block
+  } Message;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  std::vector<uint8_t> m_data;           // The encoded messages
+  uint32_t             m_messageCount;   // The number of encoded messages
+
+// Constructors etc.
+public:
+  /**
+   * \brief Create an empty batch.
+   *
+   * @param expectedMessages the number of messages to reserve buffer space for, so that appending them does not require further allocations.
+   */
+  PushPullMessageBatch (uint32_t expectedMessages = 1);
+  virtual ~PushPullMessageBatch ();
+
+// Encoding
+public:
+  void AddKeepAlive ();
+
+  /**
+   * \brief Append a CHOKE (if choke is true) or UNCHOKE message.
+   */
+  void AddChoke (bool choke);
+
+  /**
+   * \brief Append an INTERESTED (if interested is true) or NOT_INTERESTED message.
+   */
+  void AddInterested (bool interested);
+
+  void AddHave (uint32_t pieceIndex);
+
+  void AddRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  void AddCancel (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  void AddSuggestPiece (uint32_t pieceIndex);
+
+  /**
+   * \brief Append a HAVE_ALL (if haveAll is true) or HAVE_NONE message.
+   */
+  void AddHaveAll (bool haveAll);
+
+  void AddRejectRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  void AddAllowedFast (uint32_t pieceIndex);
+
+  /**
+   * \brief Remove all messages from the batch. The reserved buffer space is kept.
+   */
+  void Clear ();
+
+// Access
+public:
+  /**
+   * @returns a Packet containing all messages of the batch, in the order they were added.
+   */
+  Ptr<Packet> ToPacket () const;
+
+  const uint8_t* GetData () const
+  {
+    return m_data.empty () ? 0 : &m_data[0];
+  }
+
+  /**
+   * @returns the size, in bytes, of the encoded messages.
+   */
+  uint32_t GetSize () const
+  {
+    return m_data.size ();
+  }
+
+  uint32_t GetMessageCount () const
+  {
+    return m_messageCount;
+  }
+
+// Decoding
+public:
+  /**
+   * \brief Decode a sequence of fixed-size messages from a buffer.
+   *
+   * Decoding stops at the first message that is incomplete or of a type not supported by this class (e.g., a PIECE message),
+   * so that the caller can handle the remaining data otherwise.
+   *
+   * @param data the buffer to decode.
+   * @param size the size of the buffer, in bytes.
+   * @param messages the decoded messages are appended to this vector.
+   *
+   * @returns the number of bytes decoded.
+   */
+  static uint32_t Decode (const uint8_t* data, uint32_t size, std::vector<Message>& messages);
+
+// Internal methods
+private:
+  // Append the length prefix and type of a message
+  void AppendPrelude (uint32_t messageLength, uint8_t type);
+
+  void AppendHtonU32 (uint32_t value);
+};
+
+/************************************************************************************************/
+/************************************** PushPullCompressedBitfield **************************************/
+/************************************************************************************************/
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Encoder and decoder for the content of compressed bitfield messages.
+ *
+ * Compressed bitfields are exchanged as Extension Protocol messages (with id PP_PROTOCOL_EXTENSION_MESSAGE_ID_COMPRESSED_BITFIELD)
+ * between clients that both announced support in their handshake messages. They replace the BITFIELD message, whose size is
+ * proportional to the number of pieces of the file, by one of the following encodings (the first byte of the content):\n
+ * HAVE_NONE / HAVE_ALL: no further content.\n
+ * RUN_LENGTH: the lengths of alternating runs of missing and available pieces, starting with missing pieces (the first run may have length 0),
+ * each as an unsigned LEB128 variable-length integer.\n
+ * RAW: the uncompressed bitfield, used if no other encoding is smaller.
+ */
+class PushPullCompressedBitfield
+{
+// Types used
+public:
+  enum Encoding
+  {
+    HAVE_NONE = 0,
+    HAVE_ALL = 1,
+    RUN_LENGTH = 2,
+    RAW = 3
+  };
+
+// Encoding and decoding
+public:
+  /**
+   * \brief Encode a bitfield into the smallest of the supported encodings.
+   *
+   * @param bitfield the bitfield to encode (in the PushPull bit order, i.e., the most significant bit of the first byte denotes piece 0).
+   * @param numberOfPieces the number of pieces of the file. Bits beyond this number are ignored.
+   *
+   * @returns the content of the compressed bitfield message.
+   */
+  static std::string Encode (const std::vector<uint8_t> &bitfield, uint32_t numberOfPieces);
+
+  /**
+   * \brief Decode the content of a compressed bitfield message.
+   *
+   * @param content the content of the message.
+   * @param numberOfPieces the number of pieces of the file.
+   * @param target the bitfield to write the result to. Its size must be (numberOfPieces + 7) / 8 bytes. Left unspecified if the content is malformed.
+   *
+   * @returns true, if the content was decoded successfully.
+   */
+  static bool Decode (const std::string &content, uint32_t numberOfPieces, std::vector<uint8_t> *target);
+
+  /**
+   * \brief Encode the pieces gained between two versions of a bitfield, for the bitfield delta messages of resumed sessions
+   * (with id PP_PROTOCOL_EXTENSION_MESSAGE_ID_BITFIELD_DELTA). The content is the list of gained pieces in ascending order,
+   * each encoded as the distance to its predecessor (minus one) as an unsigned LEB128 variable-length integer.
+   *
+   * @param previous the bitfield as known to the receiver.
+   * @param current the current bitfield.
+   * @param numberOfPieces the number of pieces of the file.
+   * @param content the content of the message is written here.
+   *
+   * @returns false, if a piece of the previous bitfield is missing from the current bitfield, which cannot be expressed as a delta.
+   */
+  static bool EncodeDelta (const std::vector<uint8_t> &previous, const std::vector<uint8_t> &current, uint32_t numberOfPieces, std::string &content);
+
+  /**
+   * \brief Decode the content of a bitfield delta message and add the contained pieces to a bitfield.
+   *
+   * @param content the content of the message.
+   * @param numberOfPieces the number of pieces of the file.
+   * @param target the bitfield to add the pieces to. Its size must be (numberOfPieces + 7) / 8 bytes. Left unspecified if the content is malformed.
+   *
+   * @returns true, if the content was decoded successfully.
+   */
+  static bool DecodeDelta (const std::string &content, uint32_t numberOfPieces, std::vector<uint8_t> *target);
+
+// Internal methods
+private:
+  static bool HasPiece (const std::vector<uint8_t> &bitfield, uint32_t pieceIndex)
+  {
+    return bitfield[pieceIndex / 8] & (0x01 << (7 - pieceIndex % 8));
+  }
+
+  // Append a LEB128-encoded number
+  static void AppendVarInt (std::string &content, uint32_t value);
+
+  // Set all bits of the given piece range
+  static void SetPieces (std::vector<uint8_t> *target, uint32_t from, uint32_t count);
+};
+
 } // ns pushpull
 } // ns ns3
 
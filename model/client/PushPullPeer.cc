@@ -27,6 +27,7 @@
 #include "PushPullClient.h"
 #include "PushPullPacket.h"
 #include "StorageManager.h"
+#include "ns3/WallclockProfiler.h"
 
 #include "ns3/inet-socket-address.h"
 #include "ns3/log.h"
@@ -37,11 +38,61 @@
 #include <cstring> // for memcpy
 #include <limits>
 #include <list>
+#include <set>
 #include <vector>
 
 namespace ns3 {
 namespace pushpull {
 
+// Helpers for the 32-bit fields of availability window messages (network byte order)
+static void AppendU32 (std::string &content, uint32_t value)
+{
+  content.push_back (static_cast<char> ((value >> 24) & 0xFF));
+  content.push_back (static_cast<char> ((value >> 16) & 0xFF));
+  content.push_back (static_cast<char> ((value >> 8) & 0xFF));
+  content.push_back (static_cast<char> (value & 0xFF));
+}
+
+static uint32_t ReadU32 (const std::string &content, uint32_t position)
+{
+  return (static_cast<uint32_t> (static_cast<uint8_t> (content[position])) << 24)
+         | (static_cast<uint32_t> (static_cast<uint8_t> (content[position + 1])) << 16)
+         | (static_cast<uint32_t> (static_cast<uint8_t> (content[position + 2])) << 8)
+         | static_cast<uint32_t> (static_cast<uint8_t> (content[position + 3]));
+}
+
+// Derive the allowed fast set of a peer from its address and the info hash, so that it stays the same across reconnections and for all peers
+// of the same /24 network (see BEP 6). BEP 6 chains SHA-1 hashes; since only the determinism matters within the simulation, a cheaper hash is used.
+static void GenerateAllowedFastSet (Ipv4Address address, const uint8_t *infoHash, uint32_t numberOfPieces, uint32_t setSize, std::set<uint32_t> &allowedFast)
+{
+  // Step 1: Seed the chain with an FNV-1a hash of the masked address and the info hash
+  uint32_t x = 2166136261u;
+  uint32_t maskedAddress = address.Get () & 0xFFFFFF00;
+  for (int8_t i = 3; i >= 0; --i)
+    {
+      x = (x ^ ((maskedAddress >> (8 * i)) & 0xFF)) * 16777619u;
+    }
+  for (uint8_t i = 0; i < 20; ++i)
+    {
+      x = (x ^ infoHash[i]) * 16777619u;
+    }
+  if (x == 0)
+    {
+      x = 1;
+    }
+
+  // Step 2: Draw pieces from the chain (xorshift) until the set is complete
+  allowedFast.clear ();
+  setSize = std::min (setSize, numberOfPieces);
+  while (allowedFast.size () < setSize)
+    {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      allowedFast.insert (x % numberOfPieces);
+    }
+}
+
 NS_LOG_COMPONENT_DEFINE ("pushpull::Peer");
 NS_OBJECT_ENSURE_REGISTERED (Peer);
 
@@ -54,6 +105,14 @@ Peer::Peer (Ptr<PushPullClient> myClient)
   m_connectionState = CONN_STATE_NOT_CONNECTED;
   m_peerChoking = true;
   m_peerInterested = false;
+  m_remoteSupportsCompressedBitfield = false;
+  m_announcedSessionResume = false;
+  m_sessionResumed = false;
+  m_remoteSupportsAvailabilityWindow = false;
+  m_remoteSupportsFastExtension = false;
+  m_advertisingWindow = false;
+  m_advertisedWindowStart = 0;
+  m_advertisedWindowLength = 0;
   m_amChoking = true;
   m_amInterested = false;
 
@@ -67,6 +126,10 @@ Peer::Peer (Ptr<PushPullClient> myClient)
     {
       m_bitfield[i] = 0;
     }
+  m_bitfieldReceived = false;
+  m_bitfieldOffset = 0;
+  m_firstMissingByte = 0;
+  m_remoteWindowed = false;
 
   m_pieceCorruptionMap = new uint8_t [m_myClient->GetTorrent ()->GetNumberOfPieces ()];
   for (uint32_t i = 0; i < m_myClient->GetTorrent ()->GetNumberOfPieces (); i++)
@@ -76,16 +139,15 @@ Peer::Peer (Ptr<PushPullClient> myClient)
   // <-- Current status of the connection
 
   // Packet reception members and corresponding state machine attributes
-  m_packetBuffer = Create<Packet> ();
-  m_lengthHeader.SetPacketLength (BT_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH);
-  m_lengthHeaderRemoved = false;
-  m_blockBuffer = 0;
-  m_blockBufferSize = 0;
+  m_receiveBuffer.Reserve (PP_PEER_RECEIVE_BUFFER_INITIAL_SIZE);
 
   // Packet transmission members and corresponding state machine attributes
   m_blockSendBuffer = 0;
   m_blockSendDataLeft = 0;
   m_blockSendingActive = false;
+  m_currentRequest.pieceIndex = 0;
+  m_currentRequest.blockOffSet = 0;
+  m_currentRequest.blockLength = 0;
 
   // Statistics
   m_connectionEstablishmentTime = MilliSeconds (0) - MilliSeconds (1);     // Simulator::Now()
@@ -99,7 +161,6 @@ Peer::Peer (Ptr<PushPullClient> myClient)
 
 Peer::~Peer ()
 {
-  delete[] m_blockBuffer;
   delete[] m_blockSendBuffer;
   delete[] m_pieceCorruptionMap;
 }
@@ -168,6 +229,10 @@ void Peer::ServeNewPeer (Ptr<Socket> socket, Ipv4Address address, uint16_t port)
   std::memcpy (peerId,m_myClient->GetPeerId ().c_str (), std::min (static_cast<size_t> (BT_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX), m_myClient->GetPeerId ().size ()));
   handshake.SetPeerId (peerId);
   handshake.SetInfoHash (m_myClient->GetCurrentInfoHash ());
+  handshake.SetCompressedBitfieldSupport (m_myClient->GetCompressedBitfield ());
+  handshake.SetAvailabilityWindowSupport (true);
+  handshake.SetFastExtensionSupport (true);
+  AnnounceSessionResume (handshake);
     
   Ptr<Packet> announcementPacket = Create<Packet> ();
   announcementPacket->AddHeader (handshake);
@@ -176,7 +241,6 @@ void Peer::ServeNewPeer (Ptr<Socket> socket, Ipv4Address address, uint16_t port)
 
   // Step 4: Add the announcement message to the send queue
   m_sendQueue.push_back (announcementPacket);
-  m_sendQueuePieceMessageIndicators.push_back (false);
 
   // Step 5: Send out the announcement by processing the send queue
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
@@ -186,6 +250,11 @@ void Peer::CloseConnection (bool silent)
 {
   NS_LOG_INFO ("Peer: Closing connection with " << GetRemoteIp () << " silent: " << silent);
 
+  if (!silent)
+    {
+      StoreSession ();
+    }
+
   m_connectionState = CONN_STATE_CLOSED;
 
   m_amChoking = true;
@@ -221,30 +290,17 @@ void Peer::RequestPiece (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t blo
       return;
     }
 
-  // Step 1: Create a packet
-  Ptr<Packet> packet = Create<Packet> ();
-
-  // Step 2: Create a PushPullLengthHeader so we can read out the length of the message properly again at the remote Peer
-  PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_REQUEST_LENGTH);
+  // Step 1: Encode the message specific to this call (in this case, a REQUEST message), including its length prefix and type
+  PushPullMessageBatch batch;
+  batch.AddRequest (pieceIndex, blockOffSet, blockLength);
 
-  // Step 3: Create a PushPullTypeHeader so we can read out the type of the message properly again at the remote Peer
-  PushPullTypeHeader typeHead (PushPullTypeHeader::REQUEST);
-
-  // Step 4: Create the message specific to this call (in this case, a REQUEST message)
-  PushPullRequestMessage reqMsg (pieceIndex,blockOffSet,blockLength);
-
-  // Step 5: Combine the headers from steps 2..4 by adding them to the created packet
-  packet->AddHeader (reqMsg);
-  packet->AddHeader (typeHead);
-  packet->AddHeader (lenHead);
+  // Steps 2-5: Create a packet containing the encoded message with a single allocation
+  Ptr<Packet> packet = batch.ToPacket ();
 
-  // Step 6: Enqueue the packet
-  // Step 6a: Insert it into the send queue
-  m_sendQueue.push_back (packet);
-  // Step 6b: Indicate that this message is NOT a PIECE message (which is handled differently)
-  m_sendQueuePieceMessageIndicators.push_back (false);
+  // Step 6: Enqueue the packet as a control message, so it does not wait for queued PIECE messages
+  EnqueueControlMessage (packet, false);
 
-  NS_LOG_INFO ("Peer: Enqueueing request to " << GetRemoteIp () << " for " << reqMsg.GetPieceIndex () << "@" << reqMsg.GetBlockOffset () << "->" << reqMsg.GetBlockOffset () + reqMsg.GetBlockLength () << ".");
+  NS_LOG_INFO ("Peer: Enqueueing request to " << GetRemoteIp () << " for " << pieceIndex << "@" << blockOffSet << "->" << blockOffSet + blockLength << ".");
 
   // Step 7: Send out messages in the send queue
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
@@ -257,42 +313,25 @@ void Peer::CancelRequest (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t bl
       return;
     }
 
-  Ptr<Packet> packet = Create<Packet> ();
-
-  PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_CANCEL_LENGTH);
-  PushPullTypeHeader typeHead(PushPullTypeHeader::CANCEL);
-  PushPullCancelMessage canMsg (pieceIndex, blockOffSet, blockLength);
+  PushPullMessageBatch batch;
+  batch.AddCancel (pieceIndex, blockOffSet, blockLength);
+  Ptr<Packet> packet = batch.ToPacket ();
 
-  packet->AddHeader (canMsg);
-  packet->AddHeader (typeHead);
-  packet->AddHeader (lenHead);
-
-  // Prioritized sending
-  if (m_blockSendingActive)      // Insert the cancel request right at the beginning but after the currently sending block
-    {
-      std::list<Ptr<Packet> >::iterator sendQueueIt = m_sendQueue.begin ();
-      std::list<bool>::iterator sendQueuePieceMessageIndicatorsIt = m_sendQueuePieceMessageIndicators.begin ();
+  // Prioritized sending: Insert the cancel request right at the beginning (the currently sending block, if any, is not part of the queue)
+  EnqueueControlMessage (packet, true);
 
-      ++sendQueueIt;
-      ++sendQueuePieceMessageIndicatorsIt;
+  HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
+}
 
-      if (sendQueueIt == m_sendQueue.end ())
-        {
-          m_sendQueue.push_back (packet);
-          m_sendQueuePieceMessageIndicators.push_back (false);
-        }
-      else
-        {
-          m_sendQueue.insert (sendQueueIt, packet);
-          m_sendQueuePieceMessageIndicators.insert (sendQueuePieceMessageIndicatorsIt, false);
-        }
-    }
-  else
+void Peer::SendMessageBatch (const PushPullMessageBatch &batch)
+{
+  if (m_connectionState != CONN_STATE_CONNECTED || batch.GetMessageCount () == 0)
     {
-      m_sendQueue.push_front (packet);
-      m_sendQueuePieceMessageIndicators.push_front (false);
+      return;
     }
 
+  EnqueueControlMessage (batch.ToPacket (), false);
+
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
 
@@ -303,19 +342,92 @@ void Peer::SendBitfield ()
       return;
     }
 
+  SendBitfieldMessage ();
+
+  // With the Fast Extension, the allowed fast set of the remote peer follows the bitfield
+  if (m_remoteSupportsFastExtension)
+    {
+      SendAllowedFastSet ();
+    }
+}
+
+void Peer::SendBitfieldMessage ()
+{
+  // In superseeding mode, we pose as a peer without any pieces; the strategy reveals pieces one by one via HAVE messages
+  bool superSeeding = m_myClient->GetSuperSeeding ();
+  const std::vector<uint8_t>* bitfield = m_myClient->GetBitfield ();
+  uint32_t piecesCompleted = m_myClient->GetPiecesCompleted ();
+  std::vector<uint8_t> noPieces;
+  if (superSeeding)
+    {
+      noPieces.resize (m_myClient->GetTorrent ()->GetBitfieldSize (), 0);
+      bitfield = &noPieces;
+      piecesCompleted = 0;
+    }
+
+  // If both sides support it, only the availability window of the client is advertised
+  if (!superSeeding && m_myClient->GetAvailabilityWindow () > 0 && m_remoteSupportsAvailabilityWindow)
+    {
+      m_advertisingWindow = true;
+      m_advertisedWindowLength = m_myClient->GetAvailabilityWindow ();
+      SendAvailabilityWindow ();
+      return;
+    }
+
+  // From here on, the whole bitfield is announced (in whatever form), which a later session resume builds upon
+  if (m_myClient->GetPeerSessionCacheSize () > 0)
+    {
+      m_announcedBitfield = *bitfield;
+    }
+
+  // With the Fast Extension, the trivial bitfields of seeders and new peers are replaced by HAVE_ALL and HAVE_NONE messages
+  if (m_remoteSupportsFastExtension && (piecesCompleted == 0 || piecesCompleted == m_myClient->GetTorrent ()->GetNumberOfPieces ()))
+    {
+      std::vector<uint8_t> ().swap (m_resumedSession.m_announcedBitfield);
+
+      PushPullMessageBatch batch;
+      batch.AddHaveAll (piecesCompleted > 0);
+      EnqueueControlMessage (batch.ToPacket (), false);
+
+      HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
+      return;
+    }
+
+  // When resuming a session, only the pieces gained since the disconnection are sent, unless we lost pieces in between
+  if (m_sessionResumed && !superSeeding)
+    {
+      std::string delta;
+      bool deltaPossible = PushPullCompressedBitfield::EncodeDelta (m_resumedSession.m_announcedBitfield, *bitfield,
+                                                                    m_myClient->GetTorrent ()->GetNumberOfPieces (), delta);
+      std::vector<uint8_t> ().swap (m_resumedSession.m_announcedBitfield);
+
+      if (deltaPossible)
+        {
+          SendExtendedMessage (PP_PROTOCOL_EXTENSION_MESSAGE_ID_BITFIELD_DELTA, delta);
+          return;
+        }
+    }
+
+  // If both sides support it, the bitfield is sent in compressed form via the Extension Protocol
+  if (m_myClient->GetCompressedBitfield () && m_remoteSupportsCompressedBitfield)
+    {
+      SendExtendedMessage (PP_PROTOCOL_EXTENSION_MESSAGE_ID_COMPRESSED_BITFIELD,
+                           PushPullCompressedBitfield::Encode (*bitfield, m_myClient->GetTorrent ()->GetNumberOfPieces ()));
+      return;
+    }
+
   Ptr<Packet> packet = Create<Packet> ();
 
   PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_BITFIELD_LENGTH_MIN + m_myClient->GetTorrent ()->GetBitfieldSize ());
   PushPullTypeHeader typeHead (PushPullTypeHeader::BITFIELD);
   PushPullBitfieldMessage bitFMsg (m_myClient->GetTorrent ()->GetBitfieldSize ());
-  bitFMsg.CopyBitFieldFrom (m_myClient->GetBitfield ());
+  bitFMsg.CopyBitFieldFrom (bitfield);
 
   packet->AddHeader (bitFMsg);
   packet->AddHeader (typeHead);
   packet->AddHeader (lenHead);
 
-  m_sendQueue.push_back (packet);
-  m_sendQueuePieceMessageIndicators.push_back (false);
+  EnqueueControlMessage (packet, false);
 
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
@@ -327,42 +439,29 @@ void Peer::SendHaveMessage (uint32_t pieceIndex)
       return;
     }
 
-  Ptr<Packet> packet = Create<Packet> ();
-
-  PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_HAVE_LENGTH);
-  PushPullTypeHeader typeHead (PushPullTypeHeader::HAVE);
-  PushPullHaveMessage haveMsg (pieceIndex);
-
-  packet->AddHeader (haveMsg);
-  packet->AddHeader (typeHead);
-  packet->AddHeader (lenHead);
-
-  // Prioritized sending
-  if (m_blockSendingActive)      // Insert the have message right at the beginning but after the currently sending block
+  // Pieces outside of the advertised availability window are announced once the window reaches them
+  if (m_advertisingWindow && (pieceIndex < m_advertisedWindowStart || pieceIndex >= m_advertisedWindowStart + m_advertisedWindowLength))
     {
-      std::list<Ptr<Packet> >::iterator sendQueueIt = m_sendQueue.begin ();
-      std::list<bool>::iterator sendQueuePieceMessageIndicatorsIt = m_sendQueuePieceMessageIndicators.begin ();
+      return;
+    }
 
-      ++sendQueueIt;
-      ++sendQueuePieceMessageIndicatorsIt;
+  PushPullMessageBatch batch;
+  batch.AddHave (pieceIndex);
+  Ptr<Packet> packet = batch.ToPacket ();
 
-      if (sendQueueIt == m_sendQueue.end ())
-        {
-          m_sendQueue.push_back (packet);
-          m_sendQueuePieceMessageIndicators.push_back (false);
-        }
-      else
-        {
-          m_sendQueue.insert (sendQueueIt, packet);
-          m_sendQueuePieceMessageIndicators.insert (sendQueuePieceMessageIndicatorsIt, false);
-        }
-    }
-  else
+  // The piece only counts as announced once the message has been handed to the socket (see HandleSend)
+  if (pieceIndex / 8 < m_announcedBitfield.size ())
     {
-      m_sendQueue.push_front (packet);
-      m_sendQueuePieceMessageIndicators.push_front (false);
+      m_queuedHaveMessages[packet] = pieceIndex;
     }
 
+  /*
+   * Prioritized sending: Insert the have message right at the beginning (the currently sending block, if any, is not part of the queue).
+   * While advertising a window, the have message must not overtake queued window messages, though, since the remote peer drops
+   * have messages for pieces outside of the window it knows of. So it is queued behind them.
+   */
+  EnqueueControlMessage (packet, !m_advertisingWindow);
+
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
 
@@ -375,23 +474,56 @@ void Peer::SetAmChoking (bool amChoking)
     }
 }
 
-void Peer::SendBlock (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t blockLength)
+void Peer::SendBlock (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t blockLength, SendClass sendClass)
 {
   RequestInformation reqInfo;
   reqInfo.pieceIndex = pieceIndex;
   reqInfo.blockOffSet = blockOffSet;
   reqInfo.blockLength = std::min (m_myClient->GetTorrent ()->GetPieceLength () - blockOffSet, blockLength);
 
-  Ptr<Packet> dummyPacket = Create<Packet> ();
-
-  m_sendQueue.push_back (dummyPacket);
-  m_sendQueuePieceMessageIndicators.push_back (true);
-  m_requestQueue.push_back (reqInfo);
+  if (sendClass == SEND_CLASS_URGENT_DATA)
+    {
+      m_urgentRequestQueue.push_back (reqInfo);
+    }
+  else
+    {
+      m_bulkRequestQueue.push_back (reqInfo);
+    }
 
   // Blocks (PIECE messages) are handled separately by HandleSend, just call it
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
 
+void Peer::RejectRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  if (m_connectionState != CONN_STATE_CONNECTED || !m_remoteSupportsFastExtension)
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("Peer: Rejecting request of " << GetRemoteIp () << " for " << pieceIndex << "@" << blockOffset << "->" << blockOffset + blockLength << ".");
+
+  PushPullMessageBatch batch;
+  batch.AddRejectRequest (pieceIndex, blockOffset, blockLength);
+  EnqueueControlMessage (batch.ToPacket (), false);
+
+  HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
+}
+
+void Peer::SuggestPiece (uint32_t pieceIndex)
+{
+  if (m_connectionState != CONN_STATE_CONNECTED || !m_remoteSupportsFastExtension)
+    {
+      return;
+    }
+
+  PushPullMessageBatch batch;
+  batch.AddSuggestPiece (pieceIndex);
+  EnqueueControlMessage (batch.ToPacket (), false);
+
+  HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
+}
+
 void Peer::SendExtendedMessage (uint8_t messageId, const std::string& message)
 {
   if (m_connectionState != CONN_STATE_CONNECTED)
@@ -409,8 +541,7 @@ void Peer::SendExtendedMessage (uint8_t messageId, const std::string& message)
   packet->AddHeader (typeHead);
   packet->AddHeader (lenHead);
 
-  m_sendQueue.push_back (packet);
-  m_sendQueuePieceMessageIndicators.push_back (false);
+  EnqueueControlMessage (packet, false);
 
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
@@ -430,6 +561,51 @@ std::string Peer::GetRemotePeerId () const
   return m_remotePeerId;
 }
 
+uint32_t Peer::GetFirstMissingPiece () const
+{
+  // HAVE messages only ever set bits, so the search resumes at the first byte that was not complete the last time
+  for (uint32_t i = m_firstMissingByte; i < m_bitfield.size (); ++i)
+    {
+      if (m_bitfield[i] != 0xFF)
+        {
+          m_firstMissingByte = i;
+          uint8_t bit = 0;
+          while ((m_bitfield[i] & (1 << (7 - bit))) != 0)
+            {
+              ++bit;
+            }
+          return m_bitfieldOffset + i * 8 + bit;
+        }
+    }
+
+  m_firstMissingByte = m_bitfield.size ();
+  return m_bitfieldOffset + m_bitfield.size () * 8;
+}
+
+uint32_t Peer::GetSendBacklog () const
+{
+  if (m_connectionState != CONN_STATE_CONNECTED)
+    {
+      return 0;
+    }
+
+  uint32_t backlog = PP_PEER_SOCKET_TRANSMIT_BUFFER_SIZE - std::min (static_cast<uint32_t> (PP_PEER_SOCKET_TRANSMIT_BUFFER_SIZE), m_peerSocket->GetTxAvailable ());
+  if (m_blockSendingActive)
+    {
+      backlog += m_blockSendDataLeft;
+    }
+  for (std::list<RequestInformation>::const_iterator it = m_urgentRequestQueue.begin (); it != m_urgentRequestQueue.end (); ++it)
+    {
+      backlog += (*it).blockLength;
+    }
+  for (std::list<RequestInformation>::const_iterator it = m_bulkRequestQueue.begin (); it != m_bulkRequestQueue.end (); ++it)
+    {
+      backlog += (*it).blockLength;
+    }
+
+  return backlog;
+}
+
 bool Peer::IsChoking () const
 {
   return m_peerChoking;
@@ -462,40 +638,28 @@ uint64_t Peer::GetTotalBytesUploaded () const
 
 double Peer::GetBpsDownload ()
 {
-  uint64_t currentSecond = static_cast<uint64_t> (Simulator::Now ().GetSeconds ());
-
-  double bpsDownload = 0;
-  for (uint32_t i = 0; i < BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS; ++i)
-    {
-      if (currentSecond - m_downloadHistoryReSetTime[i] > BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS)
-        {
-          m_downloadHistory[i] = 0;
-          m_downloadHistoryReSetTime[i] = currentSecond;
-        }
-
-      bpsDownload += m_downloadHistory[i];
-    }
+  return m_downloadRate.GetBps (Simulator::Now ());
+}
 
-  return (bpsDownload * 8) / BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS;
+double Peer::GetEwmaBpsDownload ()
+{
+  return m_downloadRate.GetEwmaBps (Simulator::Now ());
 }
 
 double Peer::GetBpsUpload ()
 {
-  uint64_t currentSecond = static_cast<uint64_t> (Simulator::Now ().GetSeconds ());
-
-  double bpsUpload = 0;
-  for (uint32_t i = 0; i < BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS; ++i)
-    {
-      if (currentSecond - m_uploadHistoryReSetTime[i] > BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS)
-        {
-          m_uploadHistory[i] = 0;
-          m_uploadHistoryReSetTime[i] = currentSecond;
-        }
+  return m_uploadRate.GetBps (Simulator::Now ());
+}
 
-      bpsUpload += m_uploadHistory[i];
-    }
+double Peer::GetEwmaBpsUpload ()
+{
+  return m_uploadRate.GetEwmaBps (Simulator::Now ());
+}
 
-  return (bpsUpload * 8) / BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS;
+void Peer::SetRateEstimation (Time window, Time resolution, Time ewmaHalfLife)
+{
+  m_downloadRate.Configure (window, resolution, ewmaHalfLife);
+  m_uploadRate.Configure (window, resolution, ewmaHalfLife);
 }
 
 void Peer::NotifyPeerOfChokeChange ()
@@ -505,20 +669,51 @@ void Peer::NotifyPeerOfChokeChange ()
       return;
     }
 
-  Ptr<Packet> packet = Create<Packet> ();
+  PushPullMessageBatch batch;
+  batch.AddChoke (m_amChoking);
 
-  PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_CHOKE_LENGTH);
-  PushPullTypeHeader typeHead (PushPullTypeHeader::CHOKE);
-  if (!m_amChoking)
+  // With the Fast Extension, choking does not discard the requests of the remote peer implicitly; those not allowed fast are rejected explicitly
+  if (m_amChoking && m_remoteSupportsFastExtension)
     {
-      typeHead.SetMessageType (PushPullTypeHeader::UNCHOKE);
+      std::list<RequestInformation>* requestQueues[2] = { &m_urgentRequestQueue, &m_bulkRequestQueue };
+      for (uint8_t i = 0; i < 2; ++i)
+        {
+          std::list<RequestInformation>::iterator it = requestQueues[i]->begin ();
+          while (it != requestQueues[i]->end ())
+            {
+              if (GetAmAllowingFast ((*it).pieceIndex))
+                {
+                  ++it;
+                  continue;
+                }
+
+              batch.AddRejectRequest ((*it).pieceIndex, (*it).blockOffSet, (*it).blockLength);
+              it = requestQueues[i]->erase (it);
+            }
+        }
     }
 
-  packet->AddHeader (typeHead);
-  packet->AddHeader (lenHead);
+  /*
+   * Without the Fast Extension, the remote peer discards its outstanding requests when it is choked, so PIECE messages arriving after the
+   * CHOKE would be unexpected. The CHOKE is therefore held back until the blocks queued before it have been sent (see HandleSend).
+   * An UNCHOKE following a CHOKE that was never sent cancels both.
+   */
+  if (!m_remoteSupportsFastExtension)
+    {
+      if (m_amChoking && (m_blockSendingActive || !m_urgentRequestQueue.empty () || !m_bulkRequestQueue.empty ()))
+        {
+          m_deferredChoke = batch.ToPacket ();
+          HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
+          return;
+        }
+      if (!m_amChoking && m_deferredChoke)
+        {
+          m_deferredChoke = 0;
+          return;
+        }
+    }
 
-  m_sendQueue.push_back (packet);
-  m_sendQueuePieceMessageIndicators.push_back (false);
+  EnqueueControlMessage (batch.ToPacket (), false);
 
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
@@ -530,338 +725,468 @@ void Peer::NotifyPeerOfInterestedChange ()
       return;
     }
 
-  Ptr<Packet> packet = Create<Packet> ();
+  PushPullMessageBatch batch;
+  batch.AddInterested (m_amInterested);
 
-  PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_INTERESTED_LENGTH);
-  PushPullTypeHeader typeHead (PushPullTypeHeader::INTERESTED);
-  if (!m_amInterested)
-    {
-      typeHead.SetMessageType (PushPullTypeHeader::NOT_INTERESTED);
-    }
-
-  packet->AddHeader (typeHead);
-  packet->AddHeader (lenHead);
-
-  m_sendQueue.push_back (packet);
-  m_sendQueuePieceMessageIndicators.push_back (false);
+  EnqueueControlMessage (batch.ToPacket (), false);
 
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
 
-void Peer::HandleCancel (Ptr<Packet> packet)
+void Peer::HandleCancel (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
 {
-  PushPullCancelMessage cancelMsg;
-  packet->RemoveHeader (cancelMsg);
-
   RequestInformation reqInfo;
-  reqInfo.pieceIndex = cancelMsg.GetPieceIndex ();
-  reqInfo.blockOffSet = cancelMsg.GetBlockOffset ();
-  reqInfo.blockLength = cancelMsg.GetBlockLength ();
-
-  std::list<bool>::iterator it = m_sendQueuePieceMessageIndicators.begin ();
-  std::list<Ptr<Packet> >::iterator it2 = m_sendQueue.begin ();
-  std::list<RequestInformation>::iterator it3 = m_requestQueue.begin ();
-
-  bool requestFound = false;
+  reqInfo.pieceIndex = pieceIndex;
+  reqInfo.blockOffSet = blockOffset;
+  reqInfo.blockLength = blockLength;
 
-  if (m_blockSendingActive && (*it3) == reqInfo)
+  if (m_blockSendingActive && m_currentRequest == reqInfo)
     {
-      // We don't cancel the first request while it is active
+      // We don't cancel the request while it is active
       return;
     }
 
-  while (!requestFound && it != m_sendQueuePieceMessageIndicators.end () && it3 != m_requestQueue.end ())
+  // Look for the request in the queues of both data classes
+  bool requestFound = false;
+  std::list<RequestInformation>* requestQueues[2] = { &m_urgentRequestQueue, &m_bulkRequestQueue };
+  for (uint8_t i = 0; i < 2 && !requestFound; ++i)
     {
-      if (*it)          // If we have found a scheduled PIECE message
+      std::list<RequestInformation>::iterator it = requestQueues[i]->begin ();
+      for (; it != requestQueues[i]->end (); ++it)
         {
-          if ((*it3) == reqInfo)              // If the information on that PIECE message matches CANCEL message...
+          if ((*it) == reqInfo)
             {
+              requestQueues[i]->erase (it);
               requestFound = true;
               break;
             }
-          else               // ... else, we know that this PIECE message is not what we have to cancel. We go on to the next one.
-            {
-              ++it3;
-            }
         }
-
-      NS_ASSERT (!requestFound);
-
-      ++it;           // Next packet type indicator
-      ++it2;           // Next packet
     }
 
+  // With the Fast Extension, each cancelled request is answered, either by its PIECE message or by a rejection
   if (requestFound)
     {
-      m_sendQueuePieceMessageIndicators.erase (it);
-      m_sendQueue.erase (it2);
-      m_requestQueue.erase (it3);
-
-      m_myClient->PeerCancelEvent (this, reqInfo.pieceIndex, reqInfo.blockOffSet, reqInfo.blockLength);
+      RejectRequest (pieceIndex, blockOffset, blockLength);
     }
   else
     {
-      NS_LOG_INFO ("Peer: Received CANCEL for non-existing prior REQUEST: " << cancelMsg.GetPieceIndex () << "@" << cancelMsg.GetBlockOffset () << "->" << cancelMsg.GetBlockOffset () + cancelMsg.GetBlockLength () << ".");
+      NS_LOG_INFO ("Peer: Received CANCEL for a REQUEST not queued for sending: " << pieceIndex << "@" << blockOffset << "->" << blockOffset + blockLength << ".");
     }
+
+  // Strategies holding back requests (e.g., for upload scheduling) are informed in any case
+  m_myClient->PeerCancelEvent (this, reqInfo.pieceIndex, reqInfo.blockOffSet, reqInfo.blockLength);
 }
 
-bool Peer::HandlePiece (Ptr<Packet> packet, uint32_t packetLength)
+void Peer::HandlePiece (uint32_t messageLength)
 {
-  PushPullPieceMessage pieceMsg;
-  packet->RemoveHeader (pieceMsg);
+  // The payload follows the length prefix, the type and the piece index and offset fields
+  const uint32_t payloadOffset = PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + PP_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN;
 
-  uint32_t blockLength = packetLength - BT_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN;
-  uint32_t blockPieceIndex = pieceMsg.GetIndex ();
-  uint32_t blockBlockOffSet = pieceMsg.GetBegin ();
+  uint32_t blockLength = messageLength - PP_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN;
+  uint32_t blockPieceIndex = m_receiveBuffer.PeekNtohU32 (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + 1);
+  uint32_t blockBlockOffSet = m_receiveBuffer.PeekNtohU32 (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + 5);
 
-  if (m_blockBufferSize < blockLength)
+  // Blocks outside of the torrent are skipped, as they would be compared against (and reported for) data that does not exist
+  Ptr<Torrent> torrent = m_myClient->GetTorrent ();
+  if (blockPieceIndex >= torrent->GetNumberOfPieces ())
     {
-      delete [] m_blockBuffer;
-      m_blockBuffer = 0;
-      m_blockBuffer = new uint8_t[blockLength];
-      m_blockBufferSize = blockLength;
+      NS_LOG_INFO ("Peer: Received a PIECE message for a non-existing piece from " << GetRemoteIp () << ".");
+      return;
     }
 
-  uint32_t dataToRead = std::min (packet->GetSize (),blockLength);
-  m_totalBytesDownloaded += dataToRead;
+  uint32_t pieceLength = (torrent->HasTrailingPiece () && blockPieceIndex == torrent->GetNumberOfPieces () - 1) ? torrent->GetTrailingPieceLength () : torrent->GetPieceLength ();
+  if (static_cast<uint64_t> (blockBlockOffSet) + blockLength > pieceLength)
+    {
+      NS_LOG_INFO ("Peer: Received a PIECE message with a block beyond the end of piece " << blockPieceIndex << " from " << GetRemoteIp () << ".");
+      return;
+    }
 
-  packet->CopyData (m_blockBuffer, dataToRead);
-  packet->RemoveAtStart (dataToRead);
+  m_totalBytesDownloaded += blockLength;
 
-  if (blockLength - dataToRead == 0)
+  if (m_myClient->GetCheckDownloadedData ())
     {
-      if (m_myClient->GetCheckDownloadedData ())
+      // The payload is compared in place, so it never has to be copied out of the receive buffer
+      if (m_receiveBuffer.Equals (
+            payloadOffset,
+            m_myClient->GetTorrentDataBuffer () + static_cast<uint64_t> (blockPieceIndex) * torrent->GetPieceLength () + blockBlockOffSet,
+            blockLength))
         {
-          if (std::memcmp (
-                m_blockBuffer,
-                m_myClient->GetTorrentDataBuffer () + blockPieceIndex * m_myClient->GetTorrent ()->GetPieceLength () + blockBlockOffSet,
-                blockLength)
-              == 0)
-            {
-              m_pieceCorruptionMap[blockPieceIndex] = BT_PEER_PIECE_RECEPTION_CHECKSUM_OK;
-            }
-          else
-            {
-              m_pieceCorruptionMap[blockPieceIndex] = BT_PEER_PIECE_RECEPTION_CHECKSUM_NOT_OK;
-            }
+          m_pieceCorruptionMap[blockPieceIndex] = BT_PEER_PIECE_RECEPTION_CHECKSUM_OK;
+        }
+      else
+        {
+          m_pieceCorruptionMap[blockPieceIndex] = BT_PEER_PIECE_RECEPTION_CHECKSUM_NOT_OK;
         }
-
-      // Call the BlockCompletedEvent for this block (even if it was not downloaded correctly, that case is also handled in the called method)
-      m_myClient->PeerBlockCompleteEvent (this,blockPieceIndex,blockBlockOffSet,blockLength);
-
-      return false;           // i.e., there is no more data left to receive
     }
 
-  return true;       // i.e., there is more data left to receive until the block can be finished
+  // Call the BlockCompletedEvent for this block (even if it was not downloaded correctly, that case is also handled in the called method)
+  m_myClient->PeerBlockCompleteEvent (this,blockPieceIndex,blockBlockOffSet,blockLength);
 }
 
 void Peer::HandleRead (Ptr<Socket> socket)
 {
+  PP_PROFILE_SCOPE (PEER_HANDLE_READ);
+
   if (!(m_connectionState == CONN_STATE_CONNECTED || m_connectionState == CONN_STATE_AWAIT_HANDSHAKE))
     {
       return;
     }
 
+  // Step 1: Receive all available data directly into the free space of the receive buffer
   uint32_t available = socket->GetRxAvailable ();
   while (available > 0)
     {
-      m_packetBuffer->AddAtEnd (socket->Recv ());
+      m_receiveBuffer.Reserve (available);
 
-      uint64_t currentSecond = static_cast<uint64_t> (Simulator::Now ().GetSeconds ());
-      uint64_t currentSecondModulo = currentSecond % BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS;
-      if (m_downloadHistoryReSetTime[currentSecondModulo] != currentSecond)
+      uint32_t spanLength = 0;
+      uint8_t* span = m_receiveBuffer.GetWriteSpan (spanLength);
+      int received = socket->Recv (span, std::min (spanLength, available), 0);
+      if (received <= 0)
         {
-          m_downloadHistoryReSetTime[currentSecondModulo] = currentSecond;
-          m_downloadHistory[currentSecondModulo] = available;
-        }
-      else
-        {
-          m_downloadHistory[currentSecondModulo] += available;
+          break;
         }
+      m_receiveBuffer.CommitWrite (received);
+
+      m_downloadRate.Add (Simulator::Now (), received);
 
       available = socket->GetRxAvailable ();
     }
 
-  while (m_packetBuffer->GetSize () >= m_lengthHeader.GetPacketLength ())
+  // Step 2: Decode and dispatch all completely received messages in place
+  const uint32_t payloadOffset = PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + 1;       // Position of the first byte after the length prefix and the type
+  while (m_connectionState == CONN_STATE_CONNECTED || m_connectionState == CONN_STATE_AWAIT_HANDSHAKE)
     {
       if (m_connectionState == CONN_STATE_AWAIT_HANDSHAKE)
         {
-          /*
-           * RENE: Add way to Get protocol length from the packet first
-           * down here -------------------+ (Just as with PushPullLengthHeader, but 1 byte instead of 4)
-           *                              |
-           *                              v
-           */
-          if (m_packetBuffer->GetSize () >= BT_PROTOCOL_MESSAGES_HANDSHAKE_LENGTH_MIN + BT_PROTOCOL_MESSAGES_HANDSHAKE_PROTOCOL_STRING_LENGTH)
-            {
-              PushPullHandshakeMessage handshake;
-              m_packetBuffer->RemoveHeader (handshake);
-
-              // Store data from packet
-              m_remotePeerId.append (reinterpret_cast<const char*> (handshake.GetPeerId ()),BT_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX);
-
-              m_connectionEstablishmentTime = Simulator::Now ();
-              m_connectionState = CONN_STATE_CONNECTED;
-
-              m_lengthHeader.SetPacketLength (BT_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH);
-            }
-          else
+          uint32_t handshakeLength = 0;
+          if (!m_receiveBuffer.HasCompleteHandshake (handshakeLength))
             {
               break;                   // We still wait for the completion of the handshake message
             }
-        }
-      else if (m_connectionState == CONN_STATE_CONNECTED)
-        {
-          if (!m_lengthHeaderRemoved)              // We have not yet inspected the beginning of the next message
-            {
-              NS_ASSERT (m_packetBuffer->GetSize () >= m_lengthHeader.GetPacketLength ());
-
-              m_packetBuffer->RemoveHeader (m_lengthHeader);
 
-              if (m_lengthHeader.GetPacketLength () == 0)                 // We received a keep-alive message
-                {
-                  m_lengthHeader.SetPacketLength (BT_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH);                      // So we will end up in this same else if(!m_lengthHeaderRemoved) section again
-                }
-              else
-                {
-                  // If we receive messages > BT_PROTOCOL_MESSAGES_LENGTHHEADER_THRESHOLD_PIECE_OR_EXTENSIONPROTOCOL_MESSAGE bytes, we assume they are piece messages and start estimating the upload bandwidth of the peer
-                  // Note: Since we do this all the time, it does not matter that a bitfield message might be sent; the time is just replaced
-                  m_lengthHeaderRemoved = true;
-                }
+          // Store data from the message; the peer id is the last field of the handshake
+          uint8_t peerId[PP_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX];
+          m_receiveBuffer.CopyTo (handshakeLength - PP_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX, peerId, PP_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX);
+          m_remotePeerId.append (reinterpret_cast<const char*> (peerId), PP_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX);
+
+          // The reserved space follows the length and the content of the protocol string
+          uint8_t reservedByte = m_receiveBuffer.PeekU8 (1 + m_receiveBuffer.PeekU8 (0) + PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_BYTE);
+          m_remoteSupportsCompressedBitfield = reservedByte & PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_MASK;
+          m_remoteSupportsAvailabilityWindow = reservedByte & PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_MASK;
+          m_remoteSupportsFastExtension = reservedByte & PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_MASK;
+
+          // If both sides hold a cached session, the bitfield of the remote peer and the rate estimations continue from where the previous connection ended
+          uint8_t sessionResumeByte = m_receiveBuffer.PeekU8 (1 + m_receiveBuffer.PeekU8 (0) + PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_BYTE);
+          if (m_announcedSessionResume && (sessionResumeByte & PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_MASK)
+              && m_resumedSession.m_remoteBitfield.size () == m_bitfield.size ())
+            {
+              m_sessionResumed = true;
+              m_bitfield.swap (m_resumedSession.m_remoteBitfield);
+              m_firstMissingByte = 0;
+              std::vector<uint8_t> ().swap (m_resumedSession.m_remoteBitfield);
+              m_downloadRate.Seed (Simulator::Now (), m_resumedSession.m_bpsDownload);
+              m_uploadRate.Seed (Simulator::Now (), m_resumedSession.m_bpsUpload);
             }
           else
             {
-              NS_ASSERT (m_packetBuffer->GetSize () >= m_lengthHeader.GetPacketLength ());
+              // The session taken from the cache upon announcing is outdated once this connection starts
+              std::vector<uint8_t> ().swap (m_resumedSession.m_remoteBitfield);
+              std::vector<uint8_t> ().swap (m_resumedSession.m_announcedBitfield);
+            }
 
-              m_packetBuffer->RemoveHeader (m_typeHeader);
+          m_receiveBuffer.Consume (handshakeLength);
 
-              switch (m_typeHeader.GetMessageType ())
-                {
-                case PushPullTypeHeader::CHOKE:
-                  {
-                    if (!m_peerChoking)
-                      {
-                        m_peerChoking = true;
-
-                        uint64_t currentSecond = static_cast<uint64_t> (Simulator::Now ().GetSeconds ());
-                        uint64_t currentSecondModulo = currentSecond % BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS;
-                        if (m_downloadHistoryReSetTime[currentSecondModulo] != currentSecond)
-                          {
-                            m_downloadHistoryReSetTime[currentSecondModulo] = currentSecond;
-                            m_downloadHistory[currentSecondModulo] = 0;
-                          }
-
-                        m_myClient->PeerChokeChangingEvent (this);
-                      }
-                    break;
-                  }
-                case PushPullTypeHeader::UNCHOKE:
-                  {
-                    if (m_peerChoking)
-                      {
-                        m_peerChoking = false;
-                        m_myClient->PeerChokeChangingEvent (this);
-                      }
-                    break;
-                  }
-                case PushPullTypeHeader::INTERESTED:
-                  {
-                    if (!m_peerInterested)
-                      {
-                        m_peerInterested = true;
-                        m_myClient->PeerInterestedChangingEvent (this);
-                      }
-                    break;
-                  }
-                case PushPullTypeHeader::NOT_INTERESTED:
-                  {
-                    if (m_peerInterested)
-                      {
-                        m_peerInterested = false;
-                        m_myClient->PeerInterestedChangingEvent (this);
-                      }
-                    break;
-                  }
-                case PushPullTypeHeader::HAVE:
-                  {
-                    PushPullHaveMessage haveMsg;
-                    m_packetBuffer->RemoveHeader (haveMsg);
+          m_connectionEstablishmentTime = Simulator::Now ();
+          m_connectionState = CONN_STATE_CONNECTED;
 
-                    uint32_t pieceIndex = haveMsg.GetPieceIndex ();
+          continue;
+        }
 
-                    m_bitfield[pieceIndex / 8] |= (1 << (7 - pieceIndex % 8));
+      uint32_t messageLength = 0;
+      if (!m_receiveBuffer.HasCompleteMessage (messageLength))
+        {
+          break;                       // We still wait for the completion of the next message
+        }
 
-                    m_myClient->PeerHaveEvent (this, pieceIndex);
-                    break;
-                  }
-                case PushPullTypeHeader::BITFIELD:
-                  {
-                    PushPullBitfieldMessage bitfieldMsg (m_lengthHeader.GetPacketLength () - 1);
-                    m_packetBuffer->PeekHeader (bitfieldMsg);
-                    if (m_lengthHeader.GetPacketLength () - 1 != m_myClient->GetTorrent ()->GetBitfieldSize ())
-                      {
-                        NS_LOG_INFO ("Peer: Received a bitfield of wrong length from " << GetRemoteIp () << ".");
-                        return;
-                      }
-					else
-					  {
-					    m_packetBuffer->RemoveHeader (bitfieldMsg);
-				      }
-                    bitfieldMsg.CopyBitFieldTo (&m_bitfield);
-
-                    m_myClient->PeerBitfieldReceivedEvent (this);
-                    break;
-                  }
-                case PushPullTypeHeader::REQUEST:
-                  {
-                    PushPullRequestMessage reqMsg;
-                    m_packetBuffer->RemoveHeader (reqMsg);
+      if (messageLength == 0)          // We received a keep-alive message
+        {
+          m_receiveBuffer.Consume (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH);
+          continue;
+        }
 
-                    m_myClient->PeerRequestEvent (this, reqMsg.GetPieceIndex (), reqMsg.GetBlockOffset (), reqMsg.GetBlockLength ());
-                    break;
-                  }
-                case PushPullTypeHeader::PIECE:
-                  {
-                    HandlePiece (m_packetBuffer, m_lengthHeader.GetPacketLength ());
-                    break;
-                  }
-                case PushPullTypeHeader::CANCEL:
+      switch (m_receiveBuffer.PeekU8 (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH))
+        {
+        case PushPullTypeHeader::CHOKE:
+          {
+            if (!m_peerChoking)
+              {
+                m_peerChoking = true;
+
+                m_myClient->PeerChokeChangingEvent (this);
+              }
+            break;
+          }
+        case PushPullTypeHeader::UNCHOKE:
+          {
+            if (m_peerChoking)
+              {
+                m_peerChoking = false;
+                m_myClient->PeerChokeChangingEvent (this);
+              }
+            break;
+          }
+        case PushPullTypeHeader::INTERESTED:
+          {
+            if (!m_peerInterested)
+              {
+                m_peerInterested = true;
+                m_myClient->PeerInterestedChangingEvent (this);
+              }
+            break;
+          }
+        case PushPullTypeHeader::NOT_INTERESTED:
+          {
+            if (m_peerInterested)
+              {
+                m_peerInterested = false;
+                m_myClient->PeerInterestedChangingEvent (this);
+              }
+            break;
+          }
+        case PushPullTypeHeader::HAVE:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_HAVE_LENGTH)
+              {
+                break;
+              }
+
+            uint32_t pieceIndex = m_receiveBuffer.PeekNtohU32 (payloadOffset);
+            if (pieceIndex < m_bitfieldOffset || (pieceIndex - m_bitfieldOffset) / 8 >= m_bitfield.size ())
+              {
+                NS_LOG_INFO ("Peer: Received a HAVE message for a non-existing or non-advertised piece from " << GetRemoteIp () << ".");
+                break;
+              }
+
+            m_bitfield[(pieceIndex - m_bitfieldOffset) / 8] |= (1 << (7 - pieceIndex % 8));
+
+            m_myClient->PeerHaveEvent (this, pieceIndex);
+            break;
+          }
+        case PushPullTypeHeader::BITFIELD:
+          {
+            if (messageLength - 1 != m_myClient->GetTorrent ()->GetBitfieldSize () || messageLength - 1 != m_bitfield.size ())
+              {
+                NS_LOG_INFO ("Peer: Received a bitfield of wrong length from " << GetRemoteIp () << ".");
+                break;
+              }
+
+            m_receiveBuffer.CopyTo (payloadOffset, &m_bitfield[0], messageLength - 1);
+            m_firstMissingByte = 0;
+            m_bitfieldReceived = true;
+
+            m_myClient->PeerBitfieldReceivedEvent (this);
+            break;
+          }
+        case PushPullTypeHeader::REQUEST:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_REQUEST_LENGTH)
+              {
+                break;
+              }
+
+            m_myClient->PeerRequestEvent (this, m_receiveBuffer.PeekNtohU32 (payloadOffset), m_receiveBuffer.PeekNtohU32 (payloadOffset + 4), m_receiveBuffer.PeekNtohU32 (payloadOffset + 8));
+            break;
+          }
+        case PushPullTypeHeader::PIECE:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN)
+              {
+                break;
+              }
+
+            HandlePiece (messageLength);
+            break;
+          }
+        case PushPullTypeHeader::CANCEL:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_CANCEL_LENGTH)
+              {
+                break;
+              }
+
+            HandleCancel (m_receiveBuffer.PeekNtohU32 (payloadOffset), m_receiveBuffer.PeekNtohU32 (payloadOffset + 4), m_receiveBuffer.PeekNtohU32 (payloadOffset + 8));
+            break;
+          }
+        case PushPullTypeHeader::PORT:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_PORT_LENGTH)
+              {
+                break;
+              }
+
+            // The port is sent as a 32-bit field by PushPullPortMessage; its lower 16 bits are the actual port
+            uint16_t listenPort = m_receiveBuffer.PeekNtohU16 (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + messageLength - 2);
+
+            m_myClient->PeerPortMessageEvent (this, listenPort);
+            break;
+          }
+        case PushPullTypeHeader::SUGGEST_PIECE:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_SUGGEST_PIECE_LENGTH || !m_remoteSupportsFastExtension)
+              {
+                break;
+              }
+
+            uint32_t pieceIndex = m_receiveBuffer.PeekNtohU32 (payloadOffset);
+            if (pieceIndex >= m_myClient->GetTorrent ()->GetNumberOfPieces ())
+              {
+                NS_LOG_INFO ("Peer: Received a SUGGEST_PIECE message for a non-existing piece from " << GetRemoteIp () << ".");
+                break;
+              }
+
+            m_suggestedPieces.insert (pieceIndex);
+
+            m_myClient->PeerSuggestPieceEvent (this, pieceIndex);
+            break;
+          }
+        case PushPullTypeHeader::HAVE_ALL:
+        case PushPullTypeHeader::HAVE_NONE:
+          {
+            if (!m_remoteSupportsFastExtension)
+              {
+                break;
+              }
+
+            // Both messages replace the bitfield; they are decoded like the corresponding compressed bitfields
+            bool haveAll = m_receiveBuffer.PeekU8 (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH) == PushPullTypeHeader::HAVE_ALL;
+            std::string content (1, static_cast<char> (haveAll ? PushPullCompressedBitfield::HAVE_ALL : PushPullCompressedBitfield::HAVE_NONE));
+            m_firstMissingByte = 0;
+            if (m_remoteWindowed || !PushPullCompressedBitfield::Decode (content, m_myClient->GetTorrent ()->GetNumberOfPieces (), &m_bitfield))
+              {
+                NS_LOG_INFO ("Peer: Received an unexpected HAVE_ALL or HAVE_NONE message from " << GetRemoteIp () << ".");
+                break;
+              }
+            m_bitfieldReceived = true;
+
+            m_myClient->PeerBitfieldReceivedEvent (this);
+            break;
+          }
+        case PushPullTypeHeader::REJECT_REQUEST:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_REJECT_REQUEST_LENGTH || !m_remoteSupportsFastExtension)
+              {
+                break;
+              }
+
+            m_myClient->PeerRejectRequestEvent (this, m_receiveBuffer.PeekNtohU32 (payloadOffset), m_receiveBuffer.PeekNtohU32 (payloadOffset + 4), m_receiveBuffer.PeekNtohU32 (payloadOffset + 8));
+            break;
+          }
+        case PushPullTypeHeader::ALLOWED_FAST:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_ALLOWED_FAST_LENGTH || !m_remoteSupportsFastExtension)
+              {
+                break;
+              }
+
+            uint32_t pieceIndex = m_receiveBuffer.PeekNtohU32 (payloadOffset);
+            if (pieceIndex >= m_myClient->GetTorrent ()->GetNumberOfPieces ())
+              {
+                NS_LOG_INFO ("Peer: Received an ALLOWED_FAST message for a non-existing piece from " << GetRemoteIp () << ".");
+                break;
+              }
+
+            m_allowedFastPieces.insert (pieceIndex);
+
+            m_myClient->PeerAllowedFastEvent (this, pieceIndex);
+            break;
+          }
+        case PushPullTypeHeader::EXTENDED:
+          {
+            if (messageLength < PP_PROTOCOL_MESSAGES_EXTENSIONPROTOCOL_LENGTH_MIN + 1)
+              {
+                break;
+              }
+
+            uint8_t messageId = m_receiveBuffer.PeekU8 (payloadOffset);
+            std::string content (messageLength - 2, '\0');
+            if (!content.empty ())
+              {
+                m_receiveBuffer.CopyTo (payloadOffset + 1, reinterpret_cast<uint8_t*> (&content[0]), content.size ());
+              }
+
+            // Compressed bitfields are handled like BITFIELD messages
+            if (messageId == PP_PROTOCOL_EXTENSION_MESSAGE_ID_COMPRESSED_BITFIELD)
+              {
+                m_firstMissingByte = 0;
+                if (!PushPullCompressedBitfield::Decode (content, m_myClient->GetTorrent ()->GetNumberOfPieces (), &m_bitfield))
                   {
-                    HandleCancel (m_packetBuffer);
+                    NS_LOG_INFO ("Peer: Received a malformed compressed bitfield from " << GetRemoteIp () << ".");
                     break;
                   }
-                case PushPullTypeHeader::PORT:
-                  {
-                    PushPullPortMessage portMsg;
-                    m_packetBuffer->RemoveHeader (portMsg);
+                m_bitfieldReceived = true;
 
-                    m_myClient->PeerPortMessageEvent (this, portMsg.GetListenPort ());
-                    break;
-                  }
-                case PushPullTypeHeader::EXTENDED:
-                  {
-                    PushPullExtensionMessage extMsg (m_lengthHeader.GetPacketLength () - 1);
-                    m_packetBuffer->RemoveHeader (extMsg);
+                m_myClient->PeerBitfieldReceivedEvent (this);
+                break;
+              }
 
-                    m_myClient->PeerExtensionMessageEvent (this, extMsg.GetMessageId (), extMsg.GetContent ());
+            // Bitfield deltas add the pieces gained since the disconnection to the bitfield restored from the session cache
+            if (messageId == PP_PROTOCOL_EXTENSION_MESSAGE_ID_BITFIELD_DELTA)
+              {
+                // Without a resumed session, there is no bitfield to apply the delta to; the remote peer violates the protocol
+                if (!m_sessionResumed || m_bitfieldReceived)
+                  {
+                    NS_LOG_INFO ("Peer: Received a bitfield delta without a resumed session from " << GetRemoteIp () << ". Closing connection.");
+                    CloseConnection (false);
                     break;
                   }
-                default:
+                m_firstMissingByte = 0;
+                if (!PushPullCompressedBitfield::DecodeDelta (content, m_myClient->GetTorrent ()->GetNumberOfPieces (), &m_bitfield))
                   {
-                    m_packetBuffer->RemoveAtStart (m_lengthHeader.GetPacketLength ());
+                    NS_LOG_INFO ("Peer: Received a malformed bitfield delta from " << GetRemoteIp () << ".");
                     break;
                   }
-                }                 // end of switch(m_typeHeader.GetMessageType())
-
-              m_lengthHeaderRemoved = false;                   // So we end up in the other branch of the if statement again
-              m_lengthHeader.SetPacketLength (BT_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH);                   // So we will stay in / enter this while loop if we have enough bytes in the buffer left
-            }
+                m_bitfieldReceived = true;
+
+                m_myClient->PeerBitfieldReceivedEvent (this);
+                break;
+              }
+
+            // Availability windows replace the bitfield of the remote peer
+            if (messageId == PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW)
+              {
+                HandleAvailabilityWindow (content);
+                break;
+              }
+            if (messageId == PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW_MOVE)
+              {
+                HandleAvailabilityWindowMove (content);
+                break;
+              }
+
+            m_myClient->PeerExtensionMessageEvent (this, messageId, content);
+            break;
+          }
+        default:
+          {
+            break;
+          }
+        }                 // end of switch(message type)
+
+      // The handlers of the client may have closed the connection, which also clears the receive buffer
+      if (m_connectionState != CONN_STATE_CONNECTED)
+        {
+          break;
         }
+
+      // The announced length always determines the end of the message, so malformed or unknown messages cannot desynchronize the stream
+      m_receiveBuffer.Consume (PP_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + messageLength);
     }
 }
 
 void Peer::HandleSend (Ptr<Socket> socket, uint32_t bytesFree)
 {
+  PP_PROFILE_SCOPE (PEER_HANDLE_SEND);
+
   // We use an indicator whether or not to start another recursive call to add further data
   bool nextIteration = true;
 
@@ -873,7 +1198,14 @@ void Peer::HandleSend (Ptr<Socket> socket, uint32_t bytesFree)
           return;
         }
 
-      if (m_sendQueue.empty ())
+      // A held back CHOKE is released as soon as the blocks queued before it have been sent
+      if (m_deferredChoke && !m_blockSendingActive && m_urgentRequestQueue.empty () && m_bulkRequestQueue.empty ())
+        {
+          EnqueueControlMessage (m_deferredChoke, false);
+          m_deferredChoke = 0;
+        }
+
+      if (!m_blockSendingActive && m_sendQueue.empty () && m_urgentRequestQueue.empty () && m_bulkRequestQueue.empty ())
         {
           return;
         }
@@ -905,40 +1237,73 @@ void Peer::HandleSend (Ptr<Socket> socket, uint32_t bytesFree)
            */
           if (m_blockSendDataLeft <= 0)
             {
-              NS_LOG_INFO ("Peer: Finished upload of request " << m_requestQueue.front ().pieceIndex << "@" << m_requestQueue.front ().blockOffSet << "->" <<  m_requestQueue.front ().blockOffSet +  m_requestQueue.front ().blockLength << " to " << GetRemoteIp () << " free bytes left in tx buffer: " << m_peerSocket->GetTxAvailable () << " requests left: " << m_requestQueue.size () - 1 << ".");
+              NS_LOG_INFO ("Peer: Finished upload of request " << m_currentRequest.pieceIndex << "@" << m_currentRequest.blockOffSet << "->" <<  m_currentRequest.blockOffSet +  m_currentRequest.blockLength << " to " << GetRemoteIp () << " free bytes left in tx buffer: " << m_peerSocket->GetTxAvailable () << " requests left: " << m_urgentRequestQueue.size () + m_bulkRequestQueue.size () << ".");
 
               m_blockSendingActive = false;
 
-              m_myClient->PeerBlockUploadCompleteEvent (this, m_requestQueue.front ().pieceIndex,m_requestQueue.front ().blockOffSet,  m_requestQueue.front ().blockLength);
-
-              m_sendQueuePieceMessageIndicators.pop_front ();
-              m_sendQueue.pop_front ();
-              m_requestQueue.pop_front ();
+              m_myClient->PeerBlockUploadCompleteEvent (this, m_currentRequest.pieceIndex, m_currentRequest.blockOffSet, m_currentRequest.blockLength);
             }
 
           nextIteration = true;
         }
       else
         {
-          if (m_sendQueuePieceMessageIndicators.front ())
+          // Control messages are sent first; PIECE messages are only started if no control message is waiting
+          if (!m_sendQueue.empty ())
+            {
+              if (m_peerSocket->GetTxAvailable () >= m_sendQueue.front ()->GetSize ())
+                {
+                  // Step 1: Get the packet to send
+                  Ptr<Packet> packet = m_sendQueue.front ();
+
+                  // Step 2: Send the packet
+                  m_peerSocket->Send (packet);
+
+                  // Step 2a: A HAVE message sent out announces its piece for a later session resume
+                  if (!m_queuedHaveMessages.empty ())
+                    {
+                      std::map<Ptr<Packet>, uint32_t>::iterator qhmIt = m_queuedHaveMessages.find (packet);
+                      if (qhmIt != m_queuedHaveMessages.end ())
+                        {
+                          m_announcedBitfield[(*qhmIt).second / 8] |= 0x80 >> ((*qhmIt).second % 8);
+                          m_queuedHaveMessages.erase (qhmIt);
+                        }
+                    }
+
+                  // Step 3: Remove the packet data from the internal queue
+                  m_sendQueue.pop_front ();
+
+                  // Step 4: Start another iteration so further packets can be sent out directly
+                  nextIteration = true;
+                }
+              else
+                {
+                  nextIteration = false;
+                }
+            }
+          else
             {
-              NS_ASSERT (!m_requestQueue.empty ());
+              // Urgent data is sent before bulk data
+              std::list<RequestInformation>& requestQueue = m_urgentRequestQueue.empty () ? m_bulkRequestQueue : m_urgentRequestQueue;
 
               if (m_peerSocket->GetTxAvailable () >= BT_PROTOCOL_MESSAGES_LENGTHHEADER_LENGTH + BT_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN)
                 {
                   // Step 1: Prepare the buffer that we will send our packet data from
+                  m_currentRequest = requestQueue.front ();
+                  requestQueue.pop_front ();
+
                   m_blockSendPtr =
                     m_myClient->GetTorrentDataBuffer () +
-                    m_requestQueue.front ().pieceIndex * m_myClient->GetTorrent ()->GetPieceLength () +
-                    m_requestQueue.front ().blockOffSet;
-                  m_blockSendDataLeft = m_requestQueue.front ().blockLength;
+                    m_currentRequest.pieceIndex * m_myClient->GetTorrent ()->GetPieceLength () +
+                    m_currentRequest.blockOffSet;
+                  m_blockSendDataLeft = m_currentRequest.blockLength;
 
                   // Step 2: Create the prelude of the piece message
                   Ptr<Packet> packet = Create<Packet> ();
 
                   PushPullLengthHeader lenHead (BT_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN + m_blockSendDataLeft);
                   PushPullTypeHeader typeHead (PushPullTypeHeader::PIECE);
-                  PushPullPieceMessage pieceMsg (m_requestQueue.front ().pieceIndex,m_requestQueue.front ().blockOffSet);
+                  PushPullPieceMessage pieceMsg (m_currentRequest.pieceIndex, m_currentRequest.blockOffSet);
 
                   packet->AddHeader (pieceMsg);
                   packet->AddHeader (typeHead);
@@ -954,29 +1319,7 @@ void Peer::HandleSend (Ptr<Socket> socket, uint32_t bytesFree)
                   // Step 5: Start another iteration so the piece data can be appended directly
                   nextIteration = true;
 
-                  NS_LOG_INFO ("Peer: Starting to upload to " << GetRemoteIp () << " piece " << pieceMsg.GetIndex () << "@" << m_requestQueue.front ().blockOffSet << "->" << m_requestQueue.front ().blockOffSet + m_requestQueue.front ().blockLength << ".");
-                }
-              else
-                {
-                  nextIteration = false;
-                }
-            }
-          else
-            {
-              if (m_peerSocket->GetTxAvailable () >= m_sendQueue.front ()->GetSize ())
-                {
-                  // Step 1: Get the packet to send
-                  Ptr<Packet> packet = m_sendQueue.front() ;
-				  
-				  // Step 2: Send the packet
-				  m_peerSocket->Send (packet);
-
-                  // Step 3: Remove the packet data from the internal queue
-                  m_sendQueue.pop_front ();
-                  m_sendQueuePieceMessageIndicators.pop_front ();
-
-                  // Step 4: Start another iteration so further packets can be sent out directly
-                  nextIteration = true;
+                  NS_LOG_INFO ("Peer: Starting to upload to " << GetRemoteIp () << " piece " << pieceMsg.GetIndex () << "@" << m_currentRequest.blockOffSet << "->" << m_currentRequest.blockOffSet + m_currentRequest.blockLength << ".");
                 }
               else
                 {
@@ -989,17 +1332,7 @@ void Peer::HandleSend (Ptr<Socket> socket, uint32_t bytesFree)
 
 void Peer::HandleDataSent (Ptr<Socket> socket, uint32_t dataSent)
 {
-  uint64_t currentSecond = static_cast<uint64_t> (Simulator::Now ().GetSeconds ());
-  uint64_t currentSecondModulo = currentSecond % BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS;
-  if (m_uploadHistoryReSetTime[currentSecondModulo] != currentSecond)
-    {
-      m_uploadHistoryReSetTime[currentSecondModulo] = currentSecond;
-      m_uploadHistory[currentSecondModulo] = dataSent;
-    }
-  else
-    {
-      m_uploadHistory[currentSecondModulo] += dataSent;
-    }
+  m_uploadRate.Add (Simulator::Now (), dataSent);
 
 //  HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
@@ -1020,12 +1353,15 @@ void Peer::HandleConnected (Ptr<Socket> socket)
   std::memcpy (peerId,m_myClient->GetPeerId ().c_str (), std::min (static_cast<size_t> (BT_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX), m_myClient->GetPeerId ().size ()));
   handshake.SetPeerId (peerId);
   handshake.SetInfoHash (m_myClient->GetCurrentInfoHash ());
+  handshake.SetCompressedBitfieldSupport (m_myClient->GetCompressedBitfield ());
+  handshake.SetAvailabilityWindowSupport (true);
+  handshake.SetFastExtensionSupport (true);
+  AnnounceSessionResume (handshake);
     
   Ptr<Packet> announcementPacket = Create<Packet> ();
   announcementPacket->AddHeader (handshake);
 
   m_sendQueue.push_back (announcementPacket);
-  m_sendQueuePieceMessageIndicators.push_back (false);
 
   HandleSend (m_peerSocket, m_peerSocket->GetTxAvailable ());
 }
@@ -1052,6 +1388,8 @@ void Peer::HandleConnectionClosed (Ptr<Socket> socket)
       return;
     }
 
+  StoreSession ();
+
   m_peerSocket->Close ();
   m_connectionState = CONN_STATE_CLOSED;
 
@@ -1074,6 +1412,8 @@ void Peer::HandleConnectionClosedWithError (Ptr<Socket> socket)
       return;
     }
 
+  StoreSession ();
+
   m_connectionState = CONN_STATE_CLOSED_WITH_ERROR;
 
   m_peerSocket->Close ();
@@ -1085,6 +1425,223 @@ void Peer::HandleConnectionClosedWithError (Ptr<Socket> socket)
   Simulator::ScheduleNow (&Peer::PseudoDeInitializeMe, this);
 }
 
+void Peer::StoreSession ()
+{
+  // A session taken from the cache for a connection that closed before the handshake is put back
+  if (m_announcedSessionResume && !m_sessionResumed && !m_resumedSession.m_remoteBitfield.empty () && m_myClient->GetPeerSessionCacheSize () > 0)
+    {
+      m_myClient->GetPeerSessionCache ().Store (m_resumedSession);
+      std::vector<uint8_t> ().swap (m_resumedSession.m_remoteBitfield);
+      std::vector<uint8_t> ().swap (m_resumedSession.m_announcedBitfield);
+    }
+
+  // Only connections that completed the exchange of whole bitfields can be resumed
+  if (!m_bitfieldReceived || m_remoteWindowed || m_advertisingWindow || m_myClient->GetSuperSeeding () || m_myClient->GetPeerSessionCacheSize () == 0)
+    {
+      return;
+    }
+  m_bitfieldReceived = false;
+
+  PeerSessionCache::Session session;
+  session.m_address = m_remoteIp.Get ();
+  session.m_peerId = m_remotePeerId;
+  session.m_remoteBitfield = m_bitfield;
+  session.m_announcedBitfield.swap (m_announcedBitfield);
+  m_queuedHaveMessages.clear ();
+  session.m_bpsDownload = m_downloadRate.GetEwmaBps (Simulator::Now ());
+  session.m_bpsUpload = m_uploadRate.GetEwmaBps (Simulator::Now ());
+  session.m_disconnectionTime = Simulator::Now ();
+
+  m_myClient->GetPeerSessionCache ().Store (session);
+}
+
+void Peer::AnnounceSessionResume (PushPullHandshakeMessage &handshake)
+{
+  m_announcedSessionResume = m_myClient->GetPeerSessionCache ().Take (m_remoteIp.Get (), m_resumedSession);
+  handshake.SetSessionResume (m_announcedSessionResume);
+}
+
+void Peer::UpdateAvailabilityWindow ()
+{
+  if (!m_advertisingWindow || m_connectionState != CONN_STATE_CONNECTED)
+    {
+      return;
+    }
+
+  uint32_t windowStart = m_myClient->GetAvailabilityWindowStart ();
+  if (windowStart == m_advertisedWindowStart)
+    {
+      return;
+    }
+
+  // Backward moves and moves beyond the current window are announced by sending the whole window again
+  if (windowStart < m_advertisedWindowStart || windowStart - m_advertisedWindowStart >= m_advertisedWindowLength)
+    {
+      SendAvailabilityWindow ();
+      return;
+    }
+
+  // Otherwise, only the bits of the pieces entering the window are sent
+  const std::vector<uint8_t>* bitfield = m_myClient->GetBitfield ();
+  std::string content;
+  AppendU32 (content, windowStart);
+  for (uint32_t byte = (m_advertisedWindowStart + m_advertisedWindowLength) / 8; byte < (windowStart + m_advertisedWindowLength) / 8; ++byte)
+    {
+      content.push_back (byte < bitfield->size () ? static_cast<char> ((*bitfield)[byte]) : 0);
+    }
+  m_advertisedWindowStart = windowStart;
+
+  SendExtendedMessage (PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW_MOVE, content);
+}
+
+void Peer::SendAllowedFastSet ()
+{
+  // Step 1: Generate the allowed fast set of the remote peer
+  GenerateAllowedFastSet (m_remoteIp, m_myClient->GetCurrentInfoHash (), m_myClient->GetTorrent ()->GetNumberOfPieces (),
+                          PP_PEER_ALLOWED_FAST_SET_SIZE, m_amAllowingFastPieces);
+
+  // Step 2: Announce all of its pieces at once; the remote peer only requests those that we have
+  PushPullMessageBatch batch (m_amAllowingFastPieces.size ());
+  for (std::set<uint32_t>::const_iterator it = m_amAllowingFastPieces.begin (); it != m_amAllowingFastPieces.end (); ++it)
+    {
+      batch.AddAllowedFast (*it);
+    }
+
+  SendMessageBatch (batch);
+}
+
+void Peer::EnqueueControlMessage (Ptr<Packet> packet, bool prioritized)
+{
+  if (prioritized)
+    {
+      m_sendQueue.push_front (packet);
+    }
+  else
+    {
+      m_sendQueue.push_back (packet);
+    }
+}
+
+void Peer::SendAvailabilityWindow ()
+{
+  m_advertisedWindowStart = m_myClient->GetAvailabilityWindowStart ();
+
+  // The window is sent as its first piece and its length, followed by the corresponding bytes of the bitfield (zero beyond the end of the file)
+  const std::vector<uint8_t>* bitfield = m_myClient->GetBitfield ();
+  std::string content;
+  AppendU32 (content, m_advertisedWindowStart);
+  AppendU32 (content, m_advertisedWindowLength);
+  for (uint32_t byte = m_advertisedWindowStart / 8; byte < (m_advertisedWindowStart + m_advertisedWindowLength) / 8; ++byte)
+    {
+      content.push_back (byte < bitfield->size () ? static_cast<char> ((*bitfield)[byte]) : 0);
+    }
+
+  SendExtendedMessage (PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW, content);
+}
+
+void Peer::HandleAvailabilityWindow (const std::string &content)
+{
+  // Step 1: Check the message
+  if (content.size () < 8)
+    {
+      NS_LOG_INFO ("Peer: Received a malformed availability window from " << GetRemoteIp () << ".");
+      return;
+    }
+  uint32_t windowStart = ReadU32 (content, 0);
+  uint32_t windowLength = ReadU32 (content, 4);
+  if ((windowStart % 8) > 0 || windowLength == 0 || (windowLength % 8) > 0 || content.size () - 8 != windowLength / 8)
+    {
+      NS_LOG_INFO ("Peer: Received a malformed availability window from " << GetRemoteIp () << ".");
+      return;
+    }
+
+  // Step 2: Replace the known bitfield of the remote peer by the window
+  bool firstWindow = !m_remoteWindowed || !m_bitfieldReceived;
+  std::vector<uint32_t> leavingPieces;
+  if (!firstWindow)
+    {
+      for (uint32_t piece = m_bitfieldOffset; piece < m_bitfieldOffset + m_bitfield.size () * 8; ++piece)
+        {
+          if (HasPiece (piece))
+            {
+              leavingPieces.push_back (piece);
+            }
+        }
+    }
+
+  m_bitfieldOffset = windowStart;
+  m_bitfield.assign (content.begin () + 8, content.end ());
+  m_firstMissingByte = 0;
+  m_remoteWindowed = true;
+
+  // Step 3: The first window is handled like a BITFIELD message; later ones replace the announced pieces
+  if (firstWindow)
+    {
+      m_bitfieldReceived = true;
+      m_myClient->PeerBitfieldReceivedEvent (this);
+      return;
+    }
+
+  for (std::vector<uint32_t>::const_iterator it = leavingPieces.begin (); it != leavingPieces.end (); ++it)
+    {
+      m_myClient->PeerPieceUnavailableEvent (this, *it);
+    }
+  for (uint32_t piece = windowStart; piece < windowStart + windowLength && piece < m_myClient->GetTorrent ()->GetNumberOfPieces (); ++piece)
+    {
+      if (HasPiece (piece))
+        {
+          m_myClient->PeerHaveEvent (this, piece);
+        }
+    }
+}
+
+void Peer::HandleAvailabilityWindowMove (const std::string &content)
+{
+  // Step 1: Check the message; moves only make sense after a window has been received and must stay within the window
+  if (!m_remoteWindowed || content.size () < 4)
+    {
+      NS_LOG_INFO ("Peer: Received an unexpected or malformed availability window move from " << GetRemoteIp () << ".");
+      return;
+    }
+  uint32_t windowStart = ReadU32 (content, 0);
+  if ((windowStart % 8) > 0 || windowStart <= m_bitfieldOffset || (windowStart - m_bitfieldOffset) / 8 >= m_bitfield.size ()
+      || content.size () - 4 != (windowStart - m_bitfieldOffset) / 8)
+    {
+      NS_LOG_INFO ("Peer: Received an unexpected or malformed availability window move from " << GetRemoteIp () << ".");
+      return;
+    }
+
+  // Step 2: Shift the window, collecting the announced pieces leaving it
+  uint32_t shift = (windowStart - m_bitfieldOffset) / 8;
+  std::vector<uint32_t> leavingPieces;
+  for (uint32_t piece = m_bitfieldOffset; piece < windowStart; ++piece)
+    {
+      if (HasPiece (piece))
+        {
+          leavingPieces.push_back (piece);
+        }
+    }
+
+  m_bitfield.erase (m_bitfield.begin (), m_bitfield.begin () + shift);
+  m_bitfield.insert (m_bitfield.end (), content.begin () + 4, content.end ());
+  m_bitfieldOffset = windowStart;
+  m_firstMissingByte = 0;
+
+  // Step 3: Inform the strategies about the pieces leaving and entering the window
+  for (std::vector<uint32_t>::const_iterator it = leavingPieces.begin (); it != leavingPieces.end (); ++it)
+    {
+      m_myClient->PeerPieceUnavailableEvent (this, *it);
+    }
+  uint32_t windowEnd = m_bitfieldOffset + m_bitfield.size () * 8;
+  for (uint32_t piece = windowEnd - shift * 8; piece < windowEnd && piece < m_myClient->GetTorrent ()->GetNumberOfPieces (); ++piece)
+    {
+      if (HasPiece (piece))
+        {
+          m_myClient->PeerHaveEvent (this, piece);
+        }
+    }
+}
+
 // DEBUG
 void Peer::PseudoDeInitializeMe ()
 {
@@ -1098,22 +1655,24 @@ void Peer::PseudoDeInitializeMe ()
   m_remotePeerId.clear ();
 
   m_bitfield.clear ();
+  m_firstMissingByte = 0;
 
-  m_packetBuffer->RemoveAtStart (m_packetBuffer->GetSize ());
-  m_packetBuffer = Create<Packet> ();
+  m_receiveBuffer.Clear (true);
 
-  m_sendQueuePieceMessageIndicators.clear ();
-  
   std::list<Ptr<Packet> >* pDummy = new std::list<Ptr<Packet> > ();
   std::list<RequestInformation>* pDummy2 = new std::list<RequestInformation> ();
+  std::list<RequestInformation>* pDummy3 = new std::list<RequestInformation> ();
   m_sendQueue.clear ();
 	m_sendQueue.swap(*pDummy);
-  m_requestQueue.clear ();
-	m_requestQueue.swap(*pDummy2);
+  m_urgentRequestQueue.clear ();
+	m_urgentRequestQueue.swap(*pDummy2);
+  m_bulkRequestQueue.clear ();
+	m_bulkRequestQueue.swap(*pDummy3);
   delete pDummy;
   delete pDummy2;
-  delete[] m_blockBuffer;
-  m_blockBuffer = 0;
+  delete pDummy3;
+  m_deferredChoke = 0;
+  m_queuedHaveMessages.clear ();
   delete[] m_blockSendBuffer;
   m_blockSendBuffer = 0;
   delete[] m_pieceCorruptionMap;
@@ -24,7 +24,10 @@
 #define PEER_H_
 
 #include "ns3/PushPullDefines.h"
+#include "ns3/RateEstimator.h"
 
+#include "PeerSessionCache.h"
+#include "PushPullFrameParser.h"
 #include "PushPullPacket.h"
 
 #include "ns3/ipv4-address.h"
@@ -32,6 +35,8 @@
 #include "ns3/socket.h"
 
 #include <list>
+#include <map>
+#include <set>
 #include <stdexcept>
 #include <vector>
 
@@ -54,6 +59,9 @@ class PushPullClient;
  *
  * All default PushPull Peer Wire Protocol messages as defined in the <a href="http://wiki.theory.org/PushPullSpecification#Messages" target="_blank">Bittorrent Protocol Specification v1.0</a> are supported.
  * Additionally, you can send messages adhering to the <a href="http://www.pushpull.org/beps/bep_0010.html" target="_blank">PushPull Extension Protocol (BEP 10)</a>.
+ * If both sides announce support in their handshakes, the messages of the Fast Extension (BEP 6) are exchanged as well: seeders and new peers
+ * send HAVE_ALL or HAVE_NONE instead of their bitfields, requests that will not be served are answered with REJECT_REQUEST, and each peer
+ * announces an allowed fast set of pieces that may be requested while being choked.
  *
  * Note: The sending and analysis of a PushPull Extension Protocol handshake message are currently not implemented. However, you may still use the SendExtendedMessage member function to send messages other
  * than those defined in the standard Peer Wire Protocol specification.
@@ -79,6 +87,14 @@ public:
      */
     CONN_STATE_DEINITIALIZED
   };
+
+  // The classes of the send scheduler, in order of priority. Messages of a class are only sent if no message of a higher class is waiting.
+  enum SendClass
+  {
+    SEND_CLASS_CONTROL,                // All messages other than PIECE messages
+    SEND_CLASS_URGENT_DATA,            // PIECE messages needed soon by the remote peer
+    SEND_CLASS_BULK_DATA               // All other PIECE messages
+  };
 private:
   // Stores information about a block request.
   struct RequestInformation
@@ -103,6 +119,14 @@ private:
   Ipv4Address                     m_remoteIp;              // The IPv4 address of the remote peer
   uint16_t                        m_remotePort;            // The port of the remote peer
   std::string                     m_remotePeerId;          // The peer id sent by the remote peer to identify itself
+  bool                            m_remoteSupportsCompressedBitfield; // Whether the remote peer announced support for compressed bitfields in its handshake
+  bool                            m_announcedSessionResume; // Whether our handshake announced a cached session with the remote peer
+  bool                            m_sessionResumed;        // Whether both sides announced a cached session, i.e., whether bitfields are exchanged as deltas
+  PeerSessionCache::Session       m_resumedSession;        // The cached session of the previous connection with the remote peer, if it was resumed
+  std::vector<uint8_t>            m_announcedBitfield;     // The pieces announced to the remote peer via bitfield and HAVE messages; only tracked while sessions are cached
+  std::map<Ptr<Packet>, uint32_t> m_queuedHaveMessages;    // The HAVE messages waiting in m_sendQueue and their pieces; added to m_announcedBitfield once handed to the socket
+  bool                            m_remoteSupportsAvailabilityWindow; // Whether the remote peer announced support for availability windows in its handshake
+  bool                            m_remoteSupportsFastExtension; // Whether the remote peer announced support for the Fast Extension in its handshake
 
   // Current status of the connection
   PeerState                       m_connectionState;      // The current state of the connection represented by this class
@@ -113,23 +137,30 @@ private:
   bool                            m_amInterested;          // Whether we have expressed interest in one of the remote peer's PIECEs
 
   std::vector<uint8_t>            m_bitfield;              // The bitfield of the remote peer, updated upon reception of HAVE messages
+  bool                            m_bitfieldReceived;      // Whether the bitfield of the remote peer was received, i.e., whether the session may be cached upon disconnection
+  uint32_t                        m_bitfieldOffset;        // The piece corresponding to the first bit of m_bitfield; non-zero if the remote peer advertises an availability window
+  mutable uint32_t                m_firstMissingByte;      // The byte of m_bitfield at which GetFirstMissingPiece resumes its search; reset whenever bits may have been cleared
+  bool                            m_remoteWindowed;        // Whether the remote peer advertises an availability window instead of its whole bitfield
+  bool                            m_advertisingWindow;     // Whether we advertise an availability window instead of our whole bitfield to the remote peer
+  uint32_t                        m_advertisedWindowStart; // The first piece of the availability window advertised to the remote peer
+  uint32_t                        m_advertisedWindowLength; // The number of pieces of the availability window advertised to the remote peer
   uint8_t*                        m_pieceCorruptionMap;    // An array indicating which of the received pieces were corrupted
 
+  std::set<uint32_t>              m_allowedFastPieces;     // The pieces the remote peer allows us to request while it chokes us (Fast Extension)
+  std::set<uint32_t>              m_amAllowingFastPieces;  // The pieces we allow the remote peer to request while we choke it (Fast Extension)
+  std::set<uint32_t>              m_suggestedPieces;       // The pieces the remote peer suggested for download (Fast Extension)
 
-  // Packet reception members and corresponding state machine attributes
-  Ptr<Packet>                     m_packetBuffer;          // All incoming data is collected in a buffer represented by a Packet instance
-  PushPullLengthHeader          m_lengthHeader;          // Stores the announced size of the next PushPull PeerWire Protocol message
-  PushPullTypeHeader            m_typeHeader;            // Stores the announced type of the next PushPull PeerWire Protocol message
-  bool                            m_lengthHeaderRemoved;   // Whether the length header was already removed from the m_packetBuffer field
 
-  uint8_t*                        m_blockBuffer;           // The buffer that we use to catch PIECE payloads in, so we don't have to allocate it each time again
-  uint32_t                        m_blockBufferSize;       // The size of m_blockBuffer, for dynamic adjustment
+  // Packet reception members and corresponding state machine attributes
+  PushPullFrameParser             m_receiveBuffer;         // All incoming data is collected in this ring buffer and decoded from there in place
 
   // Packet transmission members and corresponding state machine attributes
-  std::list<RequestInformation>   m_requestQueue;          // The REQUESTs we have to fulfill for the other peer (NOTE: Requests are NOT automatically added here!)
+  std::list<RequestInformation>   m_urgentRequestQueue;    // The REQUESTs we have to fulfill for the other peer as urgent data (NOTE: Requests are NOT automatically added here!)
+  std::list<RequestInformation>   m_bulkRequestQueue;      // The REQUESTs we have to fulfill for the other peer as bulk data
+  RequestInformation              m_currentRequest;        // The REQUEST whose PIECE message is currently being sent out
 
-  std::list<Ptr<Packet> >         m_sendQueue;             // The queue that holds the packets that we want to send out
-  std::list<bool>                 m_sendQueuePieceMessageIndicators; // Whether the next message in m_sendQueue is a PIECE message or not
+  std::list<Ptr<Packet> >         m_sendQueue;             // The control messages (i.e., all messages but PIECE messages) that we want to send out; always sent before PIECE messages
+  Ptr<Packet>                     m_deferredChoke;         // A CHOKE held back until the queued PIECE messages are sent, if the remote peer does not support the Fast Extension
 
   uint8_t*                        m_blockSendBuffer;       // The buffer that we use to send PIECE messages from
   const uint8_t*                  m_blockSendPtr;          // The last position from which we read to send out the data
@@ -143,10 +174,8 @@ private:
   uint64_t                        m_totalBytesUploaded;    // The total amount of data (PIECE message payload) uploaded to the remote client
 
   // Used for the calculation of the rolling average of the download and upload speeds
-  uint64_t                        m_downloadHistory[BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS];
-  uint64_t                        m_downloadHistoryReSetTime[BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS];
-  uint64_t                        m_uploadHistory[BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS];
-  uint64_t                        m_uploadHistoryReSetTime[BT_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS];
+  RateEstimator                   m_downloadRate;          // The estimator for the download speed from the remote client
+  RateEstimator                   m_uploadRate;            // The estimator for the upload speed to the remote client
 
 // Constructors etc.
 public:
@@ -228,12 +257,26 @@ public:
    */
   void CancelRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
 
+  /**
+   * \brief Send a batch of pre-encoded control messages (e.g., multiple REQUEST or HAVE messages) to the remote peer.
+   *
+   * The batch is enqueued at the end of the local send queue as a single packet. In contrast to sending the messages one by one,
+   * this requires only one allocation and one send queue entry for the whole batch.
+   *
+   * @param batch the messages to send.
+   */
+  void SendMessageBatch (const PushPullMessageBatch &batch);
+
   /*
    * \brief Send the client's current bitfield to the remote peer.
    *
    * Note: Sending this message at any other time other than directly after the handshake message has been sent is a breach of protocol.
    * However, this message is optional.
    *
+   * If the remote peer supports the Fast Extension, a client that has all or none of the pieces sends a HAVE_ALL or HAVE_NONE message instead,
+   * and the bitfield is followed by the ALLOWED_FAST messages of the allowed fast set of the remote peer.
+   *
+   * In superseeding mode (see PushPullClient::SetSuperSeeding), the client advertises no pieces at all.
    */
   void SendBitfield ();
 
@@ -247,6 +290,14 @@ public:
    */
   void SendHaveMessage (uint32_t pieceIndex);
 
+  /**
+   * \brief Inform the remote peer of a move of the client's availability window (see PushPullClient::MoveAvailabilityWindow).
+   *
+   * If the window moved forward by less than its size, only the bits of the pieces entering the window are sent; otherwise, the whole
+   * window is sent again. Does nothing if no availability window is advertised to the remote peer.
+   */
+  void UpdateAvailabilityWindow ();
+
   /**
    * \brief Send a CHOKE or UNCHOKE message to the peer.
    *
@@ -259,13 +310,36 @@ public:
   /**
    * \brief Send a PIECE message to the peer.
    *
-   * Inserts a PIECE message into the message queue to transfer actual file data to the remote peer.
+   * Inserts a PIECE message into the message queue of the given class to transfer actual file data to the remote peer.
+   *
+   * Control messages are always sent before PIECE messages, and urgent PIECE messages are always sent before bulk ones. Since a
+   * PIECE message cannot be interrupted once its transmission started, messages of higher classes preempt lower ones only at the
+   * boundaries of PIECE messages, i.e., wait for at most one block.
    *
    * @param pieceIndex the index of the piece to send.
    * @param blockOffset the offset (in bytes) of the block to send within the piece.
    * @param blockLength the length of the block to send.
+   * @param sendClass the class of the message, either SEND_CLASS_URGENT_DATA or SEND_CLASS_BULK_DATA.
    */
-  void SendBlock (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t blockLength);
+  void SendBlock (uint32_t pieceIndex, uint32_t blockOffSet, uint32_t blockLength, SendClass sendClass = SEND_CLASS_BULK_DATA);
+
+  /**
+   * \brief Inform the peer that one of its requests will not be served by sending a REJECT_REQUEST message.
+   *
+   * Without the Fast Extension, requests are dropped silently and this method does nothing.
+   *
+   * @param pieceIndex the index of the piece of the rejected request.
+   * @param blockOffset the offset (in bytes) of the block of the rejected request within the piece.
+   * @param blockLength the length of the block of the rejected request.
+   */
+  void RejectRequest (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Suggest a piece for download to the peer by sending a SUGGEST_PIECE message. Does nothing without the Fast Extension.
+   *
+   * @param pieceIndex the index of the suggested piece.
+   */
+  void SuggestPiece (uint32_t pieceIndex);
 
   /**
    * \brief Send an PushPull Extension Protocol message to the peer.
@@ -337,18 +411,40 @@ public:
     return m_amInterested;
   }
 
+  /**
+   * @returns true, if both sides announced support for the Fast Extension, i.e., whether SUGGEST_PIECE, HAVE_ALL, HAVE_NONE, REJECT_REQUEST
+   * and ALLOWED_FAST messages are exchanged on this connection.
+   */
+  bool GetFastExtension () const
+  {
+    return m_remoteSupportsFastExtension;
+  }
+
+  /**
+   * @returns true, if the local client allows the remote peer to request the given piece while choking it (i.e., if the piece is part of the allowed fast set of the remote peer).
+   */
+  bool GetAmAllowingFast (uint32_t pieceIndex) const
+  {
+    return m_amAllowingFastPieces.find (pieceIndex) != m_amAllowingFastPieces.end ();
+  }
+
   /**
    * \brief Check whether the remote client has announced the possession of a piece.
    *
    * @param pieceId the piece to check for.
    *
-   * @returns true, if the remote client has announced the possession of the piece.
+   * @returns true, if the remote client has announced the possession of the piece. If the remote client advertises an availability window,
+   * pieces outside of the window are never reported as possessed.
    */
   bool HasPiece (uint32_t pieceId) const
   {
     try
       {
-        uint32_t result = m_bitfield.at (pieceId / 8) & (1 << (7 - pieceId % 8));
+        if (pieceId < m_bitfieldOffset)
+          {
+            return false;
+          }
+        uint32_t result = m_bitfield.at ((pieceId - m_bitfieldOffset) / 8) & (1 << (7 - pieceId % 8));
         return result;
       }
     catch (std::out_of_range oor)
@@ -357,6 +453,19 @@ public:
       }
   }
 
+  /**
+   * @returns the first piece the remote client has not announced the possession of. If the remote client advertises an availability window,
+   * the search starts at the beginning of the window. Returns a value beyond the last piece of the file if all pieces were announced.
+   * The position of the search is remembered, so repeated calls only scan the part of the bitfield that changed since.
+   */
+  uint32_t GetFirstMissingPiece () const;
+
+  /**
+   * @returns the number of bytes waiting to be uploaded to the remote peer: data handed to the socket but not yet acknowledged,
+   * the remaining data of the PIECE message currently being sent and the data of all queued PIECE messages.
+   */
+  uint32_t GetSendBacklog () const;
+
   /**
    * @returns true, if the remote peer is currently choking the local client.
    */
@@ -367,6 +476,30 @@ public:
    */
   bool IsInterested () const;
 
+  /**
+   * @returns true, if the remote peer allows the local client to request the given piece while choking it (ALLOWED_FAST message).
+   */
+  bool IsAllowedFast (uint32_t pieceIndex) const
+  {
+    return m_allowedFastPieces.find (pieceIndex) != m_allowedFastPieces.end ();
+  }
+
+  /**
+   * @returns the pieces the remote peer allows the local client to request while choking it.
+   */
+  const std::set<uint32_t>& GetAllowedFastPieces () const
+  {
+    return m_allowedFastPieces;
+  }
+
+  /**
+   * @returns the pieces the remote peer suggested for download (SUGGEST_PIECE messages). Suggestions are advisory only.
+   */
+  const std::set<uint32_t>& GetSuggestedPieces () const
+  {
+    return m_suggestedPieces;
+  }
+
   /**
    * \brief Get the piece corruption map of the remote client.
    *
@@ -416,6 +549,15 @@ public:
    */
   double GetBpsDownload ();
 
+  /**
+   * \brief Get an exponentially-weighted moving average of the download speed from the peer.
+   *
+   * In contrast to the GetBpsDownload method, this estimation quickly follows changes of the download speed.
+   *
+   * @returns an estimation of the download speed from that peer, in bps.
+   */
+  double GetEwmaBpsDownload ();
+
   /**
    * \brief Get an estimation of the current upload speed to the peer.
    *
@@ -425,15 +567,47 @@ public:
    */
   double GetBpsUpload ();
 
+  /**
+   * \brief Get an exponentially-weighted moving average of the upload speed to the peer.
+   *
+   * This method is the local counterpart to the GetEwmaBpsDownload method.
+   *
+   * @returns an estimation of the upload speed to the peer, in bps.
+   */
+  double GetEwmaBpsUpload ();
+
+  /**
+   * \brief Change the parameters of the download and upload speed estimations. This discards the data recorded so far.
+   *
+   * @param window the duration of the sliding window used by the GetBpsDownload and GetBpsUpload methods. Default is PP_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS.
+   * @param resolution the granularity of the estimations. Default is PP_RATE_ESTIMATOR_RESOLUTION milliseconds.
+   * @param ewmaHalfLife the half-life of the moving averages returned by the GetEwmaBpsDownload and GetEwmaBpsUpload methods. Default is PP_RATE_ESTIMATOR_EWMA_HALF_LIFE milliseconds.
+   */
+  void SetRateEstimation (Time window, Time resolution, Time ewmaHalfLife);
+
+  /**
+   * \brief Get the cached session of the previous connection with the remote peer, if the connection resumed it.
+   *
+   * Resumed connections exchange only the pieces gained since the disconnection instead of the whole bitfields, and start their
+   * rate estimations from the rates measured at the disconnection. The connection itself starts choked, as usual. The bitfields within
+   * the returned session are released once they were applied.
+   *
+   * @returns a pointer to the resumed session, or 0 if the connection did not resume a session.
+   */
+  const PeerSessionCache::Session* GetResumedSession () const
+  {
+    return m_sessionResumed ? &m_resumedSession : 0;
+  }
+
 // Internal methods
 private:
   // Internal message generation methods
   void NotifyPeerOfChokeChange ();
   void NotifyPeerOfInterestedChange ();
-  void HandleCancel (Ptr<Packet> packet);
+  void HandleCancel (uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
 
-  // Handling of PIECE messages
-  bool HandlePiece (Ptr<Packet> packet, uint32_t packetLength);
+  // Handling of PIECE messages; the complete message must be at the beginning of m_receiveBuffer
+  void HandlePiece (uint32_t messageLength);
 
   // The main method for reading from the TCP socket's stream
   void HandleRead (Ptr<Socket> socket);
@@ -450,6 +624,28 @@ private:
   void HandleConnectionClosed (Ptr<Socket> socket);
   void HandleConnectionClosedWithError (Ptr<Socket> socket);
 
+  // Store the state of the connection in the session cache of the client; must be called before the connection state is reset
+  void StoreSession ();
+
+  // Announce a cached session with the remote peer in the given handshake; the session is taken from the cache, so it cannot be evicted before the handshake of the remote peer arrives
+  void AnnounceSessionResume (PushPullHandshakeMessage &handshake);
+
+  // Add a control message to the send queue, either at its end or, if prioritized, at its beginning
+  void EnqueueControlMessage (Ptr<Packet> packet, bool prioritized);
+
+  // Send the client's current availability window, bitfield or the corresponding delta or Fast Extension message to the remote peer
+  void SendBitfieldMessage ();
+
+  // Send the ALLOWED_FAST messages of the allowed fast set of the remote peer
+  void SendAllowedFastSet ();
+
+  // Send the client's current availability window to the remote peer
+  void SendAvailabilityWindow ();
+
+  // Handlers for the Extension Protocol messages advertising availability windows
+  void HandleAvailabilityWindow (const std::string &content);
+  void HandleAvailabilityWindowMove (const std::string &content);
+
 // Debugging
 private:
   // We experienced the problem that the Peer class may be deinitialized too early so events in the global event queue fail.
@@ -23,11 +23,13 @@
 #include "PushPullVideoClient.h"
 
 #include "ns3/PushPullUtilities.h"
+#include "ns3/WallclockProfiler.h"
 
 #include "ns3/abort.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace ns3 {
@@ -43,6 +45,9 @@ PushPullVideoClient::PushPullVideoClient ()
   m_preBufferingTime = Seconds (10);
   m_autoPlay = false;
   m_autoPlayFromRight = false;
+  m_fastStart = false;
+  m_bufferLowWatermark = Seconds (0);
+  m_bufferHighWatermark = Seconds (0);
 
   m_piecesMissable = true; 
   // for collecting missed rate;
@@ -56,6 +61,7 @@ PushPullVideoClient::PushPullVideoClient ()
   m_paused = false;
   m_buffering = false;
   m_pausedUntil = MilliSeconds (0);
+  m_periodicChange = false;
 }
 
 PushPullVideoClient::~PushPullVideoClient ()
@@ -83,7 +89,12 @@ void PushPullVideoClient::StartApplication ()
 
   // TODO: Shift this into a new Torrent class derivate?
   std::string comment = GetTorrent ()->GetComment ();
-  if (comment.size () > 0)
+  if (GetTorrent ()->HasPieceTimestamps ())      // VBR videos: the length comes from the piece timestamp index; the average piece length is only used for periodic checks
+    {
+      m_totalLength = MilliSeconds (GetTorrent ()->GetPieceTimestamp (GetTorrent ()->GetNumberOfPieces ()));
+      m_milliSecondsPerPiece = std::max (1.0, std::ceil (static_cast<double> (m_totalLength.GetMilliSeconds ()) / GetTorrent ()->GetNumberOfPieces ()));
+    }
+  else if (comment.size () > 0)
     {
       double lengthInMs = lexical_cast<double> (comment.substr (0, comment.find ("ms")));
 
@@ -131,6 +142,37 @@ void PushPullVideoClient::SetPreBufferingTime (Time preBufferingTime)
     }
 }
 
+bool PushPullVideoClient::GetFastStart () const
+{
+  return m_fastStart;
+}
+
+void PushPullVideoClient::SetFastStart (bool fastStart)
+{
+  m_fastStart = fastStart;
+}
+
+Time PushPullVideoClient::GetBufferLowWatermark () const
+{
+  return m_bufferLowWatermark;
+}
+
+Time PushPullVideoClient::GetBufferHighWatermark () const
+{
+  return m_bufferHighWatermark;
+}
+
+void PushPullVideoClient::SetBufferWatermarks (Time lowWatermark, Time highWatermark)
+{
+  if (highWatermark.IsStrictlyNegative ())
+    {
+      highWatermark = Seconds (0);
+    }
+
+  m_bufferHighWatermark = highWatermark;
+  m_bufferLowWatermark = std::max (Seconds (0), std::min (lowWatermark, highWatermark));
+}
+
 bool PushPullVideoClient::GetAutoPlay () const
 {
   return m_autoPlay;
@@ -202,6 +244,11 @@ bool  PushPullVideoClient::IsPaused () const
   return m_paused;
 }
 
+bool PushPullVideoClient::IsBuffering () const
+{
+  return m_buffering;
+}
+
 Time PushPullVideoClient::GetRemainingPause () const
 {
   Time remainingPause = m_pausedUntil - Simulator::Now ();
@@ -352,7 +399,7 @@ void PushPullVideoClient::Play ()
   if (preBufferingTimeLeft.IsStrictlyPositive ())
     {
       NS_LOG_INFO ("Need to buffer " << preBufferingTimeLeft.GetSeconds () << " additional seconds before playback.");
-      BufferFor (preBufferingTimeLeft);
+      BufferPreBufferingRange (0, preBufferingTimeLeft);
     }
 
   // Step 5: Start the playback again
@@ -414,6 +461,9 @@ void PushPullVideoClient::Stop ()
 
 void PushPullVideoClient::SetPlaybackPosition (Time position)
 {
+  bool periodicChange = m_periodicChange;
+  m_periodicChange = false;
+
   if (position > m_totalLength)
     {
       Stop ();
@@ -428,13 +478,22 @@ void PushPullVideoClient::SetPlaybackPosition (Time position)
           position = MilliSeconds (0);
         }
 
+      uint32_t oldPiece = GetCurrentPiece ();
       m_playbackPosition = position;
       PlaybackPositionChangedEvent ();
+
+      if (!periodicChange && GetCurrentPiece () != oldPiece)
+        {
+          PlaybackSeekEvent (oldPiece, GetCurrentPiece ());
+        }
     }
 }
 
 void PushPullVideoClient::SetPlaybackPositionRelative (Time change)
 {
+  bool periodicChange = m_periodicChange;
+  m_periodicChange = false;
+
   if (m_playbackPosition + change > m_totalLength)      // If we would go beyond the "end time" of the video, we stop playback
     {
       Stop ();
@@ -449,8 +508,14 @@ void PushPullVideoClient::SetPlaybackPositionRelative (Time change)
           change = MilliSeconds (-m_playbackPosition.GetMilliSeconds ());             // ... we go right to the beginning only
 
         }
+      uint32_t oldPiece = GetCurrentPiece ();
       m_playbackPosition = PieceToTime (TimeToPiece (Time (m_playbackPosition + change)));
       PlaybackPositionChangedEvent ();
+
+      if (!periodicChange && GetCurrentPiece () != oldPiece)
+        {
+          PlaybackSeekEvent (oldPiece, GetCurrentPiece ());
+        }
     }
 }
 
@@ -589,16 +654,57 @@ void PushPullVideoClient::BufferRange (uint32_t rangeStart, uint32_t rangeEnd)
     }
 }
 
+void PushPullVideoClient::BufferPreBufferingRange (uint32_t piece, Time preBufferingTimeLeft)
+{
+  // Without fast start, the pre-buffering phase is a fixed period, as before
+  if (!m_fastStart)
+    {
+      BufferFor (preBufferingTimeLeft);
+      return;
+    }
+
+  // With fast start, the range is fetched from all peers in parallel, so playback starts as soon as it is complete
+  uint32_t rangeEnd = std::min (GetTorrent ()->GetNumberOfPieces (), piece + DurationToPieces (piece, m_preBufferingTime) + 1);
+  BufferRange (piece, rangeEnd);
+}
+
 Time PushPullVideoClient::PieceToTime (uint32_t piece) const
 {
+  if (GetTorrent ()->HasPieceTimestamps ())
+    {
+      // Beyond the end of the video, extrapolate with the average piece length (like with a constant bitrate)
+      uint32_t numberOfPieces = GetTorrent ()->GetNumberOfPieces ();
+      if (piece > numberOfPieces)
+        {
+          return m_totalLength + MilliSeconds (static_cast<uint64_t> (ceil ((piece - numberOfPieces) * m_milliSecondsPerPiece)));
+        }
+      return MilliSeconds (GetTorrent ()->GetPieceTimestamp (piece));
+    }
+
   return MilliSeconds (static_cast<uint64_t> (ceil (piece * m_milliSecondsPerPiece)));
 }
 
 uint32_t PushPullVideoClient::TimeToPiece (Time time) const
 {
+  if (GetTorrent ()->HasPieceTimestamps ())
+    {
+      return GetTorrent ()->GetPieceAtTimestamp (time.IsStrictlyNegative () ? 0 : time.GetMilliSeconds ());
+    }
+
   return floor (time.GetMilliSeconds () / m_milliSecondsPerPiece);
 }
 
+Time PushPullVideoClient::PiecesToDuration (uint32_t piece, uint32_t count) const
+{
+  return PieceToTime (piece + count) - PieceToTime (piece);
+}
+
+uint32_t PushPullVideoClient::DurationToPieces (uint32_t piece, Time duration) const
+{
+  uint32_t lastPiece = TimeToPiece (PieceToTime (piece) + duration);
+  return lastPiece > piece ? lastPiece - piece : 0;
+}
+
 void PushPullVideoClient::PlaybackStateChangedEvent ()
 {
   std::list<Callback<void> >::iterator iter = m_playbackStateChangedEventListeners.begin ();
@@ -610,6 +716,9 @@ void PushPullVideoClient::PlaybackStateChangedEvent ()
 
 void PushPullVideoClient::PlaybackPositionChangedEvent ()
 {
+  // The advertised availability window follows the playback position
+  MoveAvailabilityWindow (GetCurrentPiece ());
+
   std::list<Callback<void, Time> >::iterator iter = m_playbackPositionChangedEventListeners.begin ();
   for (; iter != m_playbackPositionChangedEventListeners.end (); ++iter)
     {
@@ -619,6 +728,8 @@ void PushPullVideoClient::PlaybackPositionChangedEvent ()
 
 void PushPullVideoClient::PlaybackPositionWillChangePeriodicallyEvent ()
 {
+  m_periodicChange = true;
+
   std::list<Callback<void> >::iterator iter = m_playbackStateWillChangePeriodicallyEventListeners.begin ();
   for (; iter != m_playbackStateWillChangePeriodicallyEventListeners.end (); ++iter)
     {
@@ -653,6 +764,15 @@ void PushPullVideoClient::PlaybackFinishedEvent ()
     }
 }
 
+void PushPullVideoClient::PlaybackSeekEvent (uint32_t oldPiece, uint32_t newPiece)
+{
+  std::list<Callback<void, uint32_t, uint32_t> >::iterator iter = m_playbackSeekEventListeners.begin ();
+  for (; iter != m_playbackSeekEventListeners.end (); ++iter)
+    {
+      (*iter)(oldPiece, newPiece);
+    }
+}
+
 void PushPullVideoClient::RegisterCallbackPlaybackStateChangedEvent (Callback<void> eventCallback)
 {
   m_playbackStateChangedEventListeners.push_back (eventCallback);
@@ -763,6 +883,24 @@ void PushPullVideoClient::UnregisterCallbackPlaybackFinishedEvent (Callback<void
     }
 }
 
+void PushPullVideoClient::RegisterCallbackPlaybackSeekEvent (Callback<void, uint32_t, uint32_t > eventCallback)
+{
+  m_playbackSeekEventListeners.push_back (eventCallback);
+}
+
+void PushPullVideoClient::UnregisterCallbackPlaybackSeekEvent (Callback<void, uint32_t, uint32_t > eventCallback)
+{
+  std::list<Callback<void, uint32_t, uint32_t > >::iterator iter = m_playbackSeekEventListeners.begin ();
+  for (; iter != m_playbackSeekEventListeners.end (); ++iter)
+    {
+      if (iter->IsEqual (eventCallback))
+        {
+          m_playbackSeekEventListeners.erase (iter);
+          break;
+        }
+    }
+}
+
 void PushPullVideoClient::UnPauseAfterBuffering ()
 {
   if (m_playing)
@@ -782,6 +920,8 @@ void PushPullVideoClient::UnPauseAfterBuffering ()
 
 void PushPullVideoClient::AdvancePlayback ()
 {
+  PP_PROFILE_SCOPE (PLAYBACK_ADVANCE);
+
   // Playback can only be advanced if the client is playing and not paused (like in DVDs: Playing ~ picture visible, Paused ~ Freezed picture)
   if (m_playing && !m_paused)
     {
@@ -832,12 +972,12 @@ void PushPullVideoClient::AdvancePlayback ()
               // Step 3a1: Get the number of pieces we may have to skip and compare them to the maximum duration of the part we may skip
               uint32_t piecesToSkip = GetContinousMissingPiecesFromPiece (currentPiece + 1);
 
-              if (PieceToTime (piecesToSkip) <= m_skipTolerance)
+              if (PiecesToDuration (currentPiece + 1, piecesToSkip) <= m_skipTolerance)
                 {
                   // Step 3a2: Since we may be able to skip, we also have to check the length of the part of the video available after the skip
                   uint32_t piecesAfterwards = GetContinousPiecesFromPiece (currentPiece + piecesToSkip + 1);
 
-                  if (PieceToTime (piecesAfterwards) >= m_continousPlaybackAfterSkip)
+                  if (PiecesToDuration (currentPiece + piecesToSkip + 1, piecesAfterwards) >= m_continousPlaybackAfterSkip)
                     {
                       NS_LOG_INFO ("Skipping playback from piece " << currentPiece << " to piece " << currentPiece + piecesToSkip << ":");
 
@@ -852,20 +992,20 @@ void PushPullVideoClient::AdvancePlayback ()
                     {
                       NS_LOG_INFO ("Cannot skip because continous playback after the skip would have been too short. Buffering until skip is possible.");
 
-                      BufferRange (currentPiece + piecesToSkip + 1, currentPiece + piecesToSkip + 1 + TimeToPiece (m_continousPlaybackAfterSkip));
+                      BufferRange (currentPiece + piecesToSkip + 1, currentPiece + piecesToSkip + 1 + DurationToPieces (currentPiece + piecesToSkip + 1, m_continousPlaybackAfterSkip));
                       CannotAdvancePlaybackEvent ();
                     }
                 }
               // Step 3a4: We cannot skip and have to buffer
               else
                 {
-                  Time preBufferingTimeLeft = m_preBufferingTime - PieceToTime (GetContinousPiecesFromPiece (currentPiece));
+                  Time preBufferingTimeLeft = m_preBufferingTime - PiecesToDuration (currentPiece, GetContinousPiecesFromPiece (currentPiece));
 
                   if (preBufferingTimeLeft.IsStrictlyPositive ())
                     {
                       NS_LOG_INFO ("Cannot advance playback. Buffering for " << preBufferingTimeLeft.GetMilliSeconds () << " ms.");
 
-                      BufferFor (preBufferingTimeLeft);
+                      BufferPreBufferingRange (currentPiece, preBufferingTimeLeft);
                       CannotAdvancePlaybackEvent ();
                     }
                 }
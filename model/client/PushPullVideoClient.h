@@ -52,12 +52,15 @@ class PushPullVideoClient : public PushPullClient
 private:
   // Basic settings for the video client
   Time    m_totalLength;               // The total length of the video to play back
-  double  m_milliSecondsPerPiece;      // How long a piece is in milli seconds
+  double  m_milliSecondsPerPiece;      // How long a piece is in milli seconds (on average, if the torrent has a piece timestamp index)
 
   // Auto-playback-related settings
   Time   m_preBufferingTime;           // The time that the client pre-buffers before first attempting to start playback
   bool   m_autoPlay;                   // Whether to automatically start pseudo-playback upon application startup (StartApplication())
   bool   m_autoPlayFromRight;          // Whether autoplay starts at the rightmost continously reachable position (starting from the left)
+  bool   m_fastStart;                  // Whether the pieces needed to start or resume playback are requested from all peers in parallel while buffering
+  Time   m_bufferLowWatermark;         // The buffered playback time below which requesting beyond the buffer target resumes
+  Time   m_bufferHighWatermark;        // The buffered playback time at which requesting beyond the buffer target is paused. Zero => No throttling
 
   // General playback-related settings
   bool  m_piecesMissable;              // Whether pieces may be missed (skipped) during playback. Otherwise, buffering periods are initiated
@@ -71,6 +74,7 @@ private:
   bool   m_paused;                     // Whether the client is currently paused (i.e., downloading but not playing)
   bool   m_buffering;                  // Whether the client is currently buffering
   Time   m_pausedUntil;                // If the current is currently buffering, this indicates how long the remaining time of buffering is
+  bool   m_periodicChange;             // Whether the upcoming change of the playback position is due to automatic playback (i.e., not a seek)
 
   // Events used to simulate playback; should not be touched if psuedo-playback is not intended to be changed
   EventId     m_nextAdvancePlaybackEvent;
@@ -85,6 +89,7 @@ private:
   std::list<Callback<void> > m_CannotAdvancePlaybackEventListeners;
   std::list<Callback<void, uint32_t, uint32_t > > m_skippedPiecesInPlaybackEventListeners;
   std::list<Callback<void> > m_playbackFinishedEventListeners;
+  std::list<Callback<void, uint32_t, uint32_t > > m_playbackSeekEventListeners;
 
 // Constructors etc.
 public:
@@ -144,6 +149,45 @@ public:
    */
   void SetPreBufferingTime (Time preBufferingTime);
 
+  /**
+   * @returns true, if fast start is enabled.
+   */
+  bool GetFastStart () const;
+
+  /**
+   * \brief Enable or disable fast start.
+   *
+   * If enabled, the part selection strategy stripes the blocks of the pieces within the pre-buffering time from the playback position
+   * across all peers while the client is buffering, and temporarily deepens the request pipeline of each peer (see PartSelectionStrategyBase::IsFastStart).
+   * Playback then starts or resumes as soon as these pieces are available, which shortens the time until the first frame, in particular for new viewers.
+   *
+   * @param fastStart the desired fast start setting. Default is false.
+   */
+  void SetFastStart (bool fastStart);
+
+  /**
+   * @returns the buffered playback time below which the part selection strategy resumes requesting beyond the buffer target.
+   */
+  Time GetBufferLowWatermark () const;
+
+  /**
+   * @returns the buffered playback time at which the part selection strategy stops requesting beyond the buffer target, or zero if downloading is not throttled.
+   */
+  Time GetBufferHighWatermark () const;
+
+  /**
+   * \brief Throttle downloading according to the buffered playback time.
+   *
+   * While the client is playing, the part selection strategy stops requesting pieces beyond the high watermark from the playback position
+   * (and pieces before the playback position) once the video is continously available for the high watermark from the playback position.
+   * Requesting resumes when the continously available playback time falls to the low watermark (see PartSelectionStrategyBase::IsThrottled).
+   * Clients with a healthy buffer thereby leave the upload capacity of their peers to clients that are about to stall.
+   *
+   * @param lowWatermark the buffered playback time at which requesting resumes. Clamped to the high watermark.
+   * @param highWatermark the buffered playback time at which requesting is paused. Zero disables throttling. Default is zero.
+   */
+  void SetBufferWatermarks (Time lowWatermark, Time highWatermark);
+
   /**
    * @returns true, if auto play is enabled.
    */
@@ -248,6 +292,11 @@ public:
    */
   bool IsPaused () const;
 
+  /**
+   * @returns true, if video playback is currently paused for buffering, i.e., until enough data for playback is available.
+   */
+  bool IsBuffering () const;
+
   /**
    * @returns the length of the remaining pause, if any. May be used to obtain the remaining time that a video is paused for buffering reasons.
    */
@@ -368,15 +417,28 @@ public:
 public:
 
   /**
-   * @returns the first time stamp period represented by the given piece.
+   * @returns the first time stamp period represented by the given piece. If the torrent comes with a piece timestamp index
+   * (see MediaData::HasPieceTimestamps), the time stamp is looked up in the index; else, a constant bitrate is assumed.
    */
   Time PieceToTime (uint32_t piece) const;
 
   /**
-   * @returns the index of the piece that contains the given video playback time.
+   * @returns the index of the piece that contains the given video playback time. Like PieceToTime, this uses the piece timestamp index, if available.
    */
   uint32_t TimeToPiece (Time time) const;
 
+  /**
+   * @returns the playback time of the given number of pieces, starting at the given piece. Use this instead of PieceToTime (count)
+   * for relative lengths, since pieces of a VBR video differ in playback time.
+   */
+  Time PiecesToDuration (uint32_t piece, uint32_t count) const;
+
+  /**
+   * @returns the number of pieces (beyond the given piece) that the given playback time, starting at the given piece, reaches into.
+   * The relative counterpart to TimeToPiece.
+   */
+  uint32_t DurationToPieces (uint32_t piece, Time duration) const;
+
 // Events (protected, as only triggered internally)
 protected:
 
@@ -422,6 +484,17 @@ protected:
    */
   void PlaybackFinishedEvent ();
 
+  /**
+   * \brief Informs interested strategies that the playback position jumped, i.e., changed other than by automatic playback.
+   *
+   * This event is triggered after the PlaybackPositionChangedEvent for changes by the SetPlaybackPosition and SetPlaybackPositionRelative
+   * methods (including the ones issued by the Play method and skips during playback) that move the playback position to another piece.
+   *
+   * @param oldPiece the piece at the playback position before the jump.
+   * @param newPiece the piece at the playback position after the jump.
+   */
+  void PlaybackSeekEvent (uint32_t oldPiece, uint32_t newPiece);
+
 // Event listeners
 public:
   void RegisterCallbackPlaybackStateChangedEvent (Callback<void> eventCallback);
@@ -436,6 +509,8 @@ public:
   void UnregisterCallbackSkippedPiecesInPlaybackEvent (Callback<void, uint32_t, uint32_t > eventCallback);
   void RegisterCallbackPlaybackFinishedEvent (Callback<void> eventCallback);
   void UnregisterCallbackPlaybackFinishedEvent (Callback<void> eventCallback);
+  void RegisterCallbackPlaybackSeekEvent (Callback<void, uint32_t, uint32_t > eventCallback);
+  void UnregisterCallbackPlaybackSeekEvent (Callback<void, uint32_t, uint32_t > eventCallback);
 
 // Internal methods
 protected:
@@ -444,6 +519,17 @@ protected:
   void UnPauseAfterBuffering ();
   /// @endcond HIDDEN
 
+  /**
+   * \brief Enter the pre-buffering phase before playback starts or resumes at the given piece.
+   *
+   * Without fast start, playback is paused for the remaining pre-buffering time (see BufferFor). With fast start, it is paused only until
+   * the pieces within the pre-buffering time from the given piece are available (see BufferRange), so that fetching them faster also starts playback earlier.
+   *
+   * @param piece the piece at which playback starts or resumes.
+   * @param preBufferingTimeLeft the part of the pre-buffering time not yet covered by available pieces.
+   */
+  void BufferPreBufferingRange (uint32_t piece, Time preBufferingTimeLeft);
+
   /**
    * \brief The main pseudo-play method.
    *
@@ -26,11 +26,12 @@
 
 #include "PushPullVideoClient.h"
 #include "PushPullPeer.h"
+#include "ns3/GlobalMetricsGatherer.h"
 
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
 
-#include <map>
+#include <algorithm>
 
 namespace ns3 {
 namespace pushpull {
@@ -48,11 +49,15 @@ PushPullVideoMetricsBase::~PushPullVideoMetricsBase ()
 void PushPullVideoMetricsBase::DoInitialize ()
 {
   // Register for the different events the client issues
-  m_myVideoClient->RegisterCallbackGatherMetricsEvent (MakeCallback (&PushPullVideoMetricsBase::ReturnPeriodicMetrics, this));
+  m_myVideoClient->RegisterCallbackUpdateMetricChannelsEvent (MakeCallback (&PushPullVideoMetricsBase::UpdateMetricChannels, this));
 
   m_myVideoClient->RegisterCallbackPlaybackPositionWillChangePeriodicallyEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPlaybackPositionWillChangePeriodicallyEvent, this));
   m_myVideoClient->RegisterCallbackPlaybackPositionChangedEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPlaybackPositionChangedEvent, this));
   m_myVideoClient->RegisterCallbackPlaybackStateChangedEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPlaybackStateChangedEvent, this));
+  m_myVideoClient->RegisterCallbackCannotAdvancePlaybackEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessCannotAdvancePlaybackEvent, this));
+  m_myVideoClient->RegisterCallbackPlaybackFinishedEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPlaybackFinishedEvent, this));
+  m_myVideoClient->RegisterCallbackPieceRequestedEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPieceRequestedEvent, this));
+  m_myVideoClient->RegisterCallbackPieceCompleteEvent (MakeCallback (&PushPullVideoMetricsBase::ProcessPieceCompleteEvent, this));
 
   // Initialize the fluency metric
   m_bufferStart = m_bufferEnd = Simulator::Now ();
@@ -61,6 +66,25 @@ void PushPullVideoMetricsBase::DoInitialize ()
   m_missedrateNumerator = m_missedrateDenominator = 0;
   m_countRate = 0;
   m_missedratePeriod = m_playbackPosition = MilliSeconds (0);
+
+  // Initialize the startup delay, stall and piece latency metrics
+  m_awaitingStartup = false;
+  m_stalled = false;
+  m_stallCount = 0;
+  m_pieceRequestedAt.assign (m_myVideoClient->GetTorrent ()->GetNumberOfPieces (), -1);
+
+  // Register the metric channels
+  MetricChannelRegistry& channels = m_myVideoClient->GetMetricChannels ();
+  m_fluencyChannel = channels.RegisterGauge ("fluency");
+  m_missedrateChannel = channels.RegisterGauge ("missedrate");
+  m_startupDelayChannel = channels.RegisterGauge ("startup-delay-ms");
+  m_stallCountChannel = channels.RegisterGauge ("stall-count");
+  m_stallDurationChannels[0] = channels.RegisterGauge ("stall-duration-ms.p50");
+  m_stallDurationChannels[1] = channels.RegisterGauge ("stall-duration-ms.p95");
+  m_stallDurationChannels[2] = channels.RegisterGauge ("stall-duration-ms.p99");
+  m_pieceLatencyChannels[0] = channels.RegisterGauge ("piece-latency-ms.p50");
+  m_pieceLatencyChannels[1] = channels.RegisterGauge ("piece-latency-ms.p95");
+  m_pieceLatencyChannels[2] = channels.RegisterGauge ("piece-latency-ms.p99");
 }
 
 void PushPullVideoMetricsBase::ProcessPlaybackPositionWillChangePeriodicallyEvent ()
@@ -70,6 +94,17 @@ void PushPullVideoMetricsBase::ProcessPlaybackPositionWillChangePeriodicallyEven
 
 void PushPullVideoMetricsBase::ProcessPlaybackPositionChangedEvent (Time newPosition)
 {
+  // Process the startup delay: The first periodic advance ends the startup phase; the time not spent playing the video was spent waiting
+  if (m_awaitingStartup && m_periodicPositionChangeAnnounced)
+    {
+      Time startupDelay = Simulator::Now () - m_playRequestedAt - newPosition;
+      double startupDelayMs = std::max (static_cast<int64_t> (0), startupDelay.GetMilliSeconds ());
+
+      m_startupDelay.Add (startupDelayMs);
+      GlobalMetricsGatherer::GetInstance ()->AddQuantileSample ("startup-delay-ms", startupDelayMs);
+      m_awaitingStartup = false;
+    }
+
   // Process the fluency metric
   if (!m_periodicPositionChangeAnnounced)
     {
@@ -94,6 +129,23 @@ void PushPullVideoMetricsBase::ProcessPlaybackPositionChangedEvent (Time newPosi
 
 void PushPullVideoMetricsBase::ProcessPlaybackStateChangedEvent ()
 {
+  // Process the startup delay and stall metrics: A (re-)started playback begins a new startup phase, resumed playback ends a stall
+  if (m_myVideoClient->IsPlaying () && !m_myVideoClient->IsPaused ())
+    {
+      if (!m_awaitingStartup && !m_stalled && m_myVideoClient->GetPlaybackPosition ().IsZero ())
+        {
+          m_playRequestedAt = Simulator::Now ();
+          m_awaitingStartup = true;
+          m_stallCount = 0;
+        }
+      EndStall ();
+    }
+  else if (!m_myVideoClient->IsPlaying ())
+    {
+      EndStall ();
+      m_awaitingStartup = false;
+    }
+
   if (m_myVideoClient->IsPlaying ())
     {
       // Process the fluency metric
@@ -113,42 +165,98 @@ void PushPullVideoMetricsBase::ProcessPlaybackStateChangedEvent ()
     }
 }
 
-std::map<std::string, std::string> PushPullVideoMetricsBase::ReturnPeriodicMetrics ()
+void PushPullVideoMetricsBase::UpdateMetricChannels ()
 {
-  // Step 1: Prepare the result
-  std::map<std::string, std::string> result;
+  MetricChannelRegistry& channels = m_myVideoClient->GetMetricChannels ();
 
-  // Step 2: Add the fluency metric
+  // Step 1: Update the fluency metric
   if (!m_fluencyDenominator.IsZero ())
     {
-      result["fluency"] = lexical_cast<std::string> (m_fluencyNumerator.GetMilliSeconds () / m_fluencyDenominator.GetMilliSeconds ());
+      channels.Set (m_fluencyChannel, static_cast<double> (m_fluencyNumerator.GetMilliSeconds ()) / m_fluencyDenominator.GetMilliSeconds ());
+    }
+  else
+    {
+      channels.Clear (m_fluencyChannel);
+    }
+
+  // Step 2: Update the missed rate metric
+  if (m_missedrateDenominator > 0)
+    {
+      channels.Set (m_missedrateChannel, static_cast<double> (m_missedrateNumerator) / m_missedrateDenominator);
     }
   else
     {
-      result["fluency"] = "div/0";
+      channels.Clear (m_missedrateChannel);
+    }
+
+  // Step 3: Update the startup delay and stall metrics
+  if (m_startupDelay.GetCount () > 0)
+    {
+      channels.Set (m_startupDelayChannel, m_startupDelay.GetMax ());
     }
+  channels.Set (m_stallCountChannel, m_stallCount);
 
-  // Last step: Return the result
-  return result;
+  // Step 4: Update the percentiles of the stall duration and the piece download latency
+  const double quantiles[3] = { 0.5, 0.95, 0.99 };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      if (m_stallDuration.GetCount () > 0)
+        {
+          channels.Set (m_stallDurationChannels[i], m_stallDuration.GetQuantile (quantiles[i]));
+        }
+      if (m_pieceLatency.GetCount () > 0)
+        {
+          channels.Set (m_pieceLatencyChannels[i], m_pieceLatency.GetQuantile (quantiles[i]));
+        }
+    }
+}
+
+void PushPullVideoMetricsBase::ProcessCannotAdvancePlaybackEvent ()
+{
+  // Buffering before the first advance of playback is part of the startup delay, not a stall
+  if (!m_awaitingStartup && !m_stalled)
+    {
+      m_stalled = true;
+      m_stallStart = Simulator::Now ();
+      ++m_stallCount;
+    }
 }
 
-std::map<std::string, std::string> PushPullVideoMetricsBase::ReturnMissedRateMetrics ()
+void PushPullVideoMetricsBase::ProcessPlaybackFinishedEvent ()
 {
-  // Step 1: Prepare the result
-  std::map<std::string, std::string> result;
+  GlobalMetricsGatherer::GetInstance ()->AddQuantileSample ("stall-count", m_stallCount);
+}
 
-  // Step 2: Add the missed rate metric
-  if (m_missedrateDenominator > 0)
+void PushPullVideoMetricsBase::ProcessPieceRequestedEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  if (pieceIndex < m_pieceRequestedAt.size () && m_pieceRequestedAt[pieceIndex] < 0)
     {
-      result["missedrate"] = lexical_cast<std::string> (m_missedrateNumerator / m_missedrateDenominator);
+      m_pieceRequestedAt[pieceIndex] = Simulator::Now ().GetMilliSeconds ();
     }
-  else
+}
+
+void PushPullVideoMetricsBase::ProcessPieceCompleteEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  if (pieceIndex < m_pieceRequestedAt.size () && m_pieceRequestedAt[pieceIndex] >= 0)
     {
-      result["missedrate"] = "div/0";
+      double latencyMs = Simulator::Now ().GetMilliSeconds () - m_pieceRequestedAt[pieceIndex];
+      m_pieceRequestedAt[pieceIndex] = -1;
+
+      m_pieceLatency.Add (latencyMs);
+      GlobalMetricsGatherer::GetInstance ()->AddQuantileSample ("piece-latency-ms", latencyMs);
     }
+}
 
-  // Last step: Return the result
-  return result;
+void PushPullVideoMetricsBase::EndStall ()
+{
+  if (m_stalled)
+    {
+      double stallDurationMs = (Simulator::Now () - m_stallStart).GetMilliSeconds ();
+      m_stalled = false;
+
+      m_stallDuration.Add (stallDurationMs);
+      GlobalMetricsGatherer::GetInstance ()->AddQuantileSample ("stall-duration-ms", stallDurationMs);
+    }
 }
 
 } // ns pushpull
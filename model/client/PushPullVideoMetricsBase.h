@@ -24,11 +24,14 @@
 #define PUSHPULLVIDEOMETRICS_H_
 
 #include "AbstractStrategy.h"
+#include "MetricChannelRegistry.h"
 #include "PushPullVideoClient.h"
 
+#include "ns3/QuantileSketch.h"
+
 #include "ns3/nstime.h"
 
-#include <map>
+#include <vector>
 
 namespace ns3 {
 namespace pushpull {
@@ -42,6 +45,10 @@ namespace pushpull {
  * protocols that use statistical information for parameter adaption.
  *
  * The class as an example includes an implementation of the Fluency metric introduced by Huang et.al. in their <a href="http://dx.doi.org/10.1145/1402958.1403001" target="_blank">2008 SIGCOMM paper</a>.
+ *
+ * Additionally, the class records the distributions of the startup delay, the duration of stalls (buffering phases after playback has started),
+ * the number of stalls per playback and the piece download latency (first request to completion) in QuantileSketch instances.
+ * Each value is recorded both client-locally (announced as p50/p95/p99 gauges) and in the simulation-wide distributions of the GlobalMetricsGatherer.
  */
 class PushPullVideoMetricsBase : public AbstractStrategy
 {
@@ -57,6 +64,29 @@ private:
   Time m_bufferStart, m_bufferEnd, m_playbackStart, m_playbackEnd, m_playbackPosition, m_missedratePeriod;
   Time m_fluencyNumerator, m_fluencyDenominator;
 
+  // Missed rate metric
+  uint32_t m_missedrateNumerator, m_missedrateDenominator, m_countRate;
+
+  // Startup delay and stall metrics
+  Time     m_playRequestedAt;          // When playback was started
+  bool     m_awaitingStartup;          // Whether playback was started but has not yet advanced
+  bool     m_stalled;                  // Whether playback is currently stalled
+  Time     m_stallStart;               // When the current stall began
+  uint32_t m_stallCount;               // The number of stalls during the current playback
+
+  // Piece download latency
+  std::vector<int64_t> m_pieceRequestedAt;   // Time (in ms) of the first request for each piece not yet completed; -1 if not requested
+
+  QuantileSketch m_startupDelay, m_stallDuration, m_pieceLatency;
+
+  // Metric channels registered with the client
+  MetricChannelRegistry::ChannelId m_fluencyChannel;
+  MetricChannelRegistry::ChannelId m_missedrateChannel;
+  MetricChannelRegistry::ChannelId m_startupDelayChannel;
+  MetricChannelRegistry::ChannelId m_stallCountChannel;
+  MetricChannelRegistry::ChannelId m_stallDurationChannels[3];   // p50, p95, p99
+  MetricChannelRegistry::ChannelId m_pieceLatencyChannels[3];    // p50, p95, p99
+
 // Constructors etc.
 public:
   PushPullVideoMetricsBase (Ptr<PushPullClient> myClient);
@@ -73,16 +103,40 @@ public:
    */
   virtual void ProcessPlaybackStateChangedEvent ();
 
+  /**
+   * \brief Mark the beginning of a stall if playback cannot advance after it has started.
+   */
+  virtual void ProcessCannotAdvancePlaybackEvent ();
+
+  /**
+   * \brief Record the number of stalls of the finished playback in the simulation-wide distribution.
+   */
+  virtual void ProcessPlaybackFinishedEvent ();
+
+  /**
+   * \brief Remember the time of the first request for a piece.
+   */
+  virtual void ProcessPieceRequestedEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
+  /**
+   * \brief Record the download latency of a completed piece.
+   */
+  virtual void ProcessPieceCompleteEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
 // Public methods for accessing the measured metrics
 public:
   /**
-   * \brief Return the collected periodic metrics.
+   * \brief Update the metric channels of this class (e.g., the "fluency" and "missedrate" gauges) with the current values.
    *
-   * The up-to-dateness of the periodic metrics depends on their specific implementation.
-   *
-   * @returns a map containing the last values of the collected periodic metrics
+   * Called periodically by the client before it announces its metric channels. A gauge is cleared while its metric is undefined
+   * (i.e., no playback has happened yet).
    */
-  std::map<std::string, std::string> ReturnPeriodicMetrics ();
+  void UpdateMetricChannels ();
+
+// Internal methods
+protected:
+  // End the current stall, if any, and record its duration
+  void EndStall ();
 };
 
 } // ns pushpull
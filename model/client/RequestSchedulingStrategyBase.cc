@@ -53,16 +53,36 @@ void RequestSchedulingStrategyBase::DoInitialize ()
 
 void RequestSchedulingStrategyBase::ProcessPeerRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
 {
-  // Only send out if we are not choking the peer...
-  if (!peer->GetAmChoking ())
+  if (AcceptRequest (peer, pieceIndex, blockOffset, blockLength))
     {
-      // and if the requested piece (and hence, the block) is available
-      if ((*m_myClient->GetBitfield ())[pieceIndex / 8] & (0x01 << (7 - pieceIndex % 8)))
-        {
-          peer->SendBlock (pieceIndex, blockOffset, blockLength);
-        }
+      peer->SendBlock (pieceIndex, blockOffset, blockLength, ClassifyRequest (peer, pieceIndex, blockOffset, blockLength));
     }
 }
 
+bool RequestSchedulingStrategyBase::AcceptRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  // Only send out if we are not choking the peer (or allow it to request the piece anyway)...
+  // and if the requested piece (and hence, the block) is available
+  if ((!peer->GetAmChoking () || peer->GetAmAllowingFast (pieceIndex))
+      && pieceIndex < m_myClient->GetTorrent ()->GetNumberOfPieces ()
+      && ((*m_myClient->GetBitfield ())[pieceIndex / 8] & (0x01 << (7 - pieceIndex % 8))))
+    {
+      return true;
+    }
+
+  peer->RejectRequest (pieceIndex, blockOffset, blockLength);
+  return false;
+}
+
+Peer::SendClass RequestSchedulingStrategyBase::ClassifyRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  if (pieceIndex < peer->GetFirstMissingPiece () + PP_PEER_URGENT_PIECE_WINDOW)
+    {
+      return Peer::SEND_CLASS_URGENT_DATA;
+    }
+
+  return Peer::SEND_CLASS_BULK_DATA;
+}
+
 } // ns pushpull
 } // ns ns3
@@ -41,8 +41,9 @@ class Peer;
  * You may override or add handler functions for events generated by the PushPullClient class and derivated classes to implement other
  * or additional behavior, such as upload traffic shaping.
  *
- * The base implementation checks whether the requesting client is currently unchoked. If so, it directly initiates a transfer of the piece
- * to the requester; else, it silently drops the request.
+ * The base implementation checks whether the requesting client is currently unchoked (or allowed to request the piece while being choked,
+ * see Peer::GetAmAllowingFast). If so, it directly initiates a transfer of the piece to the requester; else, it rejects the request, which is
+ * a silent drop without the Fast Extension.
  */
 class RequestSchedulingStrategyBase : public AbstractStrategy
 {
@@ -66,6 +67,27 @@ public:
    * @param blockLength the length of the requested block.
    */
   virtual void ProcessPeerRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+// Strategy implementation methods
+protected:
+  /**
+   * \brief Check whether a request may be served, i.e., whether the requester is unchoked or allowed to request the piece fast, and whether
+   * the piece is available. Requests that may not be served are rejected (see Peer::RejectRequest).
+   *
+   * @returns true, if the request may be served.
+   */
+  virtual bool AcceptRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Determine the class in which the answer to a request is sent (see Peer::SendBlock).
+   *
+   * The base implementation sends blocks of pieces within PP_PEER_URGENT_PIECE_WINDOW pieces from the first piece the requester is
+   * missing as urgent data, since a streaming client needs these pieces first; all other blocks are sent as bulk data. The first missing
+   * piece is tracked incrementally by the peer (see Peer::GetFirstMissingPiece), so classifying a request does not scan the whole bitfield.
+   *
+   * @returns the class of the PIECE message answering the request.
+   */
+  virtual Peer::SendClass ClassifyRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
 };
 
 } // ns pushpull
@@ -0,0 +1,363 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "DeadlineRequestSchedulingStrategy.h"
+
+#include "ns3/PushPullClient.h"
+#include "ns3/PushPullDefines.h"
+#include "ns3/PushPullPeer.h"
+#include "ns3/PushPullVideoClient.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace pushpull {
+
+NS_LOG_COMPONENT_DEFINE ("pushpull::DeadlineRequestSchedulingStrategy");
+NS_OBJECT_ENSURE_REGISTERED (DeadlineRequestSchedulingStrategy);
+
+DeadlineRequestSchedulingStrategy::DeadlineRequestSchedulingStrategy (Ptr<PushPullClient> myClient) : RequestSchedulingStrategyBase (myClient)
+{
+  m_myVideoClient = DynamicCast<PushPullVideoClient> (myClient);
+  m_dispatching = false;
+  m_lastHintPosition = 0;
+  m_lastHintPlaying = false;
+}
+
+DeadlineRequestSchedulingStrategy::~DeadlineRequestSchedulingStrategy ()
+{
+}
+
+void DeadlineRequestSchedulingStrategy::DoInitialize ()
+{
+  // The base class registers the (overridden) request handler
+  RequestSchedulingStrategyBase::DoInitialize ();
+
+  m_myClient->RegisterCallbackCancelEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPeerCancelEvent, this));
+  m_myClient->RegisterCallbackBlockUploadCompleteEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPeerBlockUploadCompleteEvent, this));
+  m_myClient->RegisterCallbackConnectionCloseEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessConnectionCloseEvent, this));
+  m_myClient->RegisterCallbackBitfieldReceivedEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPeerBitfieldReceivedEvent, this));
+  m_myClient->RegisterCallbackExtensionMessageEvent (PP_PROTOCOL_EXTENSION_MESSAGE_ID_PLAYBACK_DEADLINE,
+                                                     MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPlaybackDeadlineMessage, this));
+
+  // Only video clients have playback deadlines to announce
+  if (m_myVideoClient)
+    {
+      m_myVideoClient->RegisterCallbackPlaybackPositionChangedEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPlaybackPositionChangedEvent, this));
+      m_myVideoClient->RegisterCallbackPlaybackStateChangedEvent (MakeCallback (&DeadlineRequestSchedulingStrategy::ProcessPlaybackStateChangedEvent, this));
+    }
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPeerRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  // Step 1: Only queue requests the base class would serve
+  if (!AcceptRequest (peer, pieceIndex, blockOffset, blockLength))
+    {
+      return;
+    }
+
+  // Step 2: Queue the request by its deadline
+  PendingRequest request;
+  request.m_pieceIndex = pieceIndex;
+  request.m_blockOffset = blockOffset;
+  request.m_blockLength = blockLength;
+
+  std::map<Ptr<Peer>, PeerQueue>::iterator peerIt = m_peerQueues.find (peer);
+  if (peerIt == m_peerQueues.end ())
+    {
+      PeerQueue queue;
+      queue.m_deficit = 0;
+      peerIt = m_peerQueues.insert (std::make_pair (peer, queue)).first;
+    }
+  if ((*peerIt).second.m_requests.empty ())
+    {
+      m_activePeers.push_back (peer);
+    }
+  (*peerIt).second.m_requests.insert (std::make_pair (GetDeadline (peer, pieceIndex), request));
+
+  // Step 3: Send out what the backlog limit permits
+  Dispatch ();
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPeerCancelEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  std::map<Ptr<Peer>, PeerQueue>::iterator peerIt = m_peerQueues.find (peer);
+  if (peerIt == m_peerQueues.end ())
+    {
+      return;
+    }
+
+  RequestsByDeadline &requests = (*peerIt).second.m_requests;
+  for (RequestsByDeadline::iterator it = requests.begin (); it != requests.end (); ++it)
+    {
+      if ((*it).second.m_pieceIndex == pieceIndex && (*it).second.m_blockOffset == blockOffset && (*it).second.m_blockLength == blockLength)
+        {
+          // With the Fast Extension, cancelled requests are answered by a rejection, as they would be by the peer
+          requests.erase (it);
+          peer->RejectRequest (pieceIndex, blockOffset, blockLength);
+          break;
+        }
+    }
+
+  if (requests.empty ())
+    {
+      m_activePeers.remove (peer);
+    }
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPeerBlockUploadCompleteEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  Dispatch ();
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessConnectionCloseEvent (Ptr<Peer> peer)
+{
+  m_peerQueues.erase (peer);
+  m_activePeers.remove (peer);
+  m_playbackHints.erase (peer);
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPeerBitfieldReceivedEvent (Ptr<Peer> peer)
+{
+  if (m_myVideoClient)
+    {
+      SendPlaybackHint (peer);
+    }
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPlaybackDeadlineMessage (Ptr<Peer> peer, const std::string &content)
+{
+  if (content.size () < 9)
+    {
+      NS_LOG_INFO ("DeadlineRequestSchedulingStrategy: Received a malformed playback hint from " << peer->GetRemoteIp () << ".");
+      return;
+    }
+
+  const uint8_t* data = reinterpret_cast<const uint8_t*> (content.data ());
+  uint32_t playbackPosition = (static_cast<uint32_t> (data[0]) << 24) | (static_cast<uint32_t> (data[1]) << 16) | (static_cast<uint32_t> (data[2]) << 8) | data[3];
+  uint32_t microSecondsPerPiece = (static_cast<uint32_t> (data[4]) << 24) | (static_cast<uint32_t> (data[5]) << 16) | (static_cast<uint32_t> (data[6]) << 8) | data[7];
+
+  PlaybackHint hint;
+  hint.m_receptionTime = Simulator::Now ();
+  hint.m_playbackPosition = playbackPosition;
+  hint.m_milliSecondsPerPiece = microSecondsPerPiece / 1000.0;
+  hint.m_playing = data[8] & 0x01;
+  m_playbackHints[peer] = hint;
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPlaybackPositionChangedEvent (Time position)
+{
+  // Step 1: While playing, the peers extrapolate the playback position, so hints are only needed if the position deviates by a piece or more (e.g., after seeks)
+  bool playing = m_myVideoClient->IsPlaying () && !m_myVideoClient->IsPaused ();
+  int64_t expectedPosition = m_lastHintPosition;
+  if (m_lastHintPlaying)
+    {
+      expectedPosition += (Simulator::Now () - m_lastHintTime).GetMilliSeconds ();
+    }
+  if (playing == m_lastHintPlaying
+      && std::abs (static_cast<double> (position.GetMilliSeconds () - expectedPosition)) < std::max (m_myVideoClient->PieceToTime (m_myVideoClient->GetCurrentPiece () + 1).GetMilliSeconds ()
+                                                                                                   - m_myVideoClient->PieceToTime (m_myVideoClient->GetCurrentPiece ()).GetMilliSeconds (), static_cast<int64_t> (1)))
+    {
+      return;
+    }
+
+  // Step 2: Send the new hint to all peers
+  for (std::vector<Ptr<Peer> >::const_iterator it = m_myClient->GetPeerListIterator (); it != m_myClient->GetPeerListEnd (); ++it)
+    {
+      SendPlaybackHint (*it);
+    }
+}
+
+void DeadlineRequestSchedulingStrategy::ProcessPlaybackStateChangedEvent ()
+{
+  ProcessPlaybackPositionChangedEvent (m_myVideoClient->GetPlaybackPosition ());
+}
+
+void DeadlineRequestSchedulingStrategy::Dispatch ()
+{
+  // Handing blocks to peers may trigger further events that would call this method again
+  if (m_dispatching)
+    {
+      return;
+    }
+  m_dispatching = true;
+
+  // Step 1: Determine the data not yet acknowledged by the peers
+  uint32_t backlog = 0;
+  for (std::vector<Ptr<Peer> >::const_iterator it = m_myClient->GetPeerListIterator (); it != m_myClient->GetPeerListEnd (); ++it)
+    {
+      backlog += (*it)->GetSendBacklog ();
+    }
+
+  const int64_t urgentCredit = -static_cast<int64_t> (PP_UPLOAD_SCHEDULER_URGENT_CREDIT) * PP_UPLOAD_SCHEDULER_QUANTUM;
+  while (backlog < PP_UPLOAD_SCHEDULER_MAX_BACKLOG && !m_activePeers.empty ())
+    {
+      // Step 2: Blocks due soon go first, earliest deadline first, as long as their peer has not overdrawn its credit
+      Time urgentDeadline = Simulator::Now () + MilliSeconds (PP_UPLOAD_SCHEDULER_URGENT_HORIZON);
+      std::map<Ptr<Peer>, PeerQueue>::iterator urgentIt = m_peerQueues.end ();
+      for (std::list<Ptr<Peer> >::const_iterator it = m_activePeers.begin (); it != m_activePeers.end (); ++it)
+        {
+          std::map<Ptr<Peer>, PeerQueue>::iterator peerIt = m_peerQueues.find (*it);
+          Time deadline = (*(*peerIt).second.m_requests.begin ()).first;
+          if (deadline < urgentDeadline && (*peerIt).second.m_deficit > urgentCredit)
+            {
+              urgentDeadline = deadline;
+              urgentIt = peerIt;
+            }
+        }
+
+      if (urgentIt != m_peerQueues.end ())
+        {
+          backlog += (*(*urgentIt).second.m_requests.begin ()).second.m_blockLength;
+          SendNextBlock (urgentIt);
+          continue;
+        }
+
+      // Step 3: Otherwise, the peer whose turn it is sends if its deficit suffices; else, it receives its quantum and the next peer's turn begins
+      std::map<Ptr<Peer>, PeerQueue>::iterator peerIt = m_peerQueues.find (m_activePeers.front ());
+      uint32_t blockLength = (*(*peerIt).second.m_requests.begin ()).second.m_blockLength;
+      if ((*peerIt).second.m_deficit < static_cast<int64_t> (blockLength))
+        {
+          (*peerIt).second.m_deficit += PP_UPLOAD_SCHEDULER_QUANTUM;
+          m_activePeers.push_back (m_activePeers.front ());
+          m_activePeers.pop_front ();
+          continue;
+        }
+
+      backlog += blockLength;
+      SendNextBlock (peerIt);
+    }
+
+  m_dispatching = false;
+
+  // Step 4: Blocks held back due to the backlog limit are dispatched once the peers acknowledged some data
+  if (!m_activePeers.empty () && !m_nextDispatchEvent.IsRunning ())
+    {
+      m_nextDispatchEvent = Simulator::Schedule (MilliSeconds (PP_UPLOAD_SCHEDULER_INTERVAL), &DeadlineRequestSchedulingStrategy::Dispatch, this);
+    }
+}
+
+void DeadlineRequestSchedulingStrategy::SendNextBlock (std::map<Ptr<Peer>, PeerQueue>::iterator peerIt)
+{
+  Ptr<Peer> peer = (*peerIt).first;
+  PeerQueue &queue = (*peerIt).second;
+
+  // Disconnected peers lose their pending requests; those of peers choked in the meantime are rejected, unless allowed fast
+  if (peer->GetConnectionState () != Peer::CONN_STATE_CONNECTED)
+    {
+      queue.m_requests.clear ();
+    }
+  else
+    {
+      PendingRequest request = (*queue.m_requests.begin ()).second;
+      queue.m_requests.erase (queue.m_requests.begin ());
+
+      if (peer->GetAmChoking () && !peer->GetAmAllowingFast (request.m_pieceIndex))
+        {
+          peer->RejectRequest (request.m_pieceIndex, request.m_blockOffset, request.m_blockLength);
+        }
+      else
+        {
+          queue.m_deficit -= request.m_blockLength;
+
+          peer->SendBlock (request.m_pieceIndex, request.m_blockOffset, request.m_blockLength,
+                           ClassifyRequest (peer, request.m_pieceIndex, request.m_blockOffset, request.m_blockLength));
+        }
+    }
+
+  // Idle peers do not save up their deficit, but keep an overdraft
+  if (queue.m_requests.empty ())
+    {
+      queue.m_deficit = std::min (queue.m_deficit, static_cast<int64_t> (0));
+      m_activePeers.remove (peer);
+    }
+}
+
+Time DeadlineRequestSchedulingStrategy::GetDeadline (Ptr<Peer> peer, uint32_t pieceIndex) const
+{
+  std::map<Ptr<Peer>, PlaybackHint>::const_iterator hintIt = m_playbackHints.find (peer);
+  if (hintIt == m_playbackHints.end ())
+    {
+      return Simulator::GetMaximumSimulationTime ();
+    }
+
+  // The playback position of a playing peer advances since the reception of the hint; else, the piece is due after the playback time in between
+  const PlaybackHint &hint = (*hintIt).second;
+  Time base = hint.m_playing ? hint.m_receptionTime : Simulator::Now ();
+
+  // For VBR videos, the piece timestamp index of the (shared) torrent knows when the piece starts; else, the peer's constant bitrate applies
+  int64_t pieceStart;
+  if (m_myClient->GetTorrent ()->HasPieceTimestamps ())
+    {
+      pieceStart = static_cast<int64_t> (m_myClient->GetTorrent ()->GetPieceTimestamp (pieceIndex));
+    }
+  else
+    {
+      pieceStart = static_cast<int64_t> (pieceIndex * hint.m_milliSecondsPerPiece);
+    }
+  return base + MilliSeconds (pieceStart - hint.m_playbackPosition);
+}
+
+Peer::SendClass DeadlineRequestSchedulingStrategy::ClassifyRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength)
+{
+  if (GetDeadline (peer, pieceIndex) < Simulator::Now () + MilliSeconds (PP_UPLOAD_SCHEDULER_URGENT_HORIZON))
+    {
+      return Peer::SEND_CLASS_URGENT_DATA;
+    }
+
+  return Peer::SEND_CLASS_BULK_DATA;
+}
+
+std::string DeadlineRequestSchedulingStrategy::GetPlaybackHint () const
+{
+  // Position (in milliseconds), average playback time per piece (in microseconds) and the playing flag
+  uint32_t playbackPosition = m_myVideoClient->GetPlaybackPosition ().GetMilliSeconds ();
+  uint32_t microSecondsPerPiece = m_myVideoClient->GetTotalLength ().GetMicroSeconds () / m_myClient->GetTorrent ()->GetNumberOfPieces ();
+  uint8_t playing = (m_myVideoClient->IsPlaying () && !m_myVideoClient->IsPaused ()) ? 0x01 : 0x00;
+
+  std::string content;
+  content.push_back (static_cast<char> ((playbackPosition >> 24) & 0xFF));
+  content.push_back (static_cast<char> ((playbackPosition >> 16) & 0xFF));
+  content.push_back (static_cast<char> ((playbackPosition >> 8) & 0xFF));
+  content.push_back (static_cast<char> (playbackPosition & 0xFF));
+  content.push_back (static_cast<char> ((microSecondsPerPiece >> 24) & 0xFF));
+  content.push_back (static_cast<char> ((microSecondsPerPiece >> 16) & 0xFF));
+  content.push_back (static_cast<char> ((microSecondsPerPiece >> 8) & 0xFF));
+  content.push_back (static_cast<char> (microSecondsPerPiece & 0xFF));
+  content.push_back (static_cast<char> (playing));
+
+  return content;
+}
+
+void DeadlineRequestSchedulingStrategy::SendPlaybackHint (Ptr<Peer> peer)
+{
+  m_lastHintPosition = m_myVideoClient->GetPlaybackPosition ().GetMilliSeconds ();
+  m_lastHintTime = Simulator::Now ();
+  m_lastHintPlaying = m_myVideoClient->IsPlaying () && !m_myVideoClient->IsPaused ();
+
+  peer->SendExtendedMessage (PP_PROTOCOL_EXTENSION_MESSAGE_ID_PLAYBACK_DEADLINE, GetPlaybackHint ());
+}
+
+} // ns pushpull
+} // ns ns3
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef DEADLINEREQUESTSCHEDULINGSTRATEGY_H_
+#define DEADLINEREQUESTSCHEDULINGSTRATEGY_H_
+
+#include "ns3/RequestSchedulingStrategyBase.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace ns3 {
+namespace pushpull {
+
+class PushPullClient;
+class PushPullVideoClient;
+class Peer;
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Implements an upload scheduler that serves the requests of all peers by their playback deadlines, with deficit round robin fairness.
+ *
+ * Instead of handing each request to its peer right away, the strategy holds the requests back and only hands blocks to the peers while the
+ * data not yet acknowledged by all peers stays below PP_UPLOAD_SCHEDULER_MAX_BACKLOG. Thus, the order in which the limited upload capacity is
+ * used is decided by the strategy instead of by the competing TCP connections.
+ *
+ * Video clients running this strategy inform their peers of their playback position and the playback time of a piece (Extension Protocol message
+ * id PP_PROTOCOL_EXTENSION_MESSAGE_ID_PLAYBACK_DEADLINE) whenever the playback position or state changes. From these hints, the deadline of each
+ * requested block is derived; requests of peers that did not send a hint have no deadline.
+ *
+ * Blocks are then chosen as follows:
+ * - Blocks due within PP_UPLOAD_SCHEDULER_URGENT_HORIZON are sent first, earliest deadline first, and as urgent data (see Peer::SendBlock).
+ *   Their size is charged to the deficit of their peer, which may be overdrawn by at most PP_UPLOAD_SCHEDULER_URGENT_CREDIT quanta.
+ * - All other blocks are sent in deficit round robin order among the peers with pending requests: in each round, a peer may send
+ *   PP_UPLOAD_SCHEDULER_QUANTUM bytes (plus the savings from previous rounds), earliest deadline first within the peer.
+ *
+ * Hence, a seeder's uplink is first used for the blocks that would otherwise cause stalls, while peers cannot starve each other in the long run.
+ */
+class DeadlineRequestSchedulingStrategy : public RequestSchedulingStrategyBase
+{
+// Types used
+protected:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    uint32_t m_pieceIndex;
+    uint32_t m_blockOffset;
+    uint32_t m_blockLength;
+  } PendingRequest;
+
+  typedef std::multimap<Time, PendingRequest> RequestsByDeadline;
+
+  typedef struct
+  {
+    RequestsByDeadline m_requests;            // The pending requests of the peer, ordered by their deadline
+    int64_t            m_deficit;             // The number of bytes the peer may still send in the current round of the deficit round robin
+  } PeerQueue;
+
+  typedef struct
+  {
+    Time     m_receptionTime;                 // When the hint was received
+    int64_t  m_playbackPosition;              // The playback position of the peer, in milliseconds
+    double   m_milliSecondsPerPiece;          // The playback time of a piece
+    bool     m_playing;                       // Whether the playback position advances
+  } PlaybackHint;
+  /// @endcond HIDDEN
+
+// Fields
+protected:
+  Ptr<PushPullVideoClient>               m_myVideoClient;       // The associated client as a video client, if it is one; used to send playback hints
+
+  std::map<Ptr<Peer>, PeerQueue>         m_peerQueues;          // The pending requests and the deficits, by peer
+  std::list<Ptr<Peer> >                  m_activePeers;         // The peers with pending requests, in round robin order
+  std::map<Ptr<Peer>, PlaybackHint>      m_playbackHints;       // The last playback hint received, by peer
+
+  EventId                                m_nextDispatchEvent;   // The next dispatch attempt, scheduled while blocks are held back due to the backlog limit
+  bool                                   m_dispatching;         // Whether blocks are currently being dispatched (prevents re-entrance through events triggered by sending)
+
+  int64_t                                m_lastHintPosition;    // The playback position announced in the last playback hint sent, in milliseconds
+  Time                                   m_lastHintTime;        // When the last playback hint was sent
+  bool                                   m_lastHintPlaying;     // Whether the last playback hint announced an advancing playback position
+
+// Constructors etc.
+public:
+  DeadlineRequestSchedulingStrategy (Ptr<PushPullClient> myClient);
+  virtual ~DeadlineRequestSchedulingStrategy ();
+
+  /**
+   * Initialize the strategy. Register the needed event listeners with the associated client.
+   */
+  virtual void DoInitialize ();
+
+// Event handlers
+public:
+  /**
+   * \brief Queue a request of an unchoked peer according to its deadline and dispatch blocks, if possible.
+   */
+  virtual void ProcessPeerRequestEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Remove a cancelled request that is still held back.
+   */
+  virtual void ProcessPeerCancelEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Dispatch further blocks after a block was handed over to the socket of a peer.
+   */
+  virtual void ProcessPeerBlockUploadCompleteEvent (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+  /**
+   * \brief Drop the pending requests and the playback hint of a closed connection.
+   */
+  virtual void ProcessConnectionCloseEvent (Ptr<Peer> peer);
+
+  /**
+   * \brief Send the playback hint to a peer once the connection is ready for communication.
+   */
+  virtual void ProcessPeerBitfieldReceivedEvent (Ptr<Peer> peer);
+
+  /**
+   * \brief Store the playback hint sent by a peer.
+   */
+  virtual void ProcessPlaybackDeadlineMessage (Ptr<Peer> peer, const std::string &content);
+
+  /**
+   * \brief Send the new playback hint to all peers.
+   */
+  virtual void ProcessPlaybackPositionChangedEvent (Time position);
+
+  /**
+   * \brief Send the new playback hint to all peers.
+   */
+  virtual void ProcessPlaybackStateChangedEvent ();
+
+// Strategy implementation methods
+protected:
+  /**
+   * \brief Hand blocks to their peers, in the order described above, as long as the backlog limit permits.
+   */
+  virtual void Dispatch ();
+
+  /**
+   * @returns the deadline of the given piece at the given peer, derived from the peer's playback hint, or the maximum simulation time if there is none.
+   */
+  Time GetDeadline (Ptr<Peer> peer, uint32_t pieceIndex) const;
+
+  /**
+   * \brief Classify blocks by their deadline: blocks due within PP_UPLOAD_SCHEDULER_URGENT_HORIZON are urgent data.
+   */
+  virtual Peer::SendClass ClassifyRequest (Ptr<Peer> peer, uint32_t pieceIndex, uint32_t blockOffset, uint32_t blockLength);
+
+// Internal methods
+private:
+  // Hand the earliest-due pending block of the peer to it and charge the peer's deficit
+  void SendNextBlock (std::map<Ptr<Peer>, PeerQueue>::iterator peerIt);
+
+  // Build the playback hint of the local client
+  std::string GetPlaybackHint () const;
+
+  // Send the playback hint of the local client to the peer
+  void SendPlaybackHint (Ptr<Peer> peer);
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* DEADLINEREQUESTSCHEDULINGSTRATEGY_H_ */
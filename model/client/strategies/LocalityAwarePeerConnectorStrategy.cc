@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "LocalityAwarePeerConnectorStrategy.h"
+
+#include "ns3/PushPullClient.h"
+#include "ns3/PushPullDefines.h"
+#include "ns3/NetworkLocality.h"
+
+#include "ns3/log.h"
+#include "ns3/random-variable.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+namespace pushpull {
+
+NS_LOG_COMPONENT_DEFINE ("pushpull::LocalityAwarePeerConnectorStrategy");
+NS_OBJECT_ENSURE_REGISTERED (LocalityAwarePeerConnectorStrategy);
+
+LocalityAwarePeerConnectorStrategy::LocalityAwarePeerConnectorStrategy (Ptr<PushPullClient> myClient) : PeerConnectorStrategyBase (myClient)
+{
+  m_explorationFraction = PP_PEER_CONNECTOR_LOCALITY_EXPLORATION_FRACTION;
+}
+
+LocalityAwarePeerConnectorStrategy::~LocalityAwarePeerConnectorStrategy ()
+{
+}
+
+void LocalityAwarePeerConnectorStrategy::DoInitialize ()
+{
+  PeerConnectorStrategyBase::DoInitialize ();
+
+  m_myClient->RegisterCallbackStrategyOptionsChangedEvent (MakeCallback (&LocalityAwarePeerConnectorStrategy::ProcessStrategyOptionsChangedEvent, this));
+}
+
+void LocalityAwarePeerConnectorStrategy::SelectPeersToConnect (uint16_t count, std::vector<std::pair<uint32_t, uint16_t> > &selection)
+{
+  // Step 1: Gather the clients we may connect to; if there are not more of them than needed, no ranking is necessary
+  std::vector<std::pair<uint32_t, uint16_t> > candidates;
+  candidates.reserve (m_potentialClientsList.size ());
+  for (std::vector<std::pair<uint32_t, uint16_t> >::const_iterator it = m_potentialClientsList.begin (); it != m_potentialClientsList.end (); ++it)
+    {
+      if (!IsConnectedOrPending ((*it).first))
+        {
+          candidates.push_back (*it);
+        }
+    }
+
+  if (candidates.size () <= count)
+    {
+      selection.insert (selection.end (), candidates.begin (), candidates.end ());
+      return;
+    }
+
+  // Step 2: Draw the exploration sample; each draw takes constant time since the drawn candidate is replaced by the last one
+  UniformVariable uv;
+  uint16_t explore = static_cast<uint16_t> (count * m_explorationFraction + 0.5);
+  for (; explore > 0; --explore, --count)
+    {
+      uint32_t drawn = uv.GetInteger (0, candidates.size () - 1);
+      selection.push_back (candidates[drawn]);
+      candidates[drawn] = candidates.back ();
+      candidates.pop_back ();
+    }
+
+  if (count == 0)
+    {
+      return;
+    }
+
+  // Step 3: Rank the remaining candidates by estimated round-trip time; the random tie breaker keeps clients behind the same router from all choosing the same peers
+  NetworkLocality *locality = NetworkLocality::GetInstance ();
+  uint32_t myAddress = m_myClient->GetIp ().Get ();
+
+  std::vector<std::pair<std::pair<int64_t, uint32_t>, uint32_t> > ranking;
+  ranking.reserve (candidates.size ());
+  for (uint32_t i = 0; i < candidates.size (); ++i)
+    {
+      int64_t roundTripTime = locality->EstimateRoundTripTime (myAddress, candidates[i].first).GetMicroSeconds ();
+      ranking.push_back (std::make_pair (std::make_pair (roundTripTime, uv.GetInteger (0, 0x7fffffff)), i));
+    }
+
+  // Step 4: Only the best candidates need to be sorted
+  std::partial_sort (ranking.begin (), ranking.begin () + count, ranking.end ());
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      selection.push_back (candidates[ranking[i].second]);
+    }
+}
+
+void LocalityAwarePeerConnectorStrategy::ProcessStrategyOptionsChangedEvent ()
+{
+  std::pair<std::string, std::string> explorationFraction = m_myClient->GetStrategyOptionChangePair ("locality_exploration_fraction");
+  if (explorationFraction.second.empty ())
+    {
+      return;
+    }
+
+  m_explorationFraction = std::max (0.0, std::min (1.0, lexical_cast<double> (explorationFraction.second)));
+}
+
+} // ns pushpull
+} // ns ns3
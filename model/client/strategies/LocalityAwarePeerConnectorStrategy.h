@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef LOCALITYAWAREPEERCONNECTORSTRATEGY_H_
+#define LOCALITYAWAREPEERCONNECTORSTRATEGY_H_
+
+#include "ns3/PeerConnectorStrategyBase.h"
+
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+namespace pushpull {
+
+class PushPullClient;
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Implements a peer connector that prefers topologically close peers.
+ *
+ * This class ranks the potential peers by the round-trip time estimated from their location in the simulated topology
+ * (see the NetworkLocality class, which is, e.g., filled by the BriteTopologyHelper) and connects to the closest ones,
+ * i.e., peers attached to the same access router first, then peers in the same autonomous system, then all others.
+ * This reduces transit traffic between autonomous systems and the latency of piece transfers.
+ *
+ * To keep the swarm connected across autonomous systems, a fraction of the connections (the "exploration fraction") is established
+ * with peers drawn uniformly at random from all potential peers. The fraction can be set via the strategy option "locality_exploration_fraction"
+ * (a value between 0.0 and 1.0; defaults to PP_PEER_CONNECTOR_LOCALITY_EXPLORATION_FRACTION).
+ *
+ * Peers without known location are ranked last, so the strategy falls back to random selection if no location information is available.
+ */
+class LocalityAwarePeerConnectorStrategy : public PeerConnectorStrategyBase
+{
+// Fields
+protected:
+  double m_explorationFraction;      // The fraction of connections established with randomly-chosen peers
+
+// Constructors etc.
+public:
+  LocalityAwarePeerConnectorStrategy (Ptr<PushPullClient> myClient);
+  virtual ~LocalityAwarePeerConnectorStrategy ();
+
+  /**
+   * \brief Initialze the strategy.
+   *
+   * Register the needed event listeners with the associated client, including the ones of the base class.
+   */
+  virtual void DoInitialize ();
+
+// Internal methods
+protected:
+  /**
+   * \brief Select the clients to connect to: A random sample of size (count * exploration fraction), the remainder in order of ascending estimated round-trip time.
+   */
+  virtual void SelectPeersToConnect (uint16_t count, std::vector<std::pair<uint32_t, uint16_t> > &selection);
+
+// Event listeners
+public:
+  /**
+   * \brief Adopt a changed "locality_exploration_fraction" strategy option.
+   */
+  virtual void ProcessStrategyOptionsChangedEvent ();
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* LOCALITYAWAREPEERCONNECTORSTRATEGY_H_ */
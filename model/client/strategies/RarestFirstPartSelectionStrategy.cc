@@ -22,6 +22,7 @@
 
 #include "ns3/BitTorrentClient.h"
 #include "ns3/BitTorrentPeer.h"
+#include "ns3/BitTorrentVideoClient.h"
 
 #include "ns3/log.h"
 #include "ns3/random-variable.h"
@@ -76,10 +77,19 @@ void RarestFirstPartSelectionStrategy::DoInitialize ()
   // Step 1: Register events handled by the base class only
   m_myClient->RegisterCallbackChokeChangingEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerChokeChangingEvent,this));
   m_myClient->RegisterCallbackBlockCompleteEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerBlockCompleteEvent,this));
+  m_myClient->RegisterCallbackRejectRequestEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerRejectRequestEvent,this));
+  m_myClient->RegisterCallbackAllowedFastEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerAllowedFastEvent,this));
+  m_myClient->RegisterCallbackSuggestPieceEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPeerSuggestPieceEvent,this));
+  if (m_myVideoClient)
+    {
+      m_myVideoClient->RegisterCallbackPlaybackSeekEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPlaybackSeekEvent,this));
+      m_myVideoClient->RegisterCallbackPlaybackStateChangedEvent (MakeCallback (&PartSelectionStrategyBase::ProcessPlaybackStateChangedEvent,this));
+    }
 
   // Step 2: Register our own handlers
   m_myClient->RegisterCallbackBitfieldReceivedEvent (MakeCallback (&RarestFirstPartSelectionStrategy::ProcessPeerBitfieldReceivedEvent,this));
   m_myClient->RegisterCallbackPeerHaveEvent (MakeCallback (&RarestFirstPartSelectionStrategy::ProcessPeerHaveEvent,this));
+  m_myClient->RegisterCallbackPeerPieceUnavailableEvent (MakeCallback (&RarestFirstPartSelectionStrategy::ProcessPeerPieceUnavailableEvent,this));
   m_myClient->RegisterCallbackConnectionCloseEvent (MakeCallback (&RarestFirstPartSelectionStrategy::ProcessPeerConnectionCloseEvent,this));
   m_myClient->RegisterCallbackStrategyOptionsChangedEvent (MakeCallback (&RarestFirstPartSelectionStrategy::ProcessStrategyOptionsChangedEvent, this));
 }
@@ -145,6 +155,31 @@ void RarestFirstPartSelectionStrategy::ProcessPeerHaveEvent (Ptr<Peer> peer, uin
   PartSelectionStrategyBase::ProcessPeerHaveEvent (peer, pieceIndex);
 }
 
+void RarestFirstPartSelectionStrategy::ProcessPeerPieceUnavailableEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  /*
+   * NOTE: This function is the "inverse" to ProcessPeerHaveEvent
+   */
+  if (m_myClient->GetDownloadCompleted ())
+    {
+      return;
+    }
+
+  // Completed pieces are kept at the "maximum rarity" and need not be shifted
+  uint16_t currentRarity = m_raritiesByPiece[pieceIndex];
+  if (currentRarity == 0 || currentRarity > m_myClient->GetMaxPeers ())
+    {
+      return;
+    }
+
+  m_piecesByRarity[currentRarity].erase (pieceIndex);
+  m_piecesByRarity[currentRarity - 1].insert (pieceIndex);
+  m_raritiesByPiece[pieceIndex] = currentRarity - 1;
+
+  // Call the base class event handler, e.g., for updating our interest in the peer
+  PartSelectionStrategyBase::ProcessPeerPieceUnavailableEvent (peer, pieceIndex);
+}
+
 void RarestFirstPartSelectionStrategy::ProcessPeerConnectionCloseEvent (Ptr<Peer> peer)
 {
   /*
@@ -283,10 +318,22 @@ void RarestFirstPartSelectionStrategy::GetHighestPriorityBlockForPeer (Ptr<Peer>
   blockPtr.m_requestedFrom = peer;
   blockPtr.m_blockLength = 0;
 
-  // Step 2: Calculate the timeout of a piece by taking into account how many requests are already running for this peer
-  blockPtr.m_timeoutTime =
-    Simulator::Now () +
-    MilliSeconds ((1 + m_requestedBlocks[peer].size ()) * m_myClient->GetPieceTimeout ().GetMilliSeconds () / m_blocksPerPiece);
+  // Step 2: Calculate the timeout of the request
+  blockPtr.m_timeoutTime = Simulator::Now () + GetRequestTimeout (peer);
+
+  // Step 2a: In fast start mode, the pieces needed to start playback precede the rarest-first choices
+  GetFastStartBlockForPeer (peer, blockPtr);
+  if (blockPtr.m_blockLength > 0)
+    {
+      return;
+    }
+
+  // Step 2b: After a seek, the pieces around the new playback position precede the rarest-first choices as well
+  GetSeekBlockForPeer (peer, blockPtr);
+  if (blockPtr.m_blockLength > 0)
+    {
+      return;
+    }
 
   // Step 3: Find a block that we may need to download; with completetion of alredy-requested pieces preceding new rarest-first choices
   bool blockFound = false;
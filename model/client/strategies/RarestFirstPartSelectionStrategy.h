@@ -83,6 +83,12 @@ public:
 	 */
 	virtual void ProcessPeerHaveEvent(Ptr<Peer> peer, uint32_t pieceIndex);
 
+	/**
+	 * \brief Reacts to a piece leaving the availability window of a peer by shifting the availability of the piece down by one.
+	 * Afterwards, the base class handler is called.
+	 */
+	virtual void ProcessPeerPieceUnavailableEvent(Ptr<Peer> peer, uint32_t pieceIndex);
+
 // Semi-listener methods
 protected:
 	virtual void ProcessCompletedPiece(uint32_t pieceIndex);
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "SuperSeedingRequestSchedulingStrategy.h"
+
+#include "ns3/PushPullClient.h"
+#include "ns3/PushPullPeer.h"
+#include "ns3/TorrentFile.h"
+
+#include "ns3/log.h"
+#include "ns3/random-variable.h"
+
+namespace ns3 {
+namespace pushpull {
+
+NS_LOG_COMPONENT_DEFINE ("pushpull::SuperSeedingRequestSchedulingStrategy");
+NS_OBJECT_ENSURE_REGISTERED (SuperSeedingRequestSchedulingStrategy);
+
+SuperSeedingRequestSchedulingStrategy::SuperSeedingRequestSchedulingStrategy (Ptr<PushPullClient> myClient) : RequestSchedulingStrategyBase (myClient)
+{
+  m_superSeeding = false;
+  m_seenPiecesCount = 0;
+}
+
+SuperSeedingRequestSchedulingStrategy::~SuperSeedingRequestSchedulingStrategy ()
+{
+}
+
+void SuperSeedingRequestSchedulingStrategy::DoInitialize ()
+{
+  RequestSchedulingStrategyBase::DoInitialize ();
+
+  // Only clients that start as seeders superseed; all others behave like the base class
+  if (!m_myClient->GetDownloadCompleted ())
+    {
+      return;
+    }
+
+  uint32_t numberOfPieces = m_myClient->GetTorrent ()->GetNumberOfPieces ();
+  m_offerCounts.assign (numberOfPieces, 0);
+  m_seenPieces.assign (numberOfPieces, false);
+  m_superSeeding = true;
+  m_myClient->SetSuperSeeding (true);
+
+  m_myClient->RegisterCallbackBitfieldReceivedEvent (MakeCallback (&SuperSeedingRequestSchedulingStrategy::ProcessPeerBitfieldReceivedEvent, this));
+  m_myClient->RegisterCallbackPeerHaveEvent (MakeCallback (&SuperSeedingRequestSchedulingStrategy::ProcessPeerHaveEvent, this));
+  m_myClient->RegisterCallbackConnectionCloseEvent (MakeCallback (&SuperSeedingRequestSchedulingStrategy::ProcessConnectionCloseEvent, this));
+}
+
+void SuperSeedingRequestSchedulingStrategy::ProcessPeerBitfieldReceivedEvent (Ptr<Peer> peer)
+{
+  if (!m_superSeeding)
+    {
+      return;
+    }
+
+  // Step 1: The pieces the peer already has are out in the swarm
+  for (uint32_t i = 0; i < m_seenPieces.size () && m_superSeeding; ++i)
+    {
+      if (peer->HasPiece (i))
+        {
+          MarkPieceSeen (i);
+        }
+    }
+
+  // Step 2: Offer the first piece to the peer
+  if (m_superSeeding)
+    {
+      OfferPiece (peer);
+    }
+}
+
+void SuperSeedingRequestSchedulingStrategy::ProcessPeerHaveEvent (Ptr<Peer> peer, uint32_t pieceIndex)
+{
+  if (!m_superSeeding)
+    {
+      return;
+    }
+
+  MarkPieceSeen (pieceIndex);
+  if (!m_superSeeding)
+    {
+      return;
+    }
+
+  // Step 1: Every other peer that was offered this piece has passed it on and is credited with a new piece
+  std::vector<Ptr<Peer> > credited;
+  for (std::map<Ptr<Peer>, uint32_t>::const_iterator it = m_offeredPieces.begin (); it != m_offeredPieces.end (); ++it)
+    {
+      if ((*it).second == pieceIndex && (*it).first != peer)
+        {
+          credited.push_back ((*it).first);
+        }
+    }
+  for (std::vector<Ptr<Peer> >::iterator it = credited.begin (); it != credited.end (); ++it)
+    {
+      OfferPiece (*it);
+    }
+
+  // Step 2: If the peer itself downloaded its offered piece, it may only be credited by others; unless nobody is left to pass the piece on to
+  std::map<Ptr<Peer>, uint32_t>::iterator offerIt = m_offeredPieces.find (peer);
+  if (offerIt == m_offeredPieces.end () || (*offerIt).second != pieceIndex)
+    {
+      return;
+    }
+  const std::vector<Ptr<Peer> > &peers = m_myClient->GetActivePeers ();
+  for (std::vector<Ptr<Peer> >::const_iterator it = peers.begin (); it != peers.end (); ++it)
+    {
+      if (*it != peer && !(*it)->HasPiece (pieceIndex))
+        {
+          return;
+        }
+    }
+  OfferPiece (peer);
+}
+
+void SuperSeedingRequestSchedulingStrategy::ProcessConnectionCloseEvent (Ptr<Peer> peer)
+{
+  m_offeredPieces.erase (peer);
+}
+
+void SuperSeedingRequestSchedulingStrategy::OfferPiece (Ptr<Peer> peer)
+{
+  // Step 1: Find the piece the peer does not have that is least available in the swarm, starting at a random piece to break ties randomly
+  uint32_t numberOfPieces = m_offerCounts.size ();
+  if (numberOfPieces == 0)
+    {
+      return;
+    }
+  UniformVariable uv;
+  uint32_t start = uv.GetInteger (0, numberOfPieces - 1);
+
+  bool found = false;
+  uint32_t bestPiece = 0;
+  for (uint32_t i = 0; i < numberOfPieces; ++i)
+    {
+      uint32_t piece = (start + i) % numberOfPieces;
+      if (peer->HasPiece (piece))
+        {
+          continue;
+        }
+      if (!found || m_seenPieces[piece] < m_seenPieces[bestPiece]
+          || (m_seenPieces[piece] == m_seenPieces[bestPiece] && m_offerCounts[piece] < m_offerCounts[bestPiece]))
+        {
+          found = true;
+          bestPiece = piece;
+        }
+    }
+
+  // Step 2: If the peer has everything, there is nothing left to offer
+  if (!found)
+    {
+      m_offeredPieces.erase (peer);
+      return;
+    }
+
+  // Step 3: Reveal the piece to the peer
+  NS_LOG_INFO ("Offering piece " << bestPiece << " to peer " << peer->GetRemoteIp () << " (offered " << m_offerCounts[bestPiece] << " times before).");
+  m_offeredPieces[peer] = bestPiece;
+  ++m_offerCounts[bestPiece];
+  peer->SendHaveMessage (bestPiece);
+}
+
+void SuperSeedingRequestSchedulingStrategy::EndSuperSeeding ()
+{
+  NS_LOG_INFO ("Client " << m_myClient->GetNode ()->GetId () << " leaves superseeding mode: every piece is available in the swarm.");
+
+  m_superSeeding = false;
+  m_myClient->SetSuperSeeding (false);
+  m_offeredPieces.clear ();
+
+  // Reveal the remaining pieces to the connected peers; peers connecting from now on receive our whole bitfield
+  uint32_t numberOfPieces = m_offerCounts.size ();
+  for (std::vector<Ptr<Peer> >::const_iterator it = m_myClient->GetPeerListIterator (); it != m_myClient->GetPeerListEnd (); ++it)
+    {
+      for (uint32_t i = 0; i < numberOfPieces; ++i)
+        {
+          if (!(*it)->HasPiece (i))
+            {
+              (*it)->SendHaveMessage (i);
+            }
+        }
+    }
+}
+
+void SuperSeedingRequestSchedulingStrategy::MarkPieceSeen (uint32_t pieceIndex)
+{
+  if (pieceIndex >= m_seenPieces.size () || m_seenPieces[pieceIndex])
+    {
+      return;
+    }
+
+  m_seenPieces[pieceIndex] = true;
+  ++m_seenPiecesCount;
+  if (m_seenPiecesCount == m_seenPieces.size ())
+    {
+      EndSuperSeeding ();
+    }
+}
+
+} // ns pushpull
+} // ns ns3
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef SUPERSEEDINGREQUESTSCHEDULINGSTRATEGY_H_
+#define SUPERSEEDINGREQUESTSCHEDULINGSTRATEGY_H_
+
+#include "ns3/RequestSchedulingStrategyBase.h"
+
+#include "ns3/ptr.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace pushpull {
+
+class PushPullClient;
+class Peer;
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Implements superseeding for clients that start as seeders: pieces are revealed to each peer one at a time, and a peer is only
+ * shown a new piece once the previous one was observed propagating to other peers.
+ *
+ * A client running this strategy that has completed the download upon initialization enters superseeding mode (see PushPullClient::SetSuperSeeding)
+ * and advertises no pieces in its bitfield messages. Instead, each peer is offered a single piece via a HAVE message, preferring pieces that
+ * no other peer has announced yet and, among them, the pieces offered least often. The peer is credited with a new piece as soon as another peer
+ * announces having the offered piece, i.e., as soon as the peer has passed the piece on. If the peer downloaded the piece but no other connected
+ * peer lacks it, the peer is offered a new piece right away, so that small swarms do not stall.
+ *
+ * Hence, the origin uploads each piece about once until the swarm holds a full copy. From then on, the client leaves superseeding mode and
+ * reveals all of its pieces to every peer.
+ *
+ * Serving the requests is left to the base class.
+ */
+class SuperSeedingRequestSchedulingStrategy : public RequestSchedulingStrategyBase
+{
+// Fields
+protected:
+  bool                          m_superSeeding;       // Whether the client is (still) in superseeding mode
+  std::map<Ptr<Peer>, uint32_t> m_offeredPieces;      // The piece currently offered to each peer that did not pass it on yet, by peer
+  std::vector<uint16_t>         m_offerCounts;        // The number of times each piece was offered to a peer
+  std::vector<bool>             m_seenPieces;         // Whether any peer has announced having each piece
+  uint32_t                      m_seenPiecesCount;    // The number of pieces announced by at least one peer
+
+// Constructors etc.
+public:
+  SuperSeedingRequestSchedulingStrategy (Ptr<PushPullClient> myClient);
+  virtual ~SuperSeedingRequestSchedulingStrategy ();
+
+  /**
+   * Initialize the strategy. Register the needed event listeners with the associated client and enter superseeding mode if the client is a seeder.
+   */
+  virtual void DoInitialize ();
+
+// Event handlers
+public:
+  /**
+   * \brief Take note of the pieces of a newly-connected peer and offer it its first piece.
+   */
+  virtual void ProcessPeerBitfieldReceivedEvent (Ptr<Peer> peer);
+
+  /**
+   * \brief Credit the peers that were offered the announced piece and offer them new pieces.
+   */
+  virtual void ProcessPeerHaveEvent (Ptr<Peer> peer, uint32_t pieceIndex);
+
+  /**
+   * \brief Forget the piece offered to a closed connection.
+   */
+  virtual void ProcessConnectionCloseEvent (Ptr<Peer> peer);
+
+// Strategy implementation methods
+protected:
+  /**
+   * \brief Offer a new piece to a peer.
+   *
+   * The piece is chosen among the pieces the peer does not have: pieces not announced by any peer come first, then the pieces offered least often.
+   * Ties are broken randomly.
+   */
+  virtual void OfferPiece (Ptr<Peer> peer);
+
+  /**
+   * \brief Leave superseeding mode and reveal all pieces to all peers.
+   */
+  virtual void EndSuperSeeding ();
+
+// Internal methods
+private:
+  // Note that a peer has announced the piece; ends superseeding once every piece has been announced
+  void MarkPieceSeen (uint32_t pieceIndex);
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* SUPERSEEDINGREQUESTSCHEDULINGSTRATEGY_H_ */
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "UploadAwareVoDChokeUnChokeStrategy.h"
+
+#include "ns3/PushPullClient.h"
+#include "ns3/PushPullDefines.h"
+#include "ns3/PushPullPeer.h"
+#include "ns3/PushPullVideoClient.h"
+
+#include "ns3/log.h"
+#include "ns3/random-variable.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+namespace pushpull {
+
+NS_LOG_COMPONENT_DEFINE ("pushpull::UploadAwareVoDChokeUnChokeStrategy");
+NS_OBJECT_ENSURE_REGISTERED (UploadAwareVoDChokeUnChokeStrategy);
+
+UploadAwareVoDChokeUnChokeStrategy::UploadAwareVoDChokeUnChokeStrategy (Ptr<PushPullClient> myClient) : AbstractStrategy (myClient)
+{
+  m_roundInterval = MilliSeconds (PP_CHOKE_VOD_ROUND_INTERVAL);
+  m_round = 0;
+  m_unchokeSlots = std::max (static_cast<uint16_t> (PP_CHOKE_VOD_MIN_UNCHOKED_PEERS), m_myClient->GetMaxUnchokedPeers ());
+  m_minSlotRate = PP_CHOKE_VOD_MIN_SLOT_RATE;
+}
+
+UploadAwareVoDChokeUnChokeStrategy::~UploadAwareVoDChokeUnChokeStrategy ()
+{
+}
+
+void UploadAwareVoDChokeUnChokeStrategy::DoInitialize ()
+{
+  m_myClient->RegisterCallbackInterestedChangingEvent (MakeCallback (&UploadAwareVoDChokeUnChokeStrategy::ProcessPeerInterestedChangingEvent, this));
+  m_myClient->RegisterCallbackConnectionCloseEvent (MakeCallback (&UploadAwareVoDChokeUnChokeStrategy::ProcessConnectionCloseEvent, this));
+
+  // For video clients, an unchoked peer should at least receive a fraction of the video bitrate
+  Ptr<PushPullVideoClient> videoClient = DynamicCast<PushPullVideoClient> (m_myClient);
+  if (videoClient)
+    {
+      Time totalLength = videoClient->GetTotalLength ();
+      if (totalLength.IsStrictlyPositive ())
+        {
+          double videoBitrate = 8.0 * m_myClient->GetTorrent ()->GetFileLength () / totalLength.GetSeconds ();
+          m_minSlotRate = std::max (m_minSlotRate, PP_CHOKE_VOD_SLOT_RATE_FRACTION * videoBitrate);
+        }
+    }
+
+  m_nextRoundEvent = Simulator::Schedule (m_roundInterval, &UploadAwareVoDChokeUnChokeStrategy::ProcessPeriodicSchedule, this);
+}
+
+uint16_t UploadAwareVoDChokeUnChokeStrategy::GetUnchokeSlots () const
+{
+  return m_unchokeSlots;
+}
+
+void UploadAwareVoDChokeUnChokeStrategy::ProcessPeriodicSchedule ()
+{
+  const std::vector<Ptr<Peer> > &peers = m_myClient->GetActivePeers ();
+
+  // Step 1: Adapt the number of slots to the upload capacity observed in the last round
+  m_unchokeSlots = CalculateUnchokeSlots (peers);
+
+  // Step 2: Rank the interested peers by their next needed piece (i.e., their playback deadline), then by the rate we upload to them
+  std::vector<std::pair<std::pair<uint32_t, double>, uint32_t> > ranking;
+  for (uint32_t i = 0; i < peers.size (); ++i)
+    {
+      if (peers[i]->GetConnectionState () == Peer::CONN_STATE_CONNECTED && peers[i]->IsInterested ())
+        {
+          ranking.push_back (std::make_pair (std::make_pair (GetNextNeededPiece (peers[i]), -peers[i]->GetBpsUpload ()), i));
+        }
+    }
+  std::sort (ranking.begin (), ranking.end ());
+
+  // Step 3: Reserve one slot for the optimistic unchoke if there are more interested peers than slots
+  uint32_t regularSlots = ranking.size () > m_unchokeSlots ? m_unchokeSlots - 1 : ranking.size ();
+  std::vector<bool> unchoke (peers.size (), false);
+  for (uint32_t i = 0; i < regularSlots; ++i)
+    {
+      unchoke[ranking[i].second] = true;
+    }
+
+  // Step 4: Rotate the optimistic unchoke among the remaining interested peers
+  if (regularSlots < ranking.size ())
+    {
+      bool keepOptimisticUnchoke = false;
+      for (uint32_t i = regularSlots; i < ranking.size (); ++i)
+        {
+          keepOptimisticUnchoke = keepOptimisticUnchoke || peers[ranking[i].second] == m_optimisticUnchoke;
+        }
+
+      if (!keepOptimisticUnchoke || m_round % PP_CHOKE_VOD_OPTIMISTIC_UNCHOKE_ROUNDS == 0)
+        {
+          UniformVariable uv;
+          m_optimisticUnchoke = peers[ranking[uv.GetInteger (regularSlots, ranking.size () - 1)].second];
+        }
+
+      for (uint32_t i = regularSlots; i < ranking.size (); ++i)
+        {
+          unchoke[ranking[i].second] = peers[ranking[i].second] == m_optimisticUnchoke;
+        }
+    }
+  else
+    {
+      m_optimisticUnchoke = 0;
+    }
+
+  // Step 5: Apply the decisions; the Peer class only sends messages for actual changes
+  for (uint32_t i = 0; i < peers.size (); ++i)
+    {
+      if (peers[i]->GetConnectionState () == Peer::CONN_STATE_CONNECTED)
+        {
+          peers[i]->SetAmChoking (!unchoke[i]);
+        }
+    }
+
+  NS_LOG_INFO ("UploadAwareVoDChokeUnChokeStrategy: " << m_myClient->GetIp () << ": Round " << m_round << ": " << m_unchokeSlots << " slots for " << ranking.size () << " interested peers.");
+
+  ++m_round;
+  m_nextRoundEvent = Simulator::Schedule (m_roundInterval, &UploadAwareVoDChokeUnChokeStrategy::ProcessPeriodicSchedule, this);
+}
+
+uint16_t UploadAwareVoDChokeUnChokeStrategy::CalculateUnchokeSlots (const std::vector<Ptr<Peer> > &peers) const
+{
+  // Step 1: Count the unchoked peers and those that received at least the minimum rate
+  uint16_t unchoked = 0;
+  uint16_t satisfied = 0;
+  for (std::vector<Ptr<Peer> >::const_iterator it = peers.begin (); it != peers.end (); ++it)
+    {
+      if ((*it)->GetConnectionState () == Peer::CONN_STATE_CONNECTED && !(*it)->GetAmChoking ())
+        {
+          ++unchoked;
+          if ((*it)->GetBpsUpload () >= m_minSlotRate)
+            {
+              ++satisfied;
+            }
+        }
+    }
+
+  // Step 2: Without measurements (e.g., in the first rounds), keep the current size
+  if (unchoked == 0)
+    {
+      return m_unchokeSlots;
+    }
+
+  // Step 3: If all unchoked peers are served well, probe with one more slot; else, shrink to the peers that are served well (plus the optimistic unchoke)
+  uint16_t slots = satisfied == unchoked ? unchoked + 1 : satisfied + 1;
+
+  return std::max (static_cast<uint16_t> (PP_CHOKE_VOD_MIN_UNCHOKED_PEERS), std::min (slots, m_myClient->GetMaxPeers ()));
+}
+
+uint32_t UploadAwareVoDChokeUnChokeStrategy::GetNextNeededPiece (Ptr<Peer> peer) const
+{
+  const std::vector<uint8_t> &bitfield = *m_myClient->GetBitfield ();
+  uint32_t numberOfPieces = m_myClient->GetTorrent ()->GetNumberOfPieces ();
+
+  // The peer has announced all pieces before its first missing one (or advertises a window beginning there), so the search starts at that piece
+  for (uint32_t piece = peer->GetFirstMissingPiece (); piece < numberOfPieces; ++piece)
+    {
+      if ((bitfield[piece / 8] & (0x01 << (7 - piece % 8))) && !peer->HasPiece (piece))
+        {
+          return piece;
+        }
+    }
+
+  return numberOfPieces;
+}
+
+void UploadAwareVoDChokeUnChokeStrategy::ProcessPeerInterestedChangingEvent (Ptr<Peer> peer)
+{
+  if (!peer->IsInterested () || !peer->GetAmChoking ())
+    {
+      return;
+    }
+
+  // Count the currently unchoked peers to see whether there is a free slot
+  const std::vector<Ptr<Peer> > &peers = m_myClient->GetActivePeers ();
+  uint16_t unchoked = 0;
+  for (std::vector<Ptr<Peer> >::const_iterator it = peers.begin (); it != peers.end (); ++it)
+    {
+      if (!(*it)->GetAmChoking ())
+        {
+          ++unchoked;
+        }
+    }
+
+  if (unchoked < m_unchokeSlots)
+    {
+      peer->SetAmChoking (false);
+    }
+}
+
+void UploadAwareVoDChokeUnChokeStrategy::ProcessConnectionCloseEvent (Ptr<Peer> peer)
+{
+  if (peer == m_optimisticUnchoke)
+    {
+      m_optimisticUnchoke = 0;
+    }
+}
+
+} // ns pushpull
+} // ns ns3
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2014 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef UPLOADAWAREVODCHOKEUNCHOKESTRATEGY_H_
+#define UPLOADAWAREVODCHOKEUNCHOKESTRATEGY_H_
+
+#include "ns3/AbstractStrategy.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <vector>
+
+namespace ns3 {
+namespace pushpull {
+
+class PushPullClient;
+class Peer;
+
+/**
+ * \ingroup PushPull
+ *
+ * \brief Implements a choking/unchoking strategy for Video-on-Demand swarms that adapts to the client's upload capacity.
+ *
+ * Instead of unchoking a fixed number of peers (see PushPullClient::SetMaxUnchokedPeers), the strategy sizes the set of unchoked peers
+ * from the measured upload rates to the currently unchoked peers: As long as every unchoked peer receives at least a minimum rate
+ * (a fraction of the video bitrate, see PP_CHOKE_VOD_SLOT_RATE_FRACTION), the upload link is not saturated and one more peer may be unchoked.
+ * Peers receiving less indicate that the capacity is exhausted, so the set shrinks accordingly. The configured maximum number of unchoked
+ * peers is only used as the initial size.
+ *
+ * Within the set, the strategy prioritizes the peers with the nearest playback deadline. Since peers in a VoD swarm download in playback order,
+ * the earliest piece a peer still needs (and that the local client can provide) approximates its playback position; the peers needing the earliest
+ * pieces are unchoked first, ties are broken by the upload rate. One additional slot is rotated among the remaining interested peers
+ * every PP_CHOKE_VOD_OPTIMISTIC_UNCHOKE_ROUNDS rounds (optimistic unchoking) to discover peers the client can serve well.
+ */
+class UploadAwareVoDChokeUnChokeStrategy : public AbstractStrategy
+{
+// Fields
+protected:
+  Time      m_roundInterval;         // The interval between two choking/unchoking rounds
+  EventId   m_nextRoundEvent;        // The next scheduled round
+  uint32_t  m_round;                 // The number of rounds run so far
+
+  uint16_t  m_unchokeSlots;          // The current size of the set of unchoked peers, including the optimistic unchoke
+  double    m_minSlotRate;           // The upload rate (in bps) an unchoked peer must at least receive to justify an additional slot
+  Ptr<Peer> m_optimisticUnchoke;     // The currently optimistically-unchoked peer
+
+// Constructors etc.
+public:
+  UploadAwareVoDChokeUnChokeStrategy (Ptr<PushPullClient> myClient);
+  virtual ~UploadAwareVoDChokeUnChokeStrategy ();
+
+  /**
+   * \brief Initialze the strategy.
+   *
+   * Register the needed event listeners with the associated client, determine the video bitrate and schedule the first round.
+   */
+  virtual void DoInitialize ();
+
+// Getters, setters
+public:
+  /**
+   * @returns the current number of unchoke slots, including the optimistic unchoke.
+   */
+  uint16_t GetUnchokeSlots () const;
+
+// Internal methods
+protected:
+  /**
+   * \brief Run one choking/unchoking round and schedule the next one.
+   */
+  virtual void ProcessPeriodicSchedule ();
+
+  // Determine the number of unchoke slots from the upload rates to the currently unchoked peers
+  uint16_t CalculateUnchokeSlots (const std::vector<Ptr<Peer> > &peers) const;
+
+  // Get the earliest piece from the peer's first missing piece on that the peer does not have but the local client has; returns the number of pieces if there is none
+  uint32_t GetNextNeededPiece (Ptr<Peer> peer) const;
+
+// Event listeners
+public:
+  /**
+   * \brief Unchoke a newly-interested peer right away if there is a free slot, so that new viewers do not wait for the next round.
+   */
+  virtual void ProcessPeerInterestedChangingEvent (Ptr<Peer> peer);
+
+  /**
+   * \brief Forget a closed connection if it was the optimistic unchoke.
+   */
+  virtual void ProcessConnectionCloseEvent (Ptr<Peer> peer);
+};
+
+} // ns pushpull
+} // ns ns3
+
+#endif /* UPLOADAWAREVODCHOKEUNCHOKESTRATEGY_H_ */
@@ -22,14 +22,17 @@
 
 #include "ns3/BitTorrentClient.h"
 #include "ns3/BitTorrentPeer.h"
+#include "ns3/WallclockProfiler.h"
 
 #include "ns3/application-container.h"
 #include "ns3/mpi-interface.h"
 #include "ns3/simulator.h"
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <fstream>
 #include <ios>
+#include <sstream>
 
 namespace ns3 {
 namespace bittorrent {
@@ -42,17 +45,25 @@ GlobalMetricsGatherer::GlobalMetricsGatherer ()
   m_finishedExternalAppCount = 0;
   m_stopFraction = -1; // -1 indicatates that the GMG shall not stop the simulation at a specific threshold
   m_externalStopFraction = 0;
+  m_totalPieceCount = 0;
+  m_totalPieceDemand = 0;
+  m_destroyHookScheduled = false;
+  m_finalReportsWritten = false;
 }
 
 GlobalMetricsGatherer::~GlobalMetricsGatherer ()
 {
+  m_writer.Close ();
   m_pieceCount.clear ();
+  m_pieceDemand.clear ();
+  m_availabilityHistogram.clear ();
 }
 
 void GlobalMetricsGatherer::SetFileNamePrefix (const std::string fileNamePrefix, bool enableLogging)
 {
   m_fileNamePrefix = fileNamePrefix;
   m_fileOutputEnabled = enableLogging;
+  m_writer.SetFileNamePrefix (fileNamePrefix);
 }
 
 std::string GlobalMetricsGatherer::GetFileNamePrefix () const
@@ -67,6 +78,13 @@ bool GlobalMetricsGatherer::GetLoggingToFileEnabled () const
 
 void GlobalMetricsGatherer::RegisterWithApplications (ApplicationContainer appContainer)
 {
+  // Simulations that are not stopped by the global metrics gatherer still get their final reports
+  if (!m_destroyHookScheduled)
+    {
+      Simulator::ScheduleDestroy (&GlobalMetricsGatherer::ProcessSimulatorDestroy, this);
+      m_destroyHookScheduled = true;
+    }
+
   for (ApplicationContainer::Iterator it = appContainer.Begin (); it != appContainer.End (); ++it)
     {
       bool alreadyRegistered = false;
@@ -81,6 +99,8 @@ void GlobalMetricsGatherer::RegisterWithApplications (ApplicationContainer appCo
 
       if (!alreadyRegistered)
         {
+          ResizePieceVectors (DynamicCast<BitTorrentClient> (*it)->GetTorrent ()->GetNumberOfPieces ());
+
           DynamicCast<BitTorrentClient> (*it)->RegisterCallbackCloudConnectionEstablishedEvent (MakeCallback (&GlobalMetricsGatherer::UpdateHealthIndexAppStart, this));
           DynamicCast<BitTorrentClient> (*it)->RegisterCallbackCloudConnectionSuspendedEvent (MakeCallback (&GlobalMetricsGatherer::UpdateHealthIndexAppStop, this));
 
@@ -113,45 +133,45 @@ void GlobalMetricsGatherer::SetStopFraction (double stopFraction, double externa
     }
 }
 
-void GlobalMetricsGatherer::WriteToFile (const std::string metricName, const std::string metricString, bool timestamp) const
+void GlobalMetricsGatherer::WriteToFile (const std::string metricName, const std::string metricString, bool timestamp)
 {
-  if (!m_fileOutputEnabled)
+  PP_PROFILE_SCOPE (METRICS_WRITE);
+
+  // Step 1: Prepare the line; the file layout is "<ms>ms: <string>"
+  std::string line;
+  if (timestamp)
     {
-      std::cout << metricName;
-      if (timestamp)
-        {
-          std::cout << ": " << Simulator::Now ().GetMilliSeconds () << "ms";
-        }
-      std::cout << ": " << metricString << std::endl;
-      return;
+      line = lexical_cast<std::string> (Simulator::Now ().GetMilliSeconds ()) + "ms: ";
     }
-  else
-    {
-      std::ofstream fileStream;
+  line += metricString;
 
-      fileStream.open (std::string (GetFileNamePrefix () + "-" + metricName + ".dat").c_str (), std::ios_base::app);
+  // Step 2: Hand the line over to the (buffered) writer
+  if (m_fileOutputEnabled && m_writer.WriteLine (metricName, line))
+    {
+      return;
+    }
 
-      // Fallback for a non-ready stream
-      if (!fileStream.is_open () || !fileStream.good ())
-        {
-          std::cout << metricName;
-          if (timestamp)
-            {
-              std::cout << ": " << Simulator::Now ().GetMilliSeconds () << "ms";
-            }
-          std::cout << ": " << metricString << std::endl;
-          return;
-        }
+  // Step 3: Fallback for disabled file output or a non-ready stream; "\n" instead of std::endl, so the standard output is not flushed each time
+  std::cout << metricName << ": " << line << "\n";
+}
 
-      // Default output
-      if (timestamp)
-        {
-          fileStream << Simulator::Now ().GetMilliSeconds () << "ms: ";
-        }
-      fileStream << metricString << "\n";
+void GlobalMetricsGatherer::WriteRecord (const std::string &metricName, uint32_t node, double value)
+{
+  PP_PROFILE_SCOPE (METRICS_WRITE);
 
-      fileStream.close ();
+  if (m_fileOutputEnabled && m_writer.WriteRecord (metricName, Simulator::Now ().GetMilliSeconds (), node, value))
+    {
+      return;
     }
+
+  // Fallback for disabled file output or a non-ready stream (same layout as produced by MetricsWriter::ConvertToText)
+  std::cout << metricName << ": " << Simulator::Now ().GetMilliSeconds () << "ms: Node " << node << ": " << value << "\n";
+}
+
+void GlobalMetricsGatherer::FlushFiles ()
+{
+  m_writer.Flush ();
+  std::cout.flush ();
 }
 
 std::string GlobalMetricsGatherer::GetWallclockTime ()
@@ -207,7 +227,9 @@ void GlobalMetricsGatherer::UpdateFinishedApps ()
 
           if (m_externalStopFraction == -1 || (m_finishedExternalAppCount >= m_externalStopFraction * m_externalAppCount))
             {
+              WriteFinalReports ();
               WriteToFile ("simulation-stopped", GetWallclockTime (), false);
+              FlushFiles ();
               Simulator::Stop (Seconds (1));
             }
         }
@@ -222,7 +244,9 @@ void GlobalMetricsGatherer::AnnounceFinishedExternalClient ()
         {
           if (m_stopFraction == -1 || (m_finishedAppCount >= m_stopFraction * m_registeredWith.GetN ()))
             {
+              WriteFinalReports ();
               WriteToFile ("simulation-stopped", GetWallclockTime (), false);
+              FlushFiles ();
               Simulator::Stop (Seconds (1));
             }
         }
@@ -231,62 +255,231 @@ void GlobalMetricsGatherer::AnnounceFinishedExternalClient ()
 
 void GlobalMetricsGatherer::UpdateHealthIndexAppStart (Ptr<BitTorrentClient> client)
 {
-  const std::vector<uint8_t> clientBitfield = *(client->GetBitfield ());
-
-  for (uint32_t current = 0; current < client->GetTorrent ()->GetBitfieldSize (); ++current)
-    {
-      uint8_t currentByte = clientBitfield[current];
-      for (uint8_t bit = 0; bit < 8; ++bit)
-        {
-          if (currentByte & (1 << bit))
-            {
-              m_pieceCount[static_cast<uint32_t> ((current << 3) + bit)] = m_pieceCount[static_cast<uint32_t> ((current << 3) + bit)] + 1;
-            }
-        }
-    }
+  ResizePieceVectors (client->GetTorrent ()->GetNumberOfPieces ());
+  ChangePieceCountByBitfield (*(client->GetBitfield ()), client->GetTorrent ()->GetNumberOfPieces (), true);
 }
 
 void GlobalMetricsGatherer::UpdateHealthIndexAppStop (Ptr<BitTorrentClient> client)
 {
-  const std::vector<uint8_t> clientBitfield = *(client->GetBitfield ());
-
-  for (uint32_t current = 0; current < client->GetTorrent ()->GetBitfieldSize (); ++current)
-    {
-      uint8_t currentByte = clientBitfield[current];
-      for (uint8_t bit = 0; bit < 8; ++bit)
-        {
-          if (currentByte & (1 << bit))
-            {
-              m_pieceCount[static_cast<uint32_t> ((current << 3) + bit)] = std::max (static_cast<uint32_t> (0), m_pieceCount[static_cast<uint32_t> ((current << 3) + bit)] - 1);
-            }
-        }
-    }
+  ResizePieceVectors (client->GetTorrent ()->GetNumberOfPieces ());
+  ChangePieceCountByBitfield (*(client->GetBitfield ()), client->GetTorrent ()->GetNumberOfPieces (), false);
 }
 
 void GlobalMetricsGatherer::UpdateHealthIndexPieceCompleted (Ptr<Peer> peer, uint32_t pieceIndex)
 {
-  m_pieceCount[pieceIndex] = m_pieceCount[pieceIndex] + 1;
+  if (pieceIndex >= m_pieceCount.size ())
+    {
+      ResizePieceVectors (pieceIndex + 1);
+    }
+
+  ChangePieceCount (pieceIndex, true);
+  ++m_totalPieceCount;
 }
 
 void GlobalMetricsGatherer::UpdateDemandUp (Ptr<Peer> peer, uint32_t pieceIndex)
 {
-  m_pieceDemand[pieceIndex] = m_pieceDemand[pieceIndex] + 1;
+  if (pieceIndex >= m_pieceDemand.size ())
+    {
+      ResizePieceVectors (pieceIndex + 1);
+    }
+
+  ++m_pieceDemand[pieceIndex];
+  ++m_totalPieceDemand;
 }
 
 void GlobalMetricsGatherer::UpdateDemandDown (Ptr<Peer> peer, uint32_t pieceIndex)
 {
-  m_pieceDemand[pieceIndex] = std::max (static_cast<uint32_t> (0), m_pieceDemand[pieceIndex] - 1);
+  if (pieceIndex < m_pieceDemand.size () && m_pieceDemand[pieceIndex] > 0)
+    {
+      --m_pieceDemand[pieceIndex];
+      --m_totalPieceDemand;
+    }
 }
 
-const std::map<uint32_t, uint32_t>& GlobalMetricsGatherer::GetPieceCount () const
+const std::vector<uint32_t>& GlobalMetricsGatherer::GetPieceCount () const
 {
   return m_pieceCount;
 }
 
-const std::map<uint32_t, uint32_t>& GlobalMetricsGatherer::GetPieceDemand () const
+const std::vector<uint32_t>& GlobalMetricsGatherer::GetPieceDemand () const
 {
   return m_pieceDemand;
 }
 
+SwarmHealthSnapshot GlobalMetricsGatherer::GetSwarmHealth () const
+{
+  SwarmHealthSnapshot snapshot;
+  snapshot.m_numberOfPieces = m_pieceCount.size ();
+  snapshot.m_totalCopies = m_totalPieceCount;
+  snapshot.m_totalDemand = m_totalPieceDemand;
+  snapshot.m_unavailablePieces = m_availabilityHistogram.empty () ? 0 : m_availabilityHistogram[0];
+  snapshot.m_minAvailability = 0;
+  snapshot.m_meanAvailability = 0;
+  snapshot.m_distributedCopies = 0;
+
+  if (snapshot.m_numberOfPieces == 0)
+    {
+      return snapshot;
+    }
+
+  // The first non-empty entry of the histogram denotes the availability of the rarest piece
+  while (m_availabilityHistogram[snapshot.m_minAvailability] == 0)
+    {
+      ++snapshot.m_minAvailability;
+    }
+
+  snapshot.m_meanAvailability = static_cast<double> (m_totalPieceCount) / snapshot.m_numberOfPieces;
+  snapshot.m_distributedCopies = snapshot.m_minAvailability
+    + static_cast<double> (snapshot.m_numberOfPieces - m_availabilityHistogram[snapshot.m_minAvailability]) / snapshot.m_numberOfPieces;
+
+  return snapshot;
+}
+
+void GlobalMetricsGatherer::AddQuantileSample (const std::string &metricName, double value)
+{
+  m_quantileSketches[metricName].Add (value);
+}
+
+void GlobalMetricsGatherer::MergeQuantileSketch (const std::string &metricName, const QuantileSketch &sketch)
+{
+  m_quantileSketches[metricName].Merge (sketch);
+}
+
+const QuantileSketch* GlobalMetricsGatherer::GetQuantileSketch (const std::string &metricName) const
+{
+  std::map<std::string, QuantileSketch>::const_iterator it = m_quantileSketches.find (metricName);
+  if (it == m_quantileSketches.end ())
+    {
+      return 0;
+    }
+
+  return &((*it).second);
+}
+
+void GlobalMetricsGatherer::WriteQuantileSummaries ()
+{
+  for (std::map<std::string, QuantileSketch>::const_iterator it = m_quantileSketches.begin (); it != m_quantileSketches.end (); ++it)
+    {
+      const QuantileSketch &sketch = (*it).second;
+
+      std::stringstream ss;
+      ss << (*it).first
+         << " count=" << sketch.GetCount ()
+         << " mean=" << (sketch.GetCount () > 0 ? sketch.GetSum () / sketch.GetCount () : 0)
+         << " p50=" << sketch.GetQuantile (0.5)
+         << " p95=" << sketch.GetQuantile (0.95)
+         << " p99=" << sketch.GetQuantile (0.99)
+         << " max=" << sketch.GetMax ();
+
+      WriteToFile ("quantiles", ss.str (), true);
+    }
+}
+
+void GlobalMetricsGatherer::WriteFinalReports ()
+{
+  if (m_finalReportsWritten)
+    {
+      return;
+    }
+  m_finalReportsWritten = true;
+
+  WriteQuantileSummaries ();
+  WriteProfilingReport ();
+  FlushFiles ();
+}
+
+void GlobalMetricsGatherer::ProcessSimulatorDestroy ()
+{
+  WriteFinalReports ();
+
+  m_destroyHookScheduled = false;
+  m_finalReportsWritten = false;
+}
+
+void GlobalMetricsGatherer::WriteProfilingReport ()
+{
+  // The report is assembled completely before writing, so that writing it does not distort the metrics write category
+  std::vector<std::string> report = WallclockProfiler::GetInstance ()->GetReport ();
+  for (std::vector<std::string>::const_iterator it = report.begin (); it != report.end (); ++it)
+    {
+      WriteToFile ("profiling", *it, false);
+    }
+}
+
+void GlobalMetricsGatherer::ResizePieceVectors (uint32_t numberOfPieces)
+{
+  if (numberOfPieces <= m_pieceCount.size ())
+    {
+      return;
+    }
+
+  // All newly-tracked pieces are unavailable so far
+  if (m_availabilityHistogram.empty ())
+    {
+      m_availabilityHistogram.resize (1, 0);
+    }
+  m_availabilityHistogram[0] += numberOfPieces - m_pieceCount.size ();
+
+  m_pieceCount.resize (numberOfPieces, 0);
+  m_pieceDemand.resize (numberOfPieces, 0);
+}
+
+void GlobalMetricsGatherer::ChangePieceCount (uint32_t pieceIndex, bool increase)
+{
+  uint32_t &count = m_pieceCount[pieceIndex];
+
+  if (increase)
+    {
+      --m_availabilityHistogram[count];
+      ++count;
+      if (count >= m_availabilityHistogram.size ())
+        {
+          m_availabilityHistogram.resize (count + 1, 0);
+        }
+      ++m_availabilityHistogram[count];
+    }
+  else if (count > 0)
+    {
+      --m_availabilityHistogram[count];
+      --count;
+      ++m_availabilityHistogram[count];
+    }
+}
+
+void GlobalMetricsGatherer::ChangePieceCountByBitfield (const std::vector<uint8_t> &bitfield, uint32_t numberOfPieces, bool increase)
+{
+  // Step 1: Update the total in one go; the spare bits of the last byte are never set by the clients
+  uint64_t setBits = 0;
+  for (std::vector<uint8_t>::const_iterator it = bitfield.begin (); it != bitfield.end (); ++it)
+    {
+      setBits += __builtin_popcount (*it);
+    }
+  if (increase)
+    {
+      m_totalPieceCount += setBits;
+    }
+  else
+    {
+      m_totalPieceCount -= std::min (setBits, m_totalPieceCount);
+    }
+
+  // Step 2: Update the availability of each piece, visiting only the set bits (the high bit of each byte corresponds to the lowest piece index)
+  for (uint32_t current = 0; current < bitfield.size (); ++current)
+    {
+      uint32_t currentByte = bitfield[current];
+      while (currentByte != 0)
+        {
+          uint32_t bit = __builtin_clz (currentByte) - 24;
+          currentByte &= ~(0x80u >> bit);
+
+          uint32_t pieceIndex = (current << 3) + bit;
+          if (pieceIndex < numberOfPieces)
+            {
+              ChangePieceCount (pieceIndex, increase);
+            }
+        }
+    }
+}
+
 } // ns bittorrent
 } // ns ns3
@@ -24,14 +24,33 @@
 
 #include "ns3/BitTorrentClient.h"
 #include "ns3/BitTorrentPeer.h"
+#include "ns3/MetricsWriter.h"
+#include "ns3/QuantileSketch.h"
 
 #include "ns3/application-container.h"
 
 #include <map>
+#include <vector>
 
 namespace ns3 {
 namespace bittorrent {
 
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief A snapshot of the piece availability within the surveilled swarm, as returned by GlobalMetricsGatherer::GetSwarmHealth.
+ */
+typedef struct
+{
+  uint32_t m_numberOfPieces;           // The number of pieces tracked
+  uint64_t m_totalCopies;              // The sum of the availability of all pieces
+  uint64_t m_totalDemand;              // The sum of the current demand for all pieces
+  uint32_t m_unavailablePieces;        // The number of pieces that no client currently holds
+  uint32_t m_minAvailability;          // The availability of the rarest piece
+  double   m_meanAvailability;         // The average availability of a piece
+  double   m_distributedCopies;        // The health index: m_minAvailability plus the fraction of pieces that are available more often than the rarest piece
+} SwarmHealthSnapshot;
+
 /**
  * \ingroup BitTorrent
  *
@@ -52,6 +71,9 @@ private:
   // Whether file output is enabled or not
   bool m_fileOutputEnabled;
 
+  // The buffered sink for all file output; keeps the metric files open between calls to WriteToFile and WriteRecord
+  MetricsWriter m_writer;
+
   // Applications already registered
   ApplicationContainer m_registeredWith;
 
@@ -67,8 +89,18 @@ private:
   double  m_externalStopFraction;      // The fraction of external clients that should have finished before the GMG stops the simulation
 
   // For simulation-wide piece distribution analysis
-  std::map<uint32_t, uint32_t> m_pieceCount;     // How often a piece is present within the clients
-  std::map<uint32_t, uint32_t> m_pieceDemand;    // How many clients have currently expressed interest in a piece
+  std::vector<uint32_t> m_pieceCount;            // How often a piece is present within the clients, indexed by piece
+  std::vector<uint32_t> m_pieceDemand;           // How many clients have currently expressed interest in a piece, indexed by piece
+  std::vector<uint32_t> m_availabilityHistogram; // How many pieces are present exactly i times within the clients, indexed by i
+  uint64_t              m_totalPieceCount;       // The sum of all entries in m_pieceCount
+  uint64_t              m_totalPieceDemand;      // The sum of all entries in m_pieceDemand
+
+  // Simulation-wide distributions of client-local metrics (e.g., startup delay), by metric name
+  std::map<std::string, QuantileSketch> m_quantileSketches;
+
+  // Final reports, written once per simulation run
+  bool m_destroyHookScheduled;         // Whether the final reports are scheduled to be written upon Simulator::Destroy
+  bool m_finalReportsWritten;          // Whether the final reports of the current simulation run have been written
 
 // Constructors etc. (singleton pattern)
 private:
@@ -157,7 +189,28 @@ public:
  * @param metricString the information to write.
  * @param timestamp whether to add a timestamp ("<milliseconds of simulation time>ms: ") to the line at the beginning.
  */
-  void WriteToFile (const std::string metricName, const std::string metricString, bool timestamp) const;
+  void WriteToFile (const std::string metricName, const std::string metricString, bool timestamp);
+
+  /**
+   * \brief Write a numeric value of a certain metric for a certain node.
+   *
+   * Other than WriteToFile, this method writes a compact binary record (timestamp, node, metric id, value) to a file with a file name of the
+   * structure GetFileNamePrefix()-metricName.bin. The file can be converted into the text layout of the ".dat" files using the
+   * MetricsWriter::ConvertToText method. If file output is disabled, the value is printed to the standard output in the text layout instead.
+   *
+   * @param metricName the name of the metric for which there is new information available.
+   * @param node the id of the node the value was recorded for.
+   * @param value the value to write.
+   */
+  void WriteRecord (const std::string &metricName, uint32_t node, double value);
+
+  /**
+   * \brief Hand over all buffered output to the metric files.
+   *
+   * Output is buffered per metric file and written out in larger chunks. Buffered output is automatically written when the simulation is stopped by
+   * the global metrics gatherer and when the program exits. Call this method if you need the files to be up-to-date at other points in time.
+   */
+  void FlushFiles ();
 
   /**
    * \brief Retrieve the current wallclock time.
@@ -246,16 +299,85 @@ public:
   /**
    * \brief Retrieve the availability of all pieces.
    *
-   * @returns a pointer to a map that contains the availability of each piece in the swarm.
+   * @returns a reference to a vector that contains the availability of each piece in the swarm, indexed by piece.
    */
-  const std::map<uint32_t, uint32_t>& GetPieceCount () const;
+  const std::vector<uint32_t>& GetPieceCount () const;
 
   /**
    * \brief Retrieve the current demand for all pieces.
    *
-   * @returns a pointer to a map that contains the current demand (i.e., number of requests sent) for each piece in the swarm.
+   * @returns a reference to a vector that contains the current demand (i.e., number of requests sent) for each piece in the swarm, indexed by piece.
    */
-  const std::map<uint32_t, uint32_t>& GetPieceDemand () const;
+  const std::vector<uint32_t>& GetPieceDemand () const;
+
+  /**
+   * \brief Retrieve a summary of the current piece availability within the swarm.
+   *
+   * The totals are maintained with each update, so the cost of this method only depends on the availability of the rarest piece.
+   *
+   * @returns a snapshot of the current swarm health.
+   */
+  SwarmHealthSnapshot GetSwarmHealth () const;
+
+// Simulation-wide distributions
+public:
+  /**
+   * \brief Record a value of a client-local metric in the simulation-wide distribution of that metric.
+   *
+   * The distribution is kept in a QuantileSketch, so that percentiles can be reported without storing the individual values.
+   *
+   * @param metricName the name of the metric, e.g., "startup-delay-ms".
+   * @param value the value to record.
+   */
+  void AddQuantileSample (const std::string &metricName, double value);
+
+  /**
+   * \brief Merge a sketch of a client-local metric into the simulation-wide distribution of that metric.
+   *
+   * @param metricName the name of the metric.
+   * @param sketch the sketch to merge. Must use the default relative accuracy of the QuantileSketch class.
+   */
+  void MergeQuantileSketch (const std::string &metricName, const QuantileSketch &sketch);
+
+  /**
+   * @returns the simulation-wide distribution of the given metric, or 0 if no value was recorded for the metric so far.
+   */
+  const QuantileSketch* GetQuantileSketch (const std::string &metricName) const;
+
+  /**
+   * \brief Write a summary (count, mean, p50, p95, p99 and maximum) of each simulation-wide distribution to the "quantiles" metric file.
+   *
+   * Called automatically (once per simulation run) when the global metrics gatherer stops the simulation or, if the simulation is stopped
+   * by other means (e.g., Simulator::Stop with a fixed duration), when the simulator is destroyed.
+   */
+  void WriteQuantileSummaries ();
+
+// Profiling
+public:
+  /**
+   * \brief Write the report of the WallclockProfiler (wall-clock time and number of calls per hot path) to the "profiling" metric file.
+   *
+   * Called automatically (once per simulation run) when the global metrics gatherer stops the simulation or, if the simulation is stopped
+   * by other means (e.g., Simulator::Stop with a fixed duration), when the simulator is destroyed.
+   */
+  void WriteProfilingReport ();
+
+// Internal methods
+private:
+  // Write the final reports of the simulation run and flush all metric files, unless already done
+  void WriteFinalReports ();
+
+  // Write the final reports upon Simulator::Destroy and re-arm for a subsequent simulation run
+  void ProcessSimulatorDestroy ();
+
+  // Make sure that the piece-indexed vectors can hold the given number of pieces
+  void ResizePieceVectors (uint32_t numberOfPieces);
+
+  // Change the availability of one piece by +1 or -1, keeping the availability histogram and totals up to date
+  void ChangePieceCount (uint32_t pieceIndex, bool increase);
+
+  // Change the availability of all pieces set in the bitfield of a client by +1 or -1
+  void ChangePieceCountByBitfield (const std::vector<uint8_t> &bitfield, uint32_t numberOfPieces, bool increase);
 };
 
 } // ns bittorrent
@@ -27,6 +27,7 @@
 #include <fstream>
 #include <iomanip>
 #include <ios>
+#include <sstream>
 
 namespace ns3 {
 namespace pushpull {
@@ -229,6 +230,51 @@ bool MediaData::ReadMediaDataFile (std::string path)
       m_encoding = "utf8";           // this is standard
     }
 
+  // Finally, read the piece timestamp index of VBR videos, if there is one
+  m_pieceTimestamps.clear ();
+  Ptr<MediaDataDataString> pieceTimestamps = DynamicCast<MediaDataDataString> (rootDict->GetData (PP_MEDIA_DATA_PIECE_TIMESTAMPS_KEY));
+  if (pieceTimestamps)
+    {
+      std::istringstream timestampStream (pieceTimestamps->GetData ());
+      ReadPieceTimestamps (timestampStream, path);
+    }
+  else
+    {
+      std::string sidecarPath = path + PP_MEDIA_DATA_PIECE_TIMESTAMPS_SUFFIX;
+      std::ifstream sidecarFile (sidecarPath.c_str (), std::ios_base::in);
+      if (sidecarFile.is_open ())
+        {
+          ReadPieceTimestamps (sidecarFile, sidecarPath);
+        }
+    }
+
+  return true;
+}
+
+bool MediaData::ReadPieceTimestamps (std::istream& input, const std::string& source)
+{
+  m_pieceTimestamps.reserve (m_numberOfPieces + 1);
+
+  uint64_t timestamp;
+  while (input >> timestamp)
+    {
+      if ((m_pieceTimestamps.empty () && timestamp != 0) || (!m_pieceTimestamps.empty () && timestamp < m_pieceTimestamps.back ()))
+        {
+          NS_LOG_WARN ("Warning: Piece timestamps in \"" << source << "\" must start at 0 and must not decrease. Ignoring them.");
+          m_pieceTimestamps.clear ();
+          return false;
+        }
+      m_pieceTimestamps.push_back (timestamp);
+    }
+
+  if (!input.eof () || m_pieceTimestamps.size () != m_numberOfPieces + 1)
+    {
+      NS_LOG_WARN ("Warning: Expected " << m_numberOfPieces + 1 << " piece timestamps in \"" << source << "\", but found " << m_pieceTimestamps.size () << " (or malformed input). Ignoring them.");
+      m_pieceTimestamps.clear ();
+      return false;
+    }
+
+  NS_LOG_INFO ("Read piece timestamps of a video of " << m_pieceTimestamps.back () << " ms from \"" << source << "\".");
   return true;
 }
 
@@ -325,5 +371,29 @@ uint32_t MediaData::GetTrailingPieceLength () const
   return m_trailingPieceLength;
 }
 
+bool MediaData::HasPieceTimestamps () const
+{
+  return !m_pieceTimestamps.empty ();
+}
+
+uint64_t MediaData::GetPieceTimestamp (uint32_t piece) const
+{
+  NS_ASSERT (HasPieceTimestamps ());
+
+  return m_pieceTimestamps[std::min (piece, m_numberOfPieces)];
+}
+
+uint32_t MediaData::GetPieceAtTimestamp (uint64_t milliSeconds) const
+{
+  NS_ASSERT (HasPieceTimestamps ());
+
+  // The last piece starting at or before the given time; pieces without playback time (equal timestamps) are skipped over.
+  // The total length is included in the search, so that the end of the video maps to GetNumberOfPieces (like with a constant bitrate)
+  std::vector<uint64_t>::const_iterator it = std::upper_bound (m_pieceTimestamps.begin (), m_pieceTimestamps.end (), milliSeconds);
+  uint32_t piece = static_cast<uint32_t> (it - m_pieceTimestamps.begin ());
+
+  return piece > 0 ? piece - 1 : 0;
+}
+
 } // ns pushpull
 } // ns ns3
@@ -25,6 +25,8 @@
 
 #include "ns3/object.h"
 
+#include <istream>
+#include <string>
 #include <vector>
 
 namespace ns3 {
@@ -78,6 +80,7 @@ private:
   uint8_t                    m_byteValueInfoHash[20];      // Contains the infoHash as an array of 20 int-bytes
   std::vector<SHA_Hash_t>    m_pieces;                     // Char array of dynamic size holding the SHA1 hashes of the pieces
   uint8_t                    m_numberOfiles;               // Number of files in the torrent
+  std::vector<uint64_t>      m_pieceTimestamps;            // Optional: In milliseconds, the playback time at which each piece starts, plus the total length (VBR videos). Empty => Not available
 
   // Derived fields
   uint32_t                   m_bitfieldSize;               // Number of uint8_ts needed to hold the bitfield
@@ -106,6 +109,11 @@ public:
    */
   bool ReadMediaDataFile (std::string path);
 
+// Internal methods
+private:
+  // Read a piece timestamp index from the input; returns false (and leaves the index empty) if it does not fit the torrent
+  bool ReadPieceTimestamps (std::istream& input, const std::string& source);
+
 // Getters, setters
 public:
   // System-related
@@ -214,6 +222,32 @@ public:
    * @returns the length (in bytes) of the trailing piece.
    */
   uint32_t GetTrailingPieceLength () const;
+
+  // Video-on-Demand-related
+
+  /**
+   * \brief Check whether the torrent comes with a per-piece timestamp index, e.g., for a video file encoded with a variable bitrate.
+   *
+   * The index is read along with the ".torrent" file, either from the optional metainfo key PP_MEDIA_DATA_PIECE_TIMESTAMPS_KEY or, without it,
+   * from a sidecar file named like the ".torrent" file plus PP_MEDIA_DATA_PIECE_TIMESTAMPS_SUFFIX. Both hold whitespace-separated integers:
+   * the playback time (in milliseconds) at which each piece starts, in the order of the pieces, followed by the total length of the video.
+   * The first timestamp must be 0 and the timestamps must not decrease. Indices that do not fit the torrent are ignored.
+   *
+   * @returns true, if the PushPullVideoClient class can map between pieces and playback times via the index instead of assuming a constant bitrate.
+   */
+  bool HasPieceTimestamps () const;
+
+  /**
+   * @returns the playback time (in milliseconds) at which the given piece starts; for GetNumberOfPieces or greater, the total length of the video.
+   * Requires a piece timestamp index (see HasPieceTimestamps).
+   */
+  uint64_t GetPieceTimestamp (uint32_t piece) const;
+
+  /**
+   * @returns the index of the piece that contains the given playback time (in milliseconds), in O(log n) time; GetNumberOfPieces for playback times
+   * at or beyond the end of the video. Requires a piece timestamp index (see HasPieceTimestamps).
+   */
+  uint32_t GetPieceAtTimestamp (uint64_t milliSeconds) const;
 };
 
 } // ns pushpull
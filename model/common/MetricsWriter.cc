@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "MetricsWriter.h"
+
+#include "ns3/PushPullDefines.h"
+
+#include <fstream>
+#include <ios>
+#include <sstream>
+
+namespace ns3 {
+namespace bittorrent {
+
+MetricsWriter::MetricsWriter ()
+{
+  m_fileNamePrefix = "undefined";
+  m_bufferSize = PP_METRICS_WRITER_BUFFER_SIZE;
+}
+
+MetricsWriter::~MetricsWriter ()
+{
+  Close ();
+}
+
+void MetricsWriter::SetFileNamePrefix (const std::string &fileNamePrefix)
+{
+  if (fileNamePrefix != m_fileNamePrefix)
+    {
+      Close ();
+      m_fileNamePrefix = fileNamePrefix;
+    }
+}
+
+void MetricsWriter::SetBufferSize (uint32_t bufferSize)
+{
+  m_bufferSize = bufferSize;
+}
+
+uint32_t MetricsWriter::GetMetricId (const std::string &metricName)
+{
+  std::map<std::string, uint32_t>::const_iterator it = m_metricIds.find (metricName);
+  if (it != m_metricIds.end ())
+    {
+      return (*it).second;
+    }
+
+  uint32_t newId = m_metricIds.size ();
+  m_metricIds[metricName] = newId;
+
+  return newId;
+}
+
+bool MetricsWriter::WriteLine (const std::string &metricName, const std::string &line)
+{
+  Sink &sink = GetSink (m_textSinks, metricName, false);
+  if (sink.m_stream == 0)
+    {
+      return false;
+    }
+
+  sink.m_buffer.append (line);
+  sink.m_buffer.push_back ('\n');
+  DrainSink (sink, false);
+
+  return true;
+}
+
+bool MetricsWriter::WriteRecord (const std::string &metricName, int64_t timestamp, uint32_t node, double value)
+{
+  Sink &sink = GetSink (m_binarySinks, metricName, true);
+  if (sink.m_stream == 0)
+    {
+      return false;
+    }
+
+  Record record;
+  record.m_timestamp = timestamp;
+  record.m_value = value;
+  record.m_node = node;
+  record.m_metricId = GetMetricId (metricName);
+
+  sink.m_buffer.append (reinterpret_cast<const char*> (&record), sizeof (Record));
+  DrainSink (sink, false);
+
+  return true;
+}
+
+void MetricsWriter::Flush ()
+{
+  for (std::map<std::string, Sink>::iterator it = m_textSinks.begin (); it != m_textSinks.end (); ++it)
+    {
+      DrainSink ((*it).second, true);
+    }
+  for (std::map<std::string, Sink>::iterator it = m_binarySinks.begin (); it != m_binarySinks.end (); ++it)
+    {
+      DrainSink ((*it).second, true);
+    }
+}
+
+void MetricsWriter::Close ()
+{
+  CloseSinks (m_textSinks);
+  CloseSinks (m_binarySinks);
+}
+
+int64_t MetricsWriter::ConvertToText (const std::string &binaryFileName, const std::string &textFileName)
+{
+  // Step 1: Open the binary file and check its header
+  std::ifstream binaryFile (binaryFileName.c_str (), std::ios_base::in | std::ios_base::binary);
+  if (!binaryFile.is_open ())
+    {
+      return -1;
+    }
+
+  uint32_t magic = 0;
+  uint16_t version = 0;
+  uint16_t nameLength = 0;
+  binaryFile.read (reinterpret_cast<char*> (&magic), sizeof (magic));
+  binaryFile.read (reinterpret_cast<char*> (&version), sizeof (version));
+  binaryFile.read (reinterpret_cast<char*> (&nameLength), sizeof (nameLength));
+  if (!binaryFile.good () || magic != BINARY_FILE_MAGIC || version != BINARY_FILE_VERSION)
+    {
+      return -1;
+    }
+  binaryFile.seekg (nameLength, std::ios_base::cur); // The metric name is not needed for the text layout
+
+  // Step 2: Open the text file
+  std::ofstream textFile (textFileName.c_str (), std::ios_base::app);
+  if (!textFile.is_open () || !textFile.good ())
+    {
+      return -1;
+    }
+
+  // Step 3: Convert the records; a truncated trailing record (e.g., from an aborted simulation) is ignored
+  int64_t converted = 0;
+  Record record;
+  while (binaryFile.read (reinterpret_cast<char*> (&record), sizeof (Record)))
+    {
+      textFile << record.m_timestamp << "ms: Node " << record.m_node << ": " << record.m_value << "\n";
+      ++converted;
+    }
+
+  return converted;
+}
+
+MetricsWriter::Sink& MetricsWriter::GetSink (std::map<std::string, Sink> &sinks, const std::string &metricName, bool binary)
+{
+  // Step 1: Return the sink if the file was already opened before (or opening it failed)
+  std::map<std::string, Sink>::iterator it = sinks.find (metricName);
+  if (it != sinks.end ())
+    {
+      return (*it).second;
+    }
+
+  // Step 2: Else, open the file
+  Sink &sink = sinks[metricName];
+  sink.m_stream = new std::ofstream ();
+  if (binary)
+    {
+      sink.m_stream->open (std::string (m_fileNamePrefix + "-" + metricName + ".bin").c_str (), std::ios_base::app | std::ios_base::binary);
+    }
+  else
+    {
+      sink.m_stream->open (std::string (m_fileNamePrefix + "-" + metricName + ".dat").c_str (), std::ios_base::app);
+    }
+
+  if (!sink.m_stream->is_open () || !sink.m_stream->good ())
+    {
+      delete sink.m_stream;
+      sink.m_stream = 0;
+      return sink;
+    }
+
+  // Step 3: Write the header of newly-created binary files
+  sink.m_stream->seekp (0, std::ios_base::end);
+  if (binary && sink.m_stream->tellp () == 0)
+    {
+      uint32_t magic = BINARY_FILE_MAGIC;
+      uint16_t version = BINARY_FILE_VERSION;
+      uint16_t nameLength = metricName.size ();
+      sink.m_buffer.append (reinterpret_cast<const char*> (&magic), sizeof (magic));
+      sink.m_buffer.append (reinterpret_cast<const char*> (&version), sizeof (version));
+      sink.m_buffer.append (reinterpret_cast<const char*> (&nameLength), sizeof (nameLength));
+      sink.m_buffer.append (metricName);
+    }
+
+  sink.m_buffer.reserve (m_bufferSize + sizeof (Record));
+
+  return sink;
+}
+
+void MetricsWriter::DrainSink (Sink &sink, bool force)
+{
+  if (sink.m_stream == 0 || sink.m_buffer.empty ())
+    {
+      return;
+    }
+
+  if (force || sink.m_buffer.size () >= m_bufferSize)
+    {
+      sink.m_stream->write (sink.m_buffer.data (), sink.m_buffer.size ());
+      sink.m_buffer.clear ();
+      if (force)
+        {
+          sink.m_stream->flush ();
+        }
+    }
+}
+
+void MetricsWriter::CloseSinks (std::map<std::string, Sink> &sinks)
+{
+  for (std::map<std::string, Sink>::iterator it = sinks.begin (); it != sinks.end (); ++it)
+    {
+      if ((*it).second.m_stream != 0)
+        {
+          DrainSink ((*it).second, true);
+          (*it).second.m_stream->close ();
+          delete (*it).second.m_stream;
+          (*it).second.m_stream = 0;
+        }
+    }
+  sinks.clear ();
+}
+
+} // ns bittorrent
+} // ns ns3
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef METRICSWRITER_H_
+#define METRICSWRITER_H_
+
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Buffered output sink for the metric files written by the GlobalMetricsGatherer.
+ *
+ * This class keeps one open file handle per metric and collects output in memory until a configurable amount of data
+ * has accumulated, so that writing a metric line does not result in opening, appending to and closing a file each time.
+ *
+ * Besides the traditional text output (one "<milliseconds>ms: <string>" line per entry in a ".dat" file), the writer supports a
+ * compact binary format for numeric metrics. Each binary file starts with a small header (magic number, format version, metric
+ * name) followed by fixed-size records (timestamp, node, metric id, value), see the Record type. Binary files can be converted
+ * into the text layout after the simulation using the ConvertToText method.
+ */
+class MetricsWriter
+{
+// Types used
+public:
+  /**
+   * \brief A single fixed-size binary metric record. The field order avoids padding, so sizeof (Record) equals 24 bytes.
+   */
+  typedef struct
+  {
+    int64_t  m_timestamp;              // Simulation time in milliseconds
+    double   m_value;                  // The numeric value of the metric
+    uint32_t m_node;                   // The id of the node the value was recorded for
+    uint32_t m_metricId;               // The id of the metric as assigned by the GetMetricId method
+  } Record;
+
+  static const uint32_t BINARY_FILE_MAGIC = 0x50504d42; // "PPMB"
+  static const uint16_t BINARY_FILE_VERSION = 1;
+
+private:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    std::ofstream *m_stream;           // The open handle of the file, NULL if it could not be opened
+    std::string    m_buffer;           // Data not yet handed over to the stream
+  } Sink;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  std::string                        m_fileNamePrefix;     // The prefix for all written files
+  uint32_t                           m_bufferSize;         // The amount of buffered bytes per file after which the buffer is written out
+  std::map<std::string, Sink>        m_textSinks;          // Open ".dat" files, by metric name
+  std::map<std::string, Sink>        m_binarySinks;        // Open ".bin" files, by metric name
+  std::map<std::string, uint32_t>    m_metricIds;          // The ids assigned to metric names
+
+// Constructors etc.
+public:
+  MetricsWriter ();
+  virtual ~MetricsWriter ();
+private:
+  MetricsWriter (const MetricsWriter&);
+  MetricsWriter& operator = (const MetricsWriter&);
+
+// Getters, setters
+public:
+  /**
+   * \brief Set the prefix for all files written by this instance.
+   *
+   * Files that are already open are flushed and closed, so subsequent output goes to files with the new prefix.
+   *
+   * @param fileNamePrefix the desired prefix. May contain slashes to denote paths.
+   */
+  void SetFileNamePrefix (const std::string &fileNamePrefix);
+
+  /**
+   * \brief Set the number of bytes buffered per file before the buffer is handed over to the file.
+   *
+   * @param bufferSize the desired buffer size. A value of 0 writes out every entry immediately (but still keeps the file open).
+   */
+  void SetBufferSize (uint32_t bufferSize);
+
+  /**
+   * \brief Get the numeric id used in binary records for a metric.
+   *
+   * Ids are assigned on first use in ascending order and stay constant for the lifetime of this instance.
+   *
+   * @param metricName the name of the metric.
+   *
+   * @returns the id of the metric.
+   */
+  uint32_t GetMetricId (const std::string &metricName);
+
+// Output methods
+public:
+  /**
+   * \brief Append a line to the text file GetFileNamePrefix()-metricName.dat.
+   *
+   * @param metricName the name of the metric.
+   * @param line the line to write, without trailing newline.
+   *
+   * @returns false, if the file could not be opened. The line is discarded in this case.
+   */
+  bool WriteLine (const std::string &metricName, const std::string &line);
+
+  /**
+   * \brief Append a binary record to the file GetFileNamePrefix()-metricName.bin.
+   *
+   * @param metricName the name of the metric.
+   * @param timestamp the simulation time in milliseconds the value belongs to.
+   * @param node the id of the node the value was recorded for.
+   * @param value the value to record.
+   *
+   * @returns false, if the file could not be opened. The record is discarded in this case.
+   */
+  bool WriteRecord (const std::string &metricName, int64_t timestamp, uint32_t node, double value);
+
+  /**
+   * \brief Hand over all buffered data to the files and flush them.
+   */
+  void Flush ();
+
+  /**
+   * \brief Flush and close all open files.
+   */
+  void Close ();
+
+  /**
+   * \brief Convert a binary metric file into the text layout used for ".dat" files.
+   *
+   * Each record is written as one line of the form "<milliseconds>ms: Node <node>: <value>".
+   *
+   * @param binaryFileName the path to the binary file to read.
+   * @param textFileName the path to the text file to write. The file is appended if it already exists.
+   *
+   * @returns the number of converted records, or -1 if the binary file could not be read or is malformed.
+   */
+  static int64_t ConvertToText (const std::string &binaryFileName, const std::string &textFileName);
+
+// Internal methods
+private:
+  // Retrieve the sink for a metric, opening the respective file if necessary
+  Sink& GetSink (std::map<std::string, Sink> &sinks, const std::string &metricName, bool binary);
+
+  // Hand over the buffer of a sink to its stream if it has reached the buffer size (or unconditionally, if force is set)
+  void DrainSink (Sink &sink, bool force);
+
+  // Flush and close all sinks of the given map
+  void CloseSinks (std::map<std::string, Sink> &sinks);
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#endif /* METRICSWRITER_H_ */
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "NetworkLocality.h"
+
+namespace ns3 {
+namespace bittorrent {
+
+NetworkLocality::NetworkLocality ()
+{
+  m_intraAsDelay = MilliSeconds (5);
+  m_interAsDelay = MilliSeconds (25);
+  m_unknownRoundTripTime = Seconds (1);
+}
+
+NetworkLocality::~NetworkLocality ()
+{
+  m_locations.clear ();
+}
+
+void NetworkLocality::SetLocation (uint32_t address, int32_t autonomousSystem, uint32_t accessRouter, Time accessLinkDelay)
+{
+  Location &location = m_locations[address];
+  location.m_autonomousSystem = autonomousSystem;
+  location.m_accessRouter = accessRouter;
+  location.m_accessLinkDelay = accessLinkDelay;
+}
+
+void NetworkLocality::Clear ()
+{
+  m_locations.clear ();
+}
+
+void NetworkLocality::SetRouterDelays (Time intraAsDelay, Time interAsDelay, Time unknownRoundTripTime)
+{
+  m_intraAsDelay = intraAsDelay;
+  m_interAsDelay = interAsDelay;
+  m_unknownRoundTripTime = unknownRoundTripTime;
+}
+
+bool NetworkLocality::HasLocation (uint32_t address) const
+{
+  return m_locations.find (address) != m_locations.end ();
+}
+
+int32_t NetworkLocality::GetAutonomousSystem (uint32_t address) const
+{
+  std::map<uint32_t, Location>::const_iterator it = m_locations.find (address);
+  if (it == m_locations.end ())
+    {
+      return -1;
+    }
+
+  return (*it).second.m_autonomousSystem;
+}
+
+Time NetworkLocality::EstimateRoundTripTime (uint32_t from, uint32_t to) const
+{
+  std::map<uint32_t, Location>::const_iterator fromIt = m_locations.find (from);
+  std::map<uint32_t, Location>::const_iterator toIt = m_locations.find (to);
+  if (fromIt == m_locations.end () || toIt == m_locations.end ())
+    {
+      return m_unknownRoundTripTime;
+    }
+
+  const Location &fromLocation = (*fromIt).second;
+  const Location &toLocation = (*toIt).second;
+
+  // Step 1: The access links are traversed in any case
+  Time oneWayDelay = fromLocation.m_accessLinkDelay + toLocation.m_accessLinkDelay;
+
+  // Step 2: Add the delay between the access routers
+  if (fromLocation.m_autonomousSystem != toLocation.m_autonomousSystem)
+    {
+      oneWayDelay += m_interAsDelay;
+    }
+  else if (fromLocation.m_accessRouter != toLocation.m_accessRouter)
+    {
+      oneWayDelay += m_intraAsDelay;
+    }
+
+  return oneWayDelay + oneWayDelay;
+}
+
+} // ns bittorrent
+} // ns ns3
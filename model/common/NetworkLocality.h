@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef NETWORKLOCALITY_H_
+#define NETWORKLOCALITY_H_
+
+#include "ns3/nstime.h"
+
+#include <map>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Provides the topological location of the simulated clients to the strategies of other clients.
+ *
+ * Topology helpers (e.g., the BriteTopologyHelper) register each client's IP address together with its autonomous system,
+ * its access router and the delay of its access link once the network is established. Strategies may then use this information,
+ * e.g., to prefer connections to nearby peers. Real-world clients would obtain comparable information from
+ * latency measurements or IP-to-AS mappings.
+ *
+ * Round-trip times are estimated from the access link delays of both clients plus a fixed delay for the path between their access routers,
+ * which depends on whether the routers are identical, in the same autonomous system or in different ones.
+ */
+class NetworkLocality
+{
+// Types used
+private:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    int32_t  m_autonomousSystem;   // The autonomous system the client is located in
+    uint32_t m_accessRouter;       // The node id of the client's access router
+    Time     m_accessLinkDelay;    // The one-way delay of the client's access link
+  } Location;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  std::map<uint32_t, Location> m_locations;   // The registered locations, by IP address (in integer representation)
+
+  Time m_intraAsDelay;                        // The assumed one-way delay between two access routers in the same autonomous system
+  Time m_interAsDelay;                        // The assumed one-way delay between two access routers in different autonomous systems
+  Time m_unknownRoundTripTime;                // The round-trip time assumed if the location of a client is not known
+
+// Constructors etc.
+private:
+  NetworkLocality ();
+  NetworkLocality (const NetworkLocality &);
+  NetworkLocality& operator= (const NetworkLocality &);
+
+public:
+  virtual ~NetworkLocality ();
+
+  static NetworkLocality* GetInstance ()
+  {
+    static NetworkLocality s_instance;
+
+    return &s_instance;
+  }
+
+// Registration
+public:
+  /**
+   * \brief Register the location of a client. An existing registration for the same address is replaced.
+   *
+   * @param address the IP address (in integer representation) of the client.
+   * @param autonomousSystem the autonomous system of the client.
+   * @param accessRouter the node id of the router the client is attached to.
+   * @param accessLinkDelay the one-way delay of the link between client and access router.
+   */
+  void SetLocation (uint32_t address, int32_t autonomousSystem, uint32_t accessRouter, Time accessLinkDelay);
+
+  /**
+   * \brief Remove all registered locations.
+   */
+  void Clear ();
+
+  /**
+   * \brief Set the assumed one-way delays between access routers used for round-trip time estimation.
+   *
+   * @param intraAsDelay the delay between two different access routers within the same autonomous system. Defaults to 5 ms.
+   * @param interAsDelay the delay between two access routers in different autonomous systems. Defaults to 25 ms.
+   * @param unknownRoundTripTime the round-trip time assumed for clients without registered location. Defaults to 1 s, i.e., such clients are ranked last.
+   */
+  void SetRouterDelays (Time intraAsDelay, Time interAsDelay, Time unknownRoundTripTime);
+
+// Evaluation
+public:
+  /**
+   * @returns true, if a location was registered for the given address.
+   */
+  bool HasLocation (uint32_t address) const;
+
+  /**
+   * @returns the autonomous system registered for the given address, or -1 if no location was registered.
+   */
+  int32_t GetAutonomousSystem (uint32_t address) const;
+
+  /**
+   * \brief Estimate the round-trip time between two clients.
+   *
+   * @returns the estimated round-trip time, or the unknown round-trip time (see SetRouterDelays) if one of the locations is not registered.
+   */
+  Time EstimateRoundTripTime (uint32_t from, uint32_t to) const;
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#endif /* NETWORKLOCALITY_H_ */
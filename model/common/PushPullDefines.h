@@ -32,6 +32,9 @@
 #define PP_PEER_SOCKET_RECEIVE_BUFFER_SIZE 65536 // In bytes; per client connection 125000000 = Maximum bytes in Gigabit Ethernet per second
 #define PP_PEER_SOCKET_TCP_SEGMENT_SIZE_MAX 1452 // In bytes; per client connection; 1452 = Maximum segment size for most access providers (PPPoE); 536 = Default for many systems
 #define PP_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS 20 // Rolling down/upload rate is calculated over the given last seconds; 20 = Standard
+#define PP_PEER_RECEIVE_BUFFER_INITIAL_SIZE 65536 // In bytes; the initial size of the per-connection receive buffer, which grows if a message does not fit into it
+#define PP_RATE_ESTIMATOR_RESOLUTION 250 // In milliseconds; the duration of a bucket of the rolling down/upload rate estimation
+#define PP_RATE_ESTIMATOR_EWMA_HALF_LIFE 2000 // In milliseconds; the half-life of the exponentially-weighted moving average of the down/upload rate
 
 #define PP_PEER_PIECE_RECEPTION_NOT_RECEIVED 0
 #define PP_PEER_PIECE_RECEPTION_CHECKSUM_OK 255
@@ -44,6 +47,7 @@
 #define PP_PROTOCOL_MESSAGES_HANDSHAKE_PROTOCOL_STRING_LENGTH 19 // Length of above PP_PROTOCOL_MESSAGES_HANDSHAKE_PROTOCOL_STRING string (8-bit characters)
 #define PP_PROTOCOL_MESSAGES_HANDSHAKE_PEERID_LENGTH_MAX 20 // Only update for general revisions of the PP protocol; 20 = Standard
 #define PP_PROTOCOL_MESSAGES_KEEPALIVE_LENGTH 0
+#define PP_PROTOCOL_MESSAGES_CHOKE_LENGTH 1
 #define PP_PROTOCOL_MESSAGES_INTERESTED_LENGTH 1
 #define PP_PROTOCOL_MESSAGES_UNINTERESTED_LENGTH 1
 #define PP_PROTOCOL_MESSAGES_HAVE_LENGTH 5
@@ -52,7 +56,44 @@
 #define PP_PROTOCOL_MESSAGES_PIECE_LENGTH_MIN 9
 #define PP_PROTOCOL_MESSAGES_CANCEL_LENGTH 13
 #define PP_PROTOCOL_MESSAGES_PORT_LENGTH 3
+#define PP_PROTOCOL_MESSAGES_SUGGEST_PIECE_LENGTH 5
+#define PP_PROTOCOL_MESSAGES_HAVE_ALL_LENGTH 1
+#define PP_PROTOCOL_MESSAGES_HAVE_NONE_LENGTH 1
+#define PP_PROTOCOL_MESSAGES_REJECT_REQUEST_LENGTH 13
+#define PP_PROTOCOL_MESSAGES_ALLOWED_FAST_LENGTH 5
 #define PP_PROTOCOL_MESSAGES_EXTENSIONPROTOCOL_LENGTH_MIN 1
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_BYTE 7 // The reserved byte of the handshake message that announces support for compressed bitfields
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_COMPRESSED_BITFIELD_MASK 0x08 // The bit within the above byte that announces support for compressed bitfields
+#define PP_PROTOCOL_EXTENSION_MESSAGE_ID_COMPRESSED_BITFIELD 1 // The Extension Protocol message id of compressed bitfield messages
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_BYTE 6 // The reserved byte of the handshake message that announces a cached session with the receiver (not assigned by BEP 4)
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_SESSION_RESUME_MASK 0x01 // The bit within the above byte that announces a cached session with the receiver
+#define PP_PROTOCOL_EXTENSION_MESSAGE_ID_BITFIELD_DELTA 2 // The Extension Protocol message id of the bitfield deltas sent instead of bitfields when resuming a session
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_BYTE 7 // The reserved byte of the handshake message that announces support for availability windows
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_AVAILABILITY_WINDOW_MASK 0x02 // The bit within the above byte that announces support for availability windows
+#define PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW 3 // The Extension Protocol message id of availability windows (first piece, number of pieces, bits of the window)
+#define PP_PROTOCOL_EXTENSION_MESSAGE_ID_AVAILABILITY_WINDOW_MOVE 4 // The Extension Protocol message id of forward moves of availability windows (new first piece, bits of the entering pieces)
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_BYTE 7 // The reserved byte of the handshake message that announces support for the Fast Extension (SUGGEST_PIECE, HAVE_ALL, HAVE_NONE, REJECT_REQUEST, ALLOWED_FAST)
+#define PP_PROTOCOL_HANDSHAKE_RESERVED_FAST_EXTENSION_MASK 0x04 // The bit within the above byte that announces support for the Fast Extension (as in BEP 6)
+#define PP_PROTOCOL_EXTENSION_MESSAGE_ID_PLAYBACK_DEADLINE 5 // The Extension Protocol message id of playback deadline hints (playback position, playback time per piece, playing flag)
+#define PP_PEER_SESSION_CACHE_SIZE 64 // The default number of closed connections whose session (bitfields, rates) is kept for fast reconnects
+#define PP_PEER_ALLOWED_FAST_SET_SIZE 10 // The number of pieces a peer may request while being choked, if both sides support the Fast Extension; 10 = BEP 6 recommendation
+#define PP_PEER_URGENT_PIECE_WINDOW 8 // Requests for pieces within this number of pieces from the first piece missing at the requesting peer are sent as urgent data
+
+#define PP_PIPELINE_MIN_REQUESTS 2 // Lower bound for the number of concurrent requests per peer in adaptive pipelining mode
+#define PP_PIPELINE_MAX_REQUESTS 250 // Upper bound for the number of concurrent requests per peer in adaptive pipelining mode
+#define PP_PIPELINE_BDP_GAIN 2.0 // The request window covers this multiple of the bandwidth-delay product, leaving room for the rate estimate to grow
+#define PP_PIPELINE_RTT_FILTER_WINDOW 10000 // In milliseconds; the round-trip time estimate is the minimum request latency observed within this period
+#define PP_PIPELINE_TIMEOUT_FACTOR 4 // In adaptive pipelining mode, requests time out after this multiple of their expected completion time
+
+#define PP_SEEK_RELEVANT_PIECES 8 // Requests for pieces within this number of pieces from the new playback position (or within the pre-buffering time, if longer) survive a seek
+
+#define PP_FAST_START_PIPELINE_FACTOR 2 // During fast start, the request window of each peer is raised by this factor (up to PP_PIPELINE_MAX_REQUESTS)
+#define PP_FAST_START_REQUESTS_PER_PEER_PER_PIECE 1 // During fast start, each peer is asked for at most this many blocks of a piece within the pre-buffering range at a time
+
+#define PP_ENDGAME_MAX_REQUESTS_PER_BLOCK 3 // In endgame mode, each remaining block may be requested from up to this many peers concurrently (unless the client allows more anyway)
+
+#define PP_MEDIA_DATA_PIECE_TIMESTAMPS_KEY "piece timestamps" // Optional metainfo key holding the per-piece timestamp index of VBR videos (see MediaData::HasPieceTimestamps)
+#define PP_MEDIA_DATA_PIECE_TIMESTAMPS_SUFFIX ".timestamps" // Without the metainfo key, the index is read from the sidecar file named like the ".torrent" file plus this suffix, if present
 
 #define PP_PROTOCOL_PUSH_WINDOW 40
 #define PP_PROTOCOL_PULL_WINDOW 8
@@ -62,5 +103,22 @@
 #define PP_PROTOCOL_PULL_LISTENER_PORT 6882
 
 #define PP_PEER_CONNECTOR_CONNECTION_ACCEPTANCE_DELAY 10000 // In milliseconds; Usually, 10 seconds should be enough
+#define PP_PEER_CONNECTOR_LOCALITY_EXPLORATION_FRACTION 0.2 // Fraction of new connections that the locality-aware peer connector establishes with randomly-chosen peers
+
+#define PP_CHOKE_VOD_ROUND_INTERVAL 10000 // In milliseconds; interval between two rounds of the upload-aware VoD choking/unchoking strategy; 10 seconds = Standard
+#define PP_CHOKE_VOD_OPTIMISTIC_UNCHOKE_ROUNDS 3 // The optimistic unchoke is rotated every n rounds; 3 (i.e., 30 seconds) = Standard
+#define PP_CHOKE_VOD_MIN_UNCHOKED_PEERS 2 // Lower bound for the number of unchoke slots, including the optimistic unchoke
+#define PP_CHOKE_VOD_MIN_SLOT_RATE 16000 // In bps; minimum upload rate per unchoked peer that justifies an additional unchoke slot
+#define PP_CHOKE_VOD_SLOT_RATE_FRACTION 0.25 // For video clients, the minimum upload rate per unchoked peer is at least this fraction of the video bitrate
+
+#define PP_UPLOAD_SCHEDULER_MAX_BACKLOG 131072 // In bytes; the deadline upload scheduler only hands blocks to peers while the data not yet acknowledged by all peers is below this amount
+#define PP_UPLOAD_SCHEDULER_QUANTUM 16384 // In bytes; the amount of data each peer may send per round of the deficit round robin
+#define PP_UPLOAD_SCHEDULER_URGENT_HORIZON 2000 // In milliseconds; blocks due within this time are sent before all others, in order of their deadline
+#define PP_UPLOAD_SCHEDULER_URGENT_CREDIT 4 // The number of quanta a peer may overdraw its deficit by with urgent blocks
+#define PP_UPLOAD_SCHEDULER_INTERVAL 10 // In milliseconds; interval of dispatch attempts while blocks are held back due to the backlog limit
+
+#define PP_METRICS_WRITER_BUFFER_SIZE 65536 // In bytes; per metric file; output is handed over to the file once this amount of data has been collected
+
+#define PP_WALLCLOCK_PROFILING_ENABLED 1 // 1 = Measure the wall-clock time spent in the hot paths of the simulation (see WallclockProfiler); 0 = Compile without measurements
 
 #endif /* PUSHPULLCLIENT_DEFINES_H_ */
@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace bittorrent {
+
+QuantileSketch::QuantileSketch (double relativeAccuracy)
+{
+  if (relativeAccuracy <= 0 || relativeAccuracy >= 1)
+    {
+      relativeAccuracy = 0.01;
+    }
+
+  m_relativeAccuracy = relativeAccuracy;
+  m_gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+  m_logGamma = std::log (m_gamma);
+
+  Clear ();
+}
+
+QuantileSketch::~QuantileSketch ()
+{
+  m_buckets.clear ();
+}
+
+void QuantileSketch::Add (double value)
+{
+  // Step 1: Update the summary values
+  if (m_count == 0)
+    {
+      m_min = m_max = value;
+    }
+  else
+    {
+      m_min = std::min (m_min, value);
+      m_max = std::max (m_max, value);
+    }
+  ++m_count;
+  m_sum += value;
+
+  // Step 2: Sort the value into its bucket
+  if (value < GetMinimumValue ())
+    {
+      ++m_zeroCount;
+      return;
+    }
+
+  int32_t index = GetBucketIndex (value);
+  ExtendBuckets (index);
+  ++m_buckets[index - m_offset];
+}
+
+bool QuantileSketch::Merge (const QuantileSketch &other)
+{
+  if (other.m_relativeAccuracy != m_relativeAccuracy)
+    {
+      return false;
+    }
+
+  if (other.m_count == 0)
+    {
+      return true;
+    }
+
+  // Step 1: Merge the summary values
+  if (m_count == 0)
+    {
+      m_min = other.m_min;
+      m_max = other.m_max;
+    }
+  else
+    {
+      m_min = std::min (m_min, other.m_min);
+      m_max = std::max (m_max, other.m_max);
+    }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_zeroCount += other.m_zeroCount;
+
+  // Step 2: Add up the buckets, which have the same bounds in both sketches
+  if (!other.m_buckets.empty ())
+    {
+      ExtendBuckets (other.m_offset);
+      ExtendBuckets (other.m_offset + static_cast<int32_t> (other.m_buckets.size ()) - 1);
+      for (uint32_t i = 0; i < other.m_buckets.size (); ++i)
+        {
+          m_buckets[other.m_offset + i - m_offset] += other.m_buckets[i];
+        }
+    }
+
+  return true;
+}
+
+void QuantileSketch::Clear ()
+{
+  m_offset = 0;
+  m_buckets.clear ();
+  m_zeroCount = 0;
+  m_count = 0;
+  m_sum = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+double QuantileSketch::GetQuantile (double quantile) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+
+  quantile = std::max (0.0, std::min (1.0, quantile));
+
+  // Step 1: The extremes are known exactly
+  if (quantile == 0)
+    {
+      return m_min;
+    }
+  if (quantile == 1)
+    {
+      return m_max;
+    }
+
+  // Step 2: Walk through the buckets until the rank of the quantile is reached
+  uint64_t rank = static_cast<uint64_t> (quantile * (m_count - 1));
+  uint64_t seen = m_zeroCount;
+  if (seen > rank)
+    {
+      return std::max (0.0, m_min);
+    }
+
+  for (uint32_t i = 0; i < m_buckets.size (); ++i)
+    {
+      seen += m_buckets[i];
+      if (seen > rank)
+        {
+          return std::max (m_min, std::min (m_max, GetBucketValue (m_offset + i)));
+        }
+    }
+
+  return m_max;
+}
+
+uint64_t QuantileSketch::GetCount () const
+{
+  return m_count;
+}
+
+double QuantileSketch::GetSum () const
+{
+  return m_sum;
+}
+
+double QuantileSketch::GetMin () const
+{
+  return m_min;
+}
+
+double QuantileSketch::GetMax () const
+{
+  return m_max;
+}
+
+double QuantileSketch::GetRelativeAccuracy () const
+{
+  return m_relativeAccuracy;
+}
+
+double QuantileSketch::GetMinimumValue ()
+{
+  return 1e-9;
+}
+
+int32_t QuantileSketch::GetBucketIndex (double value) const
+{
+  return static_cast<int32_t> (std::ceil (std::log (value) / m_logGamma));
+}
+
+double QuantileSketch::GetBucketValue (int32_t index) const
+{
+  // The bucket covers (gamma^(index - 1), gamma^index]; this value has a relative error of at most m_relativeAccuracy for the whole range
+  return 2 * std::pow (m_gamma, index) / (m_gamma + 1);
+}
+
+void QuantileSketch::ExtendBuckets (int32_t index)
+{
+  if (m_buckets.empty ())
+    {
+      m_offset = index;
+      m_buckets.resize (1, 0);
+    }
+  else if (index < m_offset)
+    {
+      m_buckets.insert (m_buckets.begin (), m_offset - index, 0);
+      m_offset = index;
+    }
+  else if (index >= m_offset + static_cast<int32_t> (m_buckets.size ()))
+    {
+      m_buckets.resize (index - m_offset + 1, 0);
+    }
+}
+
+} // ns bittorrent
+} // ns ns3
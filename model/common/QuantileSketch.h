@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef QUANTILESKETCH_H_
+#define QUANTILESKETCH_H_
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief A streaming, mergeable sketch for estimating quantiles of non-negative values.
+ *
+ * The sketch sorts values into logarithmically-sized buckets, so that each quantile estimate lies within a fixed relative error
+ * of the true value (the approach is known as DDSketch). Memory use only depends on the range of the recorded values,
+ * not on their number, and two sketches with the same relative accuracy can be merged without loss.
+ *
+ * Values smaller than GetMinimumValue (including negative values) are counted as zero.
+ */
+class QuantileSketch
+{
+// Fields
+private:
+  double                m_relativeAccuracy;   // The guaranteed relative error of quantile estimates
+  double                m_gamma;              // The ratio between the upper bounds of two adjacent buckets
+  double                m_logGamma;           // Cached ln (m_gamma)
+
+  int32_t               m_offset;             // The bucket index corresponding to m_buckets[0]
+  std::vector<uint64_t> m_buckets;            // The number of values per bucket
+  uint64_t              m_zeroCount;          // The number of values counted as zero
+
+  uint64_t              m_count;              // The number of recorded values
+  double                m_sum;                // The sum of the recorded values
+  double                m_min;                // The smallest recorded value
+  double                m_max;                // The largest recorded value
+
+// Constructors etc.
+public:
+  /**
+   * \brief Create an empty sketch.
+   *
+   * @param relativeAccuracy the desired relative error of quantile estimates (0 < relativeAccuracy < 1). Defaults to 1%.
+   */
+  QuantileSketch (double relativeAccuracy = 0.01);
+  virtual ~QuantileSketch ();
+
+// Recording
+public:
+  /**
+   * \brief Record a value.
+   */
+  void Add (double value);
+
+  /**
+   * \brief Add all values recorded by another sketch to this sketch.
+   *
+   * @param other the sketch to merge. Must have been created with the same relative accuracy; otherwise, the call is ignored.
+   *
+   * @returns true, if the sketches were merged.
+   */
+  bool Merge (const QuantileSketch &other);
+
+  /**
+   * \brief Remove all recorded values.
+   */
+  void Clear ();
+
+// Evaluation
+public:
+  /**
+   * \brief Estimate a quantile of the recorded values.
+   *
+   * @param quantile the desired quantile (0.0 <= quantile <= 1.0), e.g., 0.99 for the 99th percentile.
+   *
+   * @returns the estimated value, or 0 if the sketch is empty.
+   */
+  double GetQuantile (double quantile) const;
+
+  uint64_t GetCount () const;
+
+  double GetSum () const;
+
+  /**
+   * @returns the smallest recorded value, or 0 if the sketch is empty.
+   */
+  double GetMin () const;
+
+  /**
+   * @returns the largest recorded value, or 0 if the sketch is empty.
+   */
+  double GetMax () const;
+
+  double GetRelativeAccuracy () const;
+
+  /**
+   * @returns the smallest value that is not counted as zero.
+   */
+  static double GetMinimumValue ();
+
+// Internal methods
+private:
+  // Get the index of the bucket a (positive) value belongs to
+  int32_t GetBucketIndex (double value) const;
+
+  // Get the representative value of a bucket
+  double GetBucketValue (int32_t index) const;
+
+  // Make sure m_buckets covers the given bucket index
+  void ExtendBuckets (int32_t index);
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#endif /* QUANTILESKETCH_H_ */
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "RateEstimator.h"
+
+#include "ns3/PushPullDefines.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace bittorrent {
+
+RateEstimator::RateEstimator ()
+{
+  Configure (Seconds (PP_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS), MilliSeconds (PP_RATE_ESTIMATOR_RESOLUTION), MilliSeconds (PP_RATE_ESTIMATOR_EWMA_HALF_LIFE));
+}
+
+RateEstimator::RateEstimator (Time window, Time resolution, Time ewmaHalfLife)
+{
+  Configure (window, resolution, ewmaHalfLife);
+}
+
+RateEstimator::~RateEstimator ()
+{
+  m_buckets.clear ();
+}
+
+void RateEstimator::Configure (Time window, Time resolution, Time ewmaHalfLife)
+{
+  // Step 1: Derive the bucket layout; the window must consist of at least one bucket
+  m_resolution = std::max (static_cast<int64_t> (1), resolution.GetMilliSeconds ());
+  m_bucketCount = static_cast<uint32_t> (std::max (static_cast<int64_t> (1), window.GetMilliSeconds () / m_resolution));
+
+  // Step 2: Calculate the per-bucket decay of the EWMA from its half-life
+  if (ewmaHalfLife.IsStrictlyPositive ())
+    {
+      m_ewmaDecay = std::pow (0.5, static_cast<double> (m_resolution) / ewmaHalfLife.GetMilliSeconds ());
+    }
+  else
+    {
+      m_ewmaDecay = 0;
+    }
+
+  Reset ();
+}
+
+void RateEstimator::Reset ()
+{
+  m_buckets.assign (m_bucketCount, 0);
+  m_currentBucket = 0;
+  m_windowSum = 0;
+  m_ewmaBps = 0;
+  m_ewmaInitialized = false;
+}
+
+void RateEstimator::Seed (Time now, double bps)
+{
+  Reset ();
+
+  // Step 1: Spread the rate evenly over the closed buckets of the window; the current bucket starts empty
+  m_currentBucket = now.GetMilliSeconds () / m_resolution;
+  uint64_t bucketBytes = static_cast<uint64_t> (std::max (0.0, bps) * m_resolution / (8.0 * 1000));
+  for (uint32_t i = 1; i < m_bucketCount; ++i)
+    {
+      m_buckets[(m_currentBucket + i) % m_bucketCount] = bucketBytes;
+    }
+  m_windowSum = bucketBytes * (m_bucketCount - 1);
+
+  // Step 2: Start the EWMA from the given rate
+  m_ewmaBps = std::max (0.0, bps);
+  m_ewmaInitialized = true;
+}
+
+Time RateEstimator::GetWindow () const
+{
+  return MilliSeconds (m_resolution * m_bucketCount);
+}
+
+Time RateEstimator::GetResolution () const
+{
+  return MilliSeconds (m_resolution);
+}
+
+void RateEstimator::Add (Time now, uint64_t bytes)
+{
+  Advance (now);
+
+  m_buckets[m_currentBucket % m_bucketCount] += bytes;
+  m_windowSum += bytes;
+}
+
+double RateEstimator::GetBps (Time now)
+{
+  Advance (now);
+
+  return (m_windowSum * 8.0 * 1000) / (m_resolution * m_bucketCount);
+}
+
+double RateEstimator::GetEwmaBps (Time now)
+{
+  Advance (now);
+
+  return m_ewmaBps;
+}
+
+uint64_t RateEstimator::GetWindowBytes (Time now)
+{
+  Advance (now);
+
+  return m_windowSum;
+}
+
+void RateEstimator::Advance (Time now)
+{
+  int64_t nowBucket = now.GetMilliSeconds () / m_resolution;
+  if (nowBucket <= m_currentBucket)
+    {
+      return;
+    }
+
+  int64_t elapsed = nowBucket - m_currentBucket;
+
+  // Step 1: Fold the bucket that is being closed into the EWMA
+  double closedBps = (m_buckets[m_currentBucket % m_bucketCount] * 8.0 * 1000) / m_resolution;
+  if (m_ewmaInitialized)
+    {
+      m_ewmaBps = m_ewmaDecay * m_ewmaBps + (1 - m_ewmaDecay) * closedBps;
+    }
+  else
+    {
+      m_ewmaBps = closedBps;
+      m_ewmaInitialized = true;
+    }
+
+  // Step 1a: All further elapsed buckets were empty, so they only decay the EWMA
+  if (elapsed > 1)
+    {
+      m_ewmaBps *= std::pow (m_ewmaDecay, static_cast<double> (elapsed - 1));
+    }
+
+  // Step 2: Expire the buckets that were re-entered; if the whole window elapsed, all buckets are cleared at once
+  if (elapsed >= m_bucketCount)
+    {
+      std::fill (m_buckets.begin (), m_buckets.end (), 0);
+      m_windowSum = 0;
+    }
+  else
+    {
+      for (int64_t bucket = m_currentBucket + 1; bucket <= nowBucket; ++bucket)
+        {
+          uint64_t &expired = m_buckets[bucket % m_bucketCount];
+          m_windowSum -= expired;
+          expired = 0;
+        }
+    }
+
+  m_currentBucket = nowBucket;
+}
+
+} // ns bittorrent
+} // ns ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef RATEESTIMATOR_H_
+#define RATEESTIMATOR_H_
+
+#include "ns3/nstime.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Estimates a data rate from a stream of byte counts, both as a sliding-window average and as an exponentially-weighted moving average (EWMA).
+ *
+ * Byte counts are sorted into a ring buffer of fixed-duration buckets covering the sliding window. A running sum over all buckets
+ * is updated whenever bytes are added or buckets expire, so that querying the rate is O(1) (amortized over the elapsed buckets)
+ * regardless of the window size and resolution. Whenever a bucket is closed, its rate is folded into the EWMA, which reacts to
+ * changes faster than the sliding-window average.
+ *
+ * All methods take the current time as a parameter; times must not decrease between calls.
+ */
+class RateEstimator
+{
+// Fields
+private:
+  int64_t               m_resolution;        // The duration of a bucket, in milliseconds
+  uint32_t              m_bucketCount;       // The number of buckets in the sliding window
+  double                m_ewmaDecay;         // The weight of the old EWMA value when a bucket is closed
+
+  std::vector<uint64_t> m_buckets;           // The number of bytes per bucket, as a ring buffer
+  int64_t               m_currentBucket;     // The absolute index (time / resolution) of the most recent bucket
+  uint64_t              m_windowSum;         // The sum of all buckets
+
+  double                m_ewmaBps;           // The current EWMA value, in bps
+  bool                  m_ewmaInitialized;   // Whether a bucket was closed since the last reset, i.e., whether m_ewmaBps holds a value
+
+// Constructors etc.
+public:
+  /**
+   * \brief Create an estimator using PP_PEER_DOWNLOADUPLOADRATE_ROLLING_AVERAGE_SECONDS, PP_RATE_ESTIMATOR_RESOLUTION and PP_RATE_ESTIMATOR_EWMA_HALF_LIFE as parameters.
+   */
+  RateEstimator ();
+
+  /**
+   * \brief Create an estimator without any recorded data.
+   *
+   * @param window the duration of the sliding window. Rounded down to a multiple of the resolution.
+   * @param resolution the duration of a bucket.
+   * @param ewmaHalfLife the time after which the weight of a closed bucket in the EWMA has halved.
+   */
+  RateEstimator (Time window, Time resolution, Time ewmaHalfLife);
+  virtual ~RateEstimator ();
+
+// Configuration
+public:
+  /**
+   * \brief Change the parameters of the estimator. This discards all recorded data.
+   */
+  void Configure (Time window, Time resolution, Time ewmaHalfLife);
+
+  /**
+   * \brief Discard all recorded data.
+   */
+  void Reset ();
+
+  /**
+   * \brief Discard all recorded data and continue from a previously measured rate, as if it had been observed during the whole window before the given time.
+   *
+   * @param now the current time.
+   * @param bps the rate to start with, in bps.
+   */
+  void Seed (Time now, double bps);
+
+  Time GetWindow () const;
+
+  Time GetResolution () const;
+
+// Recording
+public:
+  /**
+   * \brief Record that a number of bytes was transferred at the given time.
+   */
+  void Add (Time now, uint64_t bytes);
+
+// Evaluation
+public:
+  /**
+   * @returns the average rate over the sliding window ending at the given time, in bps.
+   */
+  double GetBps (Time now);
+
+  /**
+   * @returns the exponentially-weighted moving average of the rate at the given time, in bps. The bucket currently being filled is not yet taken into account.
+   */
+  double GetEwmaBps (Time now);
+
+  /**
+   * @returns the number of bytes recorded within the sliding window ending at the given time.
+   */
+  uint64_t GetWindowBytes (Time now);
+
+// Internal methods
+private:
+  // Expire all buckets that fell out of the window until the given time and fold closed buckets into the EWMA
+  void Advance (Time now);
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#endif /* RATEESTIMATOR_H_ */
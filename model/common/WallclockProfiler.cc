@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#include "WallclockProfiler.h"
+
+#include <sstream>
+
+namespace ns3 {
+namespace bittorrent {
+
+WallclockProfiler::WallclockProfiler ()
+{
+  m_enabled = true;
+  Reset ();
+}
+
+WallclockProfiler::~WallclockProfiler ()
+{
+}
+
+void WallclockProfiler::SetEnabled (bool enabled)
+{
+  m_enabled = enabled;
+}
+
+void WallclockProfiler::Reset ()
+{
+  m_startNanoSeconds = GetTimeStamp ();
+  for (uint32_t i = 0; i < CATEGORY_COUNT; ++i)
+    {
+      m_entries[i].m_calls = 0;
+      m_entries[i].m_totalNanoSeconds = 0;
+      m_entries[i].m_maxNanoSeconds = 0;
+    }
+}
+
+uint64_t WallclockProfiler::GetCalls (Category category) const
+{
+  return m_entries[category].m_calls;
+}
+
+uint64_t WallclockProfiler::GetTotalNanoSeconds (Category category) const
+{
+  return m_entries[category].m_totalNanoSeconds;
+}
+
+std::string WallclockProfiler::GetCategoryName (Category category)
+{
+  switch (category)
+    {
+    case PEER_HANDLE_READ:
+      return "peer-handle-read";
+    case PEER_HANDLE_SEND:
+      return "peer-handle-send";
+    case PART_SELECTION_SCHEDULER:
+      return "part-selection-scheduler";
+    case TRACKER_GENERATE_RESPONSE:
+      return "tracker-generate-response";
+    case PLAYBACK_ADVANCE:
+      return "playback-advance";
+    case METRICS_WRITE:
+      return "metrics-write";
+    default:
+      return "unknown";
+    }
+}
+
+std::vector<std::string> WallclockProfiler::GetReport () const
+{
+  std::vector<std::string> report;
+
+  // Step 1: Report the total wall-clock time as the reference for the shares
+  uint64_t totalNanoSeconds = GetTimeStamp () - m_startNanoSeconds;
+  std::stringstream header;
+  header << "total wall-ms=" << totalNanoSeconds / 1000000.0;
+  report.push_back (header.str ());
+
+  // Step 2: Report the categories
+  for (uint32_t i = 0; i < CATEGORY_COUNT; ++i)
+    {
+      const Entry &entry = m_entries[i];
+
+      std::stringstream ss;
+      ss << GetCategoryName (static_cast<Category> (i))
+         << " calls=" << entry.m_calls
+         << " wall-ms=" << entry.m_totalNanoSeconds / 1000000.0
+         << " mean-us=" << (entry.m_calls > 0 ? entry.m_totalNanoSeconds / 1000.0 / entry.m_calls : 0)
+         << " max-us=" << entry.m_maxNanoSeconds / 1000.0
+         << " share=" << (totalNanoSeconds > 0 ? 100.0 * entry.m_totalNanoSeconds / totalNanoSeconds : 0) << "%";
+      report.push_back (ss.str ());
+    }
+
+  return report;
+}
+
+} // ns bittorrent
+} // ns ns3
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010-2012 ComSys, RWTH Aachen University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Rene Glebke
+ */
+
+#ifndef WALLCLOCKPROFILER_H_
+#define WALLCLOCKPROFILER_H_
+
+#include "ns3/PushPullDefines.h"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <time.h>
+
+namespace ns3 {
+namespace bittorrent {
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Aggregates the wall-clock time and the number of calls spent in the hot paths of the simulation.
+ *
+ * Code sections are measured by placing the PP_PROFILE_SCOPE macro at their beginning, which creates a ScopedWallclockTimer
+ * for the remainder of the scope. Times are inclusive, i.e., a section called from within another measured section
+ * (e.g., metrics writes during the playback advance) is accounted for in both categories.
+ *
+ * Profiling is compiled in if PP_WALLCLOCK_PROFILING_ENABLED is set to a non-zero value and can additionally be
+ * switched off at runtime via the SetEnabled method. The GlobalMetricsGatherer writes the report (see GetReport) when it stops the simulation.
+ */
+class WallclockProfiler
+{
+// Types used
+public:
+  enum Category
+  {
+    PEER_HANDLE_READ = 0,
+    PEER_HANDLE_SEND,
+    PART_SELECTION_SCHEDULER,
+    TRACKER_GENERATE_RESPONSE,
+    PLAYBACK_ADVANCE,
+    METRICS_WRITE,
+    CATEGORY_COUNT
+  };
+
+private:
+  /// @cond HIDDEN
+  typedef struct
+  {
+    uint64_t m_calls;             // The number of measured calls
+    uint64_t m_totalNanoSeconds;  // The accumulated wall-clock time of all calls
+    uint64_t m_maxNanoSeconds;    // The wall-clock time of the longest call
+  } Entry;
+  /// @endcond HIDDEN
+
+// Fields
+private:
+  bool     m_enabled;                    // Whether measurements are currently recorded
+  uint64_t m_startNanoSeconds;           // The time of creation or of the last Reset call
+  Entry    m_entries[CATEGORY_COUNT];    // The aggregated measurements per category
+
+// Constructors etc.
+private:
+  WallclockProfiler ();
+  WallclockProfiler (const WallclockProfiler &);
+  WallclockProfiler& operator= (const WallclockProfiler &);
+
+public:
+  virtual ~WallclockProfiler ();
+
+  static WallclockProfiler* GetInstance ()
+  {
+    static WallclockProfiler s_instance;
+
+    return &s_instance;
+  }
+
+// Control functions
+public:
+  void SetEnabled (bool enabled);
+
+  bool IsEnabled () const
+  {
+    return m_enabled;
+  }
+
+  /**
+   * \brief Discard all measurements and restart the measurement of the total wall-clock time.
+   */
+  void Reset ();
+
+// Measurement
+public:
+  /**
+   * @returns a monotonic wall-clock time stamp in nanoseconds.
+   */
+  static uint64_t GetTimeStamp ()
+  {
+    timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t> (now.tv_sec) * 1000000000ULL + now.tv_nsec;
+  }
+
+  /**
+   * \brief Account a measured call to a category.
+   *
+   * @param category the category of the measured code section.
+   * @param nanoSeconds the wall-clock time spent in the call.
+   */
+  void Record (Category category, uint64_t nanoSeconds)
+  {
+    Entry &entry = m_entries[category];
+    ++entry.m_calls;
+    entry.m_totalNanoSeconds += nanoSeconds;
+    if (nanoSeconds > entry.m_maxNanoSeconds)
+      {
+        entry.m_maxNanoSeconds = nanoSeconds;
+      }
+  }
+
+// Evaluation
+public:
+  uint64_t GetCalls (Category category) const;
+
+  uint64_t GetTotalNanoSeconds (Category category) const;
+
+  static std::string GetCategoryName (Category category);
+
+  /**
+   * \brief Create a human-readable report of the measurements.
+   *
+   * @returns one line per category with calls, total, mean and maximum time and the share of the total wall-clock time, preceded by a line with the total wall-clock time.
+   */
+  std::vector<std::string> GetReport () const;
+};
+
+/**
+ * \ingroup BitTorrent
+ *
+ * \brief Measures the wall-clock time from its creation to its destruction and records it with the WallclockProfiler.
+ */
+class ScopedWallclockTimer
+{
+private:
+  WallclockProfiler::Category m_category;
+  uint64_t                    m_start;      // 0 if the profiler was disabled upon creation
+
+public:
+  ScopedWallclockTimer (WallclockProfiler::Category category) :
+    m_category (category),
+    m_start (WallclockProfiler::GetInstance ()->IsEnabled () ? WallclockProfiler::GetTimeStamp () : 0)
+  {
+  }
+
+  ~ScopedWallclockTimer ()
+  {
+    if (m_start != 0)
+      {
+        WallclockProfiler::GetInstance ()->Record (m_category, WallclockProfiler::GetTimeStamp () - m_start);
+      }
+  }
+};
+
+} // ns bittorrent
+} // ns ns3
+
+#if PP_WALLCLOCK_PROFILING_ENABLED
+#define PP_PROFILE_SCOPE(category) ns3::bittorrent::ScopedWallclockTimer ppProfileScopeTimer (ns3::bittorrent::WallclockProfiler::category)
+#else
+#define PP_PROFILE_SCOPE(category)
+#endif
+
+#endif /* WALLCLOCKPROFILER_H_ */
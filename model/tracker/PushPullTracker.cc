@@ -25,6 +25,7 @@
 #include "ns3/PullPushUtilities.h"
 #include "ns3/GlobalMetricsGatherer.h"
 #include "ns3/Torrent.h"
+#include "ns3/WallclockProfiler.h"
 
 #include "ns3/address.h"
 #include "ns3/application.h"
@@ -364,6 +365,8 @@ void PullPushTracker::DataCreater (std::string path, Ptr<Socket> socket, const A
 
 std::string PullPushTracker::GenerateResponseForPeer (const PPDict& clientInfo) const
 {
+  PP_PROFILE_SCOPE (TRACKER_GENERATE_RESPONSE);
+
   std::string result;
 
   std::string info_hash = (*(clientInfo.find ("info_hash"))).second;